@@ -109,6 +109,7 @@ class configuration:
                       'src/Cmfd.cpp',
                       'src/CPUSolver.cpp',
                       'src/CPULSSolver.cpp',
+                      'src/CPUMultiStateSolver.cpp',
                       'src/ExpEvaluator.cpp',
                       'src/Geometry.cpp',
                       'src/linalg.cpp',
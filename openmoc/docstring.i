@@ -2239,7 +2239,7 @@ Parameters
 ";
 
 %feature("docstring") Geometry::getFSRsToKeys "
-getFSRsToKeys() -> std::vector< std::string > &  
+getFSRsToKeys() -> std::vector< FSRKey > &  
 
 Returns the vector that maps FSR IDs to FSR key hashes.  
 
@@ -2290,7 +2290,7 @@ the FSR's centroid
 ";
 
 %feature("docstring") Geometry::getFSRKeysMap "
-getFSRKeysMap() -> ParallelHashMap< std::string, fsr_data * > &  
+getFSRKeysMap() -> ConcurrentHashMap< FSRKey, fsr_data * > &  
 
 Returns a pointer to the map that maps FSR keys to FSR IDs.  
 
@@ -2381,6 +2381,24 @@ Returns
 the FSR key  
 ";
 
+%feature("docstring") Geometry::getFSRKeyString "
+getFSRKeyString(long fsr_id) -> std::string  
+
+Generate the string FSR \"key\" of an FSR from its ID.  
+
+The string key is rebuilt on demand from the characteristic point of the FSR, and is
+meant for debugging and file output only.  
+
+Parameters
+----------
+* fsr_id :  
+    the FSR ID  
+
+Returns
+-------
+the FSR key  
+";
+
 %feature("docstring") Geometry::subdivideCells "
 subdivideCells()  
 
@@ -51,6 +51,10 @@
  * openmoc.process */
 %apply (double* ARGOUT_ARRAY1, int DIM1) {(double* fission_rates, long num_FSRs)}
 
+/* The typemap used to match the method signature for the Solver's
+ * loadFissionRates method, returning the fission rates on a mesh */
+%apply (double* ARGOUT_ARRAY1, int DIM1) {(double* fission_rates, int num_mesh_cells)}
+
 /* The typemap used to match the method signature for the Universe's
  * getCellIds method for the data processing routines in openmoc.process */
 %apply (int* ARGOUT_ARRAY1, int DIM1) {(int* cell_ids, int num_cells)}
@@ -33,6 +33,7 @@
   #include "../src/Solver.h"
   #include "../src/CPUSolver.h"
   #include "../src/CPULSSolver.h"
+  #include "../src/CPUMultiStateSolver.h"
   #include "../src/Surface.h"
   #include "../src/Timer.h"
   #include "../src/Track.h"
@@ -166,6 +167,7 @@ namespace std {
 %include ../src/Solver.h
 %include ../src/CPUSolver.h
 %include ../src/CPULSSolver.h
+%include ../src/CPUMultiStateSolver.h
 %include ../src/Surface.h
 %include ../src/Timer.h
 %include ../src/Track.h
@@ -0,0 +1,114 @@
+#include "../../../src/ConcurrentHashMap.h"
+#include "../../../src/ParallelHashMap.h"
+#include "../../../src/FSRKey.h"
+#include "../../../src/log.h"
+#include <omp.h>
+#include <stdlib.h>
+#include <vector>
+
+/* Number of distinct keys and number of lookups of each key, mimicking the
+ * repeated discovery of the same FSRs by many tracks during ray tracing */
+const long num_keys = 1 << 21;
+const int lookups_per_key = 8;
+
+
+/* Emulates Geometry::findFSRId on a map, returns the number of new keys */
+template <class M>
+long discover(M& map, std::vector<FSRKey>& keys, long* values) {
+
+  long num_new = 0;
+#pragma omp parallel for schedule(static) reduction(+:num_new)
+  for (long i=0; i < num_keys * lookups_per_key; i++) {
+    FSRKey& key = keys[(i * 7919) % num_keys];
+    if (map.contains(key))
+      continue;
+    long id = map.insert_and_get_count(key, NULL);
+    if (id == -1) {
+
+      /* Keys in transit during a ParallelHashMap resize may transiently be
+       * reported missing, so retry until the value is published */
+      long* value = NULL;
+      while (value == NULL) {
+        try {
+          value = map.at(key);
+        }
+        catch (std::out_of_range& e) {
+          value = NULL;
+        }
+      }
+    }
+    else {
+      map.update(key, &values[id]);
+      num_new++;
+    }
+  }
+  return num_new;
+}
+
+
+/* Looks up every key several times, returns a checksum */
+template <class M>
+long lookup(M& map, std::vector<FSRKey>& keys, long* values) {
+
+  long sum = 0;
+#pragma omp parallel for schedule(static) reduction(+:sum)
+  for (long i=0; i < num_keys * lookups_per_key; i++)
+    sum += map.at(keys[(i * 7919) % num_keys]) - values;
+  return sum;
+}
+
+
+template <class M>
+void benchmark(const char* name, int num_threads, std::vector<FSRKey>& keys,
+               long* values) {
+
+  omp_set_num_threads(num_threads);
+  M map;
+
+  double start = omp_get_wtime();
+  long num_new = discover(map, keys, values);
+  double insert_time = omp_get_wtime() - start;
+
+  start = omp_get_wtime();
+  long sum = lookup(map, keys, values);
+  double lookup_time = omp_get_wtime() - start;
+
+  if (num_new != num_keys || map.size() != num_keys)
+    log_printf(ERROR, "%s found %ld keys instead of %ld", name, num_new,
+               num_keys);
+
+  double num_ops = (double) num_keys * lookups_per_key;
+  log_printf(RESULT, "%-17s %2d threads: insert %6.2f, lookup %6.2f Mops/s",
+             name, num_threads, num_ops / insert_time * 1E-6,
+             num_ops / lookup_time * 1E-6);
+  log_printf(DEBUG, "Lookup checksum %ld", sum);
+}
+
+
+int main(int argc, char* argv[]) {
+
+  int max_threads = omp_get_num_procs();
+  if (argc > 1)
+    max_threads = atoi(argv[1]);
+
+  /* Create keys hashing a lattice, universe and cell path */
+  log_printf(NORMAL, "Creating %ld FSR keys...", num_keys);
+  std::vector<FSRKey> keys(num_keys);
+  for (long i=0; i < num_keys; i++) {
+    keys[i].append(KEY_LATTICE, i / 4096);
+    keys[i].append(KEY_UNIVERSE, (i / 64) % 64);
+    keys[i].append(KEY_CELL, i % 64);
+  }
+  long* values = new long[num_keys];
+
+  /* Compare throughput against thread count */
+  for (int num_threads=1; num_threads <= max_threads; num_threads *= 2) {
+    benchmark<ParallelHashMap<FSRKey, long*> >
+        ("ParallelHashMap", num_threads, keys, values);
+    benchmark<ConcurrentHashMap<FSRKey, long*> >
+        ("ConcurrentHashMap", num_threads, keys, values);
+  }
+
+  delete [] values;
+  return 0;
+}
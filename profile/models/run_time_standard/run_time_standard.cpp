@@ -106,6 +106,9 @@ int main(int argc, char* argv[]) {
   track_generator.setQuadrature(quad);
   track_generator.setSegmentFormation((segmentationType)
                                       runtime._segmentation_type);
+  track_generator.setMaxSegmentMemory(runtime._max_segment_memory);
+  track_generator.setPipelineDepth(runtime._pipeline_depth);
+  track_generator.setSegmentStreamingWindow(runtime._segment_window);
   if(!runtime._seg_zones.empty())
     track_generator.setSegmentationZones(runtime._seg_zones);
   track_generator.generateTracks();
@@ -120,6 +123,11 @@ int main(int argc, char* argv[]) {
     solver->setVerboseIterationReport();
   solver->setNumThreads(num_threads);
   solver->setConvergenceThreshold(runtime._tolerance);
+  if(!runtime._checkpoint_filename.empty() && runtime._checkpoint_interval > 0)
+    solver->setCheckpointing(runtime._checkpoint_filename,
+                             runtime._checkpoint_interval);
+  if(!runtime._restart_filename.empty())
+    solver->restartFromCheckpoint(runtime._restart_filename);
   solver->computeEigenvalue(runtime._max_iters, 
                            (residualType)runtime._MOC_src_residual_type);
   if(runtime._time_report)
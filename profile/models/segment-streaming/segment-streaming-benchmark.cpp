@@ -0,0 +1,171 @@
+#include "../../../src/CPUSolver.h"
+#include "../../../src/log.h"
+#include <omp.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Ray tracing parameters and number of transport sweeps timed */
+const int num_azim = 8;
+const int num_polar = 4;
+const double azim_spacing = 0.1;
+const double polar_spacing = 0.25;
+const int num_iterations = 20;
+
+
+/* Creates a 4 x 4 lattice of two-group fuel pins, 20 cm tall */
+Geometry* createGeometry() {
+
+  const int num_groups = 2;
+  double sigma_t_fuel[num_groups] = {0.5, 1.2};
+  double sigma_s_fuel[num_groups*num_groups] = {0.45, 0.02, 0.0, 0.9};
+  double nu_sigma_f_fuel[num_groups] = {0.03, 1.6};
+  double chi_fuel[num_groups] = {1.0, 0.0};
+  double sigma_t_water[num_groups] = {0.6, 2.0};
+  double sigma_s_water[num_groups*num_groups] = {0.5, 0.09, 0.0, 1.95};
+  double zeros[num_groups] = {0.0, 0.0};
+
+  Material* fuel = new Material(1, "fuel");
+  fuel->setNumEnergyGroups(num_groups);
+  fuel->setSigmaT(sigma_t_fuel, num_groups);
+  fuel->setSigmaS(sigma_s_fuel, num_groups*num_groups);
+  fuel->setNuSigmaF(nu_sigma_f_fuel, num_groups);
+  fuel->setSigmaF(nu_sigma_f_fuel, num_groups);
+  fuel->setChi(chi_fuel, num_groups);
+
+  Material* water = new Material(2, "water");
+  water->setNumEnergyGroups(num_groups);
+  water->setSigmaT(sigma_t_water, num_groups);
+  water->setSigmaS(sigma_s_water, num_groups*num_groups);
+  water->setNuSigmaF(zeros, num_groups);
+  water->setSigmaF(zeros, num_groups);
+  water->setChi(zeros, num_groups);
+
+  XPlane* xmin = new XPlane(-2.52);
+  XPlane* xmax = new XPlane(2.52);
+  YPlane* ymin = new YPlane(-2.52);
+  YPlane* ymax = new YPlane(2.52);
+  ZPlane* zmin = new ZPlane(-10.0);
+  ZPlane* zmax = new ZPlane(10.0);
+  xmin->setBoundaryType(REFLECTIVE);
+  xmax->setBoundaryType(REFLECTIVE);
+  ymin->setBoundaryType(REFLECTIVE);
+  ymax->setBoundaryType(REFLECTIVE);
+  zmin->setBoundaryType(VACUUM);
+  zmax->setBoundaryType(VACUUM);
+
+  ZCylinder* pin = new ZCylinder(0.0, 0.0, 0.4);
+  Cell* fuel_cell = new Cell();
+  fuel_cell->setFill(fuel);
+  fuel_cell->addSurface(-1, pin);
+  fuel_cell->setNumRings(3);
+  fuel_cell->setNumSectors(8);
+  Cell* water_cell = new Cell();
+  water_cell->setFill(water);
+  water_cell->addSurface(+1, pin);
+  water_cell->setNumSectors(8);
+  Universe* pin_universe = new Universe();
+  pin_universe->addCell(fuel_cell);
+  pin_universe->addCell(water_cell);
+
+  Lattice* lattice = new Lattice();
+  lattice->setWidth(1.26, 1.26, 20.0);
+  Universe* universes[4*4];
+  for (int i=0; i < 4*4; i++)
+    universes[i] = pin_universe;
+  lattice->setUniverses(1, 4, 4, universes);
+
+  Cell* root_cell = new Cell();
+  root_cell->setFill(lattice);
+  root_cell->addSurface(+1, xmin);
+  root_cell->addSurface(-1, xmax);
+  root_cell->addSurface(+1, ymin);
+  root_cell->addSurface(-1, ymax);
+  root_cell->addSurface(+1, zmin);
+  root_cell->addSurface(-1, zmax);
+  Universe* root_universe = new Universe();
+  root_universe->addCell(root_cell);
+
+  Geometry* geometry = new Geometry();
+  geometry->setRootUniverse(root_universe);
+  geometry->initializeFlatSourceRegions();
+  return geometry;
+}
+
+
+/* Times the ray tracing and transport sweeps of a segment formation */
+void run(segmentationType segment_formation, double window_memory,
+         const char* name, int num_threads) {
+
+  Geometry* geometry = createGeometry();
+  TrackGenerator3D track_generator(geometry, num_azim, num_polar,
+                                   azim_spacing, polar_spacing);
+  track_generator.setNumThreads(num_threads);
+  track_generator.setSegmentFormation(segment_formation);
+  if (segment_formation == EXPLICIT_3D)
+    track_generator.setImplicit3DTracks(true);
+  if (window_memory > 0)
+    track_generator.setSegmentStreamingWindow(window_memory);
+  std::vector<double> zones {-10.0, 10.0};
+  track_generator.setSegmentationZones(zones);
+
+  double start = omp_get_wtime();
+  track_generator.generateTracks();
+  double tracking_time = omp_get_wtime() - start;
+
+  /* Run a fixed number of transport sweeps */
+  CPUSolver solver(&track_generator);
+  solver.setNumThreads(num_threads);
+  solver.setConvergenceThreshold(1E-12);
+  start = omp_get_wtime();
+  solver.computeEigenvalue(num_iterations);
+  double sweep_time = (omp_get_wtime() - start) / solver.getNumIterations();
+
+  /* Read the peak resident memory of the process */
+  long peak_memory = 0;
+  FILE* status = fopen("/proc/self/status", "r");
+  if (status != NULL) {
+    char line[256];
+    while (fgets(line, sizeof(line), status) != NULL)
+      if (strncmp(line, "VmHWM:", 6) == 0)
+        peak_memory = atol(line + 6);
+    fclose(status);
+  }
+
+  log_printf(RESULT, "%-18s ray tracing: %7.3f s, sweep: %7.4f s, "
+             "k-eff: %8.6f, peak memory: %6.1f MB", name, tracking_time,
+             sweep_time, solver.getKeff(), peak_memory / 1E3);
+}
+
+
+int main(int argc, char* argv[]) {
+
+#ifdef MPIx
+  MPI_Init(&argc, &argv);
+  log_set_ranks(MPI_COMM_WORLD);
+#endif
+
+#ifdef OPENMP
+  int num_threads = omp_get_num_procs();
+#else
+  int num_threads = 1;
+#endif
+
+  /* Select the segment formation, each being run in its own process since
+   * the peak memory of the process is reported */
+  std::string mode = argc > 1 ? argv[1] : "stream";
+  if (mode == "otf")
+    run(OTF_STACKS, 0., "On-the-fly stacks", num_threads);
+  else if (mode == "memory")
+    run(EXPLICIT_3D, 0., "Explicit in memory", num_threads);
+  else if (mode == "stream")
+    run(EXPLICIT_3D, 1., "Explicit streamed", num_threads);
+  else
+    log_printf(ERROR, "Unknown mode %s, use otf, memory or stream",
+               mode.c_str());
+
+#ifdef MPIx
+  MPI_Finalize();
+#endif
+
+  return 0;
+}
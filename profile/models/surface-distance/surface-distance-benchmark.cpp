@@ -0,0 +1,70 @@
+#include "../../../src/Cell.h"
+#include "../../../src/Surface.h"
+#include "../../../src/Point.h"
+#include "../../../src/log.h"
+#include <omp.h>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+/* Pin discretization and number of distance queries */
+const int num_rings = 10;
+const int num_sectors = 8;
+const int num_queries = 1 << 20;
+
+
+/* Times the distance queries, returns the sum of the distances */
+double query(Cell* cell, std::vector<Point>& points, std::vector<double>& azim,
+             std::vector<double>& polar, const char* name) {
+
+  double sum = 0.;
+  double start = omp_get_wtime();
+  for (int i=0; i < num_queries; i++)
+    sum += cell->minSurfaceDist(&points[i], azim[i], polar[i]);
+  double time = omp_get_wtime() - start;
+
+  log_printf(RESULT, "%-10s distance query: %8.2f ns", name,
+             time / num_queries * 1E9);
+  return sum;
+}
+
+
+int main(int argc, char* argv[]) {
+
+  /* Create the rings and sectors of a fuel pin */
+  double radius = 0.54;
+  Cell* cell = new Cell();
+  for (int r=1; r <= num_rings; r++) {
+    ZCylinder* cylinder = new ZCylinder(0., 0., radius * sqrt(r / 10.));
+    cell->addSurface(-1, cylinder);
+  }
+  for (int s=0; s < num_sectors; s++) {
+    double angle = M_PI * s / num_sectors;
+    Plane* plane = new Plane(-sin(angle), cos(angle), 0., 0.);
+    cell->addSurface(+1, plane);
+  }
+
+  /* Sample random starting points in the pin and random directions */
+  srand(1);
+  std::vector<Point> points(num_queries);
+  std::vector<double> azim(num_queries);
+  std::vector<double> polar(num_queries);
+  for (int i=0; i < num_queries; i++) {
+    double r = radius * rand() / RAND_MAX;
+    double theta = 2. * M_PI * rand() / RAND_MAX;
+    points[i].setCoords(r * cos(theta), r * sin(theta), 0.);
+    azim[i] = 2. * M_PI * rand() / RAND_MAX;
+    polar[i] = M_PI * (0.05 + 0.9 * rand() / RAND_MAX);
+  }
+
+  /* Compare the per-Surface distances against the batched distances */
+  double sum = query(cell, points, azim, polar, "Surfaces");
+  cell->compileRegion();
+  double sum_batched = query(cell, points, azim, polar, "Batched");
+
+  if (fabs(sum - sum_batched) > 1E-6 * fabs(sum))
+    log_printf(ERROR, "Batched distances sum to %f instead of %f",
+               sum_batched, sum);
+
+  return 0;
+}
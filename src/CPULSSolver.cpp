@@ -142,6 +142,25 @@ void CPULSSolver::initializeFSRs() {
 }
 
 
+/**
+ * @brief Updates the Solver for new cross sections of the same Materials.
+ * @details The linear source constants depend on the total cross sections of
+ *          the FSRs, so that the linear expansion coefficients are generated
+ *          again.
+ */
+void CPULSSolver::updateCrossSections() {
+
+  CPUSolver::updateCrossSections();
+
+  /* Generate linear source coefficients */
+  initializeLinearSourceConstants();
+  log_printf(NORMAL, "Generating linear expansion coefficients");
+  LinearExpansionGenerator lin_src_coeffs(this);
+  lin_src_coeffs.execute();
+  log_printf(NORMAL, "Linear expansion coefficient generation complete");
+}
+
+
 /**
  * @brief Set the scalar flux constants for each FSR and energy group to some
  *        value and the scalar flux moments to zero.
@@ -808,6 +827,31 @@ void CPULSSolver::checkLimitXS(int iteration) {
 }
 
 
+/**
+ * @brief Lists the arrays of the Solver state saved in checkpoints.
+ * @details The scalar flux moments of the linear sources and their
+ *          stabilizing terms are saved in addition to the flat source state.
+ * @param arrays the list of arrays to append to
+ */
+void CPULSSolver::getCheckpointArrays(
+     std::vector<SolverCheckpointArray>& arrays) {
+
+  Solver::getCheckpointArrays(arrays);
+
+  size_t moments_size = 3 * _num_groups * sizeof(FP_PRECISION);
+  SolverCheckpointArray flux_moments = {SOLVER_SECTION_FLUX_MOMENTS,
+                                        _scalar_flux_xyz, moments_size,
+                                        _num_FSRs};
+  arrays.push_back(flux_moments);
+  if (_stabilizing_flux_xyz != NULL) {
+    SolverCheckpointArray stabilizing_moments =
+         {SOLVER_SECTION_STABILIZING_FLUX_MOMENTS, _stabilizing_flux_xyz,
+          moments_size, _num_FSRs};
+    arrays.push_back(stabilizing_moments);
+  }
+}
+
+
 /**
  * @brief Get the flux at a specific point in the geometry.
  * @param coords The coords of the point to get the flux at
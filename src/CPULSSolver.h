@@ -65,6 +65,7 @@ public:
   void initializeCmfd();
   void initializeExpEvaluators();
   void initializeFSRs();
+  void updateCrossSections();
 
   void flattenFSRFluxes(FP_PRECISION value);
   double normalizeFluxes();
@@ -84,6 +85,7 @@ public:
   void computeStabilizingFlux();
   void stabilizeFlux();
   void checkLimitXS(int iteration);
+  void getCheckpointArrays(std::vector<SolverCheckpointArray>& arrays);
 
   FP_PRECISION getFluxByCoords(LocalCoords* coords, int group);
   void initializeLinearSourceConstants();
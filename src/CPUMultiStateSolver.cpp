@@ -0,0 +1,776 @@
+#include "CPUMultiStateSolver.h"
+
+/**
+ * @brief Constructor initializes a single state of the Materials.
+ * @param track_generator an optional pointer to the TrackGenerator
+ */
+CPUMultiStateSolver::CPUMultiStateSolver(TrackGenerator* track_generator)
+    : CPUSolver(track_generator) {
+
+  _num_states = 1;
+  _num_state_groups = 0;
+  _state_materials.resize(_num_states);
+  _max_sigma_t_ratio = 1.;
+}
+
+
+/**
+ * @brief Destructor deletes the Materials stacking the states.
+ */
+CPUMultiStateSolver::~CPUMultiStateSolver() {
+
+  std::map<int, Material*>::iterator iter;
+  for (iter = _stacked_materials.begin(); iter != _stacked_materials.end();
+       ++iter)
+    delete iter->second;
+}
+
+
+/**
+ * @brief Sets the number of states solved in the same transport sweeps.
+ * @details The states use the Materials filling the Geometry unless they
+ *          are replaced with setStateMaterial(...).
+ * @param num_states the number of states
+ */
+void CPUMultiStateSolver::setNumStates(int num_states) {
+
+  if (num_states <= 0)
+    log_printf(ERROR, "Unable to set the number of states to %d since it "
+               "must be positive", num_states);
+
+  _num_states = num_states;
+  _state_materials.resize(_num_states);
+
+  /* The flux arrays depend on the number of states */
+  _initialization._track_generator = NULL;
+}
+
+
+/**
+ * @brief Replaces the Material with the same ID as a Material of the
+ *        Geometry in one state.
+ * @details The cross sections of the Material are read at the start of each
+ *          eigenvalue calculation.
+ *
+ * @code
+ *          solver.setNumStates(2)
+ *          solver.setStateMaterial(1, hot_fuel)
+ * @endcode
+ *
+ * @param state the index of the state, between 0 and the number of states
+ * @param material the Material replacing the Material with the same ID
+ */
+void CPUMultiStateSolver::setStateMaterial(int state, Material* material) {
+
+  if (state < 0 || state >= _num_states)
+    log_printf(ERROR, "Unable to set a Material for state %d since there "
+               "are %d states", state, _num_states);
+
+  _state_materials[state][material->getId()] = material;
+}
+
+
+/**
+ * @brief Returns the number of states solved in the same transport sweeps.
+ * @return the number of states
+ */
+int CPUMultiStateSolver::getNumStates() {
+  return _num_states;
+}
+
+
+/**
+ * @brief Returns the eigenvalue of a state.
+ * @details getKeff() returns the eigenvalue of the first state.
+ * @param state the index of the state
+ * @return the eigenvalue of the state
+ */
+double CPUMultiStateSolver::getStateKeff(int state) {
+
+  if (state < 0 || state >= (int) _state_k_eff.size())
+    log_printf(ERROR, "Unable to return the eigenvalue of state %d since "
+               "%d states were solved", state, (int) _state_k_eff.size());
+
+  return _state_k_eff[state];
+}
+
+
+/**
+ * @brief Returns the scalar flux of a state for some FSR and energy group.
+ * @param fsr_id the ID for the FSR of interest
+ * @param state the index of the state
+ * @param group the energy group of interest
+ * @return the FSR scalar flux
+ */
+double CPUMultiStateSolver::getStateFlux(long fsr_id, int state, int group) {
+
+  if (state < 0 || state >= (int) _state_k_eff.size())
+    log_printf(ERROR, "Unable to return a scalar flux for state %d since "
+               "%d states were solved", state, (int) _state_k_eff.size());
+
+  else if (group <= 0 || group > _num_state_groups)
+    log_printf(ERROR, "Unable to return a scalar flux in group %d "
+               "since there are only %d groups", group, _num_state_groups);
+
+  return getFlux(fsr_id, state * _num_state_groups + group);
+}
+
+
+/**
+ * @brief Checks that the options of the Solver support solving several
+ *        states.
+ * @details CMFD and the initial spectrum calculation solve a single
+ *          eigenvalue problem for all the energy groups.
+ */
+void CPUMultiStateSolver::checkStatesSupport() {
+
+  if (_geometry->getCmfd() != NULL)
+    log_printf(ERROR, "Unable to solve several states with CMFD "
+               "acceleration");
+
+  if (_calculate_initial_spectrum)
+    log_printf(ERROR, "Unable to solve several states with an initial "
+               "spectrum calculation");
+}
+
+
+/**
+ * @brief Initializes the FSR volumes and Materials array, stacking the
+ *        energy groups of all states.
+ * @details The Solver transports the energy groups of all states as a
+ *          single set of energy groups, each state occupying a contiguous
+ *          range of groups, and the FSRs are filled with Materials stacking
+ *          the cross sections of all states.
+ */
+void CPUMultiStateSolver::initializeFSRs() {
+
+  checkStatesSupport();
+
+  CPUSolver::initializeFSRs();
+
+#ifdef NGROUPS
+  log_printf(ERROR, "Unable to solve several states with a number of energy "
+             "groups set at compile time");
+#else
+  /* Stack the energy groups of all states */
+  _num_state_groups = _num_groups;
+  _num_groups *= _num_states;
+
+  if (_solve_3D)
+    _fluxes_per_track = _num_groups;
+  else
+    _fluxes_per_track = _num_groups * _num_polar/2;
+#endif
+
+  /* Allocate scratch memory for the stacked energy groups */
+  for (size_t i=0; i < _groupwise_scratch.size(); i++) {
+    delete [] _groupwise_scratch.at(i);
+    _groupwise_scratch.at(i) = new FP_PRECISION[_num_groups];
+  }
+
+  stackStateMaterials();
+
+  _state_k_eff.assign(_num_states, 1.);
+  _state_k_prev.assign(_num_states, 1.);
+}
+
+
+/**
+ * @brief Fills the FSRs with Materials stacking the cross sections of all
+ *        states.
+ * @details The scattering matrices of the states are placed on the diagonal
+ *          of the stacked scattering matrix, so that the states are not
+ *          coupled.
+ */
+void CPUMultiStateSolver::stackStateMaterials() {
+
+  std::map<int, Material*> materials = _geometry->getAllMaterials();
+  std::map<int, Material*> stacked_materials;
+  std::map<int, Material*>::iterator iter;
+  int num_groups = _num_state_groups * _num_states;
+
+  /* Check the Materials replaced in each state */
+  for (int s=0; s < _num_states; s++) {
+    for (iter = _state_materials[s].begin();
+         iter != _state_materials[s].end(); ++iter) {
+
+      if (materials.find(iter->first) == materials.end())
+        log_printf(ERROR, "Unable to replace Material %d in state %d since "
+                   "the Geometry contains no Material with this ID",
+                   iter->first, s);
+
+      if (iter->second->getNumEnergyGroups() != _num_state_groups)
+        log_printf(ERROR, "Unable to replace Material %d in state %d with "
+                   "%d energy groups instead of %d", iter->first, s,
+                   iter->second->getNumEnergyGroups(), _num_state_groups);
+    }
+  }
+
+  std::vector<double> sigma_t(num_groups);
+  std::vector<double> sigma_f(num_groups);
+  std::vector<double> nu_sigma_f(num_groups);
+  std::vector<double> chi(num_groups);
+  std::vector<double> sigma_s(num_groups * num_groups);
+
+  for (iter = materials.begin(); iter != materials.end(); ++iter) {
+
+    std::fill(sigma_s.begin(), sigma_s.end(), 0.);
+
+    for (int s=0; s < _num_states; s++) {
+
+      /* Use the Material of the Geometry unless replaced in this state */
+      Material* material = iter->second;
+      if (_state_materials[s].find(iter->first) != _state_materials[s].end())
+        material = _state_materials[s][iter->first];
+
+      FP_PRECISION* state_sigma_t = material->getSigmaT();
+      FP_PRECISION* state_sigma_f = material->getSigmaF();
+      FP_PRECISION* state_nu_sigma_f = material->getNuSigmaF();
+      FP_PRECISION* state_chi = material->getChi();
+      FP_PRECISION* state_sigma_s = material->getSigmaS();
+
+      int first_group = s * _num_state_groups;
+      for (int g=0; g < _num_state_groups; g++) {
+        sigma_t[first_group+g] = state_sigma_t[g];
+        sigma_f[first_group+g] = state_sigma_f[g];
+        nu_sigma_f[first_group+g] = state_nu_sigma_f[g];
+        chi[first_group+g] = state_chi[g];
+
+        /* Scattering matrices are stored by destination group but set by
+         * origin group */
+        for (int gp=0; gp < _num_state_groups; gp++)
+          sigma_s[(first_group+gp)*num_groups + first_group+g] =
+               state_sigma_s[g*_num_state_groups + gp];
+      }
+    }
+
+    Material* stacked_material = new Material(iter->first,
+                                              iter->second->getName());
+    stacked_material->setNumEnergyGroups(num_groups);
+    stacked_material->setSigmaT(&sigma_t[0], num_groups);
+    stacked_material->setSigmaF(&sigma_f[0], num_groups);
+    stacked_material->setNuSigmaF(&nu_sigma_f[0], num_groups);
+    stacked_material->setSigmaS(&sigma_s[0], num_groups * num_groups);
+
+    /* Chi is already normalized for each state */
+    for (int e=0; e < num_groups; e++)
+      stacked_material->setChiByGroup(chi[e], e+1);
+    stacked_materials[iter->first] = stacked_material;
+  }
+
+  /* Fill the FSRs with the stacked Materials */
+  for (long r=0; r < _num_FSRs; r++)
+    _FSR_materials[r] = stacked_materials[_FSR_materials[r]->getId()];
+
+  /* Delete the Materials stacking the previous cross sections */
+  for (iter = _stacked_materials.begin(); iter != _stacked_materials.end();
+       ++iter)
+    delete iter->second;
+  _stacked_materials = stacked_materials;
+}
+
+
+/**
+ * @brief Computes the largest ratio between the maximum total cross section
+ *        of a stacked Material and that of the Material of the Geometry.
+ * @details The segments are split and their optical lengths computed with
+ *          the Materials of the Geometry, so that the optical lengths of the
+ *          states are at most larger by this ratio.
+ * @return the largest ratio of the maximum total cross sections
+ */
+double CPUMultiStateSolver::computeMaxSigmaTRatio() {
+
+  std::map<int, Material*> materials = _geometry->getAllMaterials();
+  std::map<int, Material*>::iterator iter;
+  double max_ratio = 1.;
+
+  for (iter = _stacked_materials.begin(); iter != _stacked_materials.end();
+       ++iter) {
+
+    FP_PRECISION* sigma_t = materials[iter->first]->getSigmaT();
+    FP_PRECISION* stacked_sigma_t = iter->second->getSigmaT();
+    double max_sigma_t = 0.;
+    double max_stacked_sigma_t = 0.;
+    for (int g=0; g < _num_state_groups; g++)
+      max_sigma_t = std::max(max_sigma_t, (double) sigma_t[g]);
+    for (int e=0; e < _num_groups; e++)
+      max_stacked_sigma_t = std::max(max_stacked_sigma_t,
+                                     (double) stacked_sigma_t[e]);
+
+    /* Segments are not split in void Materials of the Geometry */
+    if (max_sigma_t == 0.) {
+      if (max_stacked_sigma_t > 0.)
+        log_printf(ERROR, "Unable to solve several states with Material %d "
+                   "void in the Geometry but not in every state",
+                   iter->first);
+      continue;
+    }
+
+    max_ratio = std::max(max_ratio, max_stacked_sigma_t / max_sigma_t);
+  }
+
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed())
+    MPI_Allreduce(MPI_IN_PLACE, &max_ratio, 1, MPI_DOUBLE, MPI_MAX,
+                  _geometry->getMPICart());
+#endif
+  return max_ratio;
+}
+
+
+/**
+ * @brief Initializes new ExpEvaluator objects to compute exponentials.
+ * @details The segments are split so that the optical lengths of every
+ *          state, rather than those of the Materials of the Geometry, are
+ *          covered by the exponential interpolation tables.
+ */
+void CPUMultiStateSolver::initializeExpEvaluators() {
+
+  _max_sigma_t_ratio = computeMaxSigmaTRatio();
+
+  ExpEvaluator* first_evaluator = _exp_evaluators[0][0];
+  if (!first_evaluator->isUsingInterpolation()) {
+    CPUSolver::initializeExpEvaluators();
+    return;
+  }
+
+  /* Split the segments for the optical lengths of the Geometry's Materials
+   * scaled down by the largest ratio of the total cross sections */
+  first_evaluator->setMaxOpticalLength(first_evaluator->getMaxOpticalLength()
+                                       / _max_sigma_t_ratio);
+  CPUSolver::initializeExpEvaluators();
+
+  /* Extend the interpolation tables to the optical lengths of all states */
+  FP_PRECISION max_tau = first_evaluator->getMaxOpticalLength() *
+       _max_sigma_t_ratio;
+  for (int a=0; a < _num_exp_evaluators_azim; a++) {
+    for (int p=0; p < _num_exp_evaluators_polar; p++) {
+      _exp_evaluators[a][p]->setMaxOpticalLength(max_tau);
+      _exp_evaluators[a][p]->initialize(a, p, _solve_3D);
+    }
+  }
+}
+
+
+/**
+ * @brief Updates the Solver for new cross sections of the same Materials.
+ * @details The cross sections of all states are stacked again, and the
+ *          exponential evaluators are initialized again if the total cross
+ *          sections of a state increased relative to those of the Geometry.
+ */
+void CPUMultiStateSolver::updateCrossSections() {
+
+  checkStatesSupport();
+  stackStateMaterials();
+
+  CPUSolver::updateCrossSections();
+
+  if (computeMaxSigmaTRatio() > _max_sigma_t_ratio)
+    initializeExpEvaluators();
+}
+
+
+/**
+ * @brief Set the scalar flux of every state for each FSR to a chi spectrum.
+ */
+void CPUMultiStateSolver::flattenFSRFluxesChiSpectrum() {
+  if (_chi_spectrum_material == NULL)
+    log_printf(ERROR, "A flattening of the FSR fluxes for a chi spectrum was "
+               "requested but no chi spectrum material was set.");
+
+  FP_PRECISION* chi = _chi_spectrum_material->getChi();
+#pragma omp parallel for schedule(guided)
+  for (long r=0; r < _num_FSRs; r++) {
+    for (int e=0; e < _num_groups; e++)
+      _scalar_flux(r,e) = chi[e % _num_state_groups];
+  }
+}
+
+
+/**
+ * @brief Normalizes the FSR scalar fluxes and Track boundary angular fluxes
+ *        of each state to the total fission source of the state.
+ * @return the normalization factor of the first state
+ */
+double CPUMultiStateSolver::normalizeFluxes() {
+
+  double* int_fission_sources = _regionwise_scratch;
+  std::vector<double> tot_fission_sources(_num_states);
+
+  /* Compute the total fission source of each state */
+  for (int s=0; s < _num_states; s++) {
+
+    int first_group = s * _num_state_groups;
+
+#pragma omp parallel
+    {
+      int tid = omp_get_thread_num();
+      FP_PRECISION* group_fission_sources = _groupwise_scratch.at(tid);
+#pragma omp for schedule(guided)
+      for (long r=0; r < _num_FSRs; r++) {
+
+        FP_PRECISION* nu_sigma_f = _FSR_materials[r]->getNuSigmaF();
+        FP_PRECISION volume = _FSR_volumes[r];
+
+        for (int g=0; g < _num_state_groups; g++)
+          group_fission_sources[g] = nu_sigma_f[first_group+g] *
+               _scalar_flux(r,first_group+g) * volume;
+
+        int_fission_sources[r] = pairwise_sum<FP_PRECISION>(
+             group_fission_sources, _num_state_groups);
+      }
+    }
+
+    tot_fission_sources[s] = pairwise_sum<double>(int_fission_sources,
+                                                  _num_FSRs);
+  }
+
+  /* Get the total number of source regions */
+  long total_num_FSRs = _num_FSRs;
+
+#ifdef MPIx
+  /* Reduce total fission rates across domians */
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Comm comm = _geometry->getMPICart();
+    MPI_Allreduce(MPI_IN_PLACE, &tot_fission_sources[0], _num_states,
+                  MPI_DOUBLE, MPI_SUM, comm);
+    MPI_Allreduce(&_num_FSRs, &total_num_FSRs, 1, MPI_LONG, MPI_SUM, comm);
+  }
+#endif
+
+  /* Normalize scalar fluxes in each FSR */
+  std::vector<double> norm_factors(_num_states);
+  for (int s=0; s < _num_states; s++) {
+    norm_factors[s] = total_num_FSRs / tot_fission_sources[s];
+    log_printf(DEBUG, "State %d Tot. Fiss. Src. = %f, Norm. factor = %f", s,
+               tot_fission_sources[s], norm_factors[s]);
+  }
+
+#pragma omp parallel for schedule(guided)
+  for (long r=0; r < _num_FSRs; r++) {
+    for (int e=0; e < _num_groups; e++)
+      _scalar_flux(r, e) *= norm_factors[e / _num_state_groups];
+  }
+
+  /* Normalize angular boundary fluxes for each Track */
+#pragma omp parallel for schedule(guided)
+  for (long t=0; t < 2 * _tot_num_tracks; t++) {
+    for (int pe=0; pe < _fluxes_per_track; pe++) {
+      double norm_factor = norm_factors[(pe % _num_groups) / _num_state_groups];
+      _start_flux[t * _fluxes_per_track + pe] *= norm_factor;
+      _boundary_flux[t * _fluxes_per_track + pe] *= norm_factor;
+    }
+  }
+
+  return norm_factors[0];
+}
+
+
+/**
+ * @brief Lists the arrays of the Solver state saved in checkpoints.
+ * @details The eigenvalues of the states at the current and previous
+ *          iterations are saved in addition to the fluxes of all states.
+ * @param arrays the list of arrays to append to
+ */
+void CPUMultiStateSolver::getCheckpointArrays(
+     std::vector<SolverCheckpointArray>& arrays) {
+
+  CPUSolver::getCheckpointArrays(arrays);
+
+  SolverCheckpointArray state_arrays[2] = {
+    {SOLVER_SECTION_STATE_K_EFF, &_state_k_eff[0], sizeof(double),
+     _num_states},
+    {SOLVER_SECTION_PREVIOUS_STATE_K_EFF, &_state_k_prev[0], sizeof(double),
+     _num_states}};
+  arrays.insert(arrays.end(), state_arrays, state_arrays + 2);
+}
+
+
+/**
+ * @brief Computes the total source (fission, scattering, fixed) of each
+ *        state in each FSR.
+ * @details The fission source of each state is divided by the eigenvalue of
+ *          the state. The eigenvalues of all states are set to the
+ *          eigenvalue of the Solver when it was assigned, such as for the
+ *          initial guess. Restarts from a checkpoint restore the eigenvalues
+ *          of all states along with that of the Solver, which is the one of
+ *          the first state, so that they are kept.
+ * @param iteration the source iteration
+ */
+void CPUMultiStateSolver::computeFSRSources(int iteration) {
+
+  if (_k_eff != _state_k_eff[0]) {
+    _state_k_eff.assign(_num_states, _k_eff);
+    _state_k_prev.assign(_num_states, _k_eff);
+  }
+
+  long num_negative_sources = 0;
+
+  /* For all FSRs, find the source */
+#pragma omp parallel for schedule(guided)
+  for (long r=0; r < _num_FSRs; r++) {
+
+    int tid = omp_get_thread_num();
+    Material* material = _FSR_materials[r];
+    FP_PRECISION* nu_sigma_f = material->getNuSigmaF();
+    FP_PRECISION* chi = material->getChi();
+    FP_PRECISION* sigma_s = material->getSigmaS();
+    FP_PRECISION* group_sources = _groupwise_scratch.at(tid);
+
+    for (int s=0; s < _num_states; s++) {
+
+      int first_group = s * _num_state_groups;
+
+      /* Compute fission source of the state */
+      FP_PRECISION fission_source = 0.0;
+      if (material->isFissionable()) {
+        for (int g=0; g < _num_state_groups; g++)
+          group_sources[g] = _scalar_flux(r,first_group+g) *
+               nu_sigma_f[first_group+g];
+
+        fission_source = pairwise_sum<FP_PRECISION>(group_sources,
+                                                    _num_state_groups);
+        fission_source /= _state_k_eff[s];
+      }
+
+      /* Compute total (fission+scatter+fixed) source for each group of the
+       * state, which only scatters within the state */
+      for (int G=first_group; G < first_group + _num_state_groups; G++) {
+        int first_idx = G * _num_groups + first_group;
+        for (int g=0; g < _num_state_groups; g++)
+          group_sources[g] = sigma_s[first_idx+g] *
+               _scalar_flux(r,first_group+g);
+        double scatter_source =
+            pairwise_sum<FP_PRECISION>(group_sources, _num_state_groups);
+
+        _reduced_sources(r,G) = fission_source * chi[G];
+        _reduced_sources(r,G) += scatter_source + _fixed_sources(r,G);
+        _reduced_sources(r,G) *= ONE_OVER_FOUR_PI;
+
+        /* Correct negative sources to (near) zero */
+        if (_reduced_sources(r,G) < 0.0) {
+#pragma omp atomic
+          num_negative_sources++;
+          if (iteration < 30)
+            _reduced_sources(r,G) = 1.0e-20;
+        }
+      }
+    }
+  }
+
+  /* Tally the total number of negative source across the entire problem */
+  long total_num_negative_sources = num_negative_sources;
+  int num_negative_source_domains = (num_negative_sources > 0);
+  int total_num_negative_source_domains = num_negative_source_domains;
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Allreduce(&num_negative_sources, &total_num_negative_sources, 1,
+                  MPI_LONG, MPI_SUM, _geometry->getMPICart());
+    MPI_Allreduce(&num_negative_source_domains,
+                  &total_num_negative_source_domains, 1,
+                  MPI_INT, MPI_SUM, _geometry->getMPICart());
+  }
+#endif
+
+  /* Report negative sources */
+  if (total_num_negative_sources > 0) {
+    if (_geometry->isRootDomain()) {
+      log_printf(WARNING, "Computed %ld negative sources on %d domains",
+                 total_num_negative_sources,
+                 total_num_negative_source_domains);
+      if (iteration < 30)
+        log_printf(WARNING, "Negative sources corrected to zero");
+    }
+  }
+}
+
+
+/**
+ * @brief Compute the \f$ k_{eff} \f$ of each state from successive fission
+ *        sources.
+ * @details The eigenvalues are always computed from the fission sources,
+ *          since the leakage is not tallied by state.
+ */
+void CPUMultiStateSolver::computeKeff() {
+
+  double* FSR_rates = _regionwise_scratch;
+  std::vector<double> rates(_num_states);
+
+  /* Loop over all FSRs and compute the volume-integrated fission rates */
+  for (int s=0; s < _num_states; s++) {
+
+    int first_group = s * _num_state_groups;
+
+#pragma omp parallel for schedule(guided)
+    for (long r=0; r < _num_FSRs; r++) {
+
+      int tid = omp_get_thread_num();
+      FP_PRECISION* group_rates = _groupwise_scratch.at(tid);
+      FP_PRECISION* nu_sigma_f = _FSR_materials[r]->getNuSigmaF();
+
+      for (int g=0; g < _num_state_groups; g++)
+        group_rates[g] = nu_sigma_f[first_group+g] *
+             _scalar_flux(r,first_group+g);
+
+      FSR_rates[r] = pairwise_sum<FP_PRECISION>(group_rates,
+                                                _num_state_groups);
+      FSR_rates[r] *= _FSR_volumes[r];
+    }
+
+    /* Reduce new fission rates across FSRs */
+    rates[s] = pairwise_sum<double>(FSR_rates, _num_FSRs);
+  }
+
+  /* Get the total number of source regions */
+  long total_num_FSRs = _num_FSRs;
+
+#ifdef MPIx
+  /* Reduce rates across domians */
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Comm comm = _geometry->getMPICart();
+    MPI_Allreduce(MPI_IN_PLACE, &rates[0], _num_states, MPI_DOUBLE, MPI_SUM,
+                  comm);
+    MPI_Allreduce(&_num_FSRs, &total_num_FSRs, 1, MPI_LONG, MPI_SUM, comm);
+  }
+#endif
+
+  _state_k_prev = _state_k_eff;
+  for (int s=0; s < _num_states; s++) {
+    _state_k_eff[s] *= rates[s] / total_num_FSRs;
+    log_printf(DEBUG, "State %d k_eff = %1.6f", s, _state_k_eff[s]);
+  }
+  _k_eff = _state_k_eff[0];
+}
+
+
+/**
+ * @brief Computes the largest residual of the states between source/flux
+ *        iterations.
+ * @details The residual is kept from falling below the convergence threshold
+ *          until the eigenvalue of every state converged.
+ * @param res_type the type of residuals to compute
+ *        (SCALAR_FLUX, FISSION_SOURCE, TOTAL_SOURCE)
+ * @return the largest average residual in each FSR of the states
+ */
+double CPUMultiStateSolver::computeResidual(residualType res_type) {
+
+  double* residuals = _regionwise_scratch;
+  std::vector<double> state_residuals(_num_states);
+  std::vector<long> norms(_num_states);
+
+  FP_PRECISION* reference_flux = _old_scalar_flux;
+  if (_calculate_residuals_by_reference)
+    reference_flux = _reference_flux;
+
+  for (int s=0; s < _num_states; s++) {
+
+    int first_group = s * _num_state_groups;
+    int last_group = first_group + _num_state_groups;
+    memset(residuals, 0., _num_FSRs * sizeof(double));
+
+    if (res_type == SCALAR_FLUX) {
+
+      norms[s] = _num_FSRs;
+
+      for (long r=0; r < _num_FSRs; r++) {
+        for (int e=first_group; e < last_group; e++)
+          if (reference_flux(r,e) > 0.) {
+            residuals[r] += pow((_scalar_flux(r,e) - reference_flux(r,e)) /
+                                reference_flux(r,e), 2);
+        }
+      }
+    }
+
+    else {
+
+      norms[s] = _num_FSRs;
+      if (res_type == FISSION_SOURCE)
+        norms[s] = _num_fissionable_FSRs;
+
+      double inverse_k_eff = 1.0 / _state_k_eff[s];
+
+      for (long r=0; r < _num_FSRs; r++) {
+        double new_source = 0.;
+        double old_source = 0.;
+        Material* material = _FSR_materials[r];
+
+        if (material->isFissionable()) {
+          FP_PRECISION* nu_sigma_f = material->getNuSigmaF();
+
+          for (int e=first_group; e < last_group; e++) {
+            new_source += _scalar_flux(r,e) * nu_sigma_f[e];
+            old_source += reference_flux(r,e) * nu_sigma_f[e];
+          }
+
+          if (res_type == TOTAL_SOURCE) {
+            new_source *= inverse_k_eff;
+            old_source *= inverse_k_eff;
+          }
+        }
+
+        /* Compute total scattering source of the state */
+        if (res_type == TOTAL_SOURCE) {
+          FP_PRECISION* sigma_s = material->getSigmaS();
+          for (int G=first_group; G < last_group; G++) {
+            int first_idx = G * _num_groups;
+            for (int g=first_group; g < last_group; g++) {
+              new_source += sigma_s[first_idx+g] * _scalar_flux(r,g);
+              old_source += sigma_s[first_idx+g] * reference_flux(r,g);
+            }
+          }
+        }
+
+        if (old_source > 0.)
+          residuals[r] = pow((new_source - old_source) / old_source, 2);
+      }
+    }
+
+    /* Sum up the residuals from each FSR */
+    state_residuals[s] = pairwise_sum<double>(residuals, _num_FSRs);
+  }
+
+#ifdef MPIx
+  /* Reduce residuals and normalization factors across domains */
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Comm comm = _geometry->getMPICart();
+    MPI_Allreduce(MPI_IN_PLACE, &state_residuals[0], _num_states, MPI_DOUBLE,
+                  MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, &norms[0], _num_states, MPI_LONG, MPI_SUM,
+                  comm);
+  }
+#endif
+
+  if (res_type == FISSION_SOURCE && norms[0] == 0)
+      log_printf(ERROR, "The Solver is unable to compute a "
+                 "FISSION_SOURCE residual without fissionable FSRs");
+
+  /* Compute the RMS residual of each state and keep the largest */
+  double residual = 0.;
+  for (int s=0; s < _num_states; s++) {
+    if (state_residuals[s] < 0.0)
+      state_residuals[s] = 0.0;
+    if (norms[s] <= 0)
+      norms[s] = 1;
+    residual = std::max(residual, sqrt(state_residuals[s] / norms[s]));
+  }
+
+  /* Continue the source iteration until every eigenvalue converged */
+  for (int s=0; s < _num_states; s++) {
+    int dk = 1e5 * (_state_k_eff[s] - _state_k_prev[s]);
+    if (std::abs(dk) >= 1)
+      residual = std::max(residual, _converge_thresh);
+  }
+
+  return residual;
+}
+
+
+/**
+ * @brief A function that prints a summary of the input parameters
+ */
+void CPUMultiStateSolver::printInputParamsSummary() {
+
+  CPUSolver::printInputParamsSummary();
+
+  log_printf(NORMAL, "Number of states = %d", _num_states);
+}
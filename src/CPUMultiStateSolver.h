@@ -0,0 +1,89 @@
+/**
+ * @file CPUMultiStateSolver.h
+ * @brief The CPUMultiStateSolver class.
+ * @date October 18, 2026
+ */
+
+
+#ifndef CPUMULTISTATESOLVER_H_
+#define CPUMULTISTATESOLVER_H_
+
+#ifdef __cplusplus
+#define _USE_MATH_DEFINES
+#include "CPUSolver.h"
+#include <math.h>
+#include <omp.h>
+#include <stdlib.h>
+#endif
+
+
+/**
+ * @class CPUMultiStateSolver CPUMultiStateSolver.h
+ *        "src/CPUMultiStateSolver.h"
+ * @brief This a subclass of the CPUSolver class solving the eigenvalue
+ *        problems of several states of the Materials in the same sweeps.
+ * @details Each state replaces some of the Materials filling the Geometry by
+ *          Materials with other cross sections, as in cross section branch
+ *          calculations. The fluxes of all the states are transported along
+ *          each segment at once, so that the ray tracing and the loading of
+ *          the segments are shared between the states. The states are
+ *          stacked as energy groups, the fluxes being indexed by FSR, state
+ *          and energy group, and each state converges its own eigenvalue.
+ *          Segments are attenuated with the stacked Materials filling their
+ *          FSRs rather than with the Materials they were traced through.
+ */
+class CPUMultiStateSolver : public CPUSolver {
+
+protected:
+
+  /** The number of states */
+  int _num_states;
+
+  /** The number of energy groups of each state */
+  int _num_state_groups;
+
+  /** The Materials replaced in each state, indexed by Material ID */
+  std::vector<std::map<int, Material*> > _state_materials;
+
+  /** The Materials stacking the cross sections of all states, indexed by
+   *  Material ID */
+  std::map<int, Material*> _stacked_materials;
+
+  /** The eigenvalue of each state */
+  std::vector<double> _state_k_eff;
+
+  /** The eigenvalue of each state at the previous iteration */
+  std::vector<double> _state_k_prev;
+
+  /** The largest ratio between the total cross sections of a state and of
+   *  the Geometry's Material, by which the optical lengths are scaled */
+  double _max_sigma_t_ratio;
+
+  void initializeFSRs();
+  void initializeExpEvaluators();
+  void updateCrossSections();
+  void stackStateMaterials();
+  double computeMaxSigmaTRatio();
+  void checkStatesSupport();
+
+  void flattenFSRFluxesChiSpectrum();
+  double normalizeFluxes();
+  void computeFSRSources(int iteration);
+  void computeKeff();
+  double computeResidual(residualType res_type);
+  void getCheckpointArrays(std::vector<SolverCheckpointArray>& arrays);
+
+public:
+  CPUMultiStateSolver(TrackGenerator* track_generator=NULL);
+  virtual ~CPUMultiStateSolver();
+
+  void setNumStates(int num_states);
+  void setStateMaterial(int state, Material* material);
+  int getNumStates();
+  double getStateKeff(int state);
+  double getStateFlux(long fsr_id, int state, int group);
+  void printInputParamsSummary();
+};
+
+
+#endif /* CPUMULTISTATESOLVER_H_ */
@@ -145,6 +145,7 @@ void CPUSolver::setNumThreads(int num_threads) {
 
   if (_track_generator != NULL && num_threads > 1)
     if ((_track_generator->getSegmentFormation() == OTF_STACKS ||
+       _track_generator->getSegmentFormation() == HYBRID_STACKS ||
        _track_generator->getSegmentFormation() == OTF_TRACKS) &&
        _track_generator->getNumThreads() != num_threads)
       log_printf(WARNING, "The number of threads used in track generation (%d)"
@@ -1825,7 +1826,8 @@ void CPUSolver::transportSweep() {
  * @brief Computes the contribution to the FSR scalar flux from a Track segment.
  * @details This method integrates the angular flux for a Track segment across
  *          energy groups and polar angles, and tallies it into the FSR
- *          scalar flux, and updates the Track's angular flux.
+ *          scalar flux, and updates the Track's angular flux. The segment is
+ *          attenuated with the Material filling its FSR in the Solver.
  * @param curr_segment a pointer to the Track segment of interest
  * @param azim_index azimuthal angle index for this segment
  * @param polar_index polar angle index for this segment
@@ -1839,7 +1841,7 @@ void CPUSolver::tallyScalarFlux(segment* curr_segment,
 
   long fsr_id = curr_segment->_region_id;
   FP_PRECISION length = curr_segment->_length;
-  FP_PRECISION* sigma_t = curr_segment->_material->getSigmaT();
+  FP_PRECISION* sigma_t = _FSR_materials[fsr_id]->getSigmaT();
   ExpEvaluator* exp_evaluator = _exp_evaluators[azim_index][polar_index];
 
   if (_solve_3D) {
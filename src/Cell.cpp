@@ -78,6 +78,7 @@ Cell::Cell(int id, const char* name) {
   _cell_type = UNFILLED;
   _region = NULL;
   _current_region = NULL;
+  _compiled_region = NULL;
   _fill = NULL;
   _volume = 0.;
   _num_instances = 0;
@@ -92,6 +93,7 @@ Cell::Cell(int id, const char* name) {
   _num_rings = 0;
   _num_sectors = 0;
   _parent = NULL;
+  _bounds_valid = false;
 }
 
 
@@ -104,6 +106,23 @@ Cell::~Cell() {
     delete [] _name;
   if (_region != NULL)
     delete _region;
+  clearCompiledRegion();
+
+  /* Detach from the objects which invalidate or read the cached bounds */
+  std::set<Surface*>::iterator s_iter;
+  for (s_iter = _bounding_surfaces.begin(); s_iter != _bounding_surfaces.end();
+       ++s_iter)
+    (*s_iter)->removeBoundedCell(this);
+  if (_parent != NULL)
+    _parent->_dependent_cells.erase(this);
+  std::set<Cell*>::iterator c_iter;
+  for (c_iter = _dependent_cells.begin(); c_iter != _dependent_cells.end();
+       ++c_iter)
+    (*c_iter)->_parent = NULL;
+  std::set<Universe*> universes = _universes;
+  std::set<Universe*>::iterator u_iter;
+  for (u_iter = universes.begin(); u_iter != universes.end(); ++u_iter)
+    (*u_iter)->removeCell(this);
   /* Materials are deleted separately from cells, since multiple cells
       can share a same material */
   /* Universes are also deleted separately, since Universes can have been
@@ -381,20 +400,9 @@ int Cell::getNumSectors() {
  * @return the minimum x-coordinate
  */
 double Cell::getMinX() {
-
-  double min_x = -std::numeric_limits<double>::infinity();
-
-  /* Look in region for minimum */
-  if (_region != NULL)
-    min_x = _region->getMinX();
-
-  /* If region has an infinite min_x, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(min_x) == std::numeric_limits<double>::infinity())
-    min_x = getParent()->getMinX();
-
-  return min_x;
+  if (!_bounds_valid)
+    computeBounds();
+  return _min_x;
 }
 
 
@@ -403,20 +411,9 @@ double Cell::getMinX() {
  * @return the maximum x-coordinate
  */
 double Cell::getMaxX() {
-
-  double max_x = +std::numeric_limits<double>::infinity();
-
-  /* Look in region for maximum */
-  if (_region != NULL)
-    max_x = _region->getMaxX();
-
-  /* If region has an infinite max_x, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(max_x) == std::numeric_limits<double>::infinity())
-    max_x = getParent()->getMaxX();
-
-  return max_x;
+  if (!_bounds_valid)
+    computeBounds();
+  return _max_x;
 }
 
 
@@ -425,20 +422,9 @@ double Cell::getMaxX() {
  * @return the minimum y-coordinate
  */
 double Cell::getMinY() {
-
-  double min_y = -std::numeric_limits<double>::infinity();
-
-  /* Look in region for minimum */
-  if (_region != NULL)
-    min_y = _region->getMinY();
-
-  /* If region has an infinite min_y, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(min_y) == std::numeric_limits<double>::infinity())
-    min_y = getParent()->getMinY();
-
-  return min_y;
+  if (!_bounds_valid)
+    computeBounds();
+  return _min_y;
 }
 
 
@@ -447,20 +433,9 @@ double Cell::getMinY() {
  * @return the maximum y-coordinate
  */
 double Cell::getMaxY() {
-
-  double max_y = +std::numeric_limits<double>::infinity();
-
-  /* Look in region for maximum */
-  if (_region != NULL)
-    max_y = _region->getMaxY();
-
-  /* If region has an infinite max_y, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(max_y) == std::numeric_limits<double>::infinity())
-    max_y = getParent()->getMaxY();
-
-  return max_y;
+  if (!_bounds_valid)
+    computeBounds();
+  return _max_y;
 }
 
 
@@ -469,20 +444,9 @@ double Cell::getMaxY() {
  * @return the minimum z-coordinate
  */
 double Cell::getMinZ() {
-
-  double min_z = -std::numeric_limits<double>::infinity();
-
-  /* Look in region for minimum */
-  if (_region != NULL)
-    min_z = _region->getMinZ();
-
-  /* If region has an infinite min_z, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(min_z) == std::numeric_limits<double>::infinity())
-    min_z = getParent()->getMinZ();
-
-  return min_z;
+  if (!_bounds_valid)
+    computeBounds();
+  return _min_z;
 }
 
 
@@ -491,20 +455,90 @@ double Cell::getMinZ() {
  * @return the maximum z-coordinate
  */
 double Cell::getMaxZ() {
+  if (!_bounds_valid)
+    computeBounds();
+  return _max_z;
+}
 
-  double max_z = +std::numeric_limits<double>::infinity();
 
-  /* Look in region for maximum */
-  if (_region != NULL)
-    max_z = _region->getMaxZ();
+/**
+ * @brief Computes and caches the bounding box of the Cell.
+ * @details The Cell registers with the Surfaces, the Region and the parent
+ *          Cell the bounds are computed from, whose changes invalidate them.
+ */
+void Cell::computeBounds() {
+
+  double infinity = std::numeric_limits<double>::infinity();
+
+  /* Compute the bounds of the parent Cell first, since they may be needed
+     and Cells may compute their bounds concurrently */
+  Cell* parent = getParent();
+  if (parent != NULL)
+    parent->getMinX();
 
-  /* If region has an infinite max_z, it could be that some Halfspaces are only
-     kept in the Parent's region */
-  if (getParent() != NULL &&
-      std::abs(max_z) == std::numeric_limits<double>::infinity())
-    max_z = getParent()->getMaxZ();
+#pragma omp critical (cell_bounds)
+  {
+    if (!_bounds_valid) {
 
-  return max_z;
+      /* Look in region for the bounds */
+      if (_region != NULL) {
+        _min_x = _region->getMinX();
+        _max_x = _region->getMaxX();
+        _min_y = _region->getMinY();
+        _max_y = _region->getMaxY();
+        _min_z = _region->getMinZ();
+        _max_z = _region->getMaxZ();
+      }
+      else {
+        _min_x = -infinity;
+        _max_x = infinity;
+        _min_y = -infinity;
+        _max_y = infinity;
+        _min_z = -infinity;
+        _max_z = infinity;
+      }
+
+      /* If region has an infinite bound, it could be that some Halfspaces are
+         only kept in the Parent's region */
+      if (parent != NULL) {
+        if (std::abs(_min_x) == infinity)
+          _min_x = parent->getMinX();
+        if (std::abs(_max_x) == infinity)
+          _max_x = parent->getMaxX();
+        if (std::abs(_min_y) == infinity)
+          _min_y = parent->getMinY();
+        if (std::abs(_max_y) == infinity)
+          _max_y = parent->getMaxY();
+        if (std::abs(_min_z) == infinity)
+          _min_z = parent->getMinZ();
+        if (std::abs(_max_z) == infinity)
+          _max_z = parent->getMaxZ();
+        parent->_dependent_cells.insert(this);
+      }
+
+      /* Register with the Surfaces of the current Region only */
+      std::set<Surface*>::iterator s_iter;
+      for (s_iter = _bounding_surfaces.begin();
+           s_iter != _bounding_surfaces.end(); ++s_iter)
+        (*s_iter)->removeBoundedCell(this);
+      _bounding_surfaces.clear();
+
+      if (_region != NULL) {
+        _region->setCell(this);
+        std::map<int, Halfspace*> surfaces = _region->getAllSurfaces();
+        std::map<int, Halfspace*>::iterator iter;
+        for (iter = surfaces.begin(); iter != surfaces.end(); ++iter) {
+          Surface* surface = iter->second->getSurface();
+          surface->addBoundedCell(this);
+          _bounding_surfaces.insert(surface);
+        }
+      }
+
+      /* Publish the bounds only once they are all computed */
+      __sync_synchronize();
+      _bounds_valid = true;
+    }
+  }
 }
 
 
@@ -822,7 +856,11 @@ void Cell::setFill(Universe* fill) {
  * @param region the Region bounding the Cell
  */
 void Cell::setRegion(Region* region) {
+  if (_region != NULL)
+    _region->setCell(NULL);
   _region = region->clone();
+  clearCompiledRegion();
+  invalidateBounds();
 }
 
 
@@ -1000,7 +1038,10 @@ void Cell::setNumSectors(int num_sectors) {
  * @param parent a pointer to the parent Cell
  */
 void Cell::setParent(Cell* parent) {
+  if (_parent != NULL)
+    _parent->_dependent_cells.erase(this);
   _parent = parent;
+  invalidateBounds();
 }
 
 
@@ -1017,6 +1058,8 @@ void Cell::addSurface(int halfspace, Surface* surface) {
                " %d is not -1 or 1", surface->getId(), _id, halfspace);
 
   Halfspace* new_halfspace = new Halfspace(halfspace, surface);
+  clearCompiledRegion();
+  invalidateBounds();
 
   /* Assign the Halfspace as the Cell's Region if it has none */
   if (_region == NULL)
@@ -1043,6 +1086,8 @@ void Cell::addSurface(int halfspace, Surface* surface) {
  
    /* Create a new halfspace */
    Halfspace* new_halfspace = new Halfspace(halfspace, surface);
+  clearCompiledRegion();
+  invalidateBounds();
 
   /* Assign the Halfspace as the Cell's Region if it has none */
   if (_region == NULL)
@@ -1059,6 +1104,9 @@ void Cell::addSurface(int halfspace, Surface* surface) {
  */
 void Cell::removeSurface(Surface* surface) {
 
+  clearCompiledRegion();
+  invalidateBounds();
+
   //FIXME This map cannot be modified, it's a const
   std::map<int, Halfspace*> surfaces = getSurfaces();
   if (surface != NULL && surfaces.find(surface->getId()) != surfaces.end()) {
@@ -1076,7 +1124,9 @@ void Cell::removeSurface(Surface* surface) {
   * @param region_type the logical operation
   */
  void Cell::addLogicalNode(int region_type) {
- 
+
+  clearCompiledRegion();
+  invalidateBounds();
    /* Create new region if void */
    if (_region == NULL) {
      if (region_type == INTERSECTION) {
@@ -1137,6 +1187,58 @@ void Cell::addNeighborCell(Cell* cell) {
 }
 
 
+/**
+ * @brief Registers a Universe containing this Cell.
+ * @details The boundaries of the Universe are reset whenever the bounds of
+ *          the Cell are invalidated. Universes may be filled concurrently.
+ * @param universe a pointer to the Universe
+ */
+void Cell::addUniverse(Universe* universe) {
+#pragma omp critical (cell_universes)
+  _universes.insert(universe);
+}
+
+
+/**
+ * @brief Removes a Universe from the Universes containing this Cell.
+ * @param universe a pointer to the Universe
+ */
+void Cell::removeUniverse(Universe* universe) {
+#pragma omp critical (cell_universes)
+  _universes.erase(universe);
+}
+
+
+/**
+ * @brief Removes a Surface from the Surfaces the bounds were computed from.
+ * @details This is used by Surfaces being destroyed.
+ * @param surface a pointer to the Surface
+ */
+void Cell::removeBoundingSurface(Surface* surface) {
+  _bounding_surfaces.erase(surface);
+}
+
+
+/**
+ * @brief Invalidates the cached bounding box of the Cell.
+ * @details The bounds of the Cells cloned from this Cell and the boundaries
+ *          of the Universes containing it are invalidated as well.
+ */
+void Cell::invalidateBounds() {
+
+  _bounds_valid = false;
+
+  std::set<Universe*>::iterator u_iter;
+  for (u_iter = _universes.begin(); u_iter != _universes.end(); ++u_iter)
+    (*u_iter)->resetBoundaries();
+
+  std::set<Cell*>::iterator c_iter;
+  for (c_iter = _dependent_cells.begin(); c_iter != _dependent_cells.end();
+       ++c_iter)
+    (*c_iter)->invalidateBounds();
+}
+
+
 /**
  * @brief Determines whether a Point is contained inside a Cell.
  * @details Queries the Region bounding the Cell to determine if the Point
@@ -1162,7 +1264,9 @@ bool Cell::containsPoint(Point* point) {
       return true;
   }
 
-  /* If not, query the Cell's bounding Region */
+  /* If not, query the Cell's compiled or bounding Region */
+  else if (_compiled_region != NULL)
+    return _compiled_region->containsPoint(point);
   else
     return _region->containsPoint(point);
 }
@@ -1211,6 +1315,8 @@ double Cell::minSurfaceDist(LocalCoords* coords) {
 double Cell::minSurfaceDist(Point* point, double azim, double polar) {
   if (_region == NULL)
     return INFINITY;
+  else if (_compiled_region != NULL)
+    return _compiled_region->minSurfaceDist(point, azim, polar);
   else
     return _region->minSurfaceDist(point, azim, polar);
 }
@@ -1564,6 +1670,33 @@ void Cell::subdivideCell(double max_radius) {
 }
 
 
+/**
+ * @brief Lowers the Cell's Region into a flat program, used for the
+ *        point containment and distance queries during ray tracing.
+ * @details Regions with Surfaces other than Planes and ZCylinders are not
+ *          compiled and keep being evaluated through the Region tree. The
+ *          compiled Region is discarded whenever the Region is modified
+ *          through the Cell.
+ */
+void Cell::compileRegion() {
+
+  clearCompiledRegion();
+
+  if (_region != NULL && CompiledRegion::isCompilable(_region))
+    _compiled_region = new CompiledRegion(_region);
+}
+
+
+/**
+ * @brief Discards the compiled Region.
+ */
+void Cell::clearCompiledRegion() {
+  if (_compiled_region != NULL)
+    delete _compiled_region;
+  _compiled_region = NULL;
+}
+
+
 /**
  * @brief Build a collection of neighboring Cells for optimized ray tracing.
  */
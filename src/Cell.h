@@ -18,6 +18,7 @@
 #include "Surface.h"
 #include "Point.h"
 #include <limits>
+#include <set>
 #include <string>
 #endif
 
@@ -26,6 +27,7 @@ class Universe;
 class Surface;
 class Region;
 class Halfspace;
+class CompiledRegion;
 
 int cell_id();
 void reset_cell_id();
@@ -81,6 +83,9 @@ private:
   /** A pointer to the Region currently examined while transfering geometry */
   Region* _current_region;
 
+  /** A flat program evaluating the Region, NULL if not compiled */
+  CompiledRegion* _compiled_region;
+
   /** The volume / area of the Cell computed from overlapping segments */
   double _volume;
 
@@ -111,11 +116,33 @@ private:
   /** A parent Cell if cloned by another Cell */
   Cell* _parent;
 
+  /** The cached bounding box of the Cell */
+  double _min_x;
+  double _max_x;
+  double _min_y;
+  double _max_y;
+  double _min_z;
+  double _max_z;
+
+  /** A boolean indicating whether the cached bounding box is up to date */
+  volatile bool _bounds_valid;
+
+  /** The Surfaces the bounding box was computed from */
+  std::set<Surface*> _bounding_surfaces;
+
+  /** The Cells whose bounding boxes were computed from this Cell's */
+  std::set<Cell*> _dependent_cells;
+
+  /** The Universes containing this Cell */
+  std::set<Universe*> _universes;
+
   /* Vector of neighboring Cells */
   std::vector<Cell*> _neighbors;
 
   void ringify(std::vector<Cell*>& subcells, double max_radius);
   void sectorize(std::vector<Cell*>& subcells);
+  void clearCompiledRegion();
+  void computeBounds();
 
 public:
   Cell(int id=0, const char* name="");
@@ -184,6 +211,10 @@ public:
   void goUpOneRegionLogical();
   void removeSurface(Surface* surface);
   void addNeighborCell(Cell* cell);
+  void addUniverse(Universe* universe);
+  void removeUniverse(Universe* universe);
+  void removeBoundingSurface(Surface* surface);
+  void invalidateBounds();
 
   bool isFissionable();
   bool containsPoint(Point* point);
@@ -194,6 +225,7 @@ public:
   Cell* clone(bool clone_region=true);
   void subdivideCell(double max_radius);
   void buildNeighbors();
+  void compileRegion();
 
   std::string toString();
   void printString();
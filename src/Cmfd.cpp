@@ -84,6 +84,9 @@ Cmfd::Cmfd() {
   _backup_cmfd = NULL;
   _cmfd_group_to_backup_group = NULL;
   _backup_group_structure.resize(0);
+  _flat_cell_fsrs = NULL;
+  _flat_cell_fsr_offsets = NULL;
+  _flat_cell_fsrs_valid = false;
 
   /* Initialize boundaries to be reflective */
   _boundaries = new boundaryType[6];
@@ -176,6 +179,12 @@ Cmfd::~Cmfd() {
     iter1->clear();
   _cell_fsrs.clear();
 
+  /* Delete the flat CMFD cell FSR layout */
+  if (_flat_cell_fsrs != NULL)
+    delete [] _flat_cell_fsrs;
+  if (_flat_cell_fsr_offsets != NULL)
+    delete [] _flat_cell_fsr_offsets;
+
   /* Clear the _k_nearest_stencils map of vectors */
   std::map<int, std::vector< std::pair<int, double> > >::iterator iter2;
   for (iter2 = _k_nearest_stencils.begin(); iter2 != _k_nearest_stencils.end();
@@ -341,6 +350,44 @@ Vector* Cmfd::getLocalCurrents() {
 }
 
 
+/**
+ * @brief Get the Vector of fluxes at the beginning of the last CMFD solve.
+ * @return pointer to a vector containing the old CMFD fluxes.
+ */
+Vector* Cmfd::getOldFlux() {
+  return _old_flux;
+}
+
+
+/**
+ * @brief Get the Vector of corrected surface diffusion coefficients from the
+ *        previous iteration.
+ * @return pointer to a vector containing the old corrected coefficients.
+ */
+Vector* Cmfd::getOldDifSurfCorr() {
+  return _old_dif_surf_corr;
+}
+
+
+/**
+ * @brief Returns whether the old corrected surface diffusion coefficients
+ *        have been set.
+ * @return whether the old corrected diffusion coefficients are valid
+ */
+bool Cmfd::isOldDifSurfValid() {
+  return _old_dif_surf_valid;
+}
+
+
+/**
+ * @brief Get the value of the k effective of the CMFD solver.
+ * @return the k effective of the last CMFD solve
+ */
+double Cmfd::getKeff() {
+  return _k_eff;
+}
+
+
 /**
  * @brief Get the array of surface currents on the boundaries.
  * @return 3D array containing the boundary surface currents.
@@ -515,132 +562,131 @@ void Cmfd::collapseXS() {
     communicateSplits(true);
 #endif
 
-#pragma omp parallel
-  {
-
-    /* Initialize variables for FSR properties*/
-    FP_PRECISION volume, flux;
-    FP_PRECISION tot, nu_fis, chi;
-    FP_PRECISION* scat;
-
-    //TODO Optimize : use groupwise scratches rather than allocate array
-    double* scat_tally = new double[_num_cmfd_groups]();
-    double* chi_tally = new double[_num_cmfd_groups]();
+  /* Rebuild the flat FSR layout if the CMFD cell FSR lists have changed */
+  if (!_flat_cell_fsrs_valid)
+    initializeFlatCellFSRs();
 
-    /* Pointers to material objects */
-    Material* fsr_material;
-    Material* cell_material;
-
-    /* Loop over CMFD cells */
-#pragma omp for
-    for (int i = 0; i < _local_num_xn * _local_num_yn * _local_num_zn; i++) {
+  int num_cells = _local_num_xn * _local_num_yn * _local_num_zn;
+  int nmg = _num_moc_groups;
+  int ncg = _num_cmfd_groups;
 
-      std::vector<long>::iterator iter;
-      cell_material = _materials[i];
+#pragma omp parallel
+  {
 
-      /* Zero group-wise fission terms */
+    /* Allocate thread-private scratch tallies for a single CMFD cell. These
+     * are indexed by MOC group so that the FSR loops vectorize, and are
+     * condensed to the CMFD group structure once per CMFD cell. */
+    double* scratch = new double[5 * nmg + nmg * nmg + ncg * ncg];
+    double* flux_volume = scratch;
+    double* rxn_tally_group = flux_volume + nmg;
+    double* trans_tally_group = rxn_tally_group + nmg;
+    double* nu_fis_tally_group = trans_tally_group + nmg;
+    double* chi_tally_group = nu_fis_tally_group + nmg;
+    double* scat_tally_group = chi_tally_group + nmg;
+    double* scat_tally = scat_tally_group + nmg * nmg;
+
+    /* Loop over contiguous ranges of CMFD cells, each thread owning the
+     * tallies of its cells so that no locking is required */
+#pragma omp for schedule(static)
+    for (int i = 0; i < num_cells; i++) {
+
+      Material* cell_material = _materials[i];
+
+      /* Zero the MOC group-wise tallies */
+      for (int h = 0; h < 5 * nmg + nmg * nmg + ncg * ncg; h++)
+        scratch[h] = 0.0;
+      double volume_tally = 0.0;
       double neutron_production_tally = 0.0;
-      for (int e = 0; e < _num_cmfd_groups; e++)
-        chi_tally[e] = 0.0;
-
-      /* Loop over FSRs in CMFD cell */
-      for (iter = _cell_fsrs.at(i).begin();
-           iter != _cell_fsrs.at(i).end(); ++iter) {
 
-        fsr_material = _FSR_materials[*iter];
-        volume = _FSR_volumes[*iter];
+      /* Loop over the FSRs of this CMFD cell in the flat layout */
+      for (long j = _flat_cell_fsr_offsets[i];
+           j < _flat_cell_fsr_offsets[i+1]; j++) {
 
-        /* Calculate total neutron production in the FSR */
-        double neutron_production = 0.0;
-        for (int h = 0; h < _num_moc_groups; h++)
-          neutron_production += fsr_material->getNuSigmaFByGroup(h+1) *
-              _FSR_fluxes[(*iter)*_num_moc_groups+h] * volume;
+        /* Gets FSR volume, flux, and cross sections */
+        long fsr_id = _flat_cell_fsrs[j];
+        Material* fsr_material = _FSR_materials[fsr_id];
+        FP_PRECISION volume = _FSR_volumes[fsr_id];
+        FP_PRECISION* flux = &_FSR_fluxes[fsr_id * nmg];
+        FP_PRECISION* sigma_t = fsr_material->getSigmaT();
+        FP_PRECISION* nu_sigma_f = fsr_material->getNuSigmaF();
+        FP_PRECISION* chi = fsr_material->getChi();
+        FP_PRECISION* scat = fsr_material->getSigmaS();
 
-        /* Calculate contribution to all CMFD groups */
-        for (int e=0; e < _num_cmfd_groups; e++) {
-          chi = 0;
-          for (int h = _group_indices[e]; h < _group_indices[e + 1]; h++)
-            chi += fsr_material->getChiByGroup(h+1);
+        volume_tally += volume;
 
-          chi_tally[e] += chi * neutron_production;
+        /* Increment reaction rate tallies and the FSR neutron production */
+        double neutron_production = 0.0;
+#pragma omp simd reduction(+:neutron_production)
+        for (int h = 0; h < nmg; h++) {
+          double fv = flux[h] * volume;
+          flux_volume[h] = fv;
+          rxn_tally_group[h] += fv;
+          trans_tally_group[h] += sigma_t[h] * fv;
+          nu_fis_tally_group[h] += nu_sigma_f[h] * fv;
+          neutron_production += nu_sigma_f[h] * fv;
         }
 
+        /* Increment fission spectrum tallies */
+#pragma omp simd
+        for (int h = 0; h < nmg; h++)
+          chi_tally_group[h] += chi[h] * neutron_production;
+
         /* Add to total neutron production within the CMFD cell */
         neutron_production_tally += neutron_production;
+
+        /* Increment scattering tallies from each MOC group g to group h */
+        for (int g = 0; g < nmg; g++) {
+          double* scat_tally_g = &scat_tally_group[g * nmg];
+          FP_PRECISION* scat_g = &scat[g * nmg];
+#pragma omp simd
+          for (int h = 0; h < nmg; h++)
+            scat_tally_g[h] += scat_g[h] * flux_volume[h];
+        }
       }
 
       /* Set chi */
-      if (fabs(neutron_production_tally) > FLT_EPSILON) {
+      for (int e = 0; e < ncg; e++) {
+        double chi_tally = 0.0;
+        for (int h = _group_indices[e]; h < _group_indices[e+1]; h++)
+          chi_tally += chi_tally_group[h];
 
-        /* Calculate group-wise fission contriubtions */
-        for (int e=0; e < _num_cmfd_groups; e++)
-          cell_material->setChiByGroup(chi_tally[e] / neutron_production_tally,
+        if (fabs(neutron_production_tally) > FLT_EPSILON)
+          cell_material->setChiByGroup(chi_tally / neutron_production_tally,
                                        e + 1);
-      }
-      else {
-        /* Calculate group-wise chi to zero */
-        for (int e=0; e < _num_cmfd_groups; e++)
+        else
           cell_material->setChiByGroup(0.0, e + 1);
       }
 
+      /* Condense the scattering tallies onto the CMFD group structure */
+      for (int g = 0; g < nmg; g++) {
+        double* scat_tally_g = &scat_tally[getCmfdGroup(g) * ncg];
+        for (int e = 0; e < ncg; e++)
+          for (int h = _group_indices[e]; h < _group_indices[e+1]; h++)
+            scat_tally_g[e] += scat_tally_group[g * nmg + h];
+      }
+
       /* Loop over CMFD coarse energy groups */
-      for (int e = 0; e < _num_cmfd_groups; e++) {
+      for (int e = 0; e < ncg; e++) {
 
-        /* Zero tallies for this group */
         double nu_fission_tally = 0.0;
         double total_tally = 0.0;
-
         _diffusion_tally[i][e] = 0.0;
         _reaction_tally[i][e] = 0.0;
-        _volume_tally[i][e] = 0.0;
-
-        /* Zero each group-to-group scattering tally */
-        for (int g = 0; g < _num_cmfd_groups; g++)
-          scat_tally[g] = 0.0;
+        _volume_tally[i][e] = volume_tally;
 
         /* Loop over MOC energy groups within this CMFD coarse group */
         for (int h = _group_indices[e]; h < _group_indices[e+1]; h++) {
 
-          /* Reset volume tally for this MOC group */
-          _volume_tally[i][e] = 0.0;
-          double rxn_tally_group = 0.0;
-          double trans_tally_group = 0.0;
-
-          /* Loop over FSRs in CMFD cell */
-          for (iter = _cell_fsrs.at(i).begin();
-               iter != _cell_fsrs.at(i).end(); ++iter) {
-
-            /* Gets FSR volume, material, and cross sections */
-            fsr_material = _FSR_materials[*iter];
-            volume = _FSR_volumes[*iter];
-            scat = fsr_material->getSigmaS();
-            flux = _FSR_fluxes[(*iter)*_num_moc_groups+h];
-            tot = fsr_material->getSigmaTByGroup(h+1);
-            nu_fis = fsr_material->getNuSigmaFByGroup(h+1);
-
-            /* Increment tallies for this group */
-            total_tally += tot * flux * volume;
-            nu_fission_tally += nu_fis * flux * volume;
-            _reaction_tally[i][e] += flux * volume;
-            _volume_tally[i][e] += volume;
-
-            /* Increment diffusion MOC group-wise tallies */
-            rxn_tally_group += flux * volume;
-            trans_tally_group += tot * flux * volume;
-
-            /* Scattering tallies */
-            for (int g = 0; g < _num_moc_groups; g++) {
-              scat_tally[getCmfdGroup(g)] +=
-                  scat[g*_num_moc_groups+h] * flux * volume;
-            }
-          }
-          if (fabs(rxn_tally_group) > FLT_EPSILON && 
-              fabs(trans_tally_group) > FLT_EPSILON) {
-            CMFD_PRECISION flux_avg_sigma_t = trans_tally_group /
-                rxn_tally_group;
-//why times rxn_tally_group here and divided by _reaction_tally[cmfd_cell][group]
-//in getDiffusionCoefficient?
-            _diffusion_tally[i][e] += rxn_tally_group / 
+          total_tally += trans_tally_group[h];
+          nu_fission_tally += nu_fis_tally_group[h];
+          _reaction_tally[i][e] += rxn_tally_group[h];
+
+          /* Increment diffusion tallies with the flux-averaged sigma-t */
+          if (fabs(rxn_tally_group[h]) > FLT_EPSILON &&
+              fabs(trans_tally_group[h]) > FLT_EPSILON) {
+            CMFD_PRECISION flux_avg_sigma_t = trans_tally_group[h] /
+                rxn_tally_group[h];
+            _diffusion_tally[i][e] += rxn_tally_group[h] /
                 (3.0 * flux_avg_sigma_t);
           }
         }
@@ -660,15 +706,14 @@ void Cmfd::collapseXS() {
         cell_material->setNuSigmaFByGroup(nu_fission_tally / rxn_tally, e + 1);
 
         /* Set scattering xs */
-        for (int g = 0; g < _num_cmfd_groups; g++) {
-          cell_material->setSigmaSByGroup(scat_tally[g] / rxn_tally, e + 1,
-                                          g + 1);
+        for (int g = 0; g < ncg; g++) {
+          cell_material->setSigmaSByGroup(scat_tally[g * ncg + e] / rxn_tally,
+                                          e + 1, g + 1);
         }
       }
     }
-    
-    delete[] chi_tally;
-    delete[] scat_tally;
+
+    delete [] scratch;
   }
 
 #ifdef MPIx
@@ -732,6 +777,48 @@ void Cmfd::collapseXS() {
 
 
 
+/**
+ * @brief Builds the flat layout of the FSRs contained in each CMFD cell.
+ * @details The FSR IDs of all local CMFD cells are copied from _cell_fsrs into
+ *          a single contiguous array, grouped by CMFD cell and sorted by FSR
+ *          ID within each cell, with a CSR-style offset array marking the
+ *          start of each cell. The cross-section collapse then streams
+ *          through FSR data in increasing memory order.
+ */
+void Cmfd::initializeFlatCellFSRs() {
+
+  int num_cells = _local_num_xn * _local_num_yn * _local_num_zn;
+
+  if ((int) _cell_fsrs.size() < num_cells)
+    log_printf(ERROR, "Unable to build the flat CMFD cell FSR layout since "
+               "only %d of %d CMFD cells have FSR lists",
+               (int) _cell_fsrs.size(), num_cells);
+
+  /* Compute the offsets of each CMFD cell */
+  if (_flat_cell_fsr_offsets != NULL)
+    delete [] _flat_cell_fsr_offsets;
+  _flat_cell_fsr_offsets = new long[num_cells+1];
+  _flat_cell_fsr_offsets[0] = 0;
+  for (int i = 0; i < num_cells; i++)
+    _flat_cell_fsr_offsets[i+1] = _flat_cell_fsr_offsets[i] +
+        _cell_fsrs.at(i).size();
+
+  /* Copy and sort the FSR IDs of each CMFD cell */
+  if (_flat_cell_fsrs != NULL)
+    delete [] _flat_cell_fsrs;
+  _flat_cell_fsrs = new long[_flat_cell_fsr_offsets[num_cells]];
+
+#pragma omp parallel for schedule(guided)
+  for (int i = 0; i < num_cells; i++) {
+    long* cell_fsrs = &_flat_cell_fsrs[_flat_cell_fsr_offsets[i]];
+    std::copy(_cell_fsrs.at(i).begin(), _cell_fsrs.at(i).end(), cell_fsrs);
+    std::sort(cell_fsrs, cell_fsrs + _cell_fsrs.at(i).size());
+  }
+
+  _flat_cell_fsrs_valid = true;
+}
+
+
 /**
  * @brief Computes the diffusion coefficient for a given CMFD cell and CMFD
  *        energy group.
@@ -950,9 +1037,16 @@ double Cmfd::computeKeff(int moc_iteration) {
   _timer->stopTimer();
   _timer->recordSplit("Total collapse time");
 
+  /* Start recording matrix construction time */
+  _timer->startTimer();
+
   /* Construct matrices */
   constructMatrices(moc_iteration);
 
+  /* Tally the matrix construction time */
+  _timer->stopTimer();
+  _timer->recordSplit("Total matrix construction time");
+
   /* Check neutron balance if requested */
   if (_check_neutron_balance)
     checkNeutronBalance();
@@ -1529,6 +1623,7 @@ void Cmfd::initializeCellMap() {
         _cell_fsrs.push_back(std::vector<long>());
     }
   }
+  _flat_cell_fsrs_valid = false;
 }
 
 
@@ -1688,6 +1783,7 @@ Lattice* Cmfd::getLattice() {
  */
 void Cmfd::addFSRToCell(int cmfd_cell, long fsr_id) {
   _cell_fsrs.at(cmfd_cell).push_back(fsr_id);
+  _flat_cell_fsrs_valid = false;
 }
 
 
@@ -2304,6 +2400,9 @@ int Cmfd::convertGlobalFSRIdToCmfdCell(long global_fsr_id) {
  * @return Vector of vectors containing FSR IDs in each cell.
  */
 std::vector< std::vector<long> >* Cmfd::getCellFSRs() {
+
+  /* The caller may modify the FSR lists, so the flat layout is rebuilt */
+  _flat_cell_fsrs_valid = false;
   return &_cell_fsrs;
 }
 
@@ -2323,6 +2422,7 @@ void Cmfd::setCellFSRs(std::vector< std::vector<long> >* cell_fsrs) {
   }
 
   _cell_fsrs = *cell_fsrs;
+  _flat_cell_fsrs_valid = false;
 }
 
 
@@ -3773,6 +3873,16 @@ void Cmfd::setKeff(double k_eff) {
 }
 
 
+/**
+ * @brief Sets whether the old corrected surface diffusion coefficients have
+ *        been set, such as when they are restored from a checkpoint.
+ * @param old_dif_surf_valid whether the old corrected coefficients are valid
+ */
+void Cmfd::setOldDifSurfValid(bool old_dif_surf_valid) {
+  _old_dif_surf_valid = old_dif_surf_valid;
+}
+
+
 /**
  * @brief Set the backup CMFD solver's group structure. It is necessarily
  *        coarser than and must align with the regular CMFD group structure.
@@ -3841,6 +3951,12 @@ void Cmfd::printTimerReport() {
   msg_string.resize(53, '.');
   log_printf(RESULT, "%s%1.4E sec", msg_string.c_str(), xs_collapse_time);
 
+  /* Get the total matrix construction time */
+  double matrix_time = _timer->getSplit("Total matrix construction time");
+  msg_string = "Total CMFD matrix construction time";
+  msg_string.resize(53, '.');
+  log_printf(RESULT, "%s%1.4E sec", msg_string.c_str(), matrix_time);
+
   /* Get the MPI communication time */
   double comm_time = _timer->getSplit("CMFD MPI communication time");
   msg_string = "CMFD MPI communication time";
@@ -3852,6 +3968,20 @@ void Cmfd::printTimerReport() {
   msg_string = "Total CMFD solver time";
   msg_string.resize(53, '.');
   log_printf(RESULT, "%s%1.4E sec", msg_string.c_str(), solver_time);
+
+  /* Report the share of the CMFD time spent in each component */
+  if (tot_time > 0.0) {
+    std::string names[3] = {"XS collapse share of CMFD time",
+                            "Matrix construction share of CMFD time",
+                            "Solver share of CMFD time"};
+    double times[3] = {xs_collapse_time, matrix_time, solver_time};
+    for (int i=0; i < 3; i++) {
+      msg_string = names[i];
+      msg_string.resize(53, '.');
+      log_printf(RESULT, "%s%6.2f %%", msg_string.c_str(),
+                 100. * times[i] / tot_time);
+    }
+  }
 }
 
 
@@ -227,6 +227,17 @@ private:
   /** Vector of vectors of FSRs containing in each cell */
   std::vector< std::vector<long> > _cell_fsrs;
 
+  /** FSR IDs of all local CMFD cells stored contiguously, grouped by CMFD
+   *  cell and sorted by FSR ID within each cell */
+  long* _flat_cell_fsrs;
+
+  /** Offset of the first FSR of each CMFD cell in _flat_cell_fsrs, with one
+   *  trailing entry holding the total number of FSRs */
+  long* _flat_cell_fsr_offsets;
+
+  /** Whether the flat FSR layout is consistent with _cell_fsrs */
+  bool _flat_cell_fsrs_valid;
+
   /** Pointer to Lattice object representing the CMFD mesh */
   Lattice* _lattice;
 
@@ -342,6 +353,7 @@ private:
                                          CMFD_PRECISION delta);
   void constructMatrices(int moc_iteration);
   void collapseXS();
+  void initializeFlatCellFSRs();
   void updateMOCFlux();
   void rescaleFlux();
   void splitVertexCurrents();
@@ -422,6 +434,10 @@ public:
   int getNumY();
   int getNumZ();
   Vector* getLocalCurrents();
+  Vector* getOldFlux();
+  Vector* getOldDifSurfCorr();
+  bool isOldDifSurfValid();
+  double getKeff();
   CMFD_PRECISION*** getBoundarySurfaceCurrents();
   int convertFSRIdToCmfdCell(long fsr_id);
   int convertGlobalFSRIdToCmfdCell(long global_fsr_id);
@@ -455,6 +471,7 @@ public:
   void setPolarSpacings(double** polar_spacings, int num_azim,
                         int num_polar);
   void setKeff(double k_eff);
+  void setOldDifSurfValid(bool old_dif_surf_valid);
   void setBackupGroupStructure(std::vector< std::vector<int> > group_indices);
 
 #ifdef MPIx
@@ -0,0 +1,578 @@
+/**
+ * @file ConcurrentHashMap.h
+ * @brief A lock-free hash map supporting insertion and lookup operations
+ * @details The concurrent hash map uses open addressing with linear probing
+ *    into a flat array of slots, compare-and-swap based insertions and
+ *    cooperative, incremental resizing. It is intended for fixed-size,
+ *    trivially copyable keys such as the FSRKey.
+ * @date October 18, 2026
+ */
+
+#ifndef __CONCURRENT_HASH_MAP__
+#define __CONCURRENT_HASH_MAP__
+#include<iostream>
+#include<stdexcept>
+#include<functional>
+#include<omp.h>
+
+#include "log.h"
+
+
+/**
+ * @class ConcurrentHashMap ConcurrentHashMap.h "src/ConcurrentHashMap.h"
+ * @brief A lock-free hash map supporting insertion and lookup operations
+ * @details The ConcurrentHashMap class offers the same interface as the
+ *    ParallelHashMap class, supporting insertion and lookup operations but
+ *    not deletion as deletion is not needed in the OpenMOC application.
+ *    Keys and values are stored inline in a single array of slots, so that
+ *    no memory is allocated per insertion. Each slot carries a state which
+ *    is claimed with an atomic compare-and-swap, so that neither lookups nor
+ *    insertions take any lock.
+ *
+ *    When the table becomes half full, a table of twice the size is
+ *    allocated and the slots of the old table are migrated in chunks by all
+ *    threads which attempt to insert, while lookups proceed without
+ *    blocking in both tables. Old tables are kept until the map is cleared
+ *    or destroyed, since other threads may still be reading them. Their
+ *    total size is bounded by the size of the current table.
+ */
+template <class K, class V>
+class ConcurrentHashMap {
+
+  /* The states of each slot in a table */
+  enum slotState {
+    EMPTY,    /* slot has never been used */
+    BUSY,     /* slot key or value is being written */
+    FULL,     /* slot contains a key and its value */
+    MOVING,   /* slot is being copied to the next table */
+    MOVED,    /* slot was copied to the next table, key is retained */
+    SEALED    /* slot was empty when its table was migrated */
+  };
+
+  /* A slot containing a key and its value */
+  struct slot {
+    volatile int state;
+    K key;
+    V volatile value;
+  };
+
+  /* A fixed-size table of slots, linked to the table it is migrated to */
+  struct table {
+    table(size_t M) : _M(M), _next(NULL), _cursor(0), _migrated(0) {
+      _slots = new slot[_M];
+      for (size_t i=0; i<_M; i++)
+        _slots[i].state = EMPTY;
+    }
+    ~table() { delete [] _slots; }
+    size_t _M;
+    slot* _slots;
+    table* volatile _next;
+    volatile size_t _cursor;
+    volatile size_t _migrated;
+  };
+
+  /* The outcomes of an insertion attempt into a single table */
+  enum insertResult {
+    INSERTED,
+    PRESENT,
+    RETRY
+  };
+
+  private:
+    table* volatile _table;
+    table* _first_table;
+    volatile size_t _N;
+    bool _fixed_size;
+
+    /* The number of slots migrated at once by a thread */
+    static const size_t _chunk_size = 1024;
+
+    static size_t roundSize(size_t M);
+    insertResult tryInsert(table* t, K& key, V value);
+    slot* find(K& key);
+    void startResize(table* t);
+    void helpMigrate(table* t);
+    void migrateSlot(table* t, size_t i);
+    void deleteTables();
+
+  public:
+    ConcurrentHashMap(size_t M = 64);
+    virtual ~ConcurrentHashMap();
+    bool contains(K& key);
+    V at(K& key);
+    void update(K& key, V value);
+    void insert(K key, V value);
+    long insert_and_get_count(K key, V value);
+    size_t size();
+    size_t bucket_count();
+    K* keys();
+    V* values();
+    void clear();
+    void setFixedSize();
+    void realloc(size_t M);
+};
+
+
+/**
+ * @brief Constructor initializes a table of empty slots.
+ * @param M initial number of slots, rounded up to a power of 2
+ */
+template <class K, class V>
+ConcurrentHashMap<K,V>::ConcurrentHashMap(size_t M) {
+  _table = new table(roundSize(M));
+  _first_table = _table;
+  _N = 0;
+  _fixed_size = false;
+}
+
+
+/**
+ * @brief Destructor deletes the current table and all migrated tables.
+ */
+template <class K, class V>
+ConcurrentHashMap<K,V>::~ConcurrentHashMap() {
+  deleteTables();
+}
+
+
+/**
+ * @brief Rounds a table size up to the nearest power of 2.
+ * @param M the requested table size
+ * @return the table size
+ */
+template <class K, class V>
+size_t ConcurrentHashMap<K,V>::roundSize(size_t M) {
+
+  if (M < 2)
+    M = 2;
+
+  if ((M & (M-1)) != 0) {
+    M--;
+    for (size_t i = 1; i < 8 * sizeof(size_t); i*=2)
+      M |= M >> i;
+    M++;
+  }
+  return M;
+}
+
+
+/**
+ * @brief Deletes the chain of tables, from the first allocated one.
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::deleteTables() {
+  table* t = _first_table;
+  while (t != NULL) {
+    table* next = t->_next;
+    delete t;
+    t = next;
+  }
+  _first_table = NULL;
+  _table = NULL;
+}
+
+
+/**
+ * @brief Finds the slot holding a key, following migrated tables.
+ * @details Slots being written are waited upon. Probing stops at the first
+ *          empty slot, since keys are never deleted. A sealed slot marks the
+ *          end of the probe sequence of a migrated table, in which case the
+ *          search continues in the next table.
+ * @param key key to be searched
+ * @return the slot containing the key or NULL if the key is not present
+ */
+template <class K, class V>
+typename ConcurrentHashMap<K,V>::slot* ConcurrentHashMap<K,V>::find(K& key) {
+
+  size_t key_hash = std::hash<K>()(key);
+  table* t = _table;
+
+  while (t != NULL) {
+
+    size_t mask = t->_M - 1;
+    size_t i = key_hash & mask;
+    table* next_table = NULL;
+
+    for (size_t probe=0; probe < t->_M; probe++) {
+
+      slot* s = &t->_slots[i];
+      int state = s->state;
+
+      /* Wait for slots which are being written or moved */
+      while (state == BUSY || state == MOVING) {
+        state = s->state;
+        __sync_synchronize();
+      }
+
+      if (state == EMPTY)
+        return NULL;
+
+      if (state == SEALED) {
+        next_table = t->_next;
+        break;
+      }
+
+      if (s->key == key) {
+        if (state == FULL)
+          return s;
+        next_table = t->_next;
+        break;
+      }
+
+      i = (i + 1) & mask;
+    }
+
+    t = next_table;
+  }
+
+  return NULL;
+}
+
+
+/**
+ * @brief Determine whether the map contains a given key.
+ * @param key key to be searched
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V>
+bool ConcurrentHashMap<K,V>::contains(K& key) {
+  return find(key) != NULL;
+}
+
+
+/**
+ * @brief Determine the value associated with a given key.
+ * @details If the key is not present, an exception is thrown.
+ * @param key key whose corresponding value is desired
+ * @return value associated with the given key
+ */
+template <class K, class V>
+V ConcurrentHashMap<K,V>::at(K& key) {
+
+  slot* s = find(key);
+  if (s == NULL)
+    throw std::out_of_range("Key not present in map");
+
+  return s->value;
+}
+
+
+/**
+ * @brief Updates the value associated with a key.
+ * @details The slot is claimed with a compare-and-swap while its value is
+ *          written, so that the value cannot be lost if the slot is
+ *          concurrently migrated to a larger table.
+ * @param key key whose value is updated
+ * @param value new value
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::update(K& key, V value) {
+
+  while (true) {
+    slot* s = find(key);
+    if (s == NULL)
+      throw std::out_of_range("Key not present in map");
+
+    if (__sync_bool_compare_and_swap(&s->state, FULL, BUSY)) {
+      s->value = value;
+      __sync_synchronize();
+      s->state = FULL;
+      return;
+    }
+  }
+}
+
+
+/**
+ * @brief Attempts to insert a key/value pair into a single table.
+ * @param t the table
+ * @param key key of the key/value pair
+ * @param value value of the key/value pair
+ * @return whether the pair was inserted, was already present, or whether
+ *         the insertion should be retried in a newer table
+ */
+template <class K, class V>
+typename ConcurrentHashMap<K,V>::insertResult
+ConcurrentHashMap<K,V>::tryInsert(table* t, K& key, V value) {
+
+  size_t mask = t->_M - 1;
+  size_t i = std::hash<K>()(key) & mask;
+
+  for (size_t probe=0; probe < t->_M; probe++) {
+
+    slot* s = &t->_slots[i];
+
+    /* Claim an empty slot, then publish its key and value */
+    if (s->state == EMPTY &&
+        __sync_bool_compare_and_swap(&s->state, EMPTY, BUSY)) {
+      s->key = key;
+      s->value = value;
+      __sync_synchronize();
+      s->state = FULL;
+      return INSERTED;
+    }
+
+    /* Wait for slots which are being written */
+    int state = s->state;
+    while (state == BUSY) {
+      state = s->state;
+      __sync_synchronize();
+    }
+
+    /* The table is being migrated */
+    if (state == MOVING || state == MOVED || state == SEALED)
+      return RETRY;
+
+    if (state == FULL && s->key == key)
+      return PRESENT;
+
+    i = (i + 1) & mask;
+  }
+
+  if (_fixed_size)
+    log_printf(ERROR, "Unable to insert into a full fixed-size hash map "
+               "with %ld slots", t->_M);
+
+  return RETRY;
+}
+
+
+/**
+ * @brief Inserts a key/value pair into the map if the key is not present.
+ * @param key key of the key/value pair to be inserted
+ * @param value value of the key/value pair to be inserted
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::insert(K key, V value) {
+  insert_and_get_count(key, value);
+}
+
+
+/**
+ * @brief Inserts a key/value pair into the map if the key is not present and
+ *        returns the order number with which it was inserted.
+ * @details If the key already exists, -1 is returned. Threads which find the
+ *          table under migration help with the migration before inserting
+ *          into the new table.
+ * @param key key of the key/value pair to be inserted
+ * @param value value of the key/value pair to be inserted
+ * @return order number in which the key/value pair was inserted, -1 if it
+ *         already exists
+ */
+template <class K, class V>
+long ConcurrentHashMap<K,V>::insert_and_get_count(K key, V value) {
+
+  while (true) {
+
+    table* t = _table;
+
+    /* Help an ongoing migration before inserting */
+    if (t->_next != NULL) {
+      helpMigrate(t);
+      continue;
+    }
+
+    /* Start a migration to a larger table if the table is half full */
+    if (!_fixed_size && 2 * (_N + 1) > t->_M) {
+      startResize(t);
+      continue;
+    }
+
+    insertResult result = tryInsert(t, key, value);
+    if (result == PRESENT)
+      return -1;
+    else if (result == INSERTED)
+      return (long) __sync_fetch_and_add(&_N, 1);
+  }
+}
+
+
+/**
+ * @brief Allocates a table of twice the size and starts migrating to it.
+ * @param t the table to migrate
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::startResize(table* t) {
+
+  table* new_table = new table(2 * t->_M);
+  if (!__sync_bool_compare_and_swap(&t->_next, (table*) NULL, new_table))
+    delete new_table;
+
+  helpMigrate(t);
+}
+
+
+/**
+ * @brief Migrates chunks of a table to its next table until all chunks are
+ *        claimed, then waits for the migration to complete.
+ * @param t the table being migrated
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::helpMigrate(table* t) {
+
+  /* Claim and migrate chunks of slots */
+  while (true) {
+    size_t start = __sync_fetch_and_add(&t->_cursor, _chunk_size);
+    if (start >= t->_M)
+      break;
+
+    size_t end = std::min(start + _chunk_size, t->_M);
+    for (size_t i=start; i < end; i++)
+      migrateSlot(t, i);
+
+    __sync_fetch_and_add(&t->_migrated, end - start);
+  }
+
+  /* Wait for the chunks claimed by other threads */
+  while (t->_migrated < t->_M)
+    __sync_synchronize();
+
+  /* Publish the new table */
+  __sync_bool_compare_and_swap(&_table, t, t->_next);
+}
+
+
+/**
+ * @brief Moves a single slot of a table to its next table.
+ * @param t the table being migrated
+ * @param i the index of the slot
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::migrateSlot(table* t, size_t i) {
+
+  slot* s = &t->_slots[i];
+  table* next = t->_next;
+
+  while (true) {
+
+    /* Seal empty slots so that no insertion can claim them */
+    if (__sync_bool_compare_and_swap(&s->state, EMPTY, SEALED))
+      return;
+
+    /* Copy full slots, locking their value against updates */
+    if (__sync_bool_compare_and_swap(&s->state, FULL, MOVING)) {
+      while (tryInsert(next, s->key, s->value) == RETRY)
+        log_printf(ERROR, "Unable to migrate a hash map slot");
+      __sync_synchronize();
+      s->state = MOVED;
+      return;
+    }
+
+    /* Otherwise the slot is being written, so wait for it */
+    __sync_synchronize();
+  }
+}
+
+
+/**
+ * @brief Returns the number of key/value pairs in the map.
+ * @return number of key/value pairs in the map
+ */
+template <class K, class V>
+size_t ConcurrentHashMap<K,V>::size() {
+  return _N;
+}
+
+
+/**
+ * @brief Returns the number of slots in the current table.
+ * @return number of slots in the current table
+ */
+template <class K, class V>
+size_t ConcurrentHashMap<K,V>::bucket_count() {
+  return _table->_M;
+}
+
+
+/**
+ * @brief Returns an array of the keys in the map.
+ * @details All insertions must have completed. The user is responsible for
+ *          freeing the memory of the returned array.
+ * @return an array of keys in the map whose length is the number of
+ *         key/value pairs in the map
+ */
+template <class K, class V>
+K* ConcurrentHashMap<K,V>::keys() {
+
+  K* key_list = new K[_N];
+  table* t = _table;
+  size_t ind = 0;
+  for (size_t i=0; i < t->_M; i++) {
+    if (t->_slots[i].state == FULL) {
+      key_list[ind] = t->_slots[i].key;
+      ind++;
+    }
+  }
+  return key_list;
+}
+
+
+/**
+ * @brief Returns an array of the values in the map, in the same order as the
+ *        keys returned by keys().
+ * @details All insertions must have completed. The user is responsible for
+ *          freeing the memory of the returned array.
+ * @return an array of values in the map whose length is the number of
+ *         key/value pairs in the map
+ */
+template <class K, class V>
+V* ConcurrentHashMap<K,V>::values() {
+
+  V* value_list = new V[_N];
+  table* t = _table;
+  size_t ind = 0;
+  for (size_t i=0; i < t->_M; i++) {
+    if (t->_slots[i].state == FULL) {
+      value_list[ind] = t->_slots[i].value;
+      ind++;
+    }
+  }
+  return value_list;
+}
+
+
+/**
+ * @brief Prevents the table from being resized.
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::setFixedSize() {
+  _fixed_size = true;
+}
+
+
+/**
+ * @brief Clears all key/value pairs from the map, keeping the current table.
+ * @details No other thread may access the map during this operation.
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::clear() {
+
+  /* Free migrated tables */
+  table* current = _table;
+  table* t = _first_table;
+  while (t != current) {
+    table* next = t->_next;
+    delete t;
+    t = next;
+  }
+  _first_table = current;
+
+  for (size_t i=0; i < current->_M; i++)
+    current->_slots[i].state = EMPTY;
+  _N = 0;
+}
+
+
+/**
+ * @brief Replaces the map by an empty table of the given size.
+ * @details No other thread may access the map during this operation.
+ * @param M the new table size
+ */
+template <class K, class V>
+void ConcurrentHashMap<K,V>::realloc(size_t M) {
+  deleteTables();
+  _table = new table(roundSize(M));
+  _first_table = _table;
+  _N = 0;
+}
+#endif
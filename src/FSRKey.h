@@ -0,0 +1,180 @@
+/**
+ * @file FSRKey.h
+ * @brief The FSRKey struct, a fixed-width integer key identifying an FSR.
+ * @details An FSRKey is a 128-bit hash of the universe/lattice/cell path
+ *          leading to a flat source region. It replaces the structured
+ *          string keys formerly built during segmentation, which were
+ *          costly to construct and hash and took large amounts of memory
+ *          for full-core 3D geometries. A human-readable string describing
+ *          the path can still be generated on demand by the Geometry.
+ * @date October 18, 2026
+ */
+
+#ifndef FSRKEY_H_
+#define FSRKEY_H_
+
+#ifdef __cplusplus
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <functional>
+#endif
+
+
+/**
+ * @brief Tags identifying the kind of each component hashed into an FSRKey.
+ * @details Tags make the hashed path unambiguous, so that for instance a
+ *          universe ID can never be confused with a lattice index.
+ */
+enum fsrKeyTag {
+
+  /** CMFD mesh cell indexes */
+  KEY_CMFD = 1,
+
+  /** Overlaid mesh cell indexes */
+  KEY_OVERLAID_MESH,
+
+  /** Lattice ID and lattice cell indexes */
+  KEY_LATTICE,
+
+  /** Universe ID */
+  KEY_UNIVERSE,
+
+  /** Cell ID */
+  KEY_CELL,
+
+  /** Version number of the coordinates */
+  KEY_VERSION
+};
+
+
+/**
+ * @struct FSRKey
+ * @brief A 128-bit hash of the hierarchical path leading to an FSR.
+ * @details Two independent 64-bit lanes are updated for every component of
+ *          the path. With 128 bits the probability of a collision between
+ *          any two of even billions of FSRs is negligible (below 1E-20).
+ */
+struct FSRKey {
+
+  /** The high 64 bits of the key */
+  uint64_t _hi;
+
+  /** The low 64 bits of the key */
+  uint64_t _lo;
+
+  /** Constructor initializes an empty path */
+  FSRKey() : _hi(0x6A09E667F3BCC908ULL), _lo(0xBB67AE8584CAA73BULL) {}
+
+  /**
+   * @brief Finalization mix of MurmurHash3, fully avalanching 64 bits.
+   * @param h the value to mix
+   * @return the mixed value
+   */
+  static inline uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  /**
+   * @brief Hashes one component of the FSR path into the key.
+   * @param value the integer component (an ID or an index)
+   */
+  inline void append(long value) {
+    uint64_t v = (uint64_t) value;
+    _lo = mix(_lo ^ (v + 0x9E3779B97F4A7C15ULL));
+    _hi = mix(_hi + (v ^ 0xC2B2AE3D27D4EB4FULL) * 0x165667B19E3779F9ULL
+              + (_lo >> 29));
+  }
+
+  /**
+   * @brief Hashes a tagged component of the FSR path into the key.
+   * @param tag the kind of path component
+   * @param value the integer component (an ID or an index)
+   */
+  inline void append(fsrKeyTag tag, long value) {
+    append(((long) tag << 56) ^ value);
+  }
+
+  /**
+   * @brief Hashes a floating point value into the key by its bit pattern.
+   * @param value the floating point value
+   */
+  inline void appendDouble(double value) {
+    long bits;
+    memcpy(&bits, &value, sizeof(double));
+    append(bits);
+  }
+
+  /**
+   * @brief Hashes a string into the key, eight characters at a time.
+   * @param value the string
+   */
+  inline void appendString(const std::string& value) {
+    append((long) value.size());
+    for (size_t i=0; i < value.size(); i += sizeof(long)) {
+      long word = 0;
+      size_t size = value.size() - i;
+      if (size > sizeof(long))
+        size = sizeof(long);
+      memcpy(&word, value.data() + i, size);
+      append(word);
+    }
+  }
+
+  /** Resets the key to an empty path */
+  inline void clear() {
+    _hi = 0x6A09E667F3BCC908ULL;
+    _lo = 0xBB67AE8584CAA73BULL;
+  }
+
+  /** Equality comparison of two keys */
+  inline bool operator==(const FSRKey& other) const {
+    return _lo == other._lo && _hi == other._hi;
+  }
+
+  /** Inequality comparison of two keys */
+  inline bool operator!=(const FSRKey& other) const {
+    return !(*this == other);
+  }
+
+  /** Strict ordering of keys, used to sort keys deterministically */
+  inline bool operator<(const FSRKey& other) const {
+    return _hi < other._hi || (_hi == other._hi && _lo < other._lo);
+  }
+
+  /**
+   * @brief Renders the key as a 32 character hexadecimal string.
+   * @return the hexadecimal string
+   */
+  std::string toString() const {
+    char buffer[33];
+    snprintf(buffer, 33, "%016llx%016llx", (unsigned long long) _hi,
+             (unsigned long long) _lo);
+    return std::string(buffer);
+  }
+};
+
+
+#ifndef SWIG
+namespace std {
+
+/**
+ * @brief Hash functor so FSRKeys can be used in the hash maps. The low lane
+ *        is already fully mixed so it is used directly.
+ */
+template <>
+struct hash<FSRKey> {
+  size_t operator()(const FSRKey& key) const {
+    return (size_t) key._lo;
+  }
+};
+}
+#endif
+
+#endif /* FSRKEY_H_ */
@@ -1,4 +1,7 @@
 #include "Geometry.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <exception>
 
 /**
  * @brief Resets the auto-generated unique IDs for Materials, Surfaces,
@@ -35,6 +38,9 @@ Geometry::Geometry() {
   _contains_FSR_centroids = false;
   _twiddle = false;
   _loaded_from_file = false;
+  _use_chord_templates = true;
+  _num_pin_crossings = 0;
+  _num_template_crossings = 0;
 }
 
 
@@ -104,6 +110,12 @@ Geometry::~Geometry() {
   }
   if (_overlaid_mesh != NULL)
     delete _overlaid_mesh;
+
+  /* Free the LocalCoords used for ray tracing */
+  for (size_t i=0; i < _thread_coords.size(); i++)
+    delete _thread_coords[i];
+
+  clearChordTemplates();
 }
 
 
@@ -538,6 +550,26 @@ std::map<int, Cell*> Geometry::getAllMaterialCells() {
 }
 
 
+/**
+ * @brief Return a std::map container of Cell IDs (keys) with the Materials
+ *        filling these Cells (values).
+ * @details Cells filled again, even with other Materials of the same IDs,
+ *          change this map.
+ * @return a std::map of Materials indexed by the ID of the Cells they fill
+ */
+std::map<int, Material*> Geometry::getMaterialCellFills() {
+
+  std::map<int, Material*> fills;
+  std::map<int, Cell*> all_material_cells = getAllMaterialCells();
+  std::map<int, Cell*>::iterator iter;
+  for (iter = all_material_cells.begin(); iter != all_material_cells.end();
+       ++iter)
+    fills[iter->first] = iter->second->getFillMaterial();
+
+  return fills;
+}
+
+
 /**
  * @brief Return a std::map container of Universe IDs (keys) with Unierses
  *        pointers (values).
@@ -939,6 +971,57 @@ Material* Geometry::findFSRMaterial(long fsr_id) {
 }
 
 
+/**
+ * @brief Finds the Material of each FSR again if Cells were filled again.
+ * @details Filling a Cell, even with a Material already in the Geometry,
+ *          changes the Materials filling the Cells. The FSRs keep their IDs,
+ *          and the Material of each one is found again at its characteristic
+ *          point.
+ *          The Materials of the axially extruded FSRs are updated as well.
+ * @return whether the Materials of the FSRs were found again
+ */
+bool Geometry::updateFSRMaterials() {
+
+  std::map<int, Material*> fills = getMaterialCellFills();
+  if (fills == _FSR_cell_fills)
+    return false;
+
+  log_printf(NORMAL, "Updating FSR Materials...");
+  _all_materials = getAllMaterials();
+
+  fsr_data** value_list = _FSR_keys_map.values();
+  long num_FSRs = _FSR_keys_map.size();
+  initializeThreadCoords();
+#pragma omp parallel for
+  for (long i=0; i < num_FSRs; i++) {
+    fsr_data* fsr = value_list[i];
+    Point* point = fsr->_point;
+    LocalCoords* coords = getThreadCoords(0, point->getX(), point->getY(),
+                                          point->getZ());
+    coords->setUniverse(_root_universe);
+    Cell* cell = findCellContainingCoords(coords);
+    fsr->_mat_id = cell->getFillMaterial()->getId();
+    _FSRs_to_material_IDs.at(fsr->_fsr_id) = fsr->_mat_id;
+  }
+  delete [] value_list;
+
+  /* Update the Materials along the axially extruded FSRs */
+  for (size_t i=0; i < _extruded_FSR_lookup.size(); i++) {
+    ExtrudedFSR* extruded_FSR = _extruded_FSR_lookup[i];
+    if (extruded_FSR->_materials == NULL)
+      continue;
+    for (size_t n=0; n < extruded_FSR->_num_fsrs; n++) {
+      long fsr_id = extruded_FSR->_fsr_ids[n];
+      extruded_FSR->_materials[n] =
+          _all_materials[_FSRs_to_material_IDs.at(fsr_id)];
+    }
+  }
+
+  _FSR_cell_fills = fills;
+  return true;
+}
+
+
 /**
  * @brief Finds the next Cell for a LocalCoords object along a trajectory
  *        defined by some angle (in radians from 0 to Pi).
@@ -1055,15 +1138,27 @@ Cell* Geometry::findNextCell(LocalCoords* coords, double azim, double polar) {
  */
 long Geometry::findFSRId(LocalCoords* coords) {
 
-  long fsr_id;
-  LocalCoords* curr = coords;
-  curr = coords->getLowestLevel();
-
   /* Generate unique FSR key */
-  int thread_id = omp_get_thread_num();
-  std::string& fsr_key = _fsr_keys[thread_id];
+  FSRKey fsr_key;
   getFSRKeyFast(coords, fsr_key);
 
+  return findFSRId(coords, fsr_key, NULL);
+}
+
+
+/**
+ * @brief Find and return the ID of the flat source region with a given key.
+ * @details The FSR is added to the FSR maps if it has not been encountered,
+ *          with the position of the LocalCoords as its characteristic point.
+ * @param coords a LocalCoords object pointer inside the FSR
+ * @param fsr_key the key of the FSR
+ * @param cell the Cell filling the FSR, or NULL to find it from the coords
+ * @return the FSR ID
+ */
+long Geometry::findFSRId(LocalCoords* coords, FSRKey& fsr_key, Cell* cell) {
+
+  long fsr_id;
+
   /* If FSR has not been encountered, update FSR maps and vectors */
   if (!_FSR_keys_map.contains(fsr_key)) {
 
@@ -1089,7 +1184,8 @@ long Geometry::findFSRId(LocalCoords* coords) {
                        coords->getHighestLevel()->getZ());
 
       /* Get the cell that contains coords */
-      Cell* cell = findCellContainingCoords(curr);
+      if (cell == NULL)
+        cell = findCellContainingCoords(coords->getLowestLevel());
       fsr->_point = point;
       fsr->_mat_id = cell->getFillMaterial()->getId();
 
@@ -1126,7 +1222,8 @@ int Geometry::findExtrudedFSR(LocalCoords* coords) {
   curr = coords->getLowestLevel();
 
   /* Generate unique FSR key */
-  std::string fsr_key = getFSRKey(coords);
+  FSRKey fsr_key;
+  getFSRKeyFast(coords, fsr_key);
 
   /* If FSR has not been encountered, update FSR maps and vectors */
   if (!_extruded_FSR_keys_map.contains(fsr_key)) {
@@ -1184,12 +1281,10 @@ int Geometry::findExtrudedFSR(LocalCoords* coords) {
 long Geometry::getFSRId(LocalCoords* coords, bool err_check) {
 
   long fsr_id = 0;
-  std::string fsr_key;
 
   try {
     /* Generate unique FSR key */
-    int thread_id = omp_get_thread_num();
-    std::string& fsr_key = _fsr_keys[thread_id];
+    FSRKey fsr_key;
     getFSRKeyFast(coords, fsr_key);
     if (!_FSR_keys_map.contains(fsr_key) && !err_check)
       return -1;
@@ -1198,7 +1293,8 @@ long Geometry::getFSRId(LocalCoords* coords, bool err_check) {
   catch(std::exception &e) {
     if (err_check) {
         log_printf(ERROR, "Could not find FSR ID with key: %s. Try creating "
-                  "geometry with finer track spacing", fsr_key.c_str());
+                  "geometry with finer track spacing",
+                  getFSRKey(coords).c_str());
     }
     else {
       return -1;
@@ -1285,7 +1381,7 @@ Point* Geometry::getFSRPoint(long fsr_id) {
   Point* point;
 
   try {
-    std::string& key = _FSRs_to_keys[fsr_id];
+    FSRKey& key = _FSRs_to_keys[fsr_id];
     point = _FSR_keys_map.at(key)->_point;
   }
   catch(std::exception &e) {
@@ -1438,203 +1534,85 @@ int Geometry::getCmfdCell(long fsr_id) {
 
 
 /**
- * @brief reserves the FSR key strings
- * @param the number of threads
- */
-void Geometry::reserveKeyStrings(int num_threads) {
-  int string_size = 255;
-  _fsr_keys.resize(num_threads);
-  for (int i=0; i<num_threads; ++i) {
-    _fsr_keys[i].reserve(string_size);
-  }
-}
-
-
-/**
- * @brief Generate a string FSR "key" that identifies an FSR by its
+ * @brief Generate an integer FSR "key" that identifies an FSR by its
  *        unique hierarchical lattice/universe/cell structure.
  * @details Since not all FSRs will reside on the absolute lowest universe
  *          level and Cells might overlap other cells, it is important to
  *          have a method for uniquely identifying FSRs. This method
- *          creates a unique FSR key by constructing a structured string
- *          that describes the hierarchy of lattices/universes/cells.
+ *          creates a unique FSR key by hashing the CMFD and overlaid mesh
+ *          cells and the hierarchy of lattices/universes/cells into a
+ *          fixed-width 128-bit key, without any memory allocation. The
+ *          equivalent human-readable key is given by getFSRKey().
  * @param coords a LocalCoords object pointer
- * @return the FSR key
+ * @param key the FSR key to compute
  */
-void Geometry::getFSRKeyFast(LocalCoords* coords, std::string& key) {
+void Geometry::getFSRKeyFast(LocalCoords* coords, FSRKey& key) {
 
-  LocalCoords* curr = coords->getHighestLevel();
+  /* Write the meshes and the levels of the hierarchy to the key */
+  getFSRKeyPrefix(coords, NULL, key);
 
-  /* Assess the string size of the key */
-  Point* point = curr->getPoint();
-  int total_size = 0;
-  if (_cmfd != NULL) {
-    total_size += getNumDigits(_cmfd->getLattice()->getLatX(point));
-    total_size += getNumDigits(_cmfd->getLattice()->getLatY(point));
-    total_size += getNumDigits(_cmfd->getLattice()->getLatZ(point));
-    total_size += 9;
-  }
-  if (_overlaid_mesh != NULL) {
-    total_size += getNumDigits(_overlaid_mesh->getLatX(point));
-    total_size += getNumDigits(_overlaid_mesh->getLatY(point));
-    total_size += getNumDigits(_overlaid_mesh->getLatZ(point));
-    total_size += 4;
-  }
-  while (curr != NULL) {
-    if (curr->getType() == LAT) {
-      total_size += getNumDigits(curr->getLattice()->getId());
-      total_size += getNumDigits(curr->getLatticeX());
-      total_size += getNumDigits(curr->getLatticeY());
-      total_size += getNumDigits(curr->getLatticeZ());
-      total_size += 6;
-    }
-    else {
-      total_size += getNumDigits(curr->getUniverse()->getId());
-      total_size += 2;
-    }
-    if (curr->getNext() == NULL)
-      break;
-    else
-      curr = curr->getNext();
-  }
-  total_size += getNumDigits(curr->getCell()->getId());
-  total_size += 1;
+  /* write cell id to key */
+  key.append(KEY_CELL, coords->getLowestLevel()->getCell()->getId());
+
+  /* write version number to key */
   int version_num = coords->getVersionNum();
-  if (version_num != 0) {
-    total_size += getNumDigits(version_num);
-    total_size += 2;
-  }
+  if (version_num != 0)
+    key.append(KEY_VERSION, version_num);
+}
+
+
+/**
+ * @brief Generates the leading part of the 128-bit FSR key of a LocalCoords,
+ *        up to a level of the hierarchy.
+ * @details The key holds the CMFD and overlaid mesh cells and the lattices
+ *          and universes of the levels above the given level. The key of the
+ *          FSR is completed by appending the universes of the remaining
+ *          levels, the cell and the version number, as in getFSRKeyFast.
+ * @param coords a LocalCoords object pointer
+ * @param last the first level not written to the key, or NULL to write all
+ *        levels
+ * @param key the FSRKey to fill
+ */
+void Geometry::getFSRKeyPrefix(LocalCoords* coords, LocalCoords* last,
+                               FSRKey& key) {
 
-  /* Resize key */
-  if (total_size > 255)
-    log_printf(ERROR, "Found key exceeding the 255 character threshold");
-  key.resize(total_size);
-  curr = curr->getHighestLevel();
+  LocalCoords* curr = coords->getHighestLevel();
+  Point* point = curr->getPoint();
+  key.clear();
 
   /* If CMFD is on, get CMFD latice cell and write to key */
-  int ind = 0;
   if (_cmfd != NULL) {
-    key.replace(ind, 5, "CMFD(");
-    ind += 5;
-    printToString(key, ind, _cmfd->getLattice()->getLatX(point));
-    key.at(ind) = ',';
-    ind++;
-    printToString(key, ind, _cmfd->getLattice()->getLatY(point));
-    key.at(ind) = ',';
-    ind++;
-    printToString(key, ind, _cmfd->getLattice()->getLatZ(point));
-    key.replace(ind, 2, "):");
-    ind += 2;
+    Lattice* lattice = _cmfd->getLattice();
+    key.append(KEY_CMFD, lattice->getLatX(point));
+    key.append(lattice->getLatY(point));
+    key.append(lattice->getLatZ(point));
   }
 
   /* If a global overlaid mesh is present, get the axial mesh cell */
   if (_overlaid_mesh != NULL) {
-    key.at(ind) = 'A';
-    ind++;
-    printToString(key, ind, _overlaid_mesh->getLatZ(point));
-    key.at(ind) = 'R';
-    ind++;
-    printToString(key, ind, _overlaid_mesh->getLatX(point));
-    key.at(ind) = ',';
-    ind++;
-    printToString(key, ind, _overlaid_mesh->getLatY(point));
-    key.at(ind) = ':';
-    ind++;
+    key.append(KEY_OVERLAID_MESH, _overlaid_mesh->getLatZ(point));
+    key.append(_overlaid_mesh->getLatX(point));
+    key.append(_overlaid_mesh->getLatY(point));
   }
 
-  /* Descend the linked list hierarchy until the lowest level has
-   * been reached */
-  while (curr != NULL) {
+  /* Descend the linked list hierarchy until the lowest level or the last
+   * level has been reached */
+  while (curr != NULL && curr != last) {
 
     /* write lattice to key */
     if (curr->getType() == LAT) {
-      key.at(ind) = 'L';
-      ind++;
-      printToString(key, ind, curr->getLattice()->getId());
-      key.at(ind) = '(';
-      ind++;
-      printToString(key, ind, curr->getLatticeX());
-      key.at(ind) = ',';
-      ind++;
-      printToString(key, ind, curr->getLatticeY());
-      key.at(ind) = ',';
-      ind++;
-      printToString(key, ind, curr->getLatticeZ());
-      key.replace(ind, 2, "):");
-      ind += 2;
-    }
-    else {
-
-      /* write universe ID to key */
-      key.at(ind) = 'U';
-      ind++;
-      printToString(key, ind, curr->getUniverse()->getId());
-      key.at(ind) = ':';
-      ind++;
+      key.append(KEY_LATTICE, curr->getLattice()->getId());
+      key.append(curr->getLatticeX());
+      key.append(curr->getLatticeY());
+      key.append(curr->getLatticeZ());
     }
 
-    /* If lowest coords reached break; otherwise get next coords */
-    if (curr->getNext() == NULL)
-      break;
+    /* write universe ID to key */
     else
-      curr = curr->getNext();
-  }
-
-  /* write cell id to key */
-  key.at(ind) = 'C';
-  ind++;
-  printToString(key, ind, curr->getCell()->getId());
-
-  /* write version number to key */
-  if (version_num != 0) {
-    key.replace(ind, 2, ":V");
-    ind += 2;
-    printToString(key, ind, version_num);
-  }
-}
-
-
-//FIXME Find a better way to do this, without a function call
-/**Using std::stringstream would be more clear.
- * @brief Get the number of digits in base 10 of a number
- * @param number the number of interest
- * @return the number of digits in base 10 of a number
- */
-int Geometry::getNumDigits(int number) {
-  if (number < 0)
-    log_printf(ERROR, "Trying to get the digits of negative number %d", number);
-  int ref = 10;
-  int num_digits = 1;
-  while (number >= ref) {
-    num_digits++;
-    ref *= 10;
-  }
-  return num_digits;
-}
+      key.append(KEY_UNIVERSE, curr->getUniverse()->getId());
 
-
-//FIXME Find a better way to do this, without a function call
-/**Using std::stringstream would be more clear.
- * @brief Print a number to a given String.
- * @param str the string to print to
- * @param index the last index in that string
- * @param value the number to print
- * @return the number of digits in base 10 of a number
- */
-void Geometry::printToString(std::string& str, int& index, int value) {
-
-  char digits[10] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
-
-  int num_digits = getNumDigits(value);
-  for (int i=0; i < num_digits; i++) {
-    int base = 1;
-    for (int j=0; j < num_digits - i - 1; j++)
-      base *= 10;
-    char digit = digits[value / base];
-    str.at(index+i) = digit;
-    value -= (value / base) * base;
+    curr = curr->getNext();
   }
-  index += num_digits;
 }
 
 
@@ -1735,6 +1713,23 @@ std::string Geometry::getFSRKey(LocalCoords* coords) {
 }
 
 
+/**
+ * @brief Generate the string FSR "key" of an FSR from its ID.
+ * @details The string key is rebuilt on demand from the characteristic point
+ *          of the FSR, and is meant for debugging and file output only.
+ * @param fsr_id the FSR ID
+ * @return the FSR key
+ */
+std::string Geometry::getFSRKeyString(long fsr_id) {
+
+  Point* point = getFSRPoint(fsr_id);
+  LocalCoords coords(point->getX(), point->getY(), point->getZ(), true);
+  coords.setUniverse(_root_universe);
+  findCellContainingCoords(&coords);
+  return getFSRKey(&coords);
+}
+
+
 /**
  * @brief Return a pointer to an ExtrudedFSR by its extruded FSR ID
  * @param extruded_fsr_id the extruded FSR ID
@@ -1783,9 +1778,23 @@ void Geometry::initializeFlatSourceRegions() {
   /* Subdivide Cells into sectors and rings */
   subdivideCells();
 
-  /* Build collections of neighbor Cells for optimized ray tracing */
-  //FIXME
-  //_root_universe->buildNeighbors();
+  /* Compile the Regions of all Cells for fast ray tracing queries */
+  std::map<int, Cell*> all_cells = getAllCells();
+  std::map<int, Cell*>::iterator cell_iter;
+  for (cell_iter = all_cells.begin(); cell_iter != all_cells.end(); ++cell_iter)
+    cell_iter->second->compileRegion();
+
+  /* Discard chord templates referring to Cells before subdivision */
+  clearChordTemplates();
+
+  /* Build the Cell search structures, including collections of neighbor
+   * Cells, for optimized ray tracing */
+  std::map<int, Universe*> all_universes = getAllUniverses();
+  std::map<int, Universe*>::iterator univ_iter;
+  for (univ_iter = all_universes.begin(); univ_iter != all_universes.end();
+       ++univ_iter)
+    if (univ_iter->second->getType() == SIMPLE)
+      univ_iter->second->initializeCellSearch();
 
   /* Create map of Material IDs to Material pointers */
   _all_materials = getAllMaterials();
@@ -1800,6 +1809,456 @@ void Geometry::initializeFlatSourceRegions() {
   /* Initialize CMFD */
   if (_cmfd != NULL)
     initializeCmfd();
+
+  _FSR_cell_fills = getMaterialCellFills();
+}
+
+
+/**
+ * @brief Allocates the LocalCoords linked lists reused by each thread for
+ *        ray tracing.
+ * @details Each thread is given NUM_THREAD_COORDS LocalCoords, each with an
+ *          array of LOCAL_COORDS_LEN LocalCoords for the lower levels, so
+ *          that segmenting Tracks allocates no LocalCoords. This method must
+ *          be called outside of parallel regions, before each parallel loop
+ *          ray tracing Tracks, it only allocates the LocalCoords of threads
+ *          that do not have them yet.
+ */
+void Geometry::initializeThreadCoords() {
+
+  size_t num_coords = omp_get_max_threads() * NUM_THREAD_COORDS;
+  while (_thread_coords.size() < num_coords)
+    _thread_coords.push_back(new LocalCoords(0, 0, 0, true));
+}
+
+
+/**
+ * @brief Returns a reset LocalCoords linked list of the calling thread.
+ * @details The LocalCoords are allocated on first use if called outside of a
+ *          parallel region.
+ * @param index the index of the linked list among those of the thread
+ * @param x the x-coordinate to reset the LocalCoords to
+ * @param y the y-coordinate to reset the LocalCoords to
+ * @param z the z-coordinate to reset the LocalCoords to
+ * @return a pointer to the highest level of the linked list
+ */
+LocalCoords* Geometry::getThreadCoords(int index, double x, double y,
+                                       double z) {
+
+  size_t position = omp_get_thread_num() * NUM_THREAD_COORDS + index;
+  if (position >= _thread_coords.size()) {
+    if (omp_in_parallel())
+      log_printf(ERROR, "The ray tracing LocalCoords of thread %d have not "
+                 "been allocated", omp_get_thread_num());
+    initializeThreadCoords();
+  }
+
+  LocalCoords* coords = _thread_coords[position];
+  coords->reset(x, y, z);
+  return coords;
+}
+
+
+/**
+ * @brief Sets whether pin crossings are ray traced with chord templates.
+ * @details Chord templates replay the chords through a pin Universe
+ *          recorded for a previous Track crossing the same pin along the same
+ *          line, up to CHORD_TEMPLATE_TOLERANCE, adding their segments
+ *          without ray tracing. The last chord of every pin is always ray
+ *          traced. Chord templates are used by default for 2D ray tracing.
+ * @param use_chord_templates whether to use chord templates
+ */
+void Geometry::useChordTemplates(bool use_chord_templates) {
+  _use_chord_templates = use_chord_templates;
+}
+
+
+/**
+ * @brief Deletes all chord templates.
+ */
+void Geometry::clearChordTemplates() {
+
+  ChordTemplate** templates = _chord_templates.values();
+  for (long i=0; i < _chord_templates.size(); i++)
+    delete templates[i];
+  delete [] templates;
+
+  _chord_templates.clear();
+  _num_pin_crossings = 0;
+  _num_template_crossings = 0;
+}
+
+
+/**
+ * @brief Returns the number of pins crossed by all 2D Tracks.
+ * @return the number of pin crossings
+ */
+long Geometry::getNumPinCrossings() {
+  return _num_pin_crossings;
+}
+
+
+/**
+ * @brief Returns the number of pins crossed by 2D Tracks by replaying a
+ *        chord template.
+ * @return the number of pin crossings using chord templates
+ */
+long Geometry::getNumTemplateCrossings() {
+  return _num_template_crossings;
+}
+
+
+/**
+ * @brief Finds the LocalCoords of the pin Universe containing a LocalCoords.
+ * @details The pin is the Universe filling a cell of the lowest Lattice in
+ *          the hierarchy. Cells of the pin may be filled by further
+ *          Universes, such as those created when subdividing Cells into
+ *          rings and sectors.
+ * @param coords pointer to the highest level LocalCoords
+ * @return a pointer to the LocalCoords of the pin, NULL if not in a Lattice
+ */
+static LocalCoords* findPinCoords(LocalCoords* coords) {
+
+  LocalCoords* curr = coords->getLowestLevel();
+  while (curr != NULL) {
+    LocalCoords* parent = curr->getPrev();
+    if (parent != NULL && parent->getType() == LAT)
+      return curr;
+    curr = parent;
+  }
+  return NULL;
+}
+
+
+/**
+ * @brief Determines whether a LocalCoords is in the current pin of a Track.
+ * @param coords pointer to the highest level LocalCoords
+ * @param state the chord template state of the Track
+ * @return whether the LocalCoords is in the pin
+ */
+static bool inCurrentPin(LocalCoords* coords, ChordState& state) {
+
+  LocalCoords* pin = findPinCoords(coords);
+  if (pin == NULL)
+    return false;
+
+  LocalCoords* parent = pin->getPrev();
+  return parent->getLattice() == state._lattice &&
+         parent->getLatticeX() == state._lat_x &&
+         parent->getLatticeY() == state._lat_y &&
+         parent->getLatticeZ() == state._lat_z;
+}
+
+
+/**
+ * @brief Looks up the chord template for a pin that a Track just entered,
+ *        or starts recording one.
+ * @details Pins are the Universes filling the cells of the lowest Lattice
+ *          containing the LocalCoords. Templates are keyed by the Lattice,
+ *          the Universe, the azimuthal angle and the distance from the pin
+ *          center to the line of the Track, quantized by
+ *          CHORD_TEMPLATE_BUCKET. A template is only replayed for lines
+ *          closer than CHORD_TEMPLATE_TOLERANCE to the line it was recorded
+ *          for. Templates are not used when a CMFD, overlaid mesh or domain
+ *          boundary cuts the pin ahead of the entry point, since these split
+ *          chords differently in every pin instance.
+ * @param coords pointer to the highest level LocalCoords of the Track
+ * @param azim the azimuthal angle of the trajectory
+ * @param state the chord template state of the Track
+ */
+void Geometry::enterPin(LocalCoords* coords, double azim, ChordState& state) {
+
+  state._template = NULL;
+  state._recording = false;
+  state._lattice = NULL;
+
+  LocalCoords* pin = findPinCoords(coords);
+  if (pin == NULL)
+    return;
+
+  LocalCoords* parent = pin->getPrev();
+  Lattice* lattice = parent->getLattice();
+  state._lattice = lattice;
+  state._lat_x = parent->getLatticeX();
+  state._lat_y = parent->getLatticeY();
+  state._lat_z = parent->getLatticeZ();
+  state._num_pins++;
+
+  if (!_use_chord_templates)
+    return;
+
+  /* Check that no mesh or domain boundary lies within the pin */
+  double pin_dist = lattice->minSurfaceDist(parent->getPoint(), azim)
+                    - TINY_MOVE;
+  Point* point = coords->getPoint();
+  if (_cmfd != NULL &&
+      _cmfd->getLattice()->minSurfaceDist(point, azim) < pin_dist)
+    return;
+  if (_overlaid_mesh != NULL &&
+      _overlaid_mesh->minSurfaceDist(point, azim) < pin_dist)
+    return;
+  if (_domain_decomposed &&
+      _domain_bounds->minSurfaceDist(point, azim) < pin_dist)
+    return;
+
+  /* Compute the template key from the line of the Track in the pin */
+  double line_offset = cos(azim) * pin->getY() - sin(azim) * pin->getX();
+  FSRKey key;
+  key.append(KEY_LATTICE, lattice->getId());
+  key.append(KEY_UNIVERSE, pin->getUniverse()->getId());
+  if (lattice->getNonUniform()) {
+    key.appendDouble(lattice->getWidthsX().at(state._lat_x));
+    key.appendDouble(lattice->getWidthsY().at(state._lat_y));
+  }
+  key.append(llround(line_offset / CHORD_TEMPLATE_BUCKET));
+  key.appendDouble(azim);
+
+  /* Replay the template if it was recorded for the same line */
+  if (_chord_templates.contains(key)) {
+    ChordTemplate* chords = _chord_templates.at(key);
+    if (fabs(chords->_line_offset - line_offset) <= CHORD_TEMPLATE_TOLERANCE
+        && chords->_cells[0] == coords->getLowestLevel()->getCell()) {
+      getFSRKeyPrefix(coords, pin, state._key_prefix);
+      state._template = chords;
+    }
+  }
+
+  /* Otherwise record a new template */
+  else {
+    ChordTemplate* chords = new ChordTemplate;
+    chords->_line_offset = line_offset;
+    chords->_replay = true;
+    chords->_key_offsets.push_back(0);
+    state._template = chords;
+    state._recording = true;
+    state._key = key;
+  }
+}
+
+
+/**
+ * @brief Records a ray traced chord in the chord template of the current
+ *        pin.
+ * @details The template is shared once the chord leaving the pin has been
+ *          recorded. Templates with chords shorter than
+ *          CHORD_TEMPLATE_MIN_LENGTH, which are close to tangent crossings,
+ *          are shared but never replayed.
+ * @param start pointer to the LocalCoords at the start of the chord
+ * @param end pointer to the LocalCoords at the end of the chord
+ * @param cell the Cell of the chord
+ * @param azim the azimuthal angle of the trajectory
+ * @param state the chord template state of the Track
+ * @param left_pin whether the chord leaves the pin
+ */
+void Geometry::recordChord(LocalCoords* start, LocalCoords* end, Cell* cell,
+                           double azim, ChordState& state, bool left_pin) {
+
+  ChordTemplate* chords = state._template;
+  chords->_cells.push_back(cell);
+  if (end->getPoint()->distanceToPoint(start->getPoint()) <
+      CHORD_TEMPLATE_MIN_LENGTH)
+    chords->_replay = false;
+
+  /* Record the end of a chord inside the pin and its FSR key components */
+  if (!left_pin) {
+    LocalCoords* pin = findPinCoords(end);
+    chords->_ends.push_back(cos(azim) * pin->getX() +
+                            sin(azim) * pin->getY());
+    for (LocalCoords* curr = findPinCoords(start); curr != NULL;
+         curr = curr->getNext())
+      chords->_key_components.push_back(((long) KEY_UNIVERSE << 56) ^
+                                        curr->getUniverse()->getId());
+    chords->_key_components.push_back(((long) KEY_CELL << 56) ^
+                                      cell->getId());
+    chords->_key_offsets.push_back(chords->_key_components.size());
+    return;
+  }
+
+  /* Share the template once the pin was crossed */
+  if (_chord_templates.insert_and_get_count(state._key, chords) == -1)
+    delete chords;
+  state._template = NULL;
+  state._recording = false;
+}
+
+
+/**
+ * @brief Adds the segments of the chords of a chord template to a 2D Track.
+ * @details All chords of the template but the last are added from the
+ *          position of the LocalCoords, without ray tracing. Their FSR keys
+ *          are formed by appending the key components recorded in the
+ *          template to the key of the levels above the pin. The LocalCoords
+ *          are then moved to the start of the last chord, where the Cells
+ *          are found once from the pin level down. If this Cell differs from
+ *          the Cell of the last chord of the template, the LocalCoords are
+ *          moved back and no segment is added.
+ * @param track pointer to the 2D Track
+ * @param coords pointer to the highest level LocalCoords of the Track, at
+ *        the entry point of the pin
+ * @param azim the azimuthal angle of the trajectory
+ * @param state the chord template state of the Track
+ * @return whether the chords of the template were added
+ */
+bool Geometry::replayChords(Track* track, LocalCoords* coords, double azim,
+                            ChordState& state) {
+
+  ChordTemplate* chords = state._template;
+  state._template = NULL;
+  int num_chords = chords->_ends.size();
+  if (!chords->_replay || num_chords == 0)
+    return false;
+
+  /* Find the position of the entry point along the line in the pin */
+  LocalCoords* pin = findPinCoords(coords);
+  double cos_azim = cos(azim);
+  double sin_azim = sin(azim);
+  double entry = cos_azim * pin->getX() + sin_azim * pin->getY();
+  if (chords->_ends[0] <= entry)
+    return false;
+
+  /* Move to the start of the last chord and check its Cell */
+  double x0 = coords->getX();
+  double y0 = coords->getY();
+  double z0 = coords->getZ();
+  double distance = chords->_ends[num_chords-1] - entry;
+  coords->adjustCoords(cos_azim * distance, sin_azim * distance);
+  pin->prune();
+  if (pin->getUniverse()->findCell(pin) != chords->_cells[num_chords]) {
+    coords->adjustCoords(-cos_azim * distance, -sin_azim * distance);
+    pin->prune();
+    pin->getUniverse()->findCell(pin);
+    return false;
+  }
+
+  /* Add the segments of the chords inside the pin */
+  LocalCoords* chord_start = getThreadCoords(2, x0, y0, z0);
+  LocalCoords* chord_end = getThreadCoords(3, x0, y0, z0);
+  int version_num = coords->getVersionNum();
+  for (int c=0; c < num_chords; c++) {
+
+    distance = chords->_ends[c] - entry;
+    chord_end->setX(x0 + cos_azim * distance);
+    chord_end->setY(y0 + sin_azim * distance);
+
+    FSRKey fsr_key = state._key_prefix;
+    for (int k=chords->_key_offsets[c]; k < chords->_key_offsets[c+1]; k++)
+      fsr_key.append(chords->_key_components[k]);
+    if (version_num != 0)
+      fsr_key.append(KEY_VERSION, version_num);
+
+    Cell* cell = chords->_cells[c];
+    long fsr_id = findFSRId(chord_start, fsr_key, cell);
+    addSegment2D(track, chord_start, chord_end, cell->getFillMaterial(),
+                 fsr_id, azim);
+
+    chord_start->setX(chord_end->getX());
+    chord_start->setY(chord_end->getY());
+  }
+
+  state._num_replayed_pins++;
+  return true;
+}
+
+
+/**
+ * @brief Adds a segment between two LocalCoords to a 2D Track.
+ * @details The CMFD surfaces crossed at the ends of the segment and its
+ *          starting position, relative to the FSR centroid if available,
+ *          are computed from the highest level of the LocalCoords.
+ * @param track pointer to the 2D Track
+ * @param start pointer to the LocalCoords at the start of the segment
+ * @param end pointer to the LocalCoords at the end of the segment
+ * @param material pointer to the Material of the segment
+ * @param fsr_id the ID of the FSR of the segment
+ * @param azim the azimuthal angle of the trajectory
+ */
+void Geometry::addSegment2D(Track* track, LocalCoords* start,
+                            LocalCoords* end, Material* material,
+                            long fsr_id, double azim) {
+
+  /* Checks that segment does not have the same start and end Points */
+  if (fabs(start->getX() - end->getX()) < FLT_EPSILON
+      && fabs(start->getY() - end->getY()) < FLT_EPSILON)
+    log_printf(ERROR, "Created 2D segment with same start and end "
+               "point: x = %f, y = %f, z=%f", start->getX(), start->getY(),
+               start->getZ());
+
+  /* Create a new Track segment */
+  segment* new_segment = new segment;
+  new_segment->_material = material;
+  new_segment->_length = double(end->getPoint()->distanceToPoint(
+      start->getPoint()));
+  new_segment->_region_id = fsr_id;
+
+  log_printf(DEBUG, "segment start x = %f, y = %f; end x = %f, y = %f",
+             start->getX(), start->getY(), end->getX(), end->getY());
+
+  /* Save indices of CMFD Mesh surfaces that the Track segment crosses */
+  if (_cmfd != NULL) {
+
+    /* Find cmfd cell that segment lies in */
+    int cmfd_cell = _cmfd->findCmfdCell(start);
+
+    /* Reverse nudge from surface to determine whether segment start or end
+     * points lie on a CMFD surface. */
+    double delta_x = cos(azim) * TINY_MOVE;
+    double delta_y = sin(azim) * TINY_MOVE;
+    start->adjustCoords(-delta_x, -delta_y);
+    end->adjustCoords(-delta_x, -delta_y);
+
+    /* Calculate CMFD surfaces */
+    int cmfd_surfaces[2];
+    cmfd_surfaces[0] = _cmfd->findCmfdSurface(cmfd_cell, end);
+    cmfd_surfaces[1] = _cmfd->findCmfdSurface(cmfd_cell, start);
+
+    /* Ensure surfaces are x-y surfaces (no z-crossings) */
+    /* Note: this code takes advantage of the numeric representation of
+       surfaces to find a mapping that removes z-surfaces */
+    for (int d=0; d<2; d++) {
+      int local_surface = cmfd_surfaces[d] % NUM_SURFACES;
+      if (local_surface == 2 || local_surface == 5) {
+          cmfd_surfaces[d] = -1;
+      }
+      else if (local_surface > 9) {
+        int cell = cmfd_surfaces[d] / NUM_SURFACES;
+        int half_surf = local_surface / 2;
+        if (local_surface > 17) {
+          int quart_surf = half_surf / 2;
+          local_surface = 2 + quart_surf + (half_surf == 2*quart_surf);
+          cmfd_surfaces[d] = cell * NUM_SURFACES + local_surface;
+        }
+        else {
+          local_surface = (half_surf > 6) + 3 *
+              (local_surface != 2*half_surf);
+          cmfd_surfaces[d] = cell * NUM_SURFACES + local_surface;
+        }
+      }
+    }
+
+    /* Save CMFD surfaces */
+    new_segment->_cmfd_surface_fwd = cmfd_surfaces[0];
+    new_segment->_cmfd_surface_bwd = cmfd_surfaces[1];
+
+    /* Re-nudge segments from surface. */
+    start->adjustCoords(delta_x, delta_y);
+    end->adjustCoords(delta_x, delta_y);
+  }
+
+  /* Calculate the local centroid of the segment if available */
+  //FIXME Consider reversing nudge
+  Point* starting_point = start->getHighestLevel()->getPoint();
+  new_segment->_starting_position[0] = starting_point->getX();
+  new_segment->_starting_position[1] = starting_point->getY();
+  if (_contains_FSR_centroids) {
+    Point* centroid = getFSRCentroid(fsr_id);
+    double x_start = starting_point->getX() - centroid->getX();
+    double y_start = starting_point->getY() - centroid->getY();
+    new_segment->_starting_position[0] = x_start;
+    new_segment->_starting_position[1] = y_start;
+  }
+
+  /* Add the segment to the Track */
+  track->addSegment(new_segment);
 }
 
 
@@ -1809,6 +2268,8 @@ void Geometry::initializeFlatSourceRegions() {
  * @details This method starts at the beginning of a Track and finds successive
  *          intersection points with FSRs as the Track crosses through the
  *          Geometry and creates segment structs and adds them to the Track.
+ *          The chords through pins crossed by a previous Track along the same
+ *          line are added from chord templates, without ray tracing.
  * @param track a pointer to a track to segmentize
  * @param z_coord the axial height at which the 2D plane of the geometry is
  *        formed
@@ -1820,17 +2281,10 @@ void Geometry::segmentize2D(Track* track, double z_coord) {
   double y0 = track->getStart()->getY();
   double z0 = z_coord;
   double phi = track->getPhi();
-  double delta_x, delta_y, delta_z;
-
-  /* Length of each segment */
-  double length;
-  Material* material;
-  int fsr_id;
-  int num_segments;
 
   /* Use a LocalCoords for the start and end of each segment */
-  LocalCoords start(x0, y0, z0, true);
-  LocalCoords end(x0, y0, z0, true);
+  LocalCoords& start = *getThreadCoords(0, x0, y0, z0);
+  LocalCoords& end = *getThreadCoords(1, x0, y0, z0);
   start.setUniverse(_root_universe);
   end.setUniverse(_root_universe);
 
@@ -1843,114 +2297,51 @@ void Geometry::segmentize2D(Track* track, double z_coord) {
     log_printf(ERROR, "Could not find a Cell containing the start Point "
                "of this Track: %s", track->toString().c_str());
 
+  /* Look for a chord template for the first pin */
+  ChordState chord_state;
+  enterPin(&end, phi, chord_state);
+
   /* While the end of the segment's LocalCoords is still within the Geometry,
    * move it to the next Cell, create a new segment, and add it to the
    * Geometry */
   while (curr != NULL) {
 
+    /* Add the chords of a chord template up to the last chord of the pin */
+    if (chord_state._template != NULL && !chord_state._recording)
+      if (replayChords(track, &end, phi, chord_state))
+        curr = end.getLowestLevel()->getCell();
+
     end.copyCoords(&start);
 
     /* Find the next Cell along the Track's trajectory */
     prev = curr;
     curr = findNextCell(&end, phi);
 
-    /* Checks that segment does not have the same start and end Points */
-    if (fabs(start.getX() - end.getX()) < FLT_EPSILON
-        && fabs(start.getY() - end.getY()) < FLT_EPSILON)
-      log_printf(ERROR, "Created 2D segment with same start and end "
-                 "point: x = %f, y = %f, z=%f", start.getX(), start.getY(),
-                 start.getZ());
+    /* Add the segment with its Material and FSR ID */
+    addSegment2D(track, &start, &end, prev->getFillMaterial(),
+                 findFSRId(&start), phi);
+
+    /* Record the chord and look for a template when entering a new pin */
+    bool same_pin = curr != NULL && chord_state._lattice != NULL &&
+                    inCurrentPin(&end, chord_state);
+    if (chord_state._recording)
+      recordChord(&start, &end, prev, phi, chord_state, !same_pin);
+    if (curr != NULL && !same_pin)
+      enterPin(&end, phi, chord_state);
+  }
 
-    /* Find the segment length, Material and FSR ID */
-    length = double(end.getPoint()->distanceToPoint(start.getPoint()));
-    material = prev->getFillMaterial();
-    fsr_id = findFSRId(&start);
+  log_printf(DEBUG, "Created %d segments for Track: %s",
+             track->getNumSegments(), track->toString().c_str());
 
-    /* Create a new Track segment */
-    segment* new_segment = new segment;
-    new_segment->_material = material;
-    new_segment->_length = length;
-    new_segment->_region_id = fsr_id;
+  /* Record the use of chord templates */
+  __sync_fetch_and_add(&_num_pin_crossings, chord_state._num_pins);
+  __sync_fetch_and_add(&_num_template_crossings,
+                       chord_state._num_replayed_pins);
 
-    log_printf(DEBUG, "segment start x = %f, y = %f; end x = %f, y = %f",
-               start.getX(), start.getY(), end.getX(), end.getY());
-
-    /* Save indices of CMFD Mesh surfaces that the Track segment crosses */
-    if (_cmfd != NULL) {
-
-      /* Find cmfd cell that segment lies in */
-      int cmfd_cell = _cmfd->findCmfdCell(&start);
-
-      /* Reverse nudge from surface to determine whether segment start or end
-       * points lie on a CMFD surface. */
-      delta_x = cos(phi) * TINY_MOVE;
-      delta_y = sin(phi) * TINY_MOVE;
-      start.adjustCoords(-delta_x, -delta_y);
-      end.adjustCoords(-delta_x, -delta_y);
-
-      /* Calculate CMFD surfaces */
-      int cmfd_surfaces[2];
-      cmfd_surfaces[0] = _cmfd->findCmfdSurface(cmfd_cell, &end);
-      cmfd_surfaces[1] = _cmfd->findCmfdSurface(cmfd_cell, &start);
-
-      /* Ensure surfaces are x-y surfaces (no z-crossings) */
-      /* Note: this code takes advantage of the numeric representation of
-         surfaces to find a mapping that removes z-surfaces */
-      for (int d=0; d<2; d++) {
-        int local_surface = cmfd_surfaces[d] % NUM_SURFACES;
-        if (local_surface == 2 || local_surface == 5) {
-            cmfd_surfaces[d] = -1;
-        }
-        else if (local_surface > 9) {
-          int cell = cmfd_surfaces[d] / NUM_SURFACES;
-          int half_surf = local_surface / 2;
-          if (local_surface > 17) {
-            int quart_surf = half_surf / 2;
-            local_surface = 2 + quart_surf + (half_surf == 2*quart_surf);
-            cmfd_surfaces[d] = cell * NUM_SURFACES + local_surface;
-          }
-          else {
-            local_surface = (half_surf > 6) + 3 *
-                (local_surface != 2*half_surf);
-            cmfd_surfaces[d] = cell * NUM_SURFACES + local_surface;
-          }
-        }
-      }
-
-      /* Save CMFD surfaces */
-      new_segment->_cmfd_surface_fwd = cmfd_surfaces[0];
-      new_segment->_cmfd_surface_bwd = cmfd_surfaces[1];
-
-      /* Re-nudge segments from surface. */
-      start.adjustCoords(delta_x, delta_y);
-      end.adjustCoords(delta_x, delta_y);
-    }
-
-    /* Calculate the local centroid of the segment if available */
-    //FIXME Consider reversing nudge
-    Point* starting_point = start.getHighestLevel()->getPoint();
-    new_segment->_starting_position[0] = starting_point->getX();
-    new_segment->_starting_position[1] = starting_point->getY();
-    if (_contains_FSR_centroids) {
-      Point* centroid = getFSRCentroid(fsr_id);
-      double x_start = starting_point->getX() - centroid->getX();
-      double y_start = starting_point->getY() - centroid->getY();
-      new_segment->_starting_position[0] = x_start;
-      new_segment->_starting_position[1] = y_start;
-    }
-
-    /* Add the segment to the Track */
-    track->addSegment(new_segment);
-
-  }
-
-  log_printf(DEBUG, "Created %d segments for Track: %s",
-             track->getNumSegments(), track->toString().c_str());
-
-  /* Truncate the linked list for the LocalCoords */
-  start.prune();
-  end.prune();
-}
+  /* Truncate the linked list for the LocalCoords */
+  start.prune();
+  end.prune();
+}
 
 
 /**
@@ -1979,8 +2370,8 @@ void Geometry::segmentize3D(Track3D* track, bool setup) {
   int num_segments;
 
   /* Use a LocalCoords for the start and end of each segment */
-  LocalCoords start(x0, y0, z0, true);
-  LocalCoords end(x0, y0, z0, true);
+  LocalCoords& start = *getThreadCoords(0, x0, y0, z0);
+  LocalCoords& end = *getThreadCoords(1, x0, y0, z0);
   start.setUniverse(_root_universe);
   end.setUniverse(_root_universe);
 
@@ -2157,14 +2548,14 @@ void Geometry::segmentizeExtruded(Track* flattened_track,
   int num_segments;
 
   /* Use a LocalCoords for the start and end of each segment */
-  LocalCoords start(x0, y0, z0, true);
-  LocalCoords end(x0, y0, z0, true);
+  LocalCoords& start = *getThreadCoords(0, x0, y0, z0);
+  LocalCoords& end = *getThreadCoords(1, x0, y0, z0);
   start.setUniverse(_root_universe);
   end.setUniverse(_root_universe);
 
   /* Create two localCoords to check results */
-  LocalCoords test_ext_coords(0,0,0,true);
-  LocalCoords test_start_coords(0,0,0,true);
+  LocalCoords& test_ext_coords = *getThreadCoords(2, 0, 0, 0);
+  LocalCoords& test_start_coords = *getThreadCoords(3, 0, 0, 0);
 
   /* Find the Cell containing the Track starting Point */
   Cell* curr = findFirstCell(&end, phi);
@@ -2245,7 +2636,8 @@ void Geometry::segmentizeExtruded(Track* flattened_track,
       /* Find FSR using starting coordinate */
       start.setVersionNum(v);
       region_id = findExtrudedFSR(&start); //FIXME
-      std::string fsr_key = getFSRKey(&start);
+      FSRKey fsr_key;
+      getFSRKeyFast(&start, fsr_key);
 
       /* Get the coordinate of the extruded FSR */
       LocalCoords* volatile retrieved_coords = NULL;
@@ -2267,13 +2659,14 @@ void Geometry::segmentizeExtruded(Track* flattened_track,
         test_start_coords.prune();
         test_start_coords.setVersionNum(0);
         findCellContainingCoords(&test_start_coords);
-        fsr_key = getFSRKey(&test_start_coords);
+        getFSRKeyFast(&test_start_coords, fsr_key);
 
         test_ext_coords.setZ(z_coords[i]);
         test_ext_coords.prune();
         test_ext_coords.setVersionNum(0);
         findCellContainingCoords(&test_ext_coords);
-        std::string ext_fsr_key = getFSRKey(&test_ext_coords);
+        FSRKey ext_fsr_key;
+        getFSRKeyFast(&test_ext_coords, ext_fsr_key);
 
         /* Check that FSR keys match */
         if (fsr_key != ext_fsr_key) {
@@ -2416,6 +2809,9 @@ void Geometry::initializeAxialFSRs(std::vector<double> global_z_mesh) {
     anticipated_size *= _overlaid_mesh->getNumZ();
   _FSR_keys_map.realloc(anticipated_size);
 
+  /* Allocate the LocalCoords reused by each thread for ray tracing */
+  initializeThreadCoords();
+
   /* Loop over extruded FSRs */
 #pragma omp parallel for
   for (int i=0; i < _extruded_FSR_keys_map.size(); i++) {
@@ -2491,6 +2887,7 @@ void Geometry::initializeAxialFSRs(std::vector<double> global_z_mesh) {
           level = max_z;
       extruded_FSR->_mesh[s+1] = level;
       }
+      extruded_FSR->_mesh_lookup.initialize(extruded_FSR->_mesh, num_segments);
     }
   }
   delete [] extruded_FSRs;
@@ -2505,13 +2902,221 @@ void Geometry::initializeAxialFSRs(std::vector<double> global_z_mesh) {
 }
 
 
+/**
+ * @brief Computes the center of the innermost region containing a point.
+ * @details The center accumulates the centers of the Lattice cells and the
+ *          translations of the Cells from the Root Universe down to the
+ *          lowest Cell, plus the center of the bounding box of that Cell
+ *          along the axes where it is finite. It only depends on the path of
+ *          the point through the CSG, and is therefore the same for all the
+ *          points of a region. Rotations are ignored.
+ * @param coords the highest level of the LocalCoords of the point
+ * @param center the center of the region
+ */
+static void findRegionCenter(LocalCoords* coords, double* center) {
+
+  center[0] = 0.;
+  center[1] = 0.;
+  center[2] = 0.;
+
+  for (LocalCoords* curr = coords; curr != NULL; curr = curr->getNext()) {
+
+    /* Add the center of the Lattice cell */
+    if (curr->getType() == LAT) {
+      Lattice* lattice = curr->getLattice();
+      int lat_x = curr->getLatticeX();
+      int lat_y = curr->getLatticeY();
+      int lat_z = curr->getLatticeZ();
+      center[0] += lattice->getMinX() + lattice->getWidthsX()[lat_x] / 2.
+          + lattice->getAccumulateX()[lat_x];
+      center[1] += lattice->getMinY() + lattice->getWidthsY()[lat_y] / 2.
+          + lattice->getAccumulateY()[lat_y];
+      if (lattice->getWidthZ() < FLT_INFINITY)
+        center[2] += lattice->getMinZ() + lattice->getWidthsZ()[lat_z] / 2.
+            + lattice->getAccumulateZ()[lat_z];
+      continue;
+    }
+
+    Cell* cell = curr->getCell();
+    if (cell == NULL)
+      break;
+
+    /* Add the center of the bounding box of the lowest Cell */
+    if (curr->getNext() == NULL) {
+      double min[3] = {cell->getMinX(), cell->getMinY(), cell->getMinZ()};
+      double max[3] = {cell->getMaxX(), cell->getMaxY(), cell->getMaxZ()};
+      for (int i=0; i < 3; i++)
+        if (min[i] > -FLT_INFINITY && max[i] < FLT_INFINITY)
+          center[i] += (min[i] + max[i]) / 2.;
+    }
+
+    /* Add the translation of a filled Cell */
+    else if (cell->isTranslated()) {
+      double* translation = cell->getTranslation();
+      for (int i=0; i < 3; i++)
+        center[i] += translation[i];
+    }
+  }
+}
+
+
+/**
+ * @brief Spreads the lowest 21 bits of an integer to every third bit.
+ * @param value the integer to spread
+ * @return the spread integer
+ */
+static inline uint64_t spreadMortonBits(uint64_t value) {
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffffULL;
+  value = (value | value << 16) & 0x1f0000ff0000ffULL;
+  value = (value | value << 8) & 0x100f00f00f00f00fULL;
+  value = (value | value << 4) & 0x10c30c30c30c30c3ULL;
+  value = (value | value << 2) & 0x1249249249249249ULL;
+  return value;
+}
+
+
+/**
+ * @brief Returns the Morton code of the center of the region containing a
+ *        point, used to order the regions spatially.
+ * @details The center of the region, as computed by findRegionCenter(), is
+ *          quantized on 21 bits along each axis over the bounds of the
+ *          Geometry and the bits are interleaved, so that regions close in
+ *          space are close in the ordering. Infinite axes are ignored.
+ * @param coords the highest level of the LocalCoords of a point in the
+ *        region, with all its levels found
+ * @return the Morton code of the region
+ */
+uint64_t Geometry::getMortonCode(LocalCoords* coords) {
+
+  double center[3];
+  findRegionCenter(coords, center);
+  double min[3] = {getMinX(), getMinY(), getMinZ()};
+  double max[3] = {getMaxX(), getMaxY(), getMaxZ()};
+
+  uint64_t code = 0;
+  for (int i=0; i < 3; i++) {
+    if (min[i] <= -FLT_INFINITY || max[i] >= FLT_INFINITY || max[i] <= min[i])
+      continue;
+    double fraction = (center[i] - min[i]) / (max[i] - min[i]);
+    fraction = std::min(std::max(fraction, 0.), 1.);
+    uint64_t bin = (uint64_t) (fraction * 0x1fffff);
+    code |= spreadMortonBits(bin) << (2 - i);
+  }
+  return code;
+}
+
+
+/**
+ * @brief Assigns the IDs of the regions in a map in spatial order.
+ * @details Region IDs handed out during parallel ray tracing depend on the
+ *          scheduling of threads. Ranking the regions by the Morton code of
+ *          their center, with ties broken by key, makes the IDs reproducible
+ *          for any number of threads while keeping neighboring regions close
+ *          in memory.
+ * @param keys the keys of the regions
+ * @param values the regions, in the same order as their keys
+ * @param codes the Morton codes of the regions, in the same order
+ * @param num_regions the number of regions
+ * @param id_mapping the new ID of each region, indexed by its previous ID
+ */
+template <class RegionType>
+static void renumberRegionsByKey(FSRKey* keys, RegionType** values,
+                                 std::vector<uint64_t>& codes,
+                                 long num_regions,
+                                 std::vector<long>& id_mapping) {
+
+  /* Sort the regions by Morton code, then by key */
+  std::vector<std::pair<std::pair<uint64_t, FSRKey>, long> >
+      sorted_keys(num_regions);
+  for (long i=0; i < num_regions; i++)
+    sorted_keys[i] = std::make_pair(std::make_pair(codes[i], keys[i]), i);
+  std::sort(sorted_keys.begin(), sorted_keys.end());
+
+  /* Assign the IDs in sorted order */
+  id_mapping.resize(num_regions);
+  for (long r=0; r < num_regions; r++) {
+    RegionType* region = values[sorted_keys[r].second];
+    id_mapping[region->_fsr_id] = r;
+    region->_fsr_id = r;
+  }
+}
+
+
+/**
+ * @brief Renumbers the FSRs in spatial order
+ * @details This is called once all FSRs have been found during ray tracing,
+ *          before the FSR lookup vectors are initialized. The segments which
+ *          reference the previous FSR IDs need to be updated by the caller
+ *          with the returned mapping.
+ * @param id_mapping the new ID of each FSR, indexed by its previous ID
+ */
+void Geometry::renumberFSRs(std::vector<long>& id_mapping) {
+
+  FSRKey* key_list = _FSR_keys_map.keys();
+  fsr_data** value_list = _FSR_keys_map.values();
+  long num_FSRs = _FSR_keys_map.size();
+
+  /* Find the Morton code of each FSR from its characteristic point */
+  std::vector<uint64_t> codes(num_FSRs);
+  initializeThreadCoords();
+#pragma omp parallel for
+  for (long i=0; i < num_FSRs; i++) {
+    Point* point = value_list[i]->_point;
+    LocalCoords* coords = getThreadCoords(0, point->getX(), point->getY(),
+                                          point->getZ());
+    coords->setUniverse(_root_universe);
+    findCellContainingCoords(coords);
+    codes[i] = getMortonCode(coords);
+  }
+
+  renumberRegionsByKey(key_list, value_list, codes, num_FSRs, id_mapping);
+  delete [] key_list;
+  delete [] value_list;
+}
+
+
+/**
+ * @brief Renumbers the extruded FSRs in spatial order
+ * @details This is called once all extruded FSRs have been found during
+ *          axially extruded ray tracing, before 3D FSRs are initialized. The
+ *          2D segments which reference the previous extruded FSR IDs need to
+ *          be updated by the caller with the returned mapping.
+ * @param id_mapping the new ID of each extruded FSR, indexed by its previous
+ *        ID
+ */
+void Geometry::renumberExtrudedFSRs(std::vector<long>& id_mapping) {
+
+  FSRKey* key_list = _extruded_FSR_keys_map.keys();
+  ExtrudedFSR** value_list = _extruded_FSR_keys_map.values();
+  long num_FSRs = _extruded_FSR_keys_map.size();
+
+  /* Find the Morton code of each extruded FSR from its LocalCoords */
+  std::vector<uint64_t> codes(num_FSRs);
+#pragma omp parallel for
+  for (long i=0; i < num_FSRs; i++)
+    codes[i] = getMortonCode(value_list[i]->_coords);
+
+  renumberRegionsByKey(key_list, value_list, codes, num_FSRs, id_mapping);
+  delete [] key_list;
+  delete [] value_list;
+}
+
+
 /**
  * @brief Reorders FSRs so that they are contiguous in the axial direction
+ * @details Extruded FSRs are visited in the order of their IDs so that the
+ *          3D FSR IDs only depend on the extruded FSR IDs.
  */
 void Geometry::reorderFSRIDs() {
 
-  /* Extract list of extruded FSRs */
-  ExtrudedFSR** extruded_FSRs = _extruded_FSR_keys_map.values();
+  /* Extract list of extruded FSRs, ordered by ID */
+  ExtrudedFSR** extruded_value_list = _extruded_FSR_keys_map.values();
+  ExtrudedFSR** extruded_FSRs =
+    new ExtrudedFSR*[_extruded_FSR_keys_map.size()];
+  for (int i=0; i < _extruded_FSR_keys_map.size(); i++)
+    extruded_FSRs[extruded_value_list[i]->_fsr_id] = extruded_value_list[i];
+  delete [] extruded_value_list;
 
   std::string msg = "reordering FSR IDs";
   Progress progress(_extruded_FSR_keys_map.size(), msg, 0.1, this, true);
@@ -2580,12 +3185,12 @@ void Geometry::initializeFSRVectors() {
 
   /* Get keys and values from map */
   log_printf(NORMAL, "Initializing FSR lookup vectors");
-  std::string *key_list = _FSR_keys_map.keys();
+  FSRKey *key_list = _FSR_keys_map.keys();
   fsr_data **value_list = _FSR_keys_map.values();
 
   /* Allocate vectors */
   size_t num_FSRs = _FSR_keys_map.size();
-  _FSRs_to_keys = std::vector<std::string>(num_FSRs);
+  _FSRs_to_keys = std::vector<FSRKey>(num_FSRs);
   _FSRs_to_centroids = std::vector<Point*>(num_FSRs, NULL);
   _FSRs_to_material_IDs = std::vector<int>(num_FSRs);
   _FSRs_to_CMFD_cells = std::vector<int>(num_FSRs);
@@ -2594,13 +3199,18 @@ void Geometry::initializeFSRVectors() {
   #pragma omp parallel for
   for (long i=0; i < num_FSRs; i++)
   {
-    std::string key = key_list[i];
+    FSRKey key = key_list[i];
     fsr_data* fsr = value_list[i];
     long fsr_id = fsr->_fsr_id;
     _FSRs_to_keys.at(fsr_id) = key;
     _FSRs_to_material_IDs.at(fsr_id) = fsr->_mat_id;
   }
 
+  /* Cells may have been filled with other Materials of the same IDs since
+   * the FSRs were initialized, so find the Materials ray tracing used */
+  _all_materials = getAllMaterials();
+  _FSR_cell_fills = getMaterialCellFills();
+
   /* Add cmfd information serially */
   if (_cmfd != NULL) {
     for (long i=0; i < num_FSRs; i++) {
@@ -2814,6 +3424,196 @@ std::string Geometry::toString() {
 }
 
 
+/**
+ * @brief Hashes the cells of a mesh Lattice, such as the CMFD lattice.
+ * @param hash the hash to update
+ * @param lattice the mesh Lattice, which does not need to be filled
+ */
+static void hashMeshLattice(FSRKey& hash, Lattice* lattice) {
+
+  hash.append(lattice->getNumX());
+  hash.append(lattice->getNumY());
+  hash.append(lattice->getNumZ());
+  hash.appendDouble(lattice->getMinX());
+  hash.appendDouble(lattice->getMinY());
+  hash.appendDouble(lattice->getMinZ());
+  hash.appendDouble(lattice->getWidthX());
+  hash.appendDouble(lattice->getWidthY());
+  hash.appendDouble(lattice->getWidthZ());
+
+  if (lattice->getNonUniform()) {
+    const std::vector<double>* widths[3] = {&lattice->getWidthsX(),
+                                            &lattice->getWidthsY(),
+                                            &lattice->getWidthsZ()};
+    for (int d=0; d < 3; d++)
+      for (size_t i=0; i < widths[d]->size(); i++)
+        hash.appendDouble(widths[d]->at(i));
+  }
+}
+
+
+/**
+ * @brief Hashes the type, boundary condition and coefficients of a Surface.
+ * @param hash the hash to update
+ * @param surface the Surface
+ */
+static void hashSurface(FSRKey& hash, Surface* surface) {
+
+  surfaceType st = surface->getSurfaceType();
+  hash.append(surface->getId());
+  hash.append(st);
+  hash.append(surface->getBoundaryType());
+
+  if (st == PLANE) {
+    Plane* plane = static_cast<Plane*>(surface);
+    hash.appendDouble(plane->getA());
+    hash.appendDouble(plane->getB());
+    hash.appendDouble(plane->getC());
+    hash.appendDouble(plane->getD());
+  }
+  else if (st == ZCYLINDER) {
+    ZCylinder* zcyl = static_cast<ZCylinder*>(surface);
+    hash.appendDouble(zcyl->getX0());
+    hash.appendDouble(zcyl->getY0());
+    hash.appendDouble(zcyl->getRadius());
+  }
+  else if (st == XPLANE)
+    hash.appendDouble(static_cast<XPlane*>(surface)->getX());
+  else if (st == YPLANE)
+    hash.appendDouble(static_cast<YPlane*>(surface)->getY());
+  else if (st == ZPLANE)
+    hash.appendDouble(static_cast<ZPlane*>(surface)->getZ());
+}
+
+
+/**
+ * @brief Hashes the CSG tree of a Region, with the Surfaces of its
+ *        Halfspaces.
+ * @param hash the hash to update
+ * @param region the Region
+ */
+static void hashRegion(FSRKey& hash, Region* region) {
+
+  hash.append(region->getRegionType());
+
+  if (region->getRegionType() == HALFSPACE) {
+    Halfspace* halfspace = static_cast<Halfspace*>(region);
+    hash.append(halfspace->getHalfspace());
+    hashSurface(hash, halfspace->getSurface());
+  }
+  else {
+    std::vector<Region*> nodes = region->getNodes();
+    hash.append((long) nodes.size());
+    for (size_t i=0; i < nodes.size(); i++)
+      hashRegion(hash, nodes[i]);
+  }
+}
+
+
+/**
+ * @brief Hashes the fill, transformations, subdivisions and Region of a
+ *        Cell.
+ * @param hash the hash to update
+ * @param cell the Cell
+ */
+static void hashCell(FSRKey& hash, Cell* cell) {
+
+  hash.append(KEY_CELL, cell->getId());
+  hash.append(cell->getType());
+  if (cell->getType() == MATERIAL)
+    hash.append(cell->getFillMaterial()->getId());
+  else if (cell->getType() == FILL)
+    hash.append(cell->getFillUniverse()->getId());
+
+  hash.append(cell->isRotated());
+  if (cell->isRotated()) {
+    hash.appendDouble(cell->getPhi("radians"));
+    hash.appendDouble(cell->getTheta("radians"));
+    hash.appendDouble(cell->getPsi("radians"));
+  }
+
+  hash.append(cell->isTranslated());
+  if (cell->isTranslated())
+    for (int i=0; i < 3; i++)
+      hash.appendDouble(cell->getTranslation()[i]);
+
+  hash.append(cell->getNumRings());
+  hash.append(cell->getNumSectors());
+
+  Region* region = cell->getRegion();
+  hash.append(region != NULL);
+  if (region != NULL)
+    hashRegion(hash, region);
+}
+
+
+/**
+ * @brief Hashes everything defining the FSRs of the Geometry.
+ * @details This includes the Cells with their Regions and Surfaces, the
+ *          Universes and Lattices, the overlaid axial mesh, the CMFD lattice
+ *          and the domain of this process. The data is hashed directly
+ *          rather than through a string representation of the Geometry. It
+ *          is used to identify the Track files made for this Geometry.
+ * @param hash the hash to update
+ */
+void Geometry::hashContents(FSRKey& hash) {
+
+  std::map<int, Cell*> all_cells = _root_universe->getAllCells();
+  std::map<int, Universe*> all_universes = _root_universe->getAllUniverses();
+
+  /* Hash the Cells */
+  hash.append((long) all_cells.size());
+  std::map<int, Cell*>::iterator cell_iter;
+  for (cell_iter = all_cells.begin(); cell_iter != all_cells.end();
+       ++cell_iter)
+    hashCell(hash, cell_iter->second);
+
+  /* Hash the Cells of the Universes and the layout of the Lattices */
+  hash.append((long) all_universes.size());
+  std::map<int, Universe*>::iterator univ_iter;
+  for (univ_iter = all_universes.begin(); univ_iter != all_universes.end();
+       ++univ_iter) {
+
+    Universe* universe = univ_iter->second;
+    hash.append(KEY_UNIVERSE, universe->getId());
+    hash.append(universe->getType());
+
+    if (universe->getType() == SIMPLE) {
+      std::map<int, Cell*> cells = universe->getCells();
+      hash.append((long) cells.size());
+      for (cell_iter = cells.begin(); cell_iter != cells.end(); ++cell_iter)
+        hash.append(cell_iter->first);
+    }
+    else if (universe->getType() == LATTICE) {
+      Lattice* lattice = static_cast<Lattice*>(universe);
+      hashMeshLattice(hash, lattice);
+      for (int k=0; k < lattice->getNumZ(); k++)
+        for (int j=0; j < lattice->getNumY(); j++)
+          for (int i=0; i < lattice->getNumX(); i++)
+            hash.append(lattice->getUniverse(i, j, k)->getId());
+    }
+  }
+
+  if (_overlaid_mesh != NULL)
+    hashMeshLattice(hash, _overlaid_mesh);
+
+  if (_cmfd != NULL) {
+    hash.append(_cmfd->getNumX());
+    hash.append(_cmfd->getNumY());
+    hash.append(_cmfd->getNumZ());
+    if (_cmfd->getLattice() != NULL)
+      hashMeshLattice(hash, _cmfd->getLattice());
+  }
+
+  if (isDomainDecomposed()) {
+    int indexes[3];
+    getDomainIndexes(indexes);
+    for (int i=0; i < 3; i++)
+      hash.append(indexes[i]);
+  }
+}
+
+
 /**
  * @brief Prints a string representation of all of the Geometry's attributes to
  *        the console.
@@ -3077,7 +3877,7 @@ void Geometry::initializeSpectrumCalculator(Cmfd* spectrum_calculator) {
  * @brief Returns a pointer to the map that maps FSR keys to FSR IDs
  * @return pointer to _FSR_keys_map map of FSR keys to FSR IDs
  */
-ParallelHashMap<std::string, fsr_data*>& Geometry::getFSRKeysMap() {
+ConcurrentHashMap<FSRKey, fsr_data*>& Geometry::getFSRKeysMap() {
   return _FSR_keys_map;
 }
 
@@ -3086,7 +3886,7 @@ ParallelHashMap<std::string, fsr_data*>& Geometry::getFSRKeysMap() {
  * @brief Returns a pointer to the map that maps FSR keys to extruded FSRs
  * @return pointer to _FSR_keys_map map of FSR keys to extruded FSRs
  */
-ParallelHashMap<std::string, ExtrudedFSR*>& Geometry::getExtrudedFSRKeysMap() {
+ConcurrentHashMap<FSRKey, ExtrudedFSR*>& Geometry::getExtrudedFSRKeysMap() {
   return _extruded_FSR_keys_map;
 }
 
@@ -3095,7 +3895,7 @@ ParallelHashMap<std::string, ExtrudedFSR*>& Geometry::getExtrudedFSRKeysMap() {
  * @brief Returns the vector that maps FSR IDs to FSR key hashes
  * @return _FSR_keys_map map of FSR keys to FSR IDs
  */
-std::vector<std::string>& Geometry::getFSRsToKeys() {
+std::vector<FSRKey>& Geometry::getFSRsToKeys() {
   return _FSRs_to_keys;
 }
 
@@ -3185,7 +3985,7 @@ bool Geometry::withinGlobalBounds(LocalCoords* coords) {
  */
 Cell* Geometry::findCellContainingFSR(long fsr_id) {
 
-  std::string& key = _FSRs_to_keys[fsr_id];
+  FSRKey& key = _FSRs_to_keys[fsr_id];
   Point* point = _FSR_keys_map.at(key)->_point;
   LocalCoords* coords = new LocalCoords(point->getX(), point->getY(),
                                         point->getZ(), true);
@@ -3200,7 +4000,7 @@ Cell* Geometry::findCellContainingFSR(long fsr_id) {
 
 /**
  * @brief Sets the centroid for an FSR
- * @details The _FSR_keys_map stores a hash of a std::string representing
+ * @details The _FSR_keys_map stores a 128-bit hash representing
  *          the Lattice/Cell/Universe hierarchy for a unique region
  *          and the associated FSR data. _centroid is a point that represents
  *          the numerical centroid of an FSR computed using all segments
@@ -3213,7 +4013,7 @@ Cell* Geometry::findCellContainingFSR(long fsr_id) {
  */
 void Geometry::setFSRCentroid(long fsr, Point* centroid) {
   _contains_FSR_centroids = true;
-  std::string& key = _FSRs_to_keys[fsr];
+  FSRKey& key = _FSRs_to_keys[fsr];
   _FSR_keys_map.at(key)->_centroid = centroid;
   _FSRs_to_centroids[fsr] = centroid;
 }
@@ -3428,350 +4228,439 @@ std::vector<double> Geometry::getUniqueZPlanes() {
 
 
 /**
- * @brief Prints all Geoemetry and Material details to a Geometry restart file
- * @param filename The name of the file where the data is printed
- * @param non_uniform_lattice Whether the non-uniform lattice is used to create 
- *        geometry This is to make the code compatible with old version of .geo 
- *        files.
+ * @brief Appends an array of values to a .geo file buffer.
+ * @param buffer the buffer holding a part of the .geo file
+ * @param values the array of values to append
+ * @param nmemb the number of values to append
  */
-void Geometry::dumpToFile(std::string filename, bool non_uniform_lattice) {
+template <class T>
+static void appendGeoValues(std::string& buffer, const T* values,
+                            size_t nmemb) {
+  buffer.append(reinterpret_cast<const char*>(values), nmemb * sizeof(T));
+}
 
-  FILE* out;
-  out = fopen(filename.c_str(), "w");
 
-  /* Print number of energy groups */
-  int num_groups = getNumEnergyGroups();
-  fwrite(&num_groups, sizeof(int), 1, out);
+/**
+ * @brief Appends a single value to a .geo file buffer.
+ * @param buffer the buffer holding a part of the .geo file
+ * @param value the value to append
+ */
+template <class T>
+static void appendGeoValue(std::string& buffer, T value) {
+  appendGeoValues(buffer, &value, 1);
+}
 
-  /* Print all material information */
-  std::map<int, Material*> all_materials = getAllMaterials();
-  int num_materials = all_materials.size();
-  fwrite(&num_materials, sizeof(int), 1, out);
-  std::map<int, Material*>::iterator material_iter;
-  for (material_iter = all_materials.begin();
-      material_iter != all_materials.end(); ++material_iter) {
-    int key = material_iter->first;
-    Material* mat = material_iter->second;
-    int id = mat->getId();
-    char* name = mat->getName();
-
-    /* Print key and general material information */
-    fwrite(&key, sizeof(int), 1, out);
-    fwrite(&id, sizeof(int), 1, out);
-    if (strcmp(name, "") == 0) {
-      int length = 0;
-      fwrite(&length, sizeof(int), 1, out);
-    }
-    else {
-      int length = std::char_traits<char>::length(name);
-      fwrite(&length, sizeof(int), 1, out);
-      fwrite(name, sizeof(char), length, out);
-    }
 
-    /* Print total cross-section */
-    for (int g=0; g < num_groups; g++) {
-      double value = mat->getSigmaTByGroup(g+1);
-      fwrite(&value, sizeof(double), 1, out);
-    }
+/**
+ * @brief Appends the key, ID and name of a Geometry object to a .geo file
+ *        buffer.
+ * @param buffer the buffer holding a part of the .geo file
+ * @param key the key of the object in the Geometry maps
+ * @param id the ID of the object
+ * @param name the name of the object
+ */
+static void appendGeoHeader(std::string& buffer, int key, int id,
+                            const char* name) {
+  int length = std::char_traits<char>::length(name);
+  appendGeoValue(buffer, key);
+  appendGeoValue(buffer, id);
+  appendGeoValue(buffer, length);
+  appendGeoValues(buffer, name, length);
+}
 
-    /* Print fission cross-section */
-    for (int g=0; g < num_groups; g++) {
-      double value = mat->getSigmaFByGroup(g+1);
-      fwrite(&value, sizeof(double), 1, out);
-    }
 
-    /* Print nu * fisison cross-section */
-    for (int g=0; g < num_groups; g++) {
-      double value = mat->getNuSigmaFByGroup(g+1);
-      fwrite(&value, sizeof(double), 1, out);
-    }
+/**
+ * @brief Copies an array of values out of a memory mapped .geo file.
+ * @details The bytes of each value are reversed if the file was written on
+ *          a machine of the opposite endianness (BGQ).
+ * @param values the array to fill with the values read
+ * @param nmemb the number of values to read
+ * @param buffer the position in the file, advanced past the values read
+ * @param end the end of the mapped file
+ * @param twiddle whether to reverse the bytes of each value
+ */
+template <class T>
+static void readGeoValues(T* values, size_t nmemb, const char*& buffer,
+                          const char* end, bool twiddle) {
+
+  size_t size = nmemb * sizeof(T);
+  if (size > (size_t) (end - buffer))
+    log_printf(ERROR, "Unable to read past the end of the Geometry file");
+  memcpy(values, buffer, size);
+  buffer += size;
+
+  if (twiddle && sizeof(T) == sizeof(uint32_t)) {
+    uint32_t* arr = reinterpret_cast<uint32_t*>(values);
+    for (size_t i=0; i < nmemb; i++)
+      arr[i] = __builtin_bswap32(arr[i]);
+  }
+  else if (twiddle && sizeof(T) == sizeof(uint64_t)) {
+    uint64_t* arr = reinterpret_cast<uint64_t*>(values);
+    for (size_t i=0; i < nmemb; i++)
+      arr[i] = __builtin_bswap64(arr[i]);
+  }
+}
 
-    /* Print neutron emission spectrum (chi) */
-    for (int g=0; g < num_groups; g++) {
-      double value = mat->getChiByGroup(g+1);
-      fwrite(&value, sizeof(double), 1, out);
-    }
 
-    /* Print scattering cross-section */
-    for (int g=0; g < num_groups; g++) {
-      for (int gp=0; gp < num_groups; gp++) {
-        double value = mat->getSigmaSByGroup(g+1, gp+1);
-        fwrite(&value, sizeof(double), 1, out);
-      }
-    }
-  }
+/**
+ * @brief Reads a single value from a memory mapped .geo file.
+ * @param buffer the position in the file, advanced past the value read
+ * @param end the end of the mapped file
+ * @param twiddle whether to reverse the bytes of the value
+ * @return the value read
+ */
+template <class T>
+static T readGeoValue(const char*& buffer, const char* end, bool twiddle) {
+  T value;
+  readGeoValues(&value, 1, buffer, end, twiddle);
+  return value;
+}
 
-  /* Print root universe ID */
-  int root_id = _root_universe->getId();
-  fwrite(&root_id, sizeof(int), 1, out);
 
-  /* Retrieve all surfaces, cells, and universes */
-  std::map<int, Surface*> all_surfaces = getAllSurfaces();
-  std::map<int, Cell*> all_cells = _root_universe->getAllCells();
-  std::map<int, Universe*> all_universes = _root_universe->getAllUniverses();
+/**
+ * @brief Skips an array of values in a memory mapped .geo file.
+ * @param nmemb the number of values to skip
+ * @param buffer the position in the file, advanced past the values
+ * @param end the end of the mapped file
+ */
+template <class T>
+static void skipGeoValues(size_t nmemb, const char*& buffer,
+                          const char* end) {
+  size_t size = nmemb * sizeof(T);
+  if (size > (size_t) (end - buffer))
+    log_printf(ERROR, "Unable to read past the end of the Geometry file");
+  buffer += size;
+}
 
-  std::map<int, Surface*>::iterator surface_iter;
-  std::map<int, Cell*>::iterator cell_iter;
-  std::map<int, Universe*>::iterator univ_iter;
 
-  /* Print all surface information */
-  int num_surfaces = all_surfaces.size();
-  fwrite(&num_surfaces, sizeof(int), 1, out);
-  for (surface_iter = all_surfaces.begin(); surface_iter != all_surfaces.end();
-      ++surface_iter) {
-
-    /* Get key, value pair and general surface information */
-    int key = surface_iter->first;
-    Surface* value = surface_iter->second;
-    int id = value->getId();
-    char* name = value->getName();
-    surfaceType st = value->getSurfaceType();
-    boundaryType bt = value->getBoundaryType();
-
-    /* Print key and general surface information */
-    fwrite(&key, sizeof(int), 1, out);
-    fwrite(&id, sizeof(int), 1, out);
-    if (strcmp(name, "") == 0) {
-      int length = 0;
-      fwrite(&length, sizeof(int), 1, out);
-    }
-    else {
-      int length = std::char_traits<char>::length(name);
-      fwrite(&length, sizeof(int), 1, out);
-      fwrite(name, sizeof(char), length, out);
-    }
-    fwrite(&st, sizeof(surfaceType), 1, out);
-    fwrite(&bt, sizeof(boundaryType), 1, out);
-
-    /* Treat specific surface types */
-    if (st == PLANE) {
-      Plane* pl = static_cast<Plane*>(value);
-      double a = pl->getA();
-      double b = pl->getB();
-      double c = pl->getC();
-      double d = pl->getD();
-      fwrite(&a, sizeof(double), 1, out);
-      fwrite(&b, sizeof(double), 1, out);
-      fwrite(&c, sizeof(double), 1, out);
-      fwrite(&d, sizeof(double), 1, out);
-    }
-    else if (st == ZCYLINDER) {
-      ZCylinder* zcyl = static_cast<ZCylinder*>(value);
-      double x = zcyl->getX0();
-      double y = zcyl->getY0();
-      double radius = zcyl->getRadius();
-      fwrite(&x, sizeof(double), 1, out);
-      fwrite(&y, sizeof(double), 1, out);
-      fwrite(&radius, sizeof(double), 1, out);
-    }
-    else if (st == XPLANE) {
-      XPlane* xpl = static_cast<XPlane*>(value);
-      double x = xpl->getX();
-      fwrite(&x, sizeof(double), 1, out);
-    }
-    else if (st == YPLANE) {
-      YPlane* ypl = static_cast<YPlane*>(value);
-      double y = ypl->getY();
-      fwrite(&y, sizeof(double), 1, out);
-    }
-    else if (st == ZPLANE) {
-      ZPlane* zpl = static_cast<ZPlane*>(value);
-      double z = zpl->getZ();
-      fwrite(&z, sizeof(double), 1, out);
-    }
-    else {
-      log_printf(ERROR, "Unsupported surface type for surface ID: %d, name:",
-                 " %s", id, name);
-    }
-  }
+/**
+ * @brief Reads the key, ID and name of a Geometry object from a memory
+ *        mapped .geo file.
+ * @param key the key of the object in the Geometry maps
+ * @param id the ID of the object
+ * @param buffer the position in the file, advanced past the header
+ * @param end the end of the mapped file
+ * @param twiddle whether to reverse the bytes of the values
+ * @return the name of the object
+ */
+static std::string readGeoHeader(int& key, int& id, const char*& buffer,
+                                 const char* end, bool twiddle) {
+  key = readGeoValue<int>(buffer, end, twiddle);
+  id = readGeoValue<int>(buffer, end, twiddle);
+  int length = readGeoValue<int>(buffer, end, twiddle);
+  if (length < 0 || length > end - buffer)
+    log_printf(ERROR, "Unable to read past the end of the Geometry file");
+  std::string name(buffer, length);
+  buffer += length;
+  return name;
+}
 
-  /* Print all cell information */
-  int num_cells = all_cells.size();
-  fwrite(&num_cells, sizeof(int), 1, out);
-  for (cell_iter = all_cells.begin(); cell_iter != all_cells.end();
-      ++cell_iter) {
 
-    /* Get key, value pair and general cell information */
-    int key = cell_iter->first;
-    Cell* cell = cell_iter->second;
-    int id = cell->getId();
-    char* name = cell->getName();
-    cellType ct = cell->getType();
-    
-    /* Print key and general surface information */
-    fwrite(&key, sizeof(int), 1, out);
-    fwrite(&id, sizeof(int), 1, out);
-    if (strcmp(name, "") == 0) {
-      int length = 0;
-      fwrite(&length, sizeof(int), 1, out);
-    }
-    else {
-      int length = std::char_traits<char>::length(name);
-      fwrite(&length, sizeof(int), 1, out);
-      fwrite(name, sizeof(char), length, out);
-    }
-    fwrite(&ct, sizeof(cellType), 1, out);
+/**
+ * @brief Finds an object loaded from a .geo file by its ID.
+ * @param objects the objects loaded, indexed by ID
+ * @param id the ID of the object
+ * @param type the type of object, for error messages
+ * @return the object
+ */
+template <class T>
+static T* findGeoObject(std::map<int, T*>& objects, int id, const char* type) {
+  typename std::map<int, T*>::iterator iter = objects.find(id);
+  if (iter == objects.end())
+    log_printf(ERROR, "Unable to find %s %d in the Geometry file", type, id);
+  return iter->second;
+}
 
-    if (ct == MATERIAL) {
-      Material* mat = cell->getFillMaterial();
-      int mat_id = mat->getId();
-      fwrite(&mat_id, sizeof(int), 1, out);
-    }
-    else if (ct == FILL) {
-      Universe* univ = cell->getFillUniverse();
-      int univ_id = univ->getId();
-      fwrite(&univ_id, sizeof(int), 1, out);
-    }
 
-    /* Print cell rotations */
-    bool rot = cell->isRotated();
-    fwrite(&rot, sizeof(bool), 1, out);
-    if (rot) {
-      double rotation[3];
-      rotation[0] = cell->getPhi("radians");
-      rotation[1] = cell->getTheta("radians");
-      rotation[2] = cell->getPsi("radians");
-      fwrite(rotation, sizeof(double), 3, out);
-    }
+/**
+ * @brief Records the first exception thrown by the threads reading a .geo
+ *        file, to be thrown again once the threads are done.
+ * @details Exceptions cannot leave an OpenMP parallel region. This must be
+ *          called from a catch block.
+ * @param error the first exception thrown
+ * @param failed whether an exception was thrown, set by this method
+ */
+static void recordGeoError(std::exception_ptr& error, volatile bool& failed) {
+#pragma omp critical (geo_error)
+  {
+    if (!failed)
+      error = std::current_exception();
+    failed = true;
+  }
+}
 
-    /* Print cell translations */
-    bool trans = cell->isTranslated();
-    fwrite(&trans, sizeof(bool), 1, out);
-    if (trans) {
-      double* translation = cell->getTranslation();
-      fwrite(translation, sizeof(double), 3, out);
-    }
 
-    /* Print ring / sector information */
-    int num_rings = cell->getNumRings();
-    int num_sectors = cell->getNumSectors();
-    fwrite(&num_rings, sizeof(int), 1, out);
-    fwrite(&num_sectors, sizeof(int), 1, out);
-
-    /* Print parent cell */
-    bool has_parent = cell->hasParent();
-    fwrite(&has_parent, sizeof(bool), 1, out);
-    if (has_parent) {
-      int parent_id = cell->getParent()->getId();
-      fwrite(&parent_id, sizeof(int), 1, out);
-    }
+/**
+ * @brief Prints all Geoemetry and Material details to a Geometry restart file
+ * @details Each Material, Surface, Cell and Universe is serialized in
+ *          parallel in its own buffer, and the buffers are then written to
+ *          the file at once.
+ * @param filename The name of the file where the data is printed
+ * @param non_uniform_lattice Whether the non-uniform lattice is used to create
+ *        geometry This is to make the code compatible with old version of .geo
+ *        files.
+ */
+void Geometry::dumpToFile(std::string filename, bool non_uniform_lattice) {
+
+  /* Retrieve all materials, surfaces, cells, and universes in the order in
+   * which they are printed. Materials and surfaces are found from the cells
+   * rather than by walking the Geometry again. */
+  std::map<int, Cell*> all_cells = _root_universe->getAllCells();
+  std::map<int, Universe*> all_universes = _root_universe->getAllUniverses();
+  std::map<int, Material*> all_materials;
+  std::map<int, Surface*> all_surfaces;
+  std::map<int, Cell*>::iterator cell_iter;
+  for (cell_iter = all_cells.begin(); cell_iter != all_cells.end();
+       ++cell_iter) {
+    Cell* cell = cell_iter->second;
+    if (cell->getType() == MATERIAL && cell->getFillMaterial() != NULL)
+      all_materials[cell->getFillMaterial()->getId()] =
+           cell->getFillMaterial();
+    std::map<int, Halfspace*> halfspaces = cell->getSurfaces();
+    std::map<int, Halfspace*>::iterator surf_iter;
+    for (surf_iter = halfspaces.begin(); surf_iter != halfspaces.end();
+         ++surf_iter)
+      all_surfaces[surf_iter->second->_surface->getId()] =
+           surf_iter->second->_surface;
+  }
 
-    /* Print region and halfspaces */
-    Region* region = cell->getRegion();
-    std::vector<Region*> all_nodes;
-    std::vector<Region*>::iterator node_iter;
+  std::vector<std::pair<int, Material*> > materials(all_materials.begin(),
+                                                    all_materials.end());
+  std::vector<std::pair<int, Surface*> > surfaces(all_surfaces.begin(),
+                                                  all_surfaces.end());
+  std::vector<std::pair<int, Cell*> > cells(all_cells.begin(),
+                                            all_cells.end());
+  std::vector<std::pair<int, Universe*> > universes(all_universes.begin(),
+                                                    all_universes.end());
 
-    if (region != NULL) {
-      /* Add local Region, head of the CSG Region tree, to the printed nodes */
-      all_nodes = region->getAllNodes();
-      all_nodes.insert(all_nodes.begin(), region);
-    }
+  int num_groups = getNumEnergyGroups();
+  int num_materials = materials.size();
+  int num_surfaces = surfaces.size();
+  int num_cells = cells.size();
+  int num_universes = universes.size();
 
-    int num_nodes = all_nodes.size();
-    fwrite(&num_nodes, sizeof(int), 1, out);
+  std::vector<std::string> material_buffers(num_materials);
+  std::vector<std::string> surface_buffers(num_surfaces);
+  std::vector<std::string> cell_buffers(num_cells);
+  std::vector<std::string> universe_buffers(num_universes);
 
-    for (node_iter = all_nodes.begin(); node_iter != all_nodes.end();
-         ++node_iter) {
+#pragma omp parallel
+  {
 
-      int region_type = (*node_iter)->getRegionType();
-      int num_subnodes = (*node_iter)->getAllNodes().size();
-      fwrite(&region_type, sizeof(int), 1, out);
-      fwrite(&num_subnodes, sizeof(int), 1, out);
+    /* Print all material information */
+#pragma omp for schedule(dynamic) nowait
+    for (int i=0; i < num_materials; i++) {
+
+      std::string& buffer = material_buffers[i];
+      Material* mat = materials[i].second;
+      appendGeoHeader(buffer, materials[i].first, mat->getId(),
+                      mat->getName());
+
+      /* Print total, fission and nu * fission cross-sections, neutron
+       * emission spectrum (chi) and scattering cross-section */
+      for (int g=0; g < num_groups; g++)
+        appendGeoValue(buffer, (double) mat->getSigmaTByGroup(g+1));
+      for (int g=0; g < num_groups; g++)
+        appendGeoValue(buffer, (double) mat->getSigmaFByGroup(g+1));
+      for (int g=0; g < num_groups; g++)
+        appendGeoValue(buffer, (double) mat->getNuSigmaFByGroup(g+1));
+      for (int g=0; g < num_groups; g++)
+        appendGeoValue(buffer, (double) mat->getChiByGroup(g+1));
+      for (int g=0; g < num_groups; g++)
+        for (int gp=0; gp < num_groups; gp++)
+          appendGeoValue(buffer, (double) mat->getSigmaSByGroup(g+1, gp+1));
+    }
 
-      if (region_type == HALFSPACE) {
-        int surface_id = 
-             static_cast<Halfspace*>(*node_iter)->getSurface()->getId();
-        int halfspace = static_cast<Halfspace*>(*node_iter)->getHalfspace();
-        fwrite(&surface_id, sizeof(int), 1, out);
-        fwrite(&halfspace, sizeof(int), 1, out);
+    /* Print all surface information */
+#pragma omp for schedule(dynamic) nowait
+    for (int i=0; i < num_surfaces; i++) {
+
+      std::string& buffer = surface_buffers[i];
+      Surface* value = surfaces[i].second;
+      int id = value->getId();
+      char* name = value->getName();
+      surfaceType st = value->getSurfaceType();
+      boundaryType bt = value->getBoundaryType();
+      appendGeoHeader(buffer, surfaces[i].first, id, name);
+      appendGeoValue(buffer, st);
+      appendGeoValue(buffer, bt);
+
+      /* Treat specific surface types */
+      if (st == PLANE) {
+        Plane* pl = static_cast<Plane*>(value);
+        appendGeoValue(buffer, pl->getA());
+        appendGeoValue(buffer, pl->getB());
+        appendGeoValue(buffer, pl->getC());
+        appendGeoValue(buffer, pl->getD());
+      }
+      else if (st == ZCYLINDER) {
+        ZCylinder* zcyl = static_cast<ZCylinder*>(value);
+        appendGeoValue(buffer, zcyl->getX0());
+        appendGeoValue(buffer, zcyl->getY0());
+        appendGeoValue(buffer, zcyl->getRadius());
       }
+      else if (st == XPLANE)
+        appendGeoValue(buffer, static_cast<XPlane*>(value)->getX());
+      else if (st == YPLANE)
+        appendGeoValue(buffer, static_cast<YPlane*>(value)->getY());
+      else if (st == ZPLANE)
+        appendGeoValue(buffer, static_cast<ZPlane*>(value)->getZ());
+      else
+        log_printf(ERROR, "Unsupported surface type for surface ID: %d, "
+                   "name: %s", id, name);
     }
 
-    //FIXME Print neighbors or decide to re-compute them
-  }
+    /* Print all cell information */
+#pragma omp for schedule(dynamic) nowait
+    for (int i=0; i < num_cells; i++) {
+
+      std::string& buffer = cell_buffers[i];
+      Cell* cell = cells[i].second;
+      cellType ct = cell->getType();
+      appendGeoHeader(buffer, cells[i].first, cell->getId(), cell->getName());
+      appendGeoValue(buffer, ct);
+
+      if (ct == MATERIAL)
+        appendGeoValue(buffer, cell->getFillMaterial()->getId());
+      else if (ct == FILL)
+        appendGeoValue(buffer, cell->getFillUniverse()->getId());
+
+      /* Print cell rotations */
+      bool rot = cell->isRotated();
+      appendGeoValue(buffer, rot);
+      if (rot) {
+        appendGeoValue(buffer, cell->getPhi("radians"));
+        appendGeoValue(buffer, cell->getTheta("radians"));
+        appendGeoValue(buffer, cell->getPsi("radians"));
+      }
 
-  /* Print all universe information */
-  int num_universes = all_universes.size();
-  fwrite(&num_universes, sizeof(int), 1, out);
-  for (univ_iter = all_universes.begin();
-       univ_iter != all_universes.end(); ++univ_iter) {
+      /* Print cell translations */
+      bool trans = cell->isTranslated();
+      appendGeoValue(buffer, trans);
+      if (trans)
+        appendGeoValues(buffer, cell->getTranslation(), 3);
+
+      /* Print ring / sector information */
+      appendGeoValue(buffer, cell->getNumRings());
+      appendGeoValue(buffer, cell->getNumSectors());
+
+      /* Print parent cell */
+      bool has_parent = cell->hasParent();
+      appendGeoValue(buffer, has_parent);
+      if (has_parent)
+        appendGeoValue(buffer, cell->getParent()->getId());
+
+      /* Print region and halfspaces */
+      Region* region = cell->getRegion();
+      std::vector<Region*> all_nodes;
+      std::vector<Region*>::iterator node_iter;
+
+      if (region != NULL) {
+        /* Add local Region, head of the CSG Region tree, to the printed
+         * nodes */
+        all_nodes = region->getAllNodes();
+        all_nodes.insert(all_nodes.begin(), region);
+      }
 
-    /* Get key, value pair and general cell information */
-    int key = univ_iter->first;
-    Universe* universe = univ_iter->second;
-    int id = universe->getId();
-    char* name = universe->getName();
-    universeType ut = universe->getType();
-    
-    /* Print key and general surface information */
-    fwrite(&key, sizeof(int), 1, out);
-    fwrite(&id, sizeof(int), 1, out);
-    if (strcmp(name, "") == 0) {
-      int length = 0;
-      fwrite(&length, sizeof(int), 1, out);
-    }
-    else {
-      int length = std::char_traits<char>::length(name);
-      fwrite(&length, sizeof(int), 1, out);
-      fwrite(name, sizeof(char), length, out);
-    }
-    fwrite(&ut, sizeof(universeType), 1, out);
+      appendGeoValue(buffer, (int) all_nodes.size());
+      for (node_iter = all_nodes.begin(); node_iter != all_nodes.end();
+           ++node_iter) {
 
-    if (ut == SIMPLE) {
-      /* Print all cells in the universe */
-      std::map<int, Cell*> cells = universe->getCells();
-      int num_universe_cells = cells.size();
-      fwrite(&num_universe_cells, sizeof(int), 1, out);
-      for (cell_iter = cells.begin(); cell_iter != cells.end(); ++cell_iter) {
-        int cell_id = cell_iter->first;
-        fwrite(&cell_id, sizeof(int), 1, out);
+        int region_type = (*node_iter)->getRegionType();
+        int num_subnodes = (*node_iter)->getAllNodes().size();
+        appendGeoValue(buffer, region_type);
+        appendGeoValue(buffer, num_subnodes);
+
+        if (region_type == HALFSPACE) {
+          Halfspace* halfspace = static_cast<Halfspace*>(*node_iter);
+          appendGeoValue(buffer, halfspace->getSurface()->getId());
+          appendGeoValue(buffer, halfspace->getHalfspace());
+        }
       }
+
+      //FIXME Print neighbors or decide to re-compute them
     }
-    else if (ut == LATTICE) {
-      /* Print lattice information */
-      Lattice* lattice = static_cast<Lattice*>(universe);
-      int num_x = lattice->getNumX();
-      int num_y = lattice->getNumY();
-      int num_z = lattice->getNumZ();
-      double width_x = lattice->getWidthX();
-      double width_y = lattice->getWidthY();
-      double width_z = lattice->getWidthZ();
-      double* offset = lattice->getOffset()->getXYZ();
-      fwrite(&num_x, sizeof(int), 1, out);
-      fwrite(&num_y, sizeof(int), 1, out);
-      fwrite(&num_z, sizeof(int), 1, out);
-      fwrite(&width_x, sizeof(double), 1, out);
-      fwrite(&width_y, sizeof(double), 1, out);
-      fwrite(&width_z, sizeof(double), 1, out);
-      fwrite(offset, sizeof(double), 3, out);
-      if(non_uniform_lattice) {
-        bool non_uniform = lattice->getNonUniform();
-        const std::vector<double> widths_x = lattice->getWidthsX();
-        const std::vector<double> widths_y = lattice->getWidthsY();
-        const std::vector<double> widths_z = lattice->getWidthsZ();
-        fwrite(&non_uniform, sizeof(bool), 1, out);
-        fwrite(&widths_x[0], sizeof(double), num_x, out);
-        fwrite(&widths_y[0], sizeof(double), num_y, out);
-        fwrite(&widths_z[0], sizeof(double), num_z, out);
+
+    /* Print all universe information */
+#pragma omp for schedule(dynamic) nowait
+    for (int n=0; n < num_universes; n++) {
+
+      std::string& buffer = universe_buffers[n];
+      Universe* universe = universes[n].second;
+      universeType ut = universe->getType();
+      appendGeoHeader(buffer, universes[n].first, universe->getId(),
+                      universe->getName());
+      appendGeoValue(buffer, ut);
+
+      if (ut == SIMPLE) {
+        /* Print all cells in the universe */
+        std::map<int, Cell*> universe_cells = universe->getCells();
+        std::map<int, Cell*>::iterator cell_iter;
+        appendGeoValue(buffer, (int) universe_cells.size());
+        for (cell_iter = universe_cells.begin();
+             cell_iter != universe_cells.end(); ++cell_iter)
+          appendGeoValue(buffer, cell_iter->first);
       }
+      else if (ut == LATTICE) {
+        /* Print lattice information */
+        Lattice* lattice = static_cast<Lattice*>(universe);
+        int num_x = lattice->getNumX();
+        int num_y = lattice->getNumY();
+        int num_z = lattice->getNumZ();
+        appendGeoValue(buffer, num_x);
+        appendGeoValue(buffer, num_y);
+        appendGeoValue(buffer, num_z);
+        appendGeoValue(buffer, lattice->getWidthX());
+        appendGeoValue(buffer, lattice->getWidthY());
+        appendGeoValue(buffer, lattice->getWidthZ());
+        appendGeoValues(buffer, lattice->getOffset()->getXYZ(), 3);
+        if(non_uniform_lattice) {
+          appendGeoValue(buffer, lattice->getNonUniform());
+          appendGeoValues(buffer, &lattice->getWidthsX()[0], num_x);
+          appendGeoValues(buffer, &lattice->getWidthsY()[0], num_y);
+          appendGeoValues(buffer, &lattice->getWidthsZ()[0], num_z);
+        }
 
-      /* Get universes */
-      Universe* universes[num_x * num_y * num_z];
-      for (int i=0; i < num_x; i++) {
-        for (int j=0; j < num_y; j++) {
-          for (int k =0; k < num_z; k++) {
-            int idx = (num_z-1-k) * num_x * num_y + (num_y-1-j) * num_x + i;
-            universes[idx] = lattice->getUniverse(i, j, k);
+        /* Print universes, from the upper left corner in row major order */
+        std::vector<int> universe_ids(num_x * num_y * num_z);
+        for (int i=0; i < num_x; i++) {
+          for (int j=0; j < num_y; j++) {
+            for (int k =0; k < num_z; k++) {
+              int idx = (num_z-1-k) * num_x * num_y + (num_y-1-j) * num_x + i;
+              universe_ids[idx] = lattice->getUniverse(i, j, k)->getId();
+            }
           }
         }
-      }
-      for (int i=0; i < num_x * num_y * num_z; i++) {
-        int universe_id = universes[i]->getId();
-        fwrite(&universe_id, sizeof(int), 1, out);
+        appendGeoValues(buffer, &universe_ids[0], universe_ids.size());
       }
     }
   }
 
+  /* Assemble the file */
+  std::string contents;
+  appendGeoValue(contents, num_groups);
+  appendGeoValue(contents, num_materials);
+  for (int i=0; i < num_materials; i++)
+    contents += material_buffers[i];
+  appendGeoValue(contents, _root_universe->getId());
+  appendGeoValue(contents, num_surfaces);
+  for (int i=0; i < num_surfaces; i++)
+    contents += surface_buffers[i];
+  appendGeoValue(contents, num_cells);
+  for (int i=0; i < num_cells; i++)
+    contents += cell_buffers[i];
+  appendGeoValue(contents, num_universes);
+  for (int i=0; i < num_universes; i++)
+    contents += universe_buffers[i];
+
+  /* Write the file at once */
+  FILE* out = fopen(filename.c_str(), "w");
+  if (out == NULL)
+    log_printf(ERROR, "Unable to open Geometry file %s", filename.c_str());
+  if (fwrite(contents.data(), sizeof(char), contents.size(), out) !=
+      contents.size())
+    log_printf(ERROR, "Unable to write Geometry file %s", filename.c_str());
+
   /* Close the output file */
   fclose(out);
 }
@@ -3779,6 +4668,12 @@ void Geometry::dumpToFile(std::string filename, bool non_uniform_lattice) {
 
 /**
  * @brief Loads all Geoemetry and Material details from a Geometry restart file
+ * @details The file is memory mapped. An index pass allocates every object
+ *          in file order, since the ID registries of the Materials, Cells
+ *          and Universes are not thread safe, and records where the data of
+ *          each object starts. The objects are then filled in parallel, the
+ *          references between them being resolved against the objects
+ *          indexed. Lattices are finally linked to their Universes.
  * @param filename The name of the file from which the data is loaded
  * @param twiddle Whether the bytes are inverted (BGQ) or not
  * @param non_uniform_lattice Option whether the .geo file in non-uniform format
@@ -3789,8 +4684,23 @@ void Geometry::loadFromFile(std::string filename, bool non_uniform_lattice,
   _twiddle = twiddle;
   _loaded_from_file = true;
 
-  FILE* in;
-  in = fopen(filename.c_str(), "r");
+  /* Map the whole file in memory */
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    log_printf(ERROR, "Unable to open Geometry file %s", filename.c_str());
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+    close(fd);
+    log_printf(ERROR, "Unable to open Geometry file %s", filename.c_str());
+  }
+  size_t file_size = file_stat.st_size;
+  char* map = (char*) mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    log_printf(ERROR, "Unable to map Geometry file %s", filename.c_str());
+  madvise(map, file_size, MADV_WILLNEED);
+  const char* buffer = map;
+  const char* end = map + file_size;
 
   if (_root_universe != NULL)
     delete _root_universe;
@@ -3802,409 +4712,405 @@ void Geometry::loadFromFile(std::string filename, bool non_uniform_lattice,
   std::map<int, Universe*> all_universes;
   std::map<int, Material*> all_materials;
 
-  std::map<int, int> fill_cell_universes;
-  std::map<int, int> cell_parent;
-  std::map<int, int*> lattice_universes;
-
-  /* Read number of energy groups */
-  int num_groups;
-  int ret = twiddleRead(&num_groups, sizeof(int), 1, in);
-
-  /* Read all material infromation */
-  int num_materials;
-  ret = twiddleRead(&num_materials, sizeof(int), 1, in);
-  for (int i=0; i < num_materials; i++) {
-
-    /* Get key, value pair and cross section information */
-    int key, id;
-    int length;
-    char* str;
-    const char* name;
-    ret = twiddleRead(&key, sizeof(int), 1, in);
-    ret = twiddleRead(&id, sizeof(int), 1, in);
-    ret = twiddleRead(&length, sizeof(int), 1, in);
-    if (length > 0) {
-      str = new char[length+1];
-      ret = twiddleRead(str, sizeof(char), length, in);
-      str[length] = '\0';
-      name = str;
-    }
-    else {
-      name = "";
-    }
-
-    /* Create Material */
-    all_materials[key] = new Material(id, name);
-    Material* mat = all_materials[key];
-    mat->setNumEnergyGroups(num_groups);
+  /* Release the mapped file if the Geometry cannot be read */
+  try {
 
-    /* Set total cross-section */
-    double value;
-    for (int g=0; g < num_groups; g++) {
-      ret = twiddleRead(&value, sizeof(double), 1, in);
-      mat->setSigmaTByGroup(value, g+1);
+    /* Read number of energy groups */
+    int num_groups = readGeoValue<int>(buffer, end, twiddle);
+    int num_xs = 4 * num_groups + num_groups * num_groups;
+
+    /* Index all materials */
+    int num_materials = readGeoValue<int>(buffer, end, twiddle);
+    std::vector<Material*> materials(num_materials);
+    std::vector<const char*> material_data(num_materials);
+    for (int i=0; i < num_materials; i++) {
+      int key, id;
+      std::string name = readGeoHeader(key, id, buffer, end, twiddle);
+      materials[i] = new Material(id, name.c_str());
+      all_materials[key] = materials[i];
+      material_data[i] = buffer;
+      skipGeoValues<double>(num_xs, buffer, end);
     }
 
-    /* Set fission cross-section */
-    for (int g=0; g < num_groups; g++) {
-      ret = twiddleRead(&value, sizeof(double), 1, in);
-      mat->setSigmaFByGroup(value, g+1);
-    }
+    /* Read root universe ID */
+    int root_id = readGeoValue<int>(buffer, end, twiddle);
 
-    /* Set nu * fisison cross-section */
-    for (int g=0; g < num_groups; g++) {
-      ret = twiddleRead(&value, sizeof(double), 1, in);
-      mat->setNuSigmaFByGroup(value, g+1);
-    }
+    /* Read all surface information, surfaces being created with their data */
+    int num_surfaces = readGeoValue<int>(buffer, end, twiddle);
+    for (int i=0; i < num_surfaces; i++) {
 
-    /* Set neutron emission spectrum (chi) */
-    for (int g=0; g < num_groups; g++) {
-      ret = twiddleRead(&value, sizeof(double), 1, in);
-      mat->setChiByGroup(value, g+1);
-    }
+      int key, id;
+      std::string name = readGeoHeader(key, id, buffer, end, twiddle);
+      surfaceType st = readGeoValue<surfaceType>(buffer, end, twiddle);
+      boundaryType bt = readGeoValue<boundaryType>(buffer, end, twiddle);
 
-    /* Set scattering cross-section */
-    for (int g=0; g < num_groups; g++) {
-      for (int gp=0; gp < num_groups; gp++) {
-        ret = twiddleRead(&value, sizeof(double), 1, in);
-        mat->setSigmaSByGroup(value, g+1, gp+1);
+      /* Treat specific surface types */
+      double coeffs[4];
+      if (st == PLANE) {
+        readGeoValues(coeffs, 4, buffer, end, twiddle);
+        all_surfaces[key] = new Plane(coeffs[0], coeffs[1], coeffs[2],
+                                      coeffs[3], id, name.c_str());
+      }
+      else if (st == ZCYLINDER) {
+        readGeoValues(coeffs, 3, buffer, end, twiddle);
+        all_surfaces[key] = new ZCylinder(coeffs[0], coeffs[1], coeffs[2], id,
+                                          name.c_str());
+      }
+      else if (st == XPLANE) {
+        readGeoValues(coeffs, 1, buffer, end, twiddle);
+        all_surfaces[key] = new XPlane(coeffs[0], id, name.c_str());
+      }
+      else if (st == YPLANE) {
+        readGeoValues(coeffs, 1, buffer, end, twiddle);
+        all_surfaces[key] = new YPlane(coeffs[0], id, name.c_str());
+      }
+      else if (st == ZPLANE) {
+        readGeoValues(coeffs, 1, buffer, end, twiddle);
+        all_surfaces[key] = new ZPlane(coeffs[0], id, name.c_str());
+      }
+      else {
+        log_printf(ERROR, "Unsupported surface type %s", name.c_str());
       }
-    }
-  }
 
-  /* Read root universe ID */
-  int root_id;
-  ret = twiddleRead(&root_id, sizeof(int), 1, in);
-
-  /* Read all surface information */
-  int num_surfaces;
-  ret = twiddleRead(&num_surfaces, sizeof(int), 1, in);
-  for (int i=0; i < num_surfaces; i++) {
-
-    /* Get key, value pair and general surface information */
-    int key, id;
-    int length;
-    char* str;
-    const char* name;
-    ret = twiddleRead(&key, sizeof(int), 1, in);
-    ret = twiddleRead(&id, sizeof(int), 1, in);
-    ret = twiddleRead(&length, sizeof(int), 1, in);
-    if (length > 0) {
-      str = new char[length+1];
-      ret = twiddleRead(str, sizeof(char), length, in);
-      str[length] = '\0';
-      name = str;
-    }
-    else {
-      name = "";
-    }
-    surfaceType st;
-    boundaryType bt;
-    ret = twiddleRead(&st, sizeof(surfaceType), 1, in);
-    ret = twiddleRead(&bt, sizeof(boundaryType), 1, in);
-
-
-    /* Treat specific surface types */
-    if (st == PLANE) {
-      double a, b, c, d;
-      ret = twiddleRead(&a, sizeof(double), 1, in);
-      ret = twiddleRead(&b, sizeof(double), 1, in);
-      ret = twiddleRead(&c, sizeof(double), 1, in);
-      ret = twiddleRead(&d, sizeof(double), 1, in);
-      all_surfaces[key] = new Plane(a, b, c, d, id, name);
-    }
-    else if (st == ZCYLINDER) {
-      double x, y, radius;
-      ret = twiddleRead(&x, sizeof(double), 1, in);
-      ret = twiddleRead(&y, sizeof(double), 1, in);
-      ret = twiddleRead(&radius, sizeof(double), 1, in);
-      all_surfaces[key] = new ZCylinder(x, y, radius, id, name);
-    }
-    else if (st == XPLANE) {
-      double x;
-      ret = twiddleRead(&x, sizeof(double), 1, in);
-      all_surfaces[key] = new XPlane(x, id, name);
-    }
-    else if (st == YPLANE) {
-      double y;
-      ret = twiddleRead(&y, sizeof(double), 1, in);
-      all_surfaces[key] = new YPlane(y, id, name);
-    }
-    else if (st == ZPLANE) {
-      double z;
-      ret = twiddleRead(&z, sizeof(double), 1, in);
-      all_surfaces[key] = new ZPlane(z, id, name);
-    }
-    else {
-      log_printf(ERROR, "Unsupported surface type %s", name);
-    }
+      /* Check that the key and ID match */
+      if (key != id) {
+        std::string str = all_surfaces[key]->toString();
+        log_printf(ERROR, "Surface key %d does not match it's corresponding ID "
+                          "%d for surface:\n%s", key, id, str.c_str());
+      }
 
-    /* Check that the key and ID match */
-    if (key != id) {
-      std::string str = all_surfaces[key]->toString();
-      log_printf(ERROR, "Surface key %d does not match it's corresponding ID "
-                        "%d for surface:\n%s", key, id, str.c_str());
+      /* Set boundary */
+      all_surfaces[key]->setBoundaryType(bt);
     }
 
-    /* Set boundary */
-    all_surfaces[key]->setBoundaryType(bt);
-  }
+    /* Index all cells */
+    int num_cells = readGeoValue<int>(buffer, end, twiddle);
+    std::vector<Cell*> cells(num_cells);
+    std::vector<const char*> cell_data(num_cells);
+    for (int i=0; i < num_cells; i++) {
+
+      int key, id;
+      std::string name = readGeoHeader(key, id, buffer, end, twiddle);
+      cells[i] = new Cell(id, name.c_str());
+      all_cells[key] = cells[i];
+      cell_data[i] = buffer;
+
+      /* Check that the key and ID match */
+      if (key != id) {
+        std::string str = cells[i]->toString();
+        log_printf(ERROR, "Cell key %d does not match its corresponding ID "
+                          "%d for cell:\n%s", key, id, str.c_str());
+      }
 
-  /* Read all cell information */
-  int num_cells;
-  ret = twiddleRead(&num_cells, sizeof(int), 1, in);
-  for (int i=0; i < num_cells; i++) {
-
-    /* Get key, value pair and general cell information */
-    int key, id;
-    int length;
-    char* str;
-    const char* name;
-    ret = twiddleRead(&key, sizeof(int), 1, in);
-    ret = twiddleRead(&id, sizeof(int), 1, in);
-    ret = twiddleRead(&length, sizeof(int), 1, in);
-    if (length > 0) {
-      str = new char[length+1];
-      ret = twiddleRead(str, sizeof(char), length, in);
-      str[length] = '\0';
-      name = str;
-    }
-    else {
-      name = "";
+      /* Skip the fill, rotation, translation, rings, sectors and parent */
+      cellType ct = readGeoValue<cellType>(buffer, end, twiddle);
+      if (ct == MATERIAL || ct == FILL)
+        skipGeoValues<int>(1, buffer, end);
+      if (readGeoValue<bool>(buffer, end, twiddle))
+        skipGeoValues<double>(3, buffer, end);
+      if (readGeoValue<bool>(buffer, end, twiddle))
+        skipGeoValues<double>(3, buffer, end);
+      skipGeoValues<int>(2, buffer, end);
+      if (readGeoValue<bool>(buffer, end, twiddle))
+        skipGeoValues<int>(1, buffer, end);
+
+      /* Skip the region nodes */
+      int num_nodes = readGeoValue<int>(buffer, end, twiddle);
+      for (int n=0; n < num_nodes; n++) {
+        int region_type = readGeoValue<int>(buffer, end, twiddle);
+        skipGeoValues<int>(1, buffer, end);
+        if (region_type == HALFSPACE)
+          skipGeoValues<int>(2, buffer, end);
+      }
     }
-    cellType ct;
-    ret = twiddleRead(&ct, sizeof(cellType), 1, in);
 
-    /* Create the cell */
-    all_cells[key] = new Cell(id, name);
+    /* Index all universes */
+    int num_universes = readGeoValue<int>(buffer, end, twiddle);
+    std::vector<Universe*> universes(num_universes);
+    std::vector<const char*> universe_data(num_universes);
+    for (int i=0; i < num_universes; i++) {
+
+      int key, id;
+      std::string name = readGeoHeader(key, id, buffer, end, twiddle);
+      universe_data[i] = buffer;
+      universeType ut = readGeoValue<universeType>(buffer, end, twiddle);
+
+      if (ut == SIMPLE) {
+        universes[i] = new Universe(id, name.c_str());
+        int num_universe_cells = readGeoValue<int>(buffer, end, twiddle);
+        skipGeoValues<int>(num_universe_cells, buffer, end);
+      }
+      else if (ut == LATTICE) {
+        universes[i] = new Lattice(id, name.c_str());
+        int num_xyz[3];
+        readGeoValues(num_xyz, 3, buffer, end, twiddle);
+        skipGeoValues<double>(6, buffer, end);
+        if (non_uniform_lattice) {
+          skipGeoValues<bool>(1, buffer, end);
+          skipGeoValues<double>(num_xyz[0] + num_xyz[1] + num_xyz[2], buffer,
+                                end);
+        }
+        skipGeoValues<int>((size_t) num_xyz[0] * num_xyz[1] * num_xyz[2],
+                           buffer, end);
+      }
+      else {
+        log_printf(ERROR, "Unsupported universe type for universe ID: %d", id);
+      }
+      all_universes[key] = universes[i];
 
-    /* Fill the cell */
-    if (ct == MATERIAL) {
-      int mat_id;
-      ret = twiddleRead(&mat_id, sizeof(int), 1, in);
-      all_cells[key]->setFill(all_materials[mat_id]);
-    }
-    else if (ct == FILL) {
-      int univ_id;
-      ret = twiddleRead(&univ_id, sizeof(int), 1, in);
-      fill_cell_universes[key] = univ_id;
+      /* Check that the key and ID match */
+      if (key != id) {
+        std::string str = universes[i]->toString();
+        log_printf(ERROR, "Universe key %d does not match it's corresponding "
+                          "ID %d for surface:\n%s", key, id, str.c_str());
+      }
     }
 
-    /* Read cell rotations */
-    bool rot;
-    ret = twiddleRead(&rot, sizeof(bool), 1, in);
-    if (rot) {
-      double rotation[3];
-      ret = twiddleRead(rotation, sizeof(double), 3, in);
-      all_cells[key]->setRotation(rotation, 3, "radians");
-    }
+    /* Lattice universes, linked once all lattices are filled */
+    std::vector<std::vector<int> > lattice_universes(num_universes);
 
-    /* Read cell translations */
-    bool trans;
-    ret = twiddleRead(&trans, sizeof(bool), 1, in);
-    if (trans) {
-      double translation[3];
-      ret = twiddleRead(translation, sizeof(double), 3, in);
-      all_cells[key]->setTranslation(translation, 3);
-    }
+    /* The first exception thrown by the threads, thrown again after them */
+    std::exception_ptr error;
+    volatile bool failed = false;
 
-    /* Read ring / sector information */
-    int num_rings, num_sectors;
-    ret = twiddleRead(&num_rings, sizeof(int), 1, in);
-    ret = twiddleRead(&num_sectors, sizeof(int), 1, in);
-    all_cells[key]->setNumRings(num_rings);
-    all_cells[key]->setNumSectors(num_sectors);
-
-    /* Read parent cell */
-    bool has_parent;
-    ret = twiddleRead(&has_parent, sizeof(bool), 1, in);
-    if (has_parent) {
-      int parent_id;
-      ret = twiddleRead(&parent_id, sizeof(int), 1, in);
-      cell_parent[key] = parent_id;
-    }
+#pragma omp parallel
+    {
 
-    /* Read region */
-    int num_nodes;
-    ret = twiddleRead(&num_nodes, sizeof(int), 1, in);
-
-    /* Vector to store the number of subnodes for each node */
-    std::vector<int> i_subnodes;
-    std::vector<int>::iterator iter;
-
-    /* This loop on the number of nodes reproduces the CSG tree of the region
-       , going down to the leaves to add Halfspaces, and adding logical nodes
-       (Intersection, Union, Complement) at the other levels */
-    for (int n=0; n < num_nodes; n++) {
-      int region_type, last_region_type;
-      int num_subnodes;
-      twiddleRead(&region_type, sizeof(int), 1, in);
-      twiddleRead(&num_subnodes, sizeof(int), 1, in);
-
-      /* Keep number of subnodes at all levels */
-      if (num_subnodes > 0)
-        i_subnodes.push_back(num_subnodes+1);
-
-      /* Remove zero values from subnode vector, and go up in region tree */
-      for (iter=i_subnodes.begin(); iter<i_subnodes.end(); iter++) {
-        if ((*iter) == 0) {
-          i_subnodes.erase(iter);
-          all_cells[key]->goUpOneRegionLogical();
+      /* Set the cross-sections of all materials */
+#pragma omp for schedule(dynamic) nowait
+      for (int i=0; i < num_materials; i++) {
+        if (failed)
+          continue;
+        try {
+          Material* mat = materials[i];
+          mat->setNumEnergyGroups(num_groups);
+          std::vector<double> xs(num_xs);
+          const char* data = material_data[i];
+          readGeoValues(&xs[0], num_xs, data, end, twiddle);
+
+          /* Set total, fission and nu * fission cross-sections, neutron
+           * emission spectrum (chi) and scattering cross-section */
+          for (int g=0; g < num_groups; g++) {
+            mat->setSigmaTByGroup(xs[g], g+1);
+            mat->setSigmaFByGroup(xs[num_groups + g], g+1);
+            mat->setNuSigmaFByGroup(xs[2*num_groups + g], g+1);
+            mat->setChiByGroup(xs[3*num_groups + g], g+1);
+          }
+          for (int g=0; g < num_groups; g++)
+            for (int gp=0; gp < num_groups; gp++)
+              mat->setSigmaSByGroup(xs[4*num_groups + g*num_groups + gp], g+1,
+                                    gp+1);
+        }
+        catch (...) {
+          recordGeoError(error, failed);
         }
       }
 
-      /* Add surface */
-      if (region_type == HALFSPACE) {
-        int surface_id;
-        int halfspace;
-        ret = twiddleRead(&surface_id, sizeof(int), 1, in);
-        ret = twiddleRead(&halfspace, sizeof(int), 1, in);
-        all_cells[key]->addSurfaceInRegion(halfspace, all_surfaces[surface_id]);
-      }
+      /* Read all cell information, before the Cells are added to Universes
+       * which are registered with them */
+#pragma omp for schedule(dynamic)
+      for (int i=0; i < num_cells; i++) {
+        if (failed)
+          continue;
+        try {
+          Cell* cell = cells[i];
+          const char* data = cell_data[i];
+          cellType ct = readGeoValue<cellType>(data, end, twiddle);
+
+          /* Fill the cell */
+          if (ct == MATERIAL) {
+            int mat_id = readGeoValue<int>(data, end, twiddle);
+            cell->setFill(findGeoObject(all_materials, mat_id, "Material"));
+          }
+          else if (ct == FILL) {
+            int univ_id = readGeoValue<int>(data, end, twiddle);
+            cell->setFill(findGeoObject(all_universes, univ_id, "Universe"));
+          }
 
-      /* Add Region logical node which will contain surfaces */
-      else
-        all_cells[key]->addLogicalNode(region_type);
+          /* Read cell rotations */
+          if (readGeoValue<bool>(data, end, twiddle)) {
+            double rotation[3];
+            readGeoValues(rotation, 3, data, end, twiddle);
+            cell->setRotation(rotation, 3, "radians");
+          }
 
-      /* Remove one from all subnode levels */
-      std::for_each(i_subnodes.begin(), i_subnodes.end(), [](int& d) {d-=1;});
-    }
+          /* Read cell translations */
+          if (readGeoValue<bool>(data, end, twiddle)) {
+            double translation[3];
+            readGeoValues(translation, 3, data, end, twiddle);
+            cell->setTranslation(translation, 3);
+          }
 
-    /* Check that the key and ID match */
-    if (key != id) {
-      std::string str = all_cells[key]->toString();
-      log_printf(ERROR, "Cell key %d does not match its corresponding ID "
-                        "%d for cell:\n%s", key, id, str.c_str());
-    }
-  }
+          /* Read ring / sector information */
+          cell->setNumRings(readGeoValue<int>(data, end, twiddle));
+          cell->setNumSectors(readGeoValue<int>(data, end, twiddle));
+
+          /* Read parent cell, which is not in the file if it was not used in
+           * the Geometry anymore */
+          if (readGeoValue<bool>(data, end, twiddle)) {
+            int parent_id = readGeoValue<int>(data, end, twiddle);
+            std::map<int, Cell*>::iterator parent = all_cells.find(parent_id);
+            if (parent != all_cells.end())
+              cell->setParent(parent->second);
+          }
 
-  /* Read all universe information */
-  int num_universes;
-  ret = twiddleRead(&num_universes, sizeof(int), 1, in);
-  for (int i=0; i < num_universes; i++) {
-
-    /* Get key, value pair and general universe information */
-    int key, id;
-    int length;
-    char* str;
-    const char* name;
-    ret = twiddleRead(&key, sizeof(int), 1, in);
-    ret = twiddleRead(&id, sizeof(int), 1, in);
-    ret = twiddleRead(&length, sizeof(int), 1, in);
-    if (length > 0) {
-      str = new char[length+1];
-      ret = twiddleRead(str, sizeof(char), length, in);
-      str[length] = '\0';
-      name = str;
-    }
-    else {
-      name = "";
-    }
-    universeType ut;
-    ret = twiddleRead(&ut, sizeof(universeType), 1, in);
-
-    if (ut == SIMPLE) {
-
-      /* Read all cells in the universe */
-      all_universes[key] = new Universe(id, name);
-      int num_universe_cells;
-      ret = twiddleRead(&num_universe_cells, sizeof(int), 1, in);
-      for (int c=0; c < num_universe_cells; c++) {
-        int cell_id;
-        ret = twiddleRead(&cell_id, sizeof(int), 1, in);
-        all_universes[key]->addCell(all_cells[cell_id]);
-      }
-    }
-    else if (ut == LATTICE) {
-
-      /* Read lattice information */
-      int num_x, num_y, num_z;
-      double width_x, width_y, width_z;
-      double offset[3];
-      ret = twiddleRead(&num_x, sizeof(int), 1, in);
-      ret = twiddleRead(&num_y, sizeof(int), 1, in);
-      ret = twiddleRead(&num_z, sizeof(int), 1, in);
-      ret = twiddleRead(&width_x, sizeof(double), 1, in);
-      ret = twiddleRead(&width_y, sizeof(double), 1, in);
-      ret = twiddleRead(&width_z, sizeof(double), 1, in);
-      ret = twiddleRead(offset, sizeof(double), 3, in);
-      
-      std::vector<double> widths_x(num_x), widths_y(num_y), widths_z(num_z);
-      bool non_uniform = false;
-      
-      /* Check if the .geo file is in non_uniform_lattice format */
-      if(non_uniform_lattice) {
-        ret = twiddleRead(&non_uniform, sizeof(bool), 1, in);
-        ret = twiddleRead(&widths_x[0], sizeof(double), num_x, in);
-        ret = twiddleRead(&widths_y[0], sizeof(double), num_y, in);
-        ret = twiddleRead(&widths_z[0], sizeof(double), num_z, in);
-      }
+          /* Read region */
+          int num_nodes = readGeoValue<int>(data, end, twiddle);
+
+          /* Vector to store the number of subnodes for each node */
+          std::vector<int> i_subnodes;
+          std::vector<int>::iterator iter;
+
+          /* This loop on the number of nodes reproduces the CSG tree of the
+             region, going down to the leaves to add Halfspaces, and adding
+             logical nodes (Intersection, Union, Complement) at the other
+             levels */
+          for (int n=0; n < num_nodes; n++) {
+            int region_type = readGeoValue<int>(data, end, twiddle);
+            int num_subnodes = readGeoValue<int>(data, end, twiddle);
+
+            /* Keep number of subnodes at all levels */
+            if (num_subnodes > 0)
+              i_subnodes.push_back(num_subnodes+1);
+
+            /* Remove zero values from subnode vector, and go up in region
+             * tree */
+            for (iter=i_subnodes.begin(); iter<i_subnodes.end(); iter++) {
+              if ((*iter) == 0) {
+                i_subnodes.erase(iter);
+                cell->goUpOneRegionLogical();
+              }
+            }
+
+            /* Add surface */
+            if (region_type == HALFSPACE) {
+              int surface_id = readGeoValue<int>(data, end, twiddle);
+              int halfspace = readGeoValue<int>(data, end, twiddle);
+              cell->addSurfaceInRegion(halfspace, findGeoObject(all_surfaces,
+                                       surface_id, "Surface"));
+            }
 
-      /* Create lattice */
-      Lattice* new_lattice = new Lattice(id, name);
-      all_universes[key] = new_lattice;
-      new_lattice->setNumX(num_x);
-      new_lattice->setNumY(num_y);
-      new_lattice->setNumZ(num_z);
-      if(non_uniform) {
-        new_lattice->setWidths(widths_x, widths_y, widths_z);
-        new_lattice->setWidth(1, 1, 1);
+            /* Add Region logical node which will contain surfaces */
+            else
+              cell->addLogicalNode(region_type);
+
+            /* Remove one from all subnode levels */
+            std::for_each(i_subnodes.begin(), i_subnodes.end(),
+                          [](int& d) {d-=1;});
+          }
+        }
+        catch (...) {
+          recordGeoError(error, failed);
+        }
       }
-      else
-        new_lattice->setWidth(width_x, width_y, width_z);
 
-      new_lattice->setNonUniform(non_uniform);
-      new_lattice->setOffset(offset[0], offset[1], offset[2]);
+      /* Read all universe information */
+#pragma omp for schedule(dynamic) nowait
+      for (int i=0; i < num_universes; i++) {
+        if (failed)
+          continue;
+        try {
+          const char* data = universe_data[i];
+          universeType ut = readGeoValue<universeType>(data, end, twiddle);
+
+          if (ut == SIMPLE) {
+
+            /* Read all cells in the universe */
+            Universe* universe = universes[i];
+            int num_universe_cells = readGeoValue<int>(data, end, twiddle);
+            std::vector<int> cell_ids(num_universe_cells);
+            readGeoValues(cell_ids.data(), num_universe_cells, data, end,
+                          twiddle);
+            for (int c=0; c < num_universe_cells; c++)
+              universe->addCell(findGeoObject(all_cells, cell_ids[c], "Cell"));
+          }
+          else if (ut == LATTICE) {
+
+            /* Read lattice information */
+            Lattice* new_lattice = static_cast<Lattice*>(universes[i]);
+            int num_x = readGeoValue<int>(data, end, twiddle);
+            int num_y = readGeoValue<int>(data, end, twiddle);
+            int num_z = readGeoValue<int>(data, end, twiddle);
+            double width_x = readGeoValue<double>(data, end, twiddle);
+            double width_y = readGeoValue<double>(data, end, twiddle);
+            double width_z = readGeoValue<double>(data, end, twiddle);
+            double offset[3];
+            readGeoValues(offset, 3, data, end, twiddle);
+
+            std::vector<double> widths_x(num_x), widths_y(num_y),
+                widths_z(num_z);
+            bool non_uniform = false;
+
+            /* Check if the .geo file is in non_uniform_lattice format */
+            if(non_uniform_lattice) {
+              non_uniform = readGeoValue<bool>(data, end, twiddle);
+              readGeoValues(&widths_x[0], num_x, data, end, twiddle);
+              readGeoValues(&widths_y[0], num_y, data, end, twiddle);
+              readGeoValues(&widths_z[0], num_z, data, end, twiddle);
+            }
+
+            /* Set up lattice */
+            new_lattice->setNumX(num_x);
+            new_lattice->setNumY(num_y);
+            new_lattice->setNumZ(num_z);
+            if(non_uniform) {
+              new_lattice->setWidths(widths_x, widths_y, widths_z);
+              new_lattice->setWidth(1, 1, 1);
+            }
+            else
+              new_lattice->setWidth(width_x, width_y, width_z);
+
+            new_lattice->setNonUniform(non_uniform);
+            new_lattice->setOffset(offset[0], offset[1], offset[2]);
 
-      /* Get universes */
-      lattice_universes[key] = new int[num_x*num_y*num_z];
-      for (int j=0; j < num_x * num_y * num_z; j++) {
-        int universe_id;
-        ret = twiddleRead(&universe_id, sizeof(int), 1, in);
-        lattice_universes[key][j] = universe_id;
+            /* Get universes */
+            lattice_universes[i].resize((size_t) num_x * num_y * num_z);
+            readGeoValues(&lattice_universes[i][0], lattice_universes[i].size(),
+                          data, end, twiddle);
+          }
+        }
+        catch (...) {
+          recordGeoError(error, failed);
+        }
       }
-    }
 
-    /* Check that the key and ID match */
-    if (key != id) {
-      std::string str = all_universes[key]->toString();
-      log_printf(ERROR, "Universe key %d does not match it's corresponding ID "
-                        "%d for surface:\n%s", key, id, str.c_str());
+      /* Set lattice universes */
+#pragma omp barrier
+#pragma omp for schedule(dynamic)
+      for (int i=0; i < num_universes; i++) {
+        if (failed)
+          continue;
+        try {
+          if (universes[i]->getType() != LATTICE)
+            continue;
+
+          Lattice* lattice = static_cast<Lattice*>(universes[i]);
+          std::vector<int>& universe_ids = lattice_universes[i];
+          std::vector<Universe*> lattice_cells(universe_ids.size());
+          for (size_t j=0; j < universe_ids.size(); j++)
+            lattice_cells[j] = findGeoObject(all_universes, universe_ids[j],
+                                             "Universe");
+          lattice->setUniverses(lattice->getNumZ(), lattice->getNumY(),
+                                lattice->getNumX(), &lattice_cells[0]);
+        }
+        catch (...) {
+          recordGeoError(error, failed);
+        }
+      }
     }
-  }
+    if (failed)
+      std::rethrow_exception(error);
 
-  /* Set universe fills in cells */
-  std::map<int, int>::iterator id_iter;
-  for (id_iter = fill_cell_universes.begin();
-       id_iter != fill_cell_universes.end(); ++id_iter)
-    all_cells[id_iter->first]->setFill(all_universes[id_iter->second]);
-
-  /* Set parent cells */
-  for (id_iter = cell_parent.begin(); id_iter != cell_parent.end(); ++id_iter)
-    all_cells[id_iter->first]->setParent(all_cells[id_iter->second]);
-
-  /* Set lattice universes */
-  std::map<int, int*>::iterator lattice_iter;
-  for (lattice_iter = lattice_universes.begin();
-       lattice_iter != lattice_universes.end(); ++lattice_iter) {
-    int id = lattice_iter->first;
-    int* array = lattice_iter->second;
-    Lattice* lattice = static_cast<Lattice*>(all_universes[id]);
-    int num_x = lattice->getNumX();
-    int num_y = lattice->getNumY();
-    int num_z = lattice->getNumZ();
-    Universe* universes[num_x * num_y * num_z];
-    for (int i=0; i < num_x * num_y * num_z; i++) {
-      universes[i] = all_universes[array[i]];
-    }
-    lattice->setUniverses(num_z, num_y, num_x, universes);
+    /* Set root universe */
+    _root_universe = findGeoObject(all_universes, root_id, "Universe");
+  }
+  catch (...) {
+    munmap(map, file_size);
+    throw;
   }
 
-  /* Set root universe */
-  _root_universe = all_universes[root_id];
-
-  /* Close the input file */
-  fclose(in);
+  /* Release the mapped file */
+  munmap(map, file_size);
 
   log_printf(NORMAL, "Read complete");
 }
@@ -21,9 +21,11 @@
 #include <fstream>
 #include <string>
 #include <set>
+#include <vector>
 #include <omp.h>
 #include <functional>
-#include "ParallelHashMap.h"
+#include "ConcurrentHashMap.h"
+#include "FSRKey.h"
 #endif
 
 #ifdef MPIx
@@ -73,6 +75,89 @@ struct fsr_data {
 };
 
 
+/**
+ * @struct AxialMeshLookup
+ * @brief An AxialMeshLookup is a uniform bucket index into an axial mesh,
+ *        used to find the mesh cell containing a height without searching.
+ * @details Each bucket of uniform height stores the mesh cell containing its
+ *          lower edge, so that the mesh cell containing a height is found
+ *          from its bucket in a few steps, since there are at least as many
+ *          buckets as mesh cells.
+ */
+struct AxialMeshLookup {
+
+  /** Constructor for AxialMeshLookup object */
+  AxialMeshLookup() : _num_cells(0), _num_buckets(0), _min(0.),
+    _inv_width(0.) {}
+
+  /** The mesh cell containing the lower edge of each bucket */
+  std::vector<int> _cells;
+
+  /** The number of mesh cells */
+  int _num_cells;
+
+  /** The number of buckets */
+  int _num_buckets;
+
+  /** The lowest height of the mesh */
+  double _min;
+
+  /** The inverse of the bucket height */
+  double _inv_width;
+
+  /**
+   * @brief Builds the buckets for an axial mesh.
+   * @param mesh an array of monotonically increasing mesh heights
+   * @param num_cells the number of mesh cells, one less than the number of
+   *        mesh heights
+   */
+  void initialize(double* mesh, int num_cells) {
+
+    _num_cells = num_cells;
+    _num_buckets = AXIAL_MESH_BUCKETS_PER_CELL * num_cells;
+    _cells.resize(_num_buckets);
+    _min = mesh[0];
+    double width = (mesh[num_cells] - mesh[0]) / _num_buckets;
+    _inv_width = 1. / width;
+
+    int cell = 0;
+    for (int b=0; b < _num_buckets; b++) {
+      double z = _min + b * width;
+      while (cell < num_cells - 1 && z >= mesh[cell+1])
+        cell++;
+      _cells[b] = cell;
+    }
+  }
+
+  /**
+   * @brief Finds the mesh cell containing a height.
+   * @details If the height lies on a mesh boundary, the upper cell is
+   *          returned for rays traveling in the positive z-direction and the
+   *          lower cell for rays traveling in the negative z-direction.
+   * @param mesh the axial mesh used to build the buckets
+   * @param z the height of interest, within the mesh
+   * @param sign the direction of the ray in the z-direction
+   * @return the index of the mesh cell containing the height
+   */
+  inline int find(double* mesh, double z, int sign) const {
+
+    int bucket = (int) ((z - _min) * _inv_width);
+    bucket = std::max(0, std::min(bucket, _num_buckets - 1));
+    int cell = _cells[bucket];
+
+    /* Correct for roundoff in the bucket index */
+    while (cell > 0 && z < mesh[cell])
+      cell--;
+    while (cell < _num_cells - 1 && z >= mesh[cell+1])
+      cell++;
+
+    if (sign < 0 && cell > 0 && z == mesh[cell])
+      cell--;
+    return cell;
+  }
+};
+
+
 /**
  * @struct ExtrudedFSR
  * @brief An ExtrudedFSR struct represents a FSR region in the superposition
@@ -90,6 +175,9 @@ struct ExtrudedFSR {
   /** Array defining the axial mesh */
   double* _mesh;
 
+  /** Bucket index to find the axial mesh cell containing a height */
+  AxialMeshLookup _mesh_lookup;
+
   /** Axial extruded FSR ID */
   int _fsr_id;
 
@@ -107,6 +195,77 @@ struct ExtrudedFSR {
 };
 
 
+/**
+ * @struct ChordTemplate
+ * @brief A ChordTemplate is the sequence of chords of a trajectory through a
+ *        pin Universe, with the Cell and the FSR key components of each
+ *        chord.
+ * @details Chord templates are shared by all instances of a pin Universe in
+ *          a Lattice crossed by the same line, so that ray tracing through
+ *          the pin internals only needs to be done once per line. The last
+ *          chord, which leaves the pin, is always ray traced.
+ */
+struct ChordTemplate {
+
+  /** The distance from the pin center to the line, in the frame of the
+   *  pin, which the template was recorded for */
+  double _line_offset;
+
+  /** The positions along the line of the end of each chord but the last, in
+   *  the frame of the pin */
+  std::vector<double> _ends;
+
+  /** The Cells crossed, including the Cell of the last chord */
+  std::vector<Cell*> _cells;
+
+  /** The FSR key components of the levels from the pin down to the Cell of
+   *  each chord but the last, and their offsets for each chord */
+  std::vector<long> _key_components;
+  std::vector<int> _key_offsets;
+
+  /** Whether the chords are long enough for the template to be replayed */
+  bool _replay;
+};
+
+
+/**
+ * @struct ChordState
+ * @brief The state of a Track being ray traced through pin Universes with
+ *        chord templates.
+ */
+struct ChordState {
+
+  /** Constructor for ChordState object */
+  ChordState() : _template(NULL), _recording(false), _lattice(NULL),
+    _lat_x(-1), _lat_y(-1), _lat_z(-1), _num_pins(0),
+    _num_replayed_pins(0) {}
+
+  /** The template replayed or recorded in the current pin, NULL if none */
+  ChordTemplate* _template;
+
+  /** Whether the template is being recorded rather than replayed */
+  bool _recording;
+
+  /** The key of the template being recorded */
+  FSRKey _key;
+
+  /** The FSR key components of the levels above the current pin */
+  FSRKey _key_prefix;
+
+  /** The Lattice and Lattice cell indexes of the current pin */
+  Lattice* _lattice;
+  int _lat_x;
+  int _lat_y;
+  int _lat_z;
+
+  /** The number of pins crossed by the Track */
+  long _num_pins;
+
+  /** The number of pins crossed by replaying a template */
+  long _num_replayed_pins;
+};
+
+
 void reset_auto_ids();
 
 
@@ -124,11 +283,11 @@ class Geometry {
 private:
 
   /** An map of FSR key hashes to unique fsr_data structs */
-  ParallelHashMap<std::string, fsr_data*> _FSR_keys_map;
-  ParallelHashMap<std::string, ExtrudedFSR*> _extruded_FSR_keys_map;
+  ConcurrentHashMap<FSRKey, fsr_data*> _FSR_keys_map;
+  ConcurrentHashMap<FSRKey, ExtrudedFSR*> _extruded_FSR_keys_map;
 
   /** An vector of FSR key hashes indexed by FSR ID */
-  std::vector<std::string> _FSRs_to_keys;
+  std::vector<FSRKey> _FSRs_to_keys;
 
   /** An vector of FSR centroids indexed by FSR ID */
   std::vector<Point*> _FSRs_to_centroids;
@@ -157,8 +316,9 @@ private:
   /* A map of all Material in the Geometry for optimization purposes */
   std::map<int, Material*> _all_materials;
 
-  /* A vector containing allocated strings for key generation */
-  std::vector<std::string> _fsr_keys;
+  /** The Materials filling the Cells, by Cell ID, when the Materials of the
+   *  FSRs were found */
+  std::map<int, Material*> _FSR_cell_fills;
 
   /* A boolean to know whether geometry is domain decomposed or not */
   bool _domain_decomposed;
@@ -201,6 +361,40 @@ private:
    * file. This matters for memory de-allocation purposes. */
   bool _loaded_from_file;
 
+  /* LocalCoords linked lists reused by each thread for ray tracing, indexed
+   * by thread and then by list */
+  std::vector<LocalCoords*> _thread_coords;
+
+  /* Whether pin crossings are ray traced with chord templates */
+  bool _use_chord_templates;
+
+  /* Map of chord template keys to chord templates */
+  ConcurrentHashMap<FSRKey, ChordTemplate*> _chord_templates;
+
+  /* Number of pins crossed, and crossed with chord templates, in 2D */
+  long _num_pin_crossings;
+  long _num_template_crossings;
+
+  /* Functions to ray trace the chords of a Track with chord templates */
+  void enterPin(LocalCoords* coords, double azim, ChordState& state);
+  void recordChord(LocalCoords* start, LocalCoords* end, Cell* cell,
+                   double azim, ChordState& state, bool left_pin);
+  bool replayChords(Track* track, LocalCoords* coords, double azim,
+                    ChordState& state);
+
+  /* Functions to add a 2D segment and to find the FSR ID from its key */
+  void addSegment2D(Track* track, LocalCoords* start, LocalCoords* end,
+                    Material* material, long fsr_id, double azim);
+  long findFSRId(LocalCoords* coords, FSRKey& fsr_key, Cell* cell);
+  void getFSRKeyPrefix(LocalCoords* coords, LocalCoords* last,
+                       FSRKey& key);
+
+  /* Function to return a reset LocalCoords linked list of this thread */
+  LocalCoords* getThreadCoords(int index, double x, double y, double z);
+
+  /* Function to return the spatial ordering code of a region */
+  uint64_t getMortonCode(LocalCoords* coords);
+
   /* Function to find the cell containing the coordinates */
   Cell* findFirstCell(LocalCoords* coords, double azim, double polar=M_PI_2);
   
@@ -245,6 +439,7 @@ public:
   std::map<int, Material*> getAllMaterials();
   std::map<int, Cell*> getAllCells();
   std::map<int, Cell*> getAllMaterialCells();
+  std::map<int, Material*> getMaterialCellFills();
   std::map<int, Universe*> getAllUniverses();
   std::vector<double> getUniqueZHeights(bool include_overlaid_mesh = false);
   std::vector<double> getUniqueZPlanes();
@@ -263,7 +458,7 @@ public:
 
   /* Get CMFD parameters */
   Cmfd* getCmfd();
-  std::vector<std::string>& getFSRsToKeys();
+  std::vector<FSRKey>& getFSRsToKeys();
   std::vector<int>& getFSRsToMaterialIDs();
   std::vector<Point*>& getFSRsToCentroids();
   std::vector<int>& getFSRsToCMFDCells();
@@ -276,11 +471,10 @@ public:
   int getCmfdCell(long fsr_id);
   ExtrudedFSR* getExtrudedFSR(int extruded_fsr_id);
   std::string getFSRKey(LocalCoords* coords);
-  void getFSRKeyFast(LocalCoords* coords, std::string& key);
-  void printToString(std::string& str, int& index, int value);
-  int getNumDigits(int number);
-  ParallelHashMap<std::string, fsr_data*>& getFSRKeysMap();
-  ParallelHashMap<std::string, ExtrudedFSR*>& getExtrudedFSRKeysMap();
+  std::string getFSRKeyString(long fsr_id);
+  void getFSRKeyFast(LocalCoords* coords, FSRKey& key);
+  ConcurrentHashMap<FSRKey, fsr_data*>& getFSRKeysMap();
+  ConcurrentHashMap<FSRKey, ExtrudedFSR*>& getExtrudedFSRKeysMap();
 #ifdef MPIx
   int getNeighborDomain(int offset_x, int offset_y, int offset_z);
 #endif
@@ -296,16 +490,23 @@ public:
   /* Find methods */
   Cell* findCellContainingCoords(LocalCoords* coords);
   Material* findFSRMaterial(long fsr_id);
+  bool updateFSRMaterials();
   long findFSRId(LocalCoords* coords);
   int findExtrudedFSR(LocalCoords* coords);
   Cell* findCellContainingFSR(long fsr_id);
 
   /* Other worker methods */
-  void reserveKeyStrings(int num_threads);
   void subdivideCells();
   void initializeAxialFSRs(std::vector<double> global_z_mesh);
   void reorderFSRIDs();
+  void renumberFSRs(std::vector<long>& id_mapping);
+  void renumberExtrudedFSRs(std::vector<long>& id_mapping);
   void initializeFlatSourceRegions();
+  void initializeThreadCoords();
+  void useChordTemplates(bool use_chord_templates);
+  void clearChordTemplates();
+  long getNumPinCrossings();
+  long getNumTemplateCrossings();
   void segmentize2D(Track* track, double z_coord);
   void segmentize3D(Track3D* track, bool setup=false);
   void segmentizeExtruded(Track* flattened_track,
@@ -322,6 +523,7 @@ public:
                                          const char* plane,
                                          const char* domain_type);
   std::string toString();
+  void hashContents(FSRKey& hash);
   void printString();
   void printFSRsToFile(const char* plane="xy", int gridsize=1000, 
                        double offset=0.0, double* bounds_x = NULL, 
@@ -1,5 +1,7 @@
 #include "LocalCoords.h"
 
+long LocalCoords::_num_allocations = 0;
+
 /**
  * @brief Constructor sets the x, y and z coordinates and position as a coord.
  * @param x the x-coordinate
@@ -15,12 +17,14 @@ LocalCoords::LocalCoords(double x, double y, double z, bool first) {
   _universe = NULL;
   _lattice = NULL;
   _cell = NULL;
+  _previous_cell = NULL;
   _next = NULL;
   _prev = NULL;
   _version_num = 0;
   if (first) {
     _array_size = LOCAL_COORDS_LEN;
     _next_array = new LocalCoords[LOCAL_COORDS_LEN];
+    __sync_fetch_and_add(&_num_allocations, 1);
   }
   else {
     _array_size = 0;
@@ -67,6 +71,19 @@ Cell* LocalCoords::getCell() const {
 }
 
 
+/**
+ * @brief Return the Cell within which this LocalCoords resided before it was
+ *        last reused for a new position.
+ * @details When a track crosses a surface, the Cell occupied at each level
+ *          before the crossing is the best guess for the Cell search at the
+ *          new position, since the new Cell is usually one of its neighbors.
+ * @return the previously occupied Cell, or NULL if unknown
+ */
+Cell* LocalCoords::getPreviousCell() const {
+  return _previous_cell;
+}
+
+
 /**
  * @brief Return the Lattice within which this LocalCoords resides.
  * @return the Lattice
@@ -196,6 +213,7 @@ LocalCoords* LocalCoords::getNextCreate(double x, double y, double z) {
       _next->getPoint()->setCoords(x, y, z);
       _next->setLattice(NULL);
       _next->setUniverse(NULL);
+      _next->_previous_cell = _next->_cell;
       _next->setCell(NULL);
       _next->setVersionNum(0);
     }
@@ -411,6 +429,37 @@ void LocalCoords::setVersionNum(int version_num) {
 }
 
 
+/**
+ * @brief Resets the LocalCoords to an empty linked list at a new position.
+ * @details The array of next LocalCoords is kept, so that a LocalCoords
+ *          reset for every Track can be used for ray tracing without any
+ *          further memory allocation.
+ * @param x the x-coordinate
+ * @param y the y-coordinate
+ * @param z the z-coordinate
+ */
+void LocalCoords::reset(double x, double y, double z) {
+  prune();
+  _coords.setCoords(x, y, z);
+  _universe = NULL;
+  _lattice = NULL;
+  _previous_cell = _cell;
+  _cell = NULL;
+  _version_num = 0;
+}
+
+
+/**
+ * @brief Returns the number of arrays of LocalCoords allocated on the heap.
+ * @details Each LocalCoords at the highest level of a linked list allocates
+ *          one array for the LocalCoords of the lower levels.
+ * @return the number of arrays allocated since the start of the run
+ */
+long LocalCoords::getNumAllocations() {
+  return _num_allocations;
+}
+
+
 
 /**
  * @brief Find and return the last LocalCoords in the linked list which
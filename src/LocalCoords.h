@@ -55,6 +55,10 @@ private:
   /** The Cell within which this LocalCoords resides */
   Cell* _cell;
 
+  /** The Cell within which this LocalCoords resided before it was last
+   *  reused, a hint for the next Cell search */
+  Cell* _previous_cell;
+
   /** The Lattice within which this LocalCoords resides */
   Lattice* _lattice;
 
@@ -97,6 +101,9 @@ private:
   /** An integer to differentiate otherwise matching coordinate FSR keys */
   int _version_num;
 
+  /** A static counter of the arrays of LocalCoords allocated on the heap */
+  static long _num_allocations;
+
   void setArrayPosition(LocalCoords* array, int position, int array_size);
 
 public:
@@ -105,6 +112,7 @@ public:
   coordType getType();
   Universe* getUniverse() const;
   Cell* getCell() const;
+  Cell* getPreviousCell() const;
   Lattice* getLattice() const;
   int getLatticeX() const;
   int getLatticeY() const;
@@ -136,6 +144,9 @@ public:
   void setNext(LocalCoords *next);
   void setPrev(LocalCoords* coords);
   void setVersionNum(int version_num);
+  void reset(double x, double y, double z);
+
+  static long getNumAllocations();
 
   LocalCoords* getLowestLevel();
   LocalCoords* getHighestLevel();
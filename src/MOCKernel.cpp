@@ -62,6 +62,15 @@ SegmentationKernel::SegmentationKernel(TrackGenerator* track_generator,
 }
 
 
+/**
+ * @brief Redirects the segment data written by the SegmentationKernel
+ * @param segments pointer to the segment data to write
+ */
+void SegmentationKernel::setSegments(segment* segments) {
+  _segments = segments;
+}
+
+
 /**
  * @brief Constructor for the CounterKernel assigns default values and calls
  *        the MOCKernel constructor
@@ -291,11 +300,11 @@ void SegmentationKernel::execute(FP_PRECISION length, Material* mat, long fsr_id
  */
 TransportKernel::TransportKernel(TrackGenerator* track_generator, int row_num)
                                  : MOCKernel(track_generator, row_num) {
+  _track_generator_3D = dynamic_cast<TrackGenerator3D*>(track_generator);
   _direction = true;
-  _min_track_idx = 0;
-  _max_track_idx = 0;
   _azim_index = 0;
   _polar_index = 0;
+  _xy_index = 0;
   _track_id = 0;
 }
 
@@ -318,14 +327,13 @@ void TransportKernel::setCPUSolver(CPUSolver* cpu_solver) {
 
 /**
  * @brief Sets the indexes of the current Track.
- * @param axim_index the Track's azimuthal index
- * @param polar_index the Track's polar index
+ * @param track the first 3D Track of the z-stack
  */
-//FIXME: delete?
 void TransportKernel::newTrack(Track* track) {
   Track3D* track_3D = dynamic_cast<Track3D*>(track);
   _azim_index = track_3D->getAzimIndex();
   _polar_index = track_3D->getPolarIndex();
+  _xy_index = track_3D->getXYIndex();
   _track_id = track_3D->getUid();
   _count = 0;
 }
@@ -335,7 +343,6 @@ void TransportKernel::newTrack(Track* track) {
  * @brief Sets the direction of the current track.
  * @param direction the direction of the track: true = Forward, false = Backward
  */
-//FIXME: delete?
 void TransportKernel::setDirection(bool direction) {
   _direction = direction;
 }
@@ -363,11 +370,6 @@ void TransportKernel::execute(FP_PRECISION length, Material* mat, long fsr_id,
                               FP_PRECISION y_start, FP_PRECISION z_start,
                               FP_PRECISION phi, FP_PRECISION theta) {
 
-  if (track_idx < _min_track_idx)
-    _min_track_idx = track_idx;
-  else if (track_idx > _max_track_idx)
-    _max_track_idx = track_idx;
-
   /* Determine the number of cuts on the segment */
   FP_PRECISION sin_theta = sin(theta);
   FP_PRECISION* sigma_t = mat->getSigmaT();
@@ -381,9 +383,7 @@ void TransportKernel::execute(FP_PRECISION length, Material* mat, long fsr_id,
     num_cuts = length * max_sigma_t * sin_theta / _max_tau + 1;
 
   /* Determine common length */
-  FP_PRECISION fp_length = length;
-  FP_PRECISION temp_length = std::min(_max_tau / (sin_theta * max_sigma_t), 
-                                      fp_length);
+  FP_PRECISION temp_length = length / num_cuts;
 
   /* Apply MOC equations to segments */
   for (int i=0; i < num_cuts; i++) {
@@ -410,34 +410,42 @@ void TransportKernel::execute(FP_PRECISION length, Material* mat, long fsr_id,
     float* track_flux = _cpu_solver->getBoundaryFlux(curr_track_id,
                                                      _direction);
 
-    FP_PRECISION fsr_flux[_num_groups] = {0.0};
+    int num_groups_aligned = (_num_groups / VEC_ALIGNMENT + 1) *
+         VEC_ALIGNMENT;
+    FP_PRECISION fsr_flux[num_groups_aligned] __attribute__
+         ((aligned (VEC_ALIGNMENT))) = {0.0};
 
     /* Apply MOC equations */
     _cpu_solver->tallyScalarFlux(&curr_segment, _azim_index, _polar_index,
                                  fsr_flux, track_flux);
     _cpu_solver->accumulateScalarFluxContribution(fsr_id, fsr_flux);
     _cpu_solver->tallyCurrent(&curr_segment, _azim_index, _polar_index,
-                                     track_flux, true);
-
-    /* Shorten remaining 3D length */
-    length -= temp_length;
+                              track_flux, _direction);
   }
 }
 
 
 /**
  * @brief Obtain and transfer the boundary track angular fluxes.
+ * @details The Tracks of the z-stack are formed from their indexes for
+ *          their boundary conditions and linking Tracks.
  */
 void TransportKernel::post() {
-  for (int i=_min_track_idx; i <= _max_track_idx; i++) {
+
+  TrackStackIndexes tsi;
+  tsi._azim = _azim_index;
+  tsi._xy = _xy_index;
+  tsi._polar = _polar_index;
+  int num_z_stack = _track_generator_3D->getTracksPerStack()
+       [_azim_index][_xy_index][_polar_index];
+
+  Track3D track;
+  for (int i=0; i < num_z_stack; i++) {
     float* track_flux = _cpu_solver->getBoundaryFlux(_track_id+i,
                                                      _direction);
-    Track track;
-    //_sti._z = i; FIXME THIS IS BROKEN
-    //_track_generator_3D->getTrackOTF(&track, &_sti);
+    tsi._z = i;
+    _track_generator_3D->getTrackOTF(&track, &tsi);
     _cpu_solver->transferBoundaryFlux(&track, _azim_index, _polar_index,
                                       _direction, track_flux);
   }
-  _min_track_idx = 0;
-  _max_track_idx = 0;
 }
@@ -20,6 +20,9 @@
 /* Forward declaration of TrackGenerator */
 class TrackGenerator;
 
+/* Forward declaration of TrackGenerator3D */
+class TrackGenerator3D;
+
 /* Forward declaration of CPUSolver */
 class CPUSolver;
 
@@ -146,6 +149,7 @@ private:
 
 public:
   SegmentationKernel(TrackGenerator* track_generator, int row_num);
+  void setSegments(segment* segments);
   void execute(FP_PRECISION length, Material* mat, long fsr_id,
                int track_idx, int cmfd_surface_fwd, int cmfd_surface_bwd,
                FP_PRECISION x_start, FP_PRECISION y_start, FP_PRECISION z_start,
@@ -165,6 +169,9 @@ private:
   /** Pointer to CPUSolver enabling use of transport functions */
   CPUSolver* _cpu_solver;
 
+  /** Pointer to the TrackGenerator3D forming the Tracks of the z-stack */
+  TrackGenerator3D* _track_generator_3D;
+
   /** Pointer to angular flux data in the current direction */
   FP_PRECISION* _thread_fsr_flux;
 
@@ -174,15 +181,15 @@ private:
   /** Polar index of the current track */
   int _polar_index;
 
+  /** Index of the 2D Track of the z-stack of the current track */
+  int _xy_index;
+
   /** Unique ID of the current track */
-  int _track_id;
+  long _track_id;
 
   /** Direction of the current track (true = Forward / false = Backward) */
   bool _direction;
 
-  int _min_track_idx;
-  int _max_track_idx;
-
 public:
   TransportKernel(TrackGenerator* track_generator, int row_num);
   virtual ~TransportKernel();
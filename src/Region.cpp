@@ -1,4 +1,5 @@
 #include "Region.h"
+#include "Cell.h"
 #include <cmath>
 
 /**
@@ -6,6 +7,7 @@
  */
 Region::Region() {
   _parent_region = NULL;
+  _cell = NULL;
 }
 
 
@@ -31,6 +33,8 @@ void Region::addNode(Region* node, bool clone) {
     _nodes.push_back(node->clone());
   else
     _nodes.push_back(node);
+  _nodes.back()->setParentRegion(this);
+  invalidateBounds();
 }
 
 
@@ -42,6 +46,8 @@ void Region::addNode(Region* node, bool clone) {
  */
 void Region::removeHalfspace(Surface* surface, int halfspace) {
 
+  invalidateBounds();
+
   if (surface != NULL) {
 
     std::vector<Region*>::iterator iter1;
@@ -145,6 +151,32 @@ Region* Region::getParentRegion() {
 }
 
 
+/**
+ * @brief Set the Cell bounded by this Region.
+ * @details The Cell caches its bounds, which changes of the Region or of its
+ *          nodes invalidate.
+ * @param cell the Cell bounded by this Region, or NULL
+ */
+void Region::setCell(Cell* cell) {
+  _cell = cell;
+}
+
+
+/**
+ * @brief Invalidates the cached bounds of the Cell bounded by the top Region
+ *        this Region belongs to.
+ */
+void Region::invalidateBounds() {
+
+  Region* top = this;
+  while (top->_parent_region != NULL)
+    top = top->_parent_region;
+
+  if (top->_cell != NULL)
+    top->_cell->invalidateBounds();
+}
+
+
 /**
  * @brief Return the minimum reachable x-coordinate in the Region.
  * @details This routine is overloaded for a Halfspace
@@ -723,6 +755,8 @@ void Complement::addNode(Region* node, bool clone) {
     _nodes.push_back(node->clone());
   else
     _nodes.push_back(node);
+  _nodes.back()->setParentRegion(this);
+  invalidateBounds();
 }
 
 
@@ -791,6 +825,7 @@ int Halfspace::getHalfspace() {
  */
 void Halfspace::reverseHalfspace() {
   _halfspace *= -1;
+  invalidateBounds();
 }
 
 
@@ -1019,3 +1054,234 @@ void RectangularPrism::setBoundaryType(boundaryType boundary_type) {
   for (iter = all_surfaces.begin(); iter != all_surfaces.end(); iter++)
     iter->second->getSurface()->setBoundaryType(boundary_type);
 }
+
+
+/**
+ * @brief Determines whether a Region can be compiled, that is whether it is
+ *        only made of Plane and ZCylinder halfspaces.
+ * @param region a pointer to the Region
+ * @return whether the Region can be compiled
+ */
+bool CompiledRegion::isCompilable(Region* region) {
+
+  if (region->getRegionType() == HALFSPACE) {
+    surfaceType type =
+        static_cast<Halfspace*>(region)->getSurface()->getSurfaceType();
+    return type == PLANE || type == XPLANE || type == YPLANE ||
+           type == ZPLANE || type == ZCYLINDER;
+  }
+
+  std::vector<Region*> nodes = region->getNodes();
+  std::vector<Region*>::iterator iter;
+  for (iter = nodes.begin(); iter != nodes.end(); ++iter)
+    if (!isCompilable(*iter))
+      return false;
+
+  return true;
+}
+
+
+/**
+ * @brief Constructor lowers a Region tree into a flat program.
+ * @param region a pointer to the Region, which must be compilable
+ */
+CompiledRegion::CompiledRegion(Region* region) {
+
+  if (!isCompilable(region))
+    log_printf(ERROR, "Unable to compile a Region with Surfaces other than "
+               "Planes and ZCylinders");
+
+  int stack_size = compileNode(region);
+  if (stack_size > MAX_CSG_STACK)
+    log_printf(ERROR, "Unable to compile a Region requiring a stack of %d "
+               "values, the maximum is %d", stack_size, MAX_CSG_STACK);
+
+  /* Detect intersections of halfspaces, evaluated with early exits */
+  _conjunction = true;
+  int num_instructions = _instructions.size();
+  for (int i=0; i < num_instructions; i++) {
+    csgOperation operation = _instructions[i]._operation;
+    if (operation != CSG_PLANE && operation != CSG_ZCYLINDER &&
+        !(operation == CSG_INTERSECTION && i == num_instructions - 1))
+      _conjunction = false;
+  }
+}
+
+
+/**
+ * @brief Stores the coefficients of a Surface, if not already stored.
+ * @param surface a pointer to a Plane or ZCylinder
+ * @return the index of the Surface in the coefficients of its type
+ */
+int CompiledRegion::addSurface(Surface* surface) {
+
+  std::map<int, int>::iterator iter = _surface_indexes.find(surface->getId());
+  if (iter != _surface_indexes.end())
+    return iter->second;
+
+  int index;
+  if (surface->getSurfaceType() == ZCYLINDER) {
+    ZCylinder* cylinder = static_cast<ZCylinder*>(surface);
+    double x = cylinder->getX0();
+    double y = cylinder->getY0();
+    double radius = cylinder->getRadius();
+    index = _zcylinder_x.size();
+    _zcylinder_x.push_back(x);
+    _zcylinder_y.push_back(y);
+    _zcylinder_r2.push_back(radius*radius);
+    _zcylinder_c.push_back(-2.*x);
+    _zcylinder_d.push_back(-2.*y);
+    _zcylinder_e.push_back(x*x + y*y - radius*radius);
+  }
+  else {
+    Plane* plane = static_cast<Plane*>(surface);
+    index = _plane_a.size();
+    _plane_a.push_back(plane->getA());
+    _plane_b.push_back(plane->getB());
+    _plane_c.push_back(plane->getC());
+    _plane_d.push_back(plane->getD());
+  }
+
+  _surface_indexes[surface->getId()] = index;
+  return index;
+}
+
+
+/**
+ * @brief Appends the instructions of a Region node in postfix order.
+ * @param region a pointer to the Region node
+ * @return the stack size required to evaluate the node
+ */
+int CompiledRegion::compileNode(Region* region) {
+
+  csgInstruction instruction;
+
+  if (region->getRegionType() == HALFSPACE) {
+    Halfspace* halfspace = static_cast<Halfspace*>(region);
+    Surface* surface = halfspace->getSurface();
+    if (surface->getSurfaceType() == ZCYLINDER)
+      instruction._operation = CSG_ZCYLINDER;
+    else
+      instruction._operation = CSG_PLANE;
+    instruction._index = addSurface(surface);
+    instruction._halfspace = halfspace->getHalfspace();
+    _instructions.push_back(instruction);
+    return 1;
+  }
+
+  /* Compile the nodes, each one leaving its value on the stack */
+  std::vector<Region*> nodes = region->getNodes();
+  int stack_size = 1;
+  for (size_t i=0; i < nodes.size(); i++)
+    stack_size = std::max(stack_size, int(i) + compileNode(nodes[i]));
+
+  /* An empty complement contains no point, like an empty union */
+  if (region->getRegionType() == INTERSECTION)
+    instruction._operation = CSG_INTERSECTION;
+  else if (region->getRegionType() == UNION || nodes.size() == 0)
+    instruction._operation = CSG_UNION;
+  else
+    instruction._operation = CSG_COMPLEMENT;
+  instruction._index = nodes.size();
+  instruction._halfspace = 0;
+  _instructions.push_back(instruction);
+
+  return stack_size;
+}
+
+
+/**
+ * @brief Determines whether a Point is contained inside the compiled Region.
+ * @param point a pointer to the Point of interest
+ * @return true if the Point is inside the Region; otherwise false
+ */
+bool CompiledRegion::containsPoint(Point* point) {
+
+  double x = point->getX();
+  double y = point->getY();
+  double z = point->getZ();
+  int num_instructions = _instructions.size();
+
+  /* Intersections of halfspaces exit on the first halfspace not containing
+   * the point */
+  if (_conjunction) {
+    int num_halfspaces = num_instructions;
+    if (_instructions[num_instructions-1]._operation == CSG_INTERSECTION)
+      num_halfspaces--;
+    for (int i=0; i < num_halfspaces; i++)
+      if (!inHalfspace(_instructions[i], x, y, z))
+        return false;
+    return true;
+  }
+
+  /* Interpret the postfix program */
+  bool stack[MAX_CSG_STACK];
+  int top = 0;
+  for (int i=0; i < num_instructions; i++) {
+    const csgInstruction& instruction = _instructions[i];
+    switch (instruction._operation) {
+      case CSG_PLANE:
+      case CSG_ZCYLINDER:
+        stack[top++] = inHalfspace(instruction, x, y, z);
+        break;
+      case CSG_INTERSECTION: {
+        bool value = true;
+        for (int n=0; n < instruction._index; n++)
+          value &= stack[--top];
+        stack[top++] = value;
+        break;
+      }
+      case CSG_UNION: {
+        bool value = false;
+        for (int n=0; n < instruction._index; n++)
+          value |= stack[--top];
+        stack[top++] = value;
+        break;
+      }
+      case CSG_COMPLEMENT:
+        stack[top-1] = !stack[top-1];
+        break;
+    }
+  }
+
+  return stack[0];
+}
+
+
+/**
+ * @brief Computes the minimum distance to a Surface of the compiled Region
+ *        from a Point with a given trajectory.
+ * @details The distances to all Planes, then to all ZCylinders, are computed
+ *          with the batched distance functions. If the trajectory will not
+ *          intersect any of the Surfaces, returns INFINITY.
+ * @param point a pointer to the starting Point
+ * @param azim the azimuthal angle of the trajectory
+ * @param polar the polar angle of the trajectory
+ * @return the minimum distance to a Surface in the Region
+ */
+double CompiledRegion::minSurfaceDist(Point* point, double azim,
+                                      double polar) {
+
+  /* Compute the direction vector of the trajectory */
+  double sin_polar = sin(polar);
+  double direction[3] = {sin_polar * cos(azim), sin_polar * sin(azim),
+                         cos(polar)};
+  double* origin = point->getXYZ();
+
+  double min_dist = INFINITY;
+  int index;
+
+  int num_planes = _plane_a.size();
+  if (num_planes > 0)
+    min_dist = minPlaneDistance(num_planes, &_plane_a[0], &_plane_b[0],
+                                &_plane_c[0], &_plane_d[0], origin,
+                                direction, index);
+
+  int num_zcylinders = _zcylinder_x.size();
+  if (num_zcylinders > 0)
+    min_dist = std::min(min_dist, minZCylinderDistance(num_zcylinders,
+                        &_zcylinder_x[0], &_zcylinder_y[0], &_zcylinder_r2[0],
+                        origin, direction, index));
+
+  return min_dist;
+}
@@ -16,6 +16,7 @@
 #endif
 
  /* Forward declarations to resolve circular dependencies */
+class Cell;
 class Intersection;
 class Union;
 class Complement;
@@ -53,6 +54,11 @@ protected:
   /** The parent region, a region which has this region among its nodes */
   Region* _parent_region;
 
+  /** The Cell bounded by this Region, if it is the top Region of a Cell */
+  Cell* _cell;
+
+  void invalidateBounds();
+
 public:
   Region();
   virtual ~Region();
@@ -63,6 +69,7 @@ public:
   regionType getRegionType();
   void setParentRegion(Region* node);
   Region* getParentRegion();
+  void setCell(Cell* cell);
 
   /* Getter functions */
   virtual std::vector<Region*> getNodes();
@@ -172,4 +179,116 @@ public:
   void setBoundaryType(boundaryType boundary_type);
 };
 
+/**
+ * @enum csgOperation
+ * @brief The instructions of a compiled Region, evaluated in postfix order.
+ */
+enum csgOperation {
+  /** Push whether the point is in a Plane halfspace */
+  CSG_PLANE,
+
+  /** Push whether the point is in a ZCylinder halfspace */
+  CSG_ZCYLINDER,
+
+  /** Pop a number of values and push their conjunction */
+  CSG_INTERSECTION,
+
+  /** Pop a number of values and push their disjunction */
+  CSG_UNION,
+
+  /** Pop a value and push its negation */
+  CSG_COMPLEMENT
+};
+
+
+/**
+ * @struct csgInstruction
+ * @brief An instruction of a compiled Region.
+ */
+struct csgInstruction {
+
+  /** The operation */
+  csgOperation _operation;
+
+  /** The index of the Surface in the coefficients of its type for halfspace
+   *  operations, the number of operands for logical operations */
+  int _index;
+
+  /** The halfspace (+1 or -1) for halfspace operations */
+  int _halfspace;
+};
+
+
+/**
+ * @class CompiledRegion Region.h "src/Region.h"
+ * @brief A Region tree lowered into a flat program.
+ * @details The Region tree is flattened into an array of instructions in
+ *          postfix order, interpreted with a small stack of booleans, while
+ *          the coefficients of the Surfaces are stored contiguously by type.
+ *          Point containment and distance queries thus need neither virtual
+ *          calls nor pointer chasing. Only Regions made of Plane and
+ *          ZCylinder halfspaces can be compiled.
+ */
+class CompiledRegion {
+
+private:
+
+  /** The instructions in postfix order */
+  std::vector<csgInstruction> _instructions;
+
+  /** The A, B, C and D coefficients of the Planes, stored by coefficient */
+  std::vector<double> _plane_a;
+  std::vector<double> _plane_b;
+  std::vector<double> _plane_c;
+  std::vector<double> _plane_d;
+
+  /** The centers and squared radii of the ZCylinders */
+  std::vector<double> _zcylinder_x;
+  std::vector<double> _zcylinder_y;
+  std::vector<double> _zcylinder_r2;
+
+  /** The C, D and E coefficients of the ZCylinders' quadratic equations */
+  std::vector<double> _zcylinder_c;
+  std::vector<double> _zcylinder_d;
+  std::vector<double> _zcylinder_e;
+
+  /** The IDs of the Surfaces already stored */
+  std::map<int, int> _surface_indexes;
+
+  /** Whether the Region is an intersection of halfspaces only */
+  bool _conjunction;
+
+  int compileNode(Region* region);
+  int addSurface(Surface* surface);
+
+public:
+  CompiledRegion(Region* region);
+
+  static bool isCompilable(Region* region);
+  bool containsPoint(Point* point);
+  double minSurfaceDist(Point* point, double azim, double polar=M_PI_2);
+
+  /**
+   * @brief Determines whether a point is in the halfspace of an instruction.
+   * @param instruction the halfspace instruction
+   * @param x the x-coordinate of the point
+   * @param y the y-coordinate of the point
+   * @param z the z-coordinate of the point
+   * @return whether the point is in the halfspace
+   */
+  inline bool inHalfspace(const csgInstruction& instruction, double x,
+                          double y, double z) const {
+    double evaluation;
+    int i = instruction._index;
+    if (instruction._operation == CSG_PLANE)
+      evaluation = _plane_a[i] * x + _plane_b[i] * y + _plane_c[i] * z
+                   + _plane_d[i];
+    else
+      evaluation = x * x + y * y + _zcylinder_c[i] * x + _zcylinder_d[i] * y
+                   + _zcylinder_e[i];
+    return evaluation * instruction._halfspace >= 0;
+  }
+};
+
+
 #endif /* REGION_H_ */
@@ -236,6 +236,30 @@ int setRuntimeParameters(RuntimeParameters &RP, int argc, char *argv[]) {
       arg_index++;
       RP._segmentation_type = atoi(argv[arg_index++]);
     }
+    else if(strcmp(argv[arg_index], "-max_segment_memory") == 0) {
+      arg_index++;
+      RP._max_segment_memory = atof(argv[arg_index++]);
+    }
+    else if(strcmp(argv[arg_index], "-pipeline_depth") == 0) {
+      arg_index++;
+      RP._pipeline_depth = atoi(argv[arg_index++]);
+    }
+    else if(strcmp(argv[arg_index], "-segment_window") == 0) {
+      arg_index++;
+      RP._segment_window = atof(argv[arg_index++]);
+    }
+    else if(strcmp(argv[arg_index], "-checkpoint_file") == 0) {
+      arg_index++;
+      RP._checkpoint_filename = std::string(argv[arg_index++]);
+    }
+    else if(strcmp(argv[arg_index], "-checkpoint_interval") == 0) {
+      arg_index++;
+      RP._checkpoint_interval = atoi(argv[arg_index++]);
+    }
+    else if(strcmp(argv[arg_index], "-restart_file") == 0) {
+      arg_index++;
+      RP._restart_filename = std::string(argv[arg_index++]);
+    }
     else if(strcmp(argv[arg_index], "-CMFD_group_structure") == 0) {
       arg_index++;
       char *buf = argv[arg_index];
@@ -337,6 +361,9 @@ int setRuntimeParameters(RuntimeParameters &RP, int argc, char *argv[]) {
       "-num_polar               6                                          \\\n"
       "-seg_zones               -1.0,2.0,3.0                               \\\n"
       "-segmentation_type       3                                          \\\n"
+      "-max_segment_memory      1024                                       \\\n"
+      "-pipeline_depth          4                                          \\\n"
+      "-segment_window          64                                         \\\n"
       "-quadraturetype          2                                          \\\n"
       "-CMFD_group_structure    1-3/4,5/6-8,9                              \\\n"
       "-CMFD_lattice            2,3,3                                      \\\n"
@@ -353,6 +380,8 @@ int setRuntimeParameters(RuntimeParameters &RP, int argc, char *argv[]) {
       "-max_iters               100                                        \\\n"
       "-MOC_src_residual_type   1                                          \\\n"
       "-MOC_src_tolerance       1.0E-5                                     \\\n"
+      "-checkpoint_file         test_problem.chk                           \\\n"
+      "-checkpoint_interval     10                                         \\\n"
       "-output_mesh_lattice     -output_mesh_lattice 5,5,9 -output_type 0  \\\n"
       "-output_mesh_lattice     -output_mesh_lattice 5,5,9 -output_type 1  \\\n"
       "-non_uniform_output      1.26*3/1*3/4.*3/-1.,1.,-1. -output_type 1  \\\n"
@@ -384,7 +413,13 @@ int setRuntimeParameters(RuntimeParameters &RP, int argc, char *argv[]) {
     printf("-num_polar              : (10)\n");
     printf("-seg_zones              : (null) set the segmentation zones\n");
     printf("-segmentation_type      : (3-OTF_STACKS) 0-EXPLICIT_2D, "
-           "1-EXPLICIT_3D, 2-OTF_TRACKS, 3-OTF_STACKS \n");
+           "1-EXPLICIT_3D, 2-OTF_TRACKS, 3-OTF_STACKS, 4-HYBRID_STACKS \n");
+    printf("-max_segment_memory     : (0) memory budget (MB) for explicit "
+           "segments with HYBRID_STACKS\n");
+    printf("-pipeline_depth         : (0) number of z-stacks traced ahead of "
+           "transport by paired threads\n");
+    printf("-segment_window         : (0) window (MB) per thread for streaming "
+           "explicit 3D segments from the Track file\n");
     printf("-quadraturetype         : (2 - GAUSS_LEGENDRE) is default value\n"
            "                           0 - TABUCHI_YAMAMOTO\n"
            "                           1 - LEONARD\n"
@@ -428,6 +463,12 @@ int setRuntimeParameters(RuntimeParameters &RP, int argc, char *argv[]) {
            "1-FISSION_SOURCE, 2-TOTAL_SOURCE\n");
     printf("-MOC_src_tolerance      : (1.0E-4) MOC source convergence "
            "tolerance\n");
+    printf("-checkpoint_file        : (NULL) the file name of checkpoints of "
+           "the MOC source iteration\n");
+    printf("-checkpoint_interval    : (0) number of MOC source iterations "
+           "between checkpoints\n");
+    printf("-restart_file           : (NULL) the file name of a checkpoint to "
+           "restart the MOC source iteration from\n");
     printf("\n");
 
     printf("Output parameters\n");
@@ -44,9 +44,11 @@ struct RuntimeParameters {
     _CMFD_flux_update_on(true), _CMFD_centroid_update_on(false),
     _use_axial_interpolation(0), _log_filename(NULL), _linear_solver(true),
     _MOC_src_residual_type(1), _SOR_factor(1.0), _CMFD_relaxation_factor(1.0),
-    _segmentation_type(3), _verbose_report(true), _time_report(true),
+    _segmentation_type(3), _max_segment_memory(0.), _pipeline_depth(0),
+    _segment_window(0.),
+    _verbose_report(true), _time_report(true),
     _log_level((char*)"NORMAL"),_quadraturetype(2), _test_run(false), 
-    _geo_version(0) {}
+    _geo_version(0), _checkpoint_interval(0) {}
   
   /* To debug or not when running, dead while loop */
   bool _debug_flag;
@@ -73,6 +75,12 @@ struct RuntimeParameters {
   std::vector<double> _seg_zones;
   /* Segmentation type of track generation*/
   int _segmentation_type;
+  /* Memory budget (MB) for explicit segments in hybrid segmentation */
+  double _max_segment_memory;
+  /* Number of z-stacks ray traced ahead of transport, 0 if not pipelined */
+  int _pipeline_depth;
+  /* Window (MB) per thread for streaming explicit 3D segments, 0 if in memory */
+  double _segment_window;
   /* Polar quadrature type */
   int _quadraturetype;
   
@@ -107,6 +115,11 @@ struct RuntimeParameters {
   int _MOC_src_residual_type;  
   /* MOC source convergence tolerance */
   double _tolerance;
+  /* Checkpoint file name and number of iterations between checkpoints */
+  std::string _checkpoint_filename;
+  int _checkpoint_interval;
+  /* Checkpoint file name to restart the MOC source iteration from */
+  std::string _restart_filename;
 
   
   /* uniform lattice output */
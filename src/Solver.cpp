@@ -2,6 +2,10 @@
 #include <unordered_map>
 #include <fstream>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
 #ifdef BGQ
 #include <spi/include/kernel/memory.h>
 #endif
@@ -72,7 +76,14 @@ Solver::Solver(TrackGenerator* track_generator) {
   _calculate_initial_spectrum = false;
   _initial_spectrum_thresh = 1.0;
   _load_initial_FSR_fluxes = false;
+  _transfer_initial_FSR_fluxes = false;
   _calculate_residuals_by_reference = false;
+  _checkpoint_interval = 0;
+  _restart_from_checkpoint = false;
+  _checkpoint_thread = NULL;
+  _initialization._track_generator = NULL;
+  _initialization._exp_evaluators_valid = false;
+  _warm_start = false;
 
   _xs_log_level = ERROR;
 
@@ -92,6 +103,15 @@ Solver::Solver(TrackGenerator* track_generator) {
  */
 Solver::~Solver() {
 
+  /* Finish writing any checkpoint, which reads the Geometry */
+  try {
+    waitForCheckpoint();
+  }
+  catch (std::exception &e) {
+    log_printf(WARNING, "Unable to write the last checkpoint. Backtrace:"
+               "\n%s", e.what());
+  }
+
   if (_FSR_materials != NULL)
     delete [] _FSR_materials;
 
@@ -205,6 +225,15 @@ int Solver::getNumPolarAngles() {
 }
 
 
+/**
+ * @brief Returns the number of energy groups transported by the Solver.
+ * @return the number of energy groups
+ */
+int Solver::getNumEnergyGroups() {
+  return _num_groups;
+}
+
+
 /**
  * @brief Returns the number of source iterations to converge the source.
  * @return the number of iterations
@@ -512,6 +541,7 @@ void Solver::setFixedSourceByMaterial(Material* material, int group,
  * @param max_optical_length The max optical length
  */
 void Solver::setMaxOpticalLength(FP_PRECISION max_optical_length) {
+  _initialization._exp_evaluators_valid = false;
   for (int a=0; a < _num_exp_evaluators_azim; a++)
     for (int p=0; p < _num_exp_evaluators_polar; p++)
       _exp_evaluators[a][p]->setMaxOpticalLength(max_optical_length);
@@ -526,6 +556,7 @@ void Solver::setMaxOpticalLength(FP_PRECISION max_optical_length) {
  * @param precision the precision of the exponential interpolation table,
  */
 void Solver::setExpPrecision(double precision) {
+  _initialization._exp_evaluators_valid = false;
   for (int a=0; a < _num_exp_evaluators_azim; a++)
     for (int p=0; p < _num_exp_evaluators_polar; p++)
       _exp_evaluators[a][p]->setExpPrecision(precision);
@@ -537,6 +568,7 @@ void Solver::setExpPrecision(double precision) {
  *        exponential in the transport equation.
  */
 void Solver::useExponentialInterpolation() {
+  _initialization._exp_evaluators_valid = false;
   for (int a=0; a < _num_exp_evaluators_azim; a++)
     for (int p=0; p < _num_exp_evaluators_polar; p++)
       _exp_evaluators[a][p]->useInterpolation();
@@ -548,6 +580,7 @@ void Solver::useExponentialInterpolation() {
  *        function to compute the exponential in the transport equation.
  */
 void Solver::useExponentialIntrinsic() {
+  _initialization._exp_evaluators_valid = false;
   for (int a=0; a < _num_exp_evaluators_azim; a++)
     for (int p=0; p < _num_exp_evaluators_polar; p++)
       _exp_evaluators[a][p]->useIntrinsic();
@@ -750,6 +783,7 @@ void Solver::initializeFSRs() {
   _FSR_materials = new Material*[_num_FSRs];
 
   /* Loop over all FSRs to extract FSR material pointers */
+  _track_generator->updateFSRMaterials();
   for (long r=0; r < _num_FSRs; r++) {
     _FSR_materials[r] = _geometry->findFSRMaterial(r);
     log_printf(DEBUG, "FSR ID = %d has Material ID = %d, volume = %f", r, 
@@ -1046,6 +1080,114 @@ void Solver::initializeCmfd() {
 }
 
 
+/**
+ * @brief Returns the maximum total cross section of a Material.
+ * @param material the Material
+ * @return the maximum total cross section over all energy groups
+ */
+static double getMaxSigmaT(Material* material) {
+
+  FP_PRECISION* sigma_t = material->getSigmaT();
+  double max_sigma_t = 0.;
+  for (int e=0; e < material->getNumEnergyGroups(); e++)
+    max_sigma_t = std::max(max_sigma_t, (double) sigma_t[e]);
+  return max_sigma_t;
+}
+
+
+/**
+ * @brief Checks whether only the cross sections may have changed since the
+ *        arrays were last initialized by an eigenvalue calculation.
+ * @details The arrays are initialized again after Tracks are generated, when
+ *          the Materials filling the Geometry, the Cmfd, the number of energy
+ *          groups or threads or the transport stabilization change, and after
+ *          fixed source calculations. Filling a Cell again with another
+ *          Material is detected as well, as the Materials of the FSRs may
+ *          change even though the same Materials fill the Geometry.
+ * @return whether the arrays can be kept
+ */
+bool Solver::onlyCrossSectionsChanged() {
+
+  SolverInitialization& init = _initialization;
+  int unchanged = (init._track_generator == _track_generator &&
+                   init._tracks_version == _track_generator->getTracksVersion()
+                   && init._num_groups == _geometry->getNumEnergyGroups() &&
+                   init._num_threads == omp_get_max_threads() &&
+                   init._stabilize_transport == _stabilize_transport &&
+                   init._cmfd == _geometry->getCmfd() &&
+                   init._cell_fills == _geometry->getMaterialCellFills() &&
+                   init._materials == _geometry->getAllMaterials());
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed())
+    MPI_Allreduce(MPI_IN_PLACE, &unchanged, 1, MPI_INT, MPI_MIN,
+                  _geometry->getMPICart());
+#endif
+  return unchanged;
+}
+
+
+/**
+ * @brief Updates the Solver for new cross sections of the same Materials.
+ * @details The FSR, flux and source arrays are kept, and the fissionable FSRs
+ *          and fixed sources are set again. The exponential evaluators are
+ *          only initialized again, splitting the segments, if a total cross
+ *          section increased, since the optical lengths of the segments cannot
+ *          increase otherwise. CMFD condenses the cross sections of the FSRs
+ *          at every solve, so that the Cmfd does not need updating.
+ */
+void Solver::updateCrossSections() {
+
+  log_printf(NORMAL, "Updating solver cross sections...");
+
+  countFissionableFSRs();
+
+  /* Set the fixed sources again, which may be assigned by Material */
+  memset(_fixed_sources, 0, _num_FSRs * _num_groups * sizeof(FP_PRECISION));
+  initializeFixedSources();
+
+  /* Check whether any total cross section increased */
+  int increased = !_initialization._exp_evaluators_valid;
+  std::map<int, Material*>::iterator iter;
+  for (iter = _initialization._materials.begin();
+       iter != _initialization._materials.end(); ++iter)
+    if (getMaxSigmaT(iter->second) >
+        _initialization._max_sigma_t[iter->first])
+      increased = true;
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed())
+    MPI_Allreduce(MPI_IN_PLACE, &increased, 1, MPI_INT, MPI_MAX,
+                  _geometry->getMPICart());
+#endif
+  if (increased)
+    initializeExpEvaluators();
+
+  if (_cmfd != NULL && _cmfd->isFluxUpdateOn())
+    _cmfd->setSourceConvergenceThreshold(_converge_thresh*1.e-1);
+}
+
+
+/**
+ * @brief Records the inputs for which the arrays were initialized.
+ */
+void Solver::recordInitialization() {
+
+  SolverInitialization& init = _initialization;
+  init._track_generator = _track_generator;
+  init._tracks_version = _track_generator->getTracksVersion();
+  init._num_groups = _geometry->getNumEnergyGroups();
+  init._num_threads = omp_get_max_threads();
+  init._stabilize_transport = _stabilize_transport;
+  init._cmfd = _geometry->getCmfd();
+  init._cell_fills = _geometry->getMaterialCellFills();
+  init._materials = _geometry->getAllMaterials();
+  init._max_sigma_t.clear();
+  std::map<int, Material*>::iterator iter;
+  for (iter = init._materials.begin(); iter != init._materials.end(); ++iter)
+    init._max_sigma_t[iter->first] = getMaxSigmaT(iter->second);
+  init._exp_evaluators_valid = true;
+}
+
+
 /**
  * @brief Performs a spectrum calculation to update the scalar fluxes
  * @details This function is meant to be used before transport sweeps in an
@@ -1179,7 +1321,9 @@ void Solver::computeFlux(int max_iters, bool only_fixed_source) {
 
   double residual = 0.;
 
-  /* Initialize data structures */
+  /* Initialize data structures, which an eigenvalue calculation must then
+   * initialize again */
+  _initialization._track_generator = NULL;
   initializeFSRs();
   initializeSourceArrays();
   countFissionableFSRs();
@@ -1283,7 +1427,9 @@ void Solver::computeSource(int max_iters, double k_eff, residualType res_type) {
   _k_eff = k_eff;
   double residual = 0.;
 
-  /* Initialize data structures */
+  /* Initialize data structures, which an eigenvalue calculation must then
+   * initialize again */
+  _initialization._track_generator = NULL;
   initializeFSRs();
   initializeExpEvaluators();
   initializeFluxArrays();
@@ -1364,16 +1510,34 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
   /* Clear convergence data from a previous simulation run */
   double previous_residual = 1.0;
   double residual = 0.;
-  _k_eff = 1.;
 
-  /* Initialize data structures */
-  initializeFSRs();
-  countFissionableFSRs();
-  initializeExpEvaluators();
-  initializeFluxArrays();
-  initializeSourceArrays();
-  initializeCmfd();
+  /* Initialize data structures, or only update those depending on the cross
+   * sections if nothing else changed since the previous calculation */
+  bool warm_start = false;
+  if (onlyCrossSectionsChanged()) {
+    updateCrossSections();
+    warm_start = _warm_start && !_calculate_residuals_by_reference;
+
+    /* Discard the fluxes of the previous calculation unless starting from
+     * them */
+    if (!warm_start) {
+      zeroTrackFluxes();
+      if (_cmfd != NULL && _cmfd->isFluxUpdateOn())
+        _cmfd->getOldDifSurfCorr()->setAll(0.0);
+    }
+  }
+  else {
+    initializeFSRs();
+    countFissionableFSRs();
+    initializeExpEvaluators();
+    initializeFluxArrays();
+    initializeSourceArrays();
+    initializeCmfd();
+  }
+  recordInitialization();
   _geometry->fixFSRMaps();
+  if (!warm_start)
+    _k_eff = 1.;
 #ifdef MPIx
   if (_geometry->isDomainDecomposed())
     MPI_Barrier(_geometry->getMPICart());
@@ -1388,17 +1552,30 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
     memcpy(_reference_flux, _scalar_flux, size * sizeof(FP_PRECISION));
   }
 
-  /* Guess flat spatial scalar flux for each region */
-  if (_chi_spectrum_material == NULL)
+  /* Guess flat spatial scalar flux for each region, unless starting from the
+   * fluxes of the previous calculation */
+  if (warm_start)
+    log_printf(NORMAL, "Starting from the fluxes of the previous calculation");
+  else if (_chi_spectrum_material == NULL)
     flattenFSRFluxes(1.0);
   else
     flattenFSRFluxesChiSpectrum();
   normalizeFluxes();
   storeFSRFluxes();
 
-  /* Load initial FSR fluxes from file if requested */
-  if (_load_initial_FSR_fluxes) {
-    loadFSRFluxes(_initial_FSR_fluxes_file, true);
+  /* Restore the state of the source iteration from a checkpoint, or load
+   * initial FSR fluxes from file if requested */
+  int first_iteration = 0;
+  bool restart = _restart_from_checkpoint;
+  if (restart) {
+    first_iteration = loadCheckpoint(previous_residual);
+    _num_iterations = first_iteration;
+  }
+  else if (_load_initial_FSR_fluxes) {
+    if (_transfer_initial_FSR_fluxes)
+      transferFSRFluxes(_initial_FSR_fluxes_file, true);
+    else
+      loadFSRFluxes(_initial_FSR_fluxes_file, true);
     normalizeFluxes();
     storeFSRFluxes();
 
@@ -1422,7 +1599,7 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
 #endif
   
   /* Perform initial spectrum calculation if requested */
-  if (_calculate_initial_spectrum)
+  if (_calculate_initial_spectrum && !restart && !warm_start)
     calculateInitialSpectrum(_initial_spectrum_thresh);
 
   /* Start the timer to record the total time to converge the source */
@@ -1449,7 +1626,7 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
   double k_prev = _k_eff;
 
   /* Source iteration loop */
-  for (int i=0; i < max_iters; i++) {
+  for (int i=first_iteration; i < max_iters; i++) {
 
     /* Compute the stabilizing flux if necessary */
     if (i > 0 && _stabilize_transport) {
@@ -1517,6 +1694,10 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
     previous_residual = residual;
     _num_iterations++;
 
+    /* Write a checkpoint of the iteration in the background */
+    if (_checkpoint_interval > 0 && _num_iterations % _checkpoint_interval == 0)
+      writeCheckpoint(residual);
+
     /* Check for convergence of the fission source distribution */
     if (i > 1 && residual < _converge_thresh && std::abs(dk) < 1)
       break;
@@ -1525,6 +1706,9 @@ void Solver::computeEigenvalue(int max_iters, residualType res_type) {
   if (_num_iterations == max_iters-1)
     log_printf(WARNING, "Unable to converge the source distribution");
 
+  /* Finish writing the last checkpoint */
+  waitForCheckpoint();
+
   _timer->stopTimer();
   _timer->recordSplit("Total time");
 }
@@ -1600,10 +1784,19 @@ void Solver::printTimerReport() {
   msg_string.resize(53, '.');
   log_printf(RESULT, "%s%1.4E sec", msg_string.c_str(), idle_time);
 
-  /* Time per segment */
-  long num_segments = 0;
+  /* Time threads waited on pipelined on-the-fly ray tracing */
   TrackGenerator3D* track_generator_3D =
     dynamic_cast<TrackGenerator3D*>(_track_generator);
+  if (track_generator_3D != NULL &&
+      track_generator_3D->getPipelineDepth() > 0) {
+    double stall_time = track_generator_3D->getPipelineStallTime();
+    msg_string = "Pipeline Stall Time (summed over threads)";
+    msg_string.resize(53, '.');
+    log_printf(RESULT, "%s%1.4E sec", msg_string.c_str(), stall_time);
+  }
+
+  /* Time per segment */
+  long num_segments = 0;
   if (track_generator_3D != NULL)
     num_segments = track_generator_3D->getNum3DSegments();
   else
@@ -1676,65 +1869,185 @@ void Solver::printTimerReport() {
 }
 
 
-//FIXME
-void Solver::printFissionRates(std::string fname, int nx, int ny, int nz) {
+/**
+ * @brief Computes the fission rates on a uniform mesh over the Geometry.
+ * @details Each domain tallies the fission rates of its own FSRs in the mesh
+ *          cells containing their centroids, and the tallies of all domains
+ *          are then summed.
+ * @param fission_rates the array of mesh fission rates to fill, indexed by
+ *        (z * ny + y) * nx + x
+ * @param nx the number of mesh cells along x
+ * @param ny the number of mesh cells along y
+ * @param nz the number of mesh cells along z
+ */
+void Solver::computeMeshFissionRates(double* fission_rates, int nx, int ny,
+                                     int nz) {
 
   Universe* root_universe = _geometry->getRootUniverse();
-  double x_min = root_universe->getMinX();
-  double x_max = root_universe->getMaxX();
-  double y_min = root_universe->getMinY();
-  double y_max = root_universe->getMaxY();
-  double z_min = root_universe->getMinZ();
-  double z_max = root_universe->getMaxZ();
-
-  double* fission_rates = new double[nx*ny*nz];
-  for (int i=0; i < nx*ny*nz; i++)
-    fission_rates[i] = 0;
+  double min_xyz[3] = {root_universe->getMinX(), root_universe->getMinY(),
+                       root_universe->getMinZ()};
+  double max_xyz[3] = {root_universe->getMaxX(), root_universe->getMaxY(),
+                       root_universe->getMaxZ()};
+  int num_cells[3] = {nx, ny, nz};
+  long num_mesh_cells = (long) nx * ny * nz;
 
-  int num_fsrs = _geometry->getNumTotalFSRs();
-  double* fsr_fission_rates = new double[num_fsrs];
-  computeFSRFissionRates(fsr_fission_rates, num_fsrs);
+  /* Generate centroids if they have not been generated yet */
+  if (!_geometry->containsFSRCentroids())
+    _track_generator->generateFSRCentroids(_FSR_volumes);
 
-  for (long r=0; r < num_fsrs; r++) {
+  std::vector<double> domain_fission_rates(num_mesh_cells, 0.);
 
-    std::vector<double> pt = _geometry->getGlobalFSRCentroidData(r);
+  /* Tally the fission rate of each FSR in the mesh cell of its centroid */
+#pragma omp parallel for
+  for (long r=0; r < _num_FSRs; r++) {
 
-    int x_ind = nx * (pt.at(0) - x_min) / (x_max - x_min);
-    int y_ind = ny * (pt.at(1) - y_min) / (y_max - y_min);
-    int z_ind = nz * (pt.at(2) - z_min) / (z_max - z_min);
+    FP_PRECISION* nu_sigma_f = _FSR_materials[r]->getNuSigmaF();
+    double fission_rate = 0.;
+    for (int e=0; e < _num_groups; e++)
+      fission_rate += nu_sigma_f[e] * _scalar_flux(r,e);
+    if (fission_rate == 0.)
+      continue;
 
-    int ind = z_ind * nx * ny + y_ind * nx + x_ind;
+    /* Directions with a single mesh cell may have infinite bounds */
+    double* centroid_xyz = _geometry->getFSRCentroid(r)->getXYZ();
+    int ind[3] = {0, 0, 0};
+    for (int i=0; i < 3; i++) {
+      if (num_cells[i] > 1) {
+        ind[i] = num_cells[i] * (centroid_xyz[i] - min_xyz[i]) /
+                 (max_xyz[i] - min_xyz[i]);
+        ind[i] = std::max(0, std::min(num_cells[i] - 1, ind[i]));
+      }
+    }
 
-    fission_rates[ind] += fsr_fission_rates[r];
+    long index = ((long) ind[2] * ny + ind[1]) * nx + ind[0];
+#pragma omp atomic update
+    domain_fission_rates[index] += fission_rate * _FSR_volumes[r];
   }
 
-  int rank = 0;
+  /* Sum the tallies of all domains */
 #ifdef MPIx
   if (_geometry->isDomainDecomposed()) {
-    MPI_Comm comm = _geometry->getMPICart();
-    MPI_Comm_rank(comm, &rank);
+    MPI_Allreduce(&domain_fission_rates[0], fission_rates, num_mesh_cells,
+                  MPI_DOUBLE, MPI_SUM, _geometry->getMPICart());
+    return;
   }
 #endif
+  std::copy(domain_fission_rates.begin(), domain_fission_rates.end(),
+            fission_rates);
+}
+
+
+/**
+ * @brief Prints the fission rates on a uniform mesh over the Geometry to a
+ *        text file.
+ * @param fname the name of the file to write
+ * @param nx the number of mesh cells along x
+ * @param ny the number of mesh cells along y
+ * @param nz the number of mesh cells along z
+ */
+void Solver::printFissionRates(std::string fname, int nx, int ny, int nz) {
 
-  if (rank == 0) {
+  Universe* root_universe = _geometry->getRootUniverse();
+  double x_min = root_universe->getMinX();
+  double x_max = root_universe->getMaxX();
+  double y_min = root_universe->getMinY();
+  double y_max = root_universe->getMaxY();
+  double z_min = root_universe->getMinZ();
+  double z_max = root_universe->getMaxZ();
+
+  std::vector<double> fission_rates((long) nx * ny * nz);
+  computeMeshFissionRates(&fission_rates[0], nx, ny, nz);
+
+  if (_geometry->isRootDomain()) {
     std::ofstream out(fname.c_str());
     out << "Fission rates for (" << nx << ", " << ny << ", " << nz <<
       ")" << std::endl;
     for (int i=0; i < nx; i++) {
       for (int j=0; j < ny; j++) {
         for (int k=0; k < nz; k++) {
-          int ind = k * nx * ny + j * nx + i;
+          long ind = ((long) k * ny + j) * nx + i;
           out << "Region " << i << ", " << j << ", " << k << " at point " <<
-            "(" << x_min + (i+0.5) * (x_max - x_min) << ", " <<
-            y_min + (j+0.5) * (y_max - y_min) << ", " <<
-            z_min + (k+0.5) * (z_max - z_min) << ") -> " <<
+            "(" << x_min + (i+0.5) * (x_max - x_min) / nx << ", " <<
+            y_min + (j+0.5) * (y_max - y_min) / ny << ", " <<
+            z_min + (k+0.5) * (z_max - z_min) / nz << ") -> " <<
             fission_rates[ind] << std::endl;
         }
       }
     }
   }
-  delete [] fission_rates;
-  delete [] fsr_fission_rates;
+}
+
+
+/**
+ * @brief Writes the fission rates on a uniform mesh over the Geometry to a
+ *        binary Solver file.
+ * @details The file holds the mesh and its fission rates, which can be read
+ *          back with loadFissionRates().
+ * @param fname the name of the file to write
+ * @param nx the number of mesh cells along x
+ * @param ny the number of mesh cells along y
+ * @param nz the number of mesh cells along z
+ */
+void Solver::dumpFissionRates(std::string fname, int nx, int ny, int nz) {
+
+  long num_mesh_cells = (long) nx * ny * nz;
+  std::vector<double> fission_rates(num_mesh_cells);
+  computeMeshFissionRates(&fission_rates[0], nx, ny, nz);
+
+  /* Describe the mesh by its number of cells and its bounds */
+  Universe* root_universe = _geometry->getRootUniverse();
+  int64_t num_cells[3] = {nx, ny, nz};
+  double bounds[6] = {root_universe->getMinX(), root_universe->getMaxX(),
+                      root_universe->getMinY(), root_universe->getMaxY(),
+                      root_universe->getMinZ(), root_universe->getMaxZ()};
+  char mesh[sizeof(num_cells) + sizeof(bounds)];
+  memcpy(mesh, num_cells, sizeof(num_cells));
+  memcpy(mesh + sizeof(num_cells), bounds, sizeof(bounds));
+
+  SolverFile file;
+  createSolverFile(file, fname);
+  writeSolverFileSection(file, SOLVER_SECTION_MESH, mesh, sizeof(mesh), 1,
+                         false);
+  writeSolverFileSection(file, SOLVER_SECTION_FISSION_RATES, &fission_rates[0],
+                         sizeof(double), num_mesh_cells, false);
+  closeSolverFile(file);
+
+  log_printf(INFO, "Wrote fission rates on a (%d, %d, %d) mesh to %s", nx, ny,
+             nz, fname.c_str());
+}
+
+
+/**
+ * @brief Reads the fission rates on a mesh from a binary Solver file
+ *        written by dumpFissionRates().
+ * @details This may be called from Python with the number of mesh cells,
+ *          returning a NumPy array of the fission rates:
+ *
+ * @code
+ *          fission_rates = solver.loadFissionRates('rates.bin', nx*ny*nz)
+ * @endcode
+ *
+ * @param fname the name of the file to read
+ * @param fission_rates the array of mesh fission rates to fill
+ * @param num_mesh_cells the number of cells of the mesh
+ */
+void Solver::loadFissionRates(std::string fname, double* fission_rates,
+                              int num_mesh_cells) {
+
+  SolverFile file;
+  if (!openSolverFile(file, fname))
+    log_printf(ERROR, "Unable to read fission rates from %s, which is not a "
+               "Solver file", fname.c_str());
+
+  long num_file_cells = file._header._sections[SOLVER_SECTION_FISSION_RATES]
+                        ._count;
+  if (num_file_cells != num_mesh_cells)
+    log_printf(ERROR, "The file %s holds fission rates on %ld mesh cells, not "
+               "%d", fname.c_str(), num_file_cells, num_mesh_cells);
+
+  readSolverFileSection(file, SOLVER_SECTION_FISSION_RATES, fission_rates,
+                        sizeof(double), 0, num_mesh_cells);
+  closeSolverFile(file);
 }
 
 
@@ -1766,71 +2079,150 @@ void Solver::setResidualByReference(std::string fname) {
 
 
 /**
- * @brief Prints scalar fluxes to a binary file
- * @details The name of the file to dump the fluxes to
+ * @brief Writes the scalar fluxes and sources to a binary Solver file.
+ * @details All domains write their FSRs to a single file, each at an offset
+ *          given by the number of FSRs of the preceding domains. With domain
+ *          decomposition the file is written collectively through MPI-IO,
+ *          otherwise it is written in chunks by several threads. The key and
+ *          centroid of each FSR are written as well so that the fluxes can
+ *          be loaded by runs with a different domain decomposition, and the
+ *          volume and material of each FSR so that they can be transferred
+ *          to different FSRs.
+ * @param fname the name of the file to write
  */
 void Solver::dumpFSRFluxes(std::string fname) {
 
-  /* Determine the FSR fluxes file name */
-  std::string filename = fname;
-  if (_geometry->isDomainDecomposed()) {
-    int indexes[3];
-    if (_geometry->isRootDomain())
-      mkdir(filename.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+  /* Generate centroids if they have not been generated yet */
+  if (!_geometry->containsFSRCentroids())
+    _track_generator->generateFSRCentroids(_FSR_volumes);
+
+  /* Gather the number of FSRs of each domain */
+  std::vector<long> domain_FSRs(1, _num_FSRs);
 #ifdef MPIx
-    MPI_Barrier(_geometry->getMPICart());
-#endif
-    filename += "/node";
-    _geometry->getDomainIndexes(indexes);
-    for (int i=0; i < 3; i++) {
-      long long int num = indexes[i];
-      std::string str = std::to_string(num);
-      filename += "_" + str;
-    }
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Comm comm = _geometry->getMPICart();
+    int num_domains;
+    MPI_Comm_size(comm, &num_domains);
+    domain_FSRs.resize(num_domains);
+    MPI_Allgather(&_num_FSRs, 1, MPI_LONG, &domain_FSRs[0], 1, MPI_LONG,
+                  comm);
   }
-  
-  /* Write the FSR fluxes file */
-  FILE* out;
-  out = fopen(filename.c_str(), "w");
-
-  /* Write k-eff */
-  fwrite(&_k_eff, sizeof(double), 1, out);
-
-  /* Write number of energy groups */
-  fwrite(&_num_groups, sizeof(int), 1, out);
-  
-  /* Write number of energy groups */
-  fwrite(&_num_FSRs, sizeof(long), 1, out);
+#endif
 
-  /* Write centroid and flux data */
+  /* Gather the centroid, volume and material of each FSR */
+  std::vector<double> centroids(3 * _num_FSRs);
+  std::vector<double> volumes(_num_FSRs);
+  std::vector<int> materials(_num_FSRs);
+#pragma omp parallel for
   for (long r=0; r < _num_FSRs; r++) {
     Point* centroid = _geometry->getFSRCentroid(r);
-    double x = centroid->getX();
-    double y = centroid->getY();
-    double z = centroid->getZ();
-    fwrite(&x, sizeof(double), 1, out);
-    fwrite(&y, sizeof(double), 1, out);
-    fwrite(&z, sizeof(double), 1, out);
-    fwrite(&_scalar_flux[r*_num_groups], sizeof(double), _num_groups, out);
+    centroids[3*r] = centroid->getX();
+    centroids[3*r+1] = centroid->getY();
+    centroids[3*r+2] = centroid->getZ();
+    volumes[r] = _FSR_volumes[r];
+    materials[r] = _FSR_materials[r]->getId();
   }
-  fclose(out);
+
+  /* Write the file */
+  size_t values_size = _num_groups * sizeof(FP_PRECISION);
+  SolverFile file;
+  createSolverFile(file, fname);
+  writeSolverFileSection(file, SOLVER_SECTION_DOMAIN_FSRS, &domain_FSRs[0],
+                         sizeof(long), domain_FSRs.size(), false);
+  writeSolverFileSection(file, SOLVER_SECTION_FSR_KEYS,
+                         &_geometry->getFSRsToKeys()[0], sizeof(FSRKey),
+                         _num_FSRs);
+  writeSolverFileSection(file, SOLVER_SECTION_FSR_CENTROIDS, &centroids[0],
+                         3 * sizeof(double), _num_FSRs);
+  writeSolverFileSection(file, SOLVER_SECTION_FSR_VOLUMES, &volumes[0],
+                         sizeof(double), _num_FSRs);
+  writeSolverFileSection(file, SOLVER_SECTION_FSR_MATERIALS, &materials[0],
+                         sizeof(int), _num_FSRs);
+  writeSolverFileSection(file, SOLVER_SECTION_SCALAR_FLUXES, _scalar_flux,
+                         values_size, _num_FSRs);
+  if (_reduced_sources != NULL)
+    writeSolverFileSection(file, SOLVER_SECTION_SOURCES, _reduced_sources,
+                           values_size, _num_FSRs);
+  closeSolverFile(file);
+
+  log_printf(INFO, "Wrote FSR fluxes to %s", fname.c_str());
 }
 
 
 /**
  * @brief Loads the initial scalar flux distribution from a binary file
+ * @details If the file was written for different FSRs, for instance with more
+ *          rings, sectors or axial layers, the fluxes can be transferred to
+ *          the current FSRs as a warm start, see transferFSRFluxes().
  * @param fname The file containing the scalar fluxes
+ * @param transfer whether to transfer the fluxes to different FSRs
  */
-void Solver::loadInitialFSRFluxes(std::string fname) {
+void Solver::loadInitialFSRFluxes(std::string fname, bool transfer) {
   _initial_FSR_fluxes_file = fname;
   _load_initial_FSR_fluxes = true;
+  _transfer_initial_FSR_fluxes = transfer;
+}
+
+
+/**
+ * @brief Writes checkpoints of the eigenvalue calculation every number of
+ *        source iterations.
+ * @details Each domain writes its checkpoint to a local file of its own,
+ *          named after the given file and the domain indexes with domain
+ *          decomposition. The state of the iteration is copied and written
+ *          by a background thread while the source iteration proceeds. The
+ *          previous checkpoint is only replaced once the new one is
+ *          complete.
+ * @param fname the name of the checkpoint file
+ * @param interval the number of source iterations between checkpoints
+ */
+void Solver::setCheckpointing(std::string fname, int interval) {
+  if (interval <= 0)
+    log_printf(ERROR, "Unable to write checkpoints every %d iterations",
+               interval);
+  _checkpoint_file = fname;
+  _checkpoint_interval = interval;
+}
+
+
+/**
+ * @brief Restarts the next eigenvalue calculation from a checkpoint.
+ * @details The calculation continues from the iteration at which the
+ *          checkpoint was written, with the fluxes, eigenvalue, stabilization
+ *          and CMFD state of the interrupted calculation, and without any
+ *          startup sweeps. The checkpoint must have been written with the same
+ *          Geometry, Tracks and domain decomposition.
+ * @param fname the name of the checkpoint file
+ */
+void Solver::restartFromCheckpoint(std::string fname) {
+  _restart_file = fname;
+  _restart_from_checkpoint = true;
+}
+
+
+/**
+ * @brief Starts eigenvalue calculations from the fluxes of the previous one.
+ * @details This applies when only the cross sections of the Materials changed
+ *          since the previous calculation, as in branch or depletion
+ *          calculations. The eigenvalue, scalar fluxes and boundary angular
+ *          fluxes of the previous calculation are then the initial guess,
+ *          instead of a flat flux.
+ * @param warm_start whether to start from the previous fluxes
+ */
+void Solver::setWarmStart(bool warm_start) {
+  _warm_start = warm_start;
 }
 
 
 /**
  * @brief Load scalar fluxes from a binary file
- * @details The matching source regions between the current calculation and
- *          those in the loaded file are determined by comparing centroids
+ * @details If the file was written with the same domain decomposition and
+ *          FSRs, each domain reads its own slice of the file. Otherwise the
+ *          FSRs of the file are matched to the current FSRs by key, and the
+ *          FSRs without a match are matched to the FSR of the file with the
+ *          nearest centroid. The sources are loaded as well if the file holds
+ *          them. Files written in the previous format, with a file per domain,
+ *          are still read.
  * @param assign_k_eff Whether to set k-eff to that loaded in the binary file
  * @param tolerance The width of the region in which to search for the matching
  *        centroid
@@ -1838,10 +2230,396 @@ void Solver::loadInitialFSRFluxes(std::string fname) {
 void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
                            double tolerance) {
 
+  SolverFile file;
+  if (!openSolverFile(file, fname)) {
+    loadLegacyFSRFluxes(fname, assign_k_eff, tolerance);
+    return;
+  }
+  log_printf(NORMAL, "Reading fluxes from %s", fname.c_str());
+
+  SolverFileHeader& header = file._header;
+  if (header._num_groups != (uint32_t) _num_groups)
+    log_printf(ERROR, "The number of energy groups in the current Geometry do "
+               "not match the number of energy groups in the binary flux data "
+               "file");
+  if (assign_k_eff) {
+    log_printf(NORMAL, "Loaded k-eff %6.6f", header._k_eff);
+    _k_eff = header._k_eff;
+  }
+
+  /* Locate the FSRs of this domain in the file */
+  long num_file_FSRs = header._num_FSRs;
+  long num_total_FSRs;
+  long first_FSR = getFirstDomainItem(_num_FSRs, num_total_FSRs);
+  int rank = 0;
+  uint32_t num_domains = 1;
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed()) {
+    int size;
+    MPI_Comm_rank(_geometry->getMPICart(), &rank);
+    MPI_Comm_size(_geometry->getMPICart(), &size);
+    num_domains = size;
+  }
+#endif
+  std::vector<long> domain_FSRs(header._num_domains);
+  readSolverFileSection(file, SOLVER_SECTION_DOMAIN_FSRS, &domain_FSRs[0],
+                        sizeof(long), 0, header._num_domains);
+  int same_FSRs = (header._num_domains == num_domains &&
+                   domain_FSRs[rank] == _num_FSRs);
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed())
+    MPI_Allreduce(MPI_IN_PLACE, &same_FSRs, 1, MPI_INT, MPI_MIN,
+                  _geometry->getMPICart());
+#endif
+
+  /* Check whether this domain's slice of the file holds its FSRs */
+  std::vector<FSRKey>& FSRs_to_keys = _geometry->getFSRsToKeys();
+  if (same_FSRs) {
+    std::vector<FSRKey> keys(_num_FSRs);
+    readSolverFileSection(file, SOLVER_SECTION_FSR_KEYS, &keys[0],
+                          sizeof(FSRKey), first_FSR, _num_FSRs);
+    long num_different = 0;
+#pragma omp parallel for reduction(+:num_different)
+    for (long r=0; r < _num_FSRs; r++)
+      if (keys[r] != FSRs_to_keys[r])
+        num_different++;
+    same_FSRs = (num_different == 0);
+#ifdef MPIx
+    if (_geometry->isDomainDecomposed())
+      MPI_Allreduce(MPI_IN_PLACE, &same_FSRs, 1, MPI_INT, MPI_MIN,
+                    _geometry->getMPICart());
+#endif
+  }
+
+  std::vector<long> file_FSRs(_num_FSRs, -1);
+  if (same_FSRs) {
+#pragma omp parallel for
+    for (long r=0; r < _num_FSRs; r++)
+      file_FSRs[r] = first_FSR + r;
+  }
+  else {
+
+    /* Match the FSRs of the file by key, scanning the keys in chunks */
+    ConcurrentHashMap<FSRKey, fsr_data*>& FSR_keys_map =
+         _geometry->getFSRKeysMap();
+    long chunk_size = SOLVER_FILE_CHUNK / sizeof(FSRKey);
+    std::vector<FSRKey> keys(std::min(chunk_size, num_file_FSRs));
+    for (long start=0; start < num_file_FSRs; start += chunk_size) {
+      long num_keys = std::min(chunk_size, num_file_FSRs - start);
+      readSolverFileSection(file, SOLVER_SECTION_FSR_KEYS, &keys[0],
+                            sizeof(FSRKey), start, num_keys);
+#pragma omp parallel for
+      for (long k=0; k < num_keys; k++) {
+        if (FSR_keys_map.contains(keys[k])) {
+          long fsr_id = FSR_keys_map.at(keys[k])->_fsr_id;
+          __sync_bool_compare_and_swap(&file_FSRs[fsr_id], -1L, start + k);
+        }
+      }
+    }
+
+    /* Match the remaining FSRs by centroid */
+    long num_unmatched = 0;
+#pragma omp parallel for reduction(+:num_unmatched)
+    for (long r=0; r < _num_FSRs; r++)
+      if (file_FSRs[r] < 0)
+        num_unmatched++;
+    long num_total_unmatched = num_unmatched;
+#ifdef MPIx
+    if (_geometry->isDomainDecomposed())
+      MPI_Allreduce(&num_unmatched, &num_total_unmatched, 1, MPI_LONG,
+                    MPI_SUM, _geometry->getMPICart());
+#endif
+    if (num_total_unmatched > 0) {
+      std::vector<double> centroids(3 * num_file_FSRs);
+      readSolverFileSection(file, SOLVER_SECTION_FSR_CENTROIDS, &centroids[0],
+                            3 * sizeof(double), 0, num_file_FSRs);
+      double max_centroid_error = 0.;
+      if (num_unmatched > 0)
+        max_centroid_error = matchFSRCentroids(&centroids[0], num_file_FSRs,
+                                               &file_FSRs[0], tolerance);
+      log_printf(NORMAL, "Matched %ld FSRs by centroid with maximum centroid "
+                 "error %6.4e", num_unmatched, max_centroid_error);
+    }
+  }
+
+  /* Read the fluxes and sources of the matching FSRs of the file */
+  readSolverFileFSRValues(file, SOLVER_SECTION_SCALAR_FLUXES, _scalar_flux,
+                          &file_FSRs[0], same_FSRs);
+  if (_reduced_sources != NULL &&
+      header._sections[SOLVER_SECTION_SOURCES]._count > 0)
+    readSolverFileFSRValues(file, SOLVER_SECTION_SOURCES, _reduced_sources,
+                            &file_FSRs[0], same_FSRs);
+  closeSolverFile(file);
+
+  log_printf(NORMAL, "FSR fluxes successfully loaded");
+}
+
+
+/**
+ * @brief Transfers scalar fluxes from a Solver file written for different
+ *        FSRs, as a warm start.
+ * @details This is meant for runs whose FSRs differ from those of the run
+ *          which wrote the file, for instance with more rings, sectors or
+ *          axial layers, so that the fluxes cannot be loaded by FSR key. The
+ *          centroid of each FSR of the file is located in the current
+ *          Geometry, and each FSR with the same Material takes the average
+ *          of the fluxes of the FSRs of the file located in it, weighted by
+ *          their volumes. The FSRs without the centroid of any FSR of the
+ *          file, as when FSRs are refined, take the fluxes of the FSR of the
+ *          file with the same Material and the nearest centroid. The search
+ *          for the nearest centroid is widened until every FSR is matched.
+ *          Each domain only keeps the FSRs of the file with a centroid in
+ *          the domain, and reads the fluxes of the chunks holding them.
+ * @param fname the name of the Solver file
+ * @param assign_k_eff Whether to set k-eff to that loaded in the file
+ * @param tolerance The width of the region in which to first search for the
+ *        nearest centroid
+ */
+void Solver::transferFSRFluxes(std::string fname, bool assign_k_eff,
+                               double tolerance) {
+
+  SolverFile file;
+  if (!openSolverFile(file, fname))
+    log_printf(ERROR, "Unable to transfer fluxes from %s which is not a "
+               "Solver file", fname.c_str());
+  log_printf(NORMAL, "Transferring fluxes from %s", fname.c_str());
+
+  SolverFileHeader& header = file._header;
+  if (header._num_groups != (uint32_t) _num_groups)
+    log_printf(ERROR, "The number of energy groups in the current Geometry do "
+               "not match the number of energy groups in the binary flux data "
+               "file");
+  if (assign_k_eff) {
+    log_printf(NORMAL, "Loaded k-eff %6.6f", header._k_eff);
+    _k_eff = header._k_eff;
+  }
+
+  /* Check for the volume and material of each FSR of the file */
+  if (header._sections[SOLVER_SECTION_FSR_VOLUMES]._count == 0 ||
+      header._sections[SOLVER_SECTION_FSR_MATERIALS]._count == 0)
+    log_printf(ERROR, "Unable to transfer fluxes from %s which has no FSR "
+               "volumes and Materials, as written by version %d of Solver "
+               "files", fname.c_str(), header._version);
+
+  /* Get the bounds of this domain */
+  bool domain_decomposed = _geometry->isDomainDecomposed();
+  double min_xyz[3] = {_geometry->getMinX(), _geometry->getMinY(),
+                       _geometry->getMinZ()};
+  double max_xyz[3] = {_geometry->getMaxX(), _geometry->getMaxY(),
+                       _geometry->getMaxZ()};
+
+  /* Read the centroid, volume and material of the FSRs of the file in
+   * chunks, keeping those with a centroid in this domain */
+  long num_file_FSRs = header._num_FSRs;
+  long chunk_size = std::max(1L, (long) (SOLVER_FILE_CHUNK /
+                                         (3 * sizeof(double))));
+  long buffer_size = std::min(chunk_size, num_file_FSRs);
+  std::vector<double> chunk_centroids(3 * buffer_size);
+  std::vector<double> chunk_volumes(buffer_size);
+  std::vector<int> chunk_materials(buffer_size);
+  std::vector<long> file_ids;
+  std::vector<double> centroids;
+  std::vector<double> volumes;
+  std::vector<int> materials;
+  for (long start=0; start < num_file_FSRs; start += chunk_size) {
+    long num_items = std::min(chunk_size, num_file_FSRs - start);
+    readSolverFileSection(file, SOLVER_SECTION_FSR_CENTROIDS,
+                          &chunk_centroids[0], 3 * sizeof(double), start,
+                          num_items);
+    readSolverFileSection(file, SOLVER_SECTION_FSR_VOLUMES, &chunk_volumes[0],
+                          sizeof(double), start, num_items);
+    readSolverFileSection(file, SOLVER_SECTION_FSR_MATERIALS,
+                          &chunk_materials[0], sizeof(int), start, num_items);
+
+    for (long i=0; i < num_items; i++) {
+      double* xyz = &chunk_centroids[3*i];
+      if (domain_decomposed &&
+          (xyz[0] < min_xyz[0] || xyz[0] > max_xyz[0] ||
+           xyz[1] < min_xyz[1] || xyz[1] > max_xyz[1] ||
+           xyz[2] < min_xyz[2] || xyz[2] > max_xyz[2]))
+        continue;
+      file_ids.push_back(start + i);
+      centroids.insert(centroids.end(), xyz, xyz + 3);
+      volumes.push_back(chunk_volumes[i]);
+      materials.push_back(chunk_materials[i]);
+    }
+  }
+  long num_local_FSRs = file_ids.size();
+
+  /* Generate centroids if they have not been generated yet */
+  if (!_geometry->containsFSRCentroids())
+    _track_generator->generateFSRCentroids(_FSR_volumes);
+
+  /* Find the FSR of this domain containing the centroid of each FSR of the
+   * file kept, if it has the same Material. FSRs of the file are indexed
+   * by their order among those kept from here on. */
+  Universe* root_universe = _geometry->getRootUniverse();
+  std::vector<long> FSRs(num_local_FSRs, -1);
+  std::vector<long> file_FSRs(_num_FSRs, -1);
+#pragma omp parallel for schedule(guided)
+  for (long i=0; i < num_local_FSRs; i++) {
+    LocalCoords coords(centroids[3*i], centroids[3*i+1], centroids[3*i+2],
+                       true);
+    coords.setUniverse(root_universe);
+    Cell* cell = _geometry->findCellContainingCoords(&coords);
+    if (cell == NULL || cell->getFillMaterial()->getId() != materials[i])
+      continue;
+    long fsr_id = _geometry->getFSRId(&coords, false);
+    if (fsr_id < 0)
+      continue;
+    FSRs[i] = fsr_id;
+    __sync_bool_compare_and_swap(&file_FSRs[fsr_id], -1L, i);
+  }
+
+  /* Find the largest coordinate, as a search region wider than it holds all
+   * the centroids */
+  double max_coordinate = 0.;
+#pragma omp parallel for reduction(max:max_coordinate)
+  for (long i=0; i < 3 * num_local_FSRs; i++)
+    max_coordinate = std::max(max_coordinate, fabs(centroids[i]));
+#pragma omp parallel for reduction(max:max_coordinate)
+  for (long r=0; r < _num_FSRs; r++) {
+    double* centroid_xyz = _geometry->getFSRCentroid(r)->getXYZ();
+    for (int i=0; i < 3; i++)
+      max_coordinate = std::max(max_coordinate, fabs(centroid_xyz[i]));
+  }
+
+  /* Match the other FSRs to the FSR of the file with the same Material and
+   * the nearest centroid, widening the search region as needed */
+  std::vector<long> nearest_FSRs(file_FSRs);
+  double max_centroid_error = 0.;
+  double width = tolerance;
+  long num_unmatched = std::count(nearest_FSRs.begin(), nearest_FSRs.end(),
+                                  -1L);
+  while (num_unmatched > 0 && num_local_FSRs > 0) {
+    max_centroid_error = std::max(max_centroid_error,
+         matchFSRCentroids(&centroids[0], num_local_FSRs, &nearest_FSRs[0],
+                           width, &materials[0]));
+    num_unmatched = std::count(nearest_FSRs.begin(), nearest_FSRs.end(), -1L);
+    if (width > max_coordinate)
+      break;
+    width *= 2;
+  }
+
+  /* List the FSRs matched by centroid, ordered by FSR of the file */
+  std::vector<std::pair<long, long> > nearest;
+  for (long r=0; r < _num_FSRs; r++)
+    if (file_FSRs[r] < 0 && nearest_FSRs[r] >= 0)
+      nearest.push_back(std::make_pair(nearest_FSRs[r], r));
+  std::sort(nearest.begin(), nearest.end());
+
+  /* Read the fluxes of the file in chunks holding FSRs kept, accumulating
+   * the volume-weighted fluxes of each FSR and copying those of the nearest
+   * FSRs */
+  size_t value_size = header._precision_size;
+  size_t item_size = _num_groups * value_size;
+  chunk_size = std::max(1L, (long) (SOLVER_FILE_CHUNK / item_size));
+  std::vector<char> buffer(std::min(chunk_size, num_file_FSRs) * item_size);
+  std::vector<double> fluxes(_num_FSRs * _num_groups, 0.);
+  std::vector<double> weights(_num_FSRs, 0.);
+  long first = 0;
+  size_t n = 0;
+  for (long start=0; start < num_file_FSRs; start += chunk_size) {
+    long num_items = std::min(chunk_size, num_file_FSRs - start);
+
+    /* Find the FSRs kept in this chunk */
+    long last = first;
+    while (last < num_local_FSRs && file_ids[last] < start + num_items)
+      last++;
+    if (last == first)
+      continue;
+    readSolverFileSection(file, SOLVER_SECTION_SCALAR_FLUXES, &buffer[0],
+                          item_size, start, num_items);
+
+#pragma omp parallel for
+    for (long i=first; i < last; i++) {
+      long fsr_id = FSRs[i];
+      if (fsr_id < 0)
+        continue;
+      double volume = volumes[i];
+      char* item = &buffer[(file_ids[i] - start) * item_size];
+      for (int e=0; e < _num_groups; e++) {
+        double flux;
+        if (value_size == sizeof(double))
+          flux = ((double*) item)[e];
+        else
+          flux = ((float*) item)[e];
+#pragma omp atomic update
+        fluxes[fsr_id * _num_groups + e] += volume * flux;
+      }
+#pragma omp atomic update
+      weights[fsr_id] += volume;
+    }
+
+    size_t end = n;
+    while (end < nearest.size() && nearest[end].first < last)
+      end++;
+#pragma omp parallel for
+    for (size_t j=n; j < end; j++) {
+      char* item = &buffer[(file_ids[nearest[j].first] - start) * item_size];
+      long fsr_id = nearest[j].second;
+      for (int e=0; e < _num_groups; e++) {
+        if (value_size == sizeof(double))
+          fluxes[fsr_id * _num_groups + e] = ((double*) item)[e];
+        else
+          fluxes[fsr_id * _num_groups + e] = ((float*) item)[e];
+      }
+      weights[fsr_id] = 1.;
+    }
+    n = end;
+    first = last;
+  }
+  closeSolverFile(file);
+
+  /* Assign the transferred fluxes */
+  long num_averaged = 0;
+#pragma omp parallel for reduction(+:num_averaged)
+  for (long r=0; r < _num_FSRs; r++) {
+    if (weights[r] == 0.)
+      continue;
+    for (int e=0; e < _num_groups; e++)
+      _scalar_flux(r,e) = fluxes[r * _num_groups + e] / weights[r];
+    if (file_FSRs[r] >= 0)
+      num_averaged++;
+  }
+
+  /* Report the transfer for all domains */
+  long num_FSRs[3] = {num_averaged, (long) nearest.size(), num_unmatched};
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Allreduce(MPI_IN_PLACE, num_FSRs, 3, MPI_LONG, MPI_SUM,
+                  _geometry->getMPICart());
+    MPI_Allreduce(MPI_IN_PLACE, &max_centroid_error, 1, MPI_DOUBLE, MPI_MAX,
+                  _geometry->getMPICart());
+  }
+#endif
+  log_printf(NORMAL, "Transferred fluxes to %ld FSRs by volume-weighted "
+             "averaging and to %ld FSRs from the nearest centroid with "
+             "maximum distance %6.4e", num_FSRs[0], num_FSRs[1],
+             max_centroid_error);
+  if (num_FSRs[2] > 0)
+    log_printf(WARNING, "%ld FSRs filled with Materials absent from %s keep "
+               "their current fluxes", num_FSRs[2], fname.c_str());
+}
+
+
+/**
+ * @brief Load scalar fluxes from a binary file written in the previous format
+ * @details With domain decomposition, each domain reads a file of its own.
+ *          The FSRs are matched by centroid.
+ * @param fname the name of the file, or of the directory of files of each
+ *        domain
+ * @param assign_k_eff Whether to set k-eff to that loaded in the binary file
+ * @param tolerance The width of the region in which to search for the matching
+ *        centroid
+ */
+void Solver::loadLegacyFSRFluxes(std::string fname, bool assign_k_eff,
+                                 double tolerance) {
+
   /* Determine the FSR fluxes file name */
   std::string filename = fname;
   if (_geometry->isDomainDecomposed()) {
-    int indexes[3]; 
+    int indexes[3];
     filename += "/node";
     _geometry->getDomainIndexes(indexes);
     for (int i=0; i < 3; i++) {
@@ -1850,7 +2628,7 @@ void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
       filename += "_" + str;
     }
   }
-  
+
   /* Load the FSR fluxes file */
   FILE* in;
   in = fopen(filename.c_str(), "r");
@@ -1858,7 +2636,7 @@ void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
     log_printf(ERROR, "Failed to find file %s", filename.c_str());
   log_printf(NORMAL, "Reading fluxes from %s", fname.c_str());
 
-  /* Read number of energy groups */
+  /* Read k-eff */
   double k_eff;
   int ret = fread(&k_eff, sizeof(double), 1, in);
   if (assign_k_eff) {
@@ -1869,8 +2647,8 @@ void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
   /* Read number of energy groups */
   int num_groups;
   ret = fread(&num_groups, sizeof(int), 1, in);
-  
-  /* Read number of energy groups */
+
+  /* Read number of FSRs */
   long num_FSRs;
   ret = fread(&num_FSRs, sizeof(long), 1, in);
 
@@ -1883,42 +2661,69 @@ void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
                "not match the number of energy groups in the binary flux data "
                "file");
 
-  /* Setup array structures */
-  double* x_coord = new double[num_FSRs];
-  double* y_coord = new double[num_FSRs];
-  double* z_coord = new double[num_FSRs];
-  double* fluxes = new double[num_FSRs * num_groups];
-
   /* Load data into structures */
+  double* centroids = new double[3 * num_FSRs];
+  double* fluxes = new double[num_FSRs * num_groups];
   for (long r=0; r < num_FSRs; r++) {
-    ret = fread(&x_coord[r], sizeof(double), 1, in);
-    ret = fread(&y_coord[r], sizeof(double), 1, in);
-    ret = fread(&z_coord[r], sizeof(double), 1, in);
+    ret = fread(&centroids[3*r], sizeof(double), 3, in);
     ret = fread(&fluxes[r*num_groups], sizeof(double), num_groups, in);
   }
   fclose(in);
 
+  /* Match the FSRs by centroid */
+  std::vector<long> file_FSRs(_num_FSRs, -1);
+  double max_centroid_error = matchFSRCentroids(centroids, num_FSRs,
+                                                &file_FSRs[0], tolerance);
+
+  /* Assign starting fluxes to the scalar fluxes array */
+#pragma omp parallel for
+  for (long r=0; r < _num_FSRs; r++)
+    for (int e=0; e < _num_groups; e++)
+      _scalar_flux(r,e) = fluxes[file_FSRs[r] * num_groups + e];
+
+  /* Delete auxilary data structures */
+  delete [] centroids;
+  delete [] fluxes;
+
+  log_printf(NORMAL, "FSR fluxes successfully loaded with maximum centroid "
+             "error %6.4e", max_centroid_error);
+}
+
+
+/**
+ * @brief Matches FSRs to the FSRs of a file with the nearest centroid.
+ * @details The centroids of the file are hashed into cells of the width of
+ *          the tolerance, and the centroid of each FSR without a match yet
+ *          is compared to those in the neighboring cells.
+ * @param centroids the x, y and z coordinates of the centroid of each FSR of
+ *        the file
+ * @param num_file_FSRs the number of FSRs of the file
+ * @param file_FSRs the FSR of the file matching each FSR, or -1 for the FSRs
+ *        to match
+ * @param tolerance the width of the region in which to search for the
+ *        matching centroid
+ * @param materials the Material ID of each FSR of the file, if the matching
+ *        FSRs must have the same Material. FSRs without such a match in the
+ *        search region are left at -1.
+ * @return the maximum distance between matching centroids
+ */
+double Solver::matchFSRCentroids(double* centroids, long num_file_FSRs,
+                                 long* file_FSRs, double tolerance,
+                                 int* materials) {
+
   /* Setup cell index mapping */
-  int* cell_x = new int[num_FSRs];
-  int* cell_y = new int[num_FSRs];
-  int* cell_z = new int[num_FSRs];
+  int* cell_indexes = new int[3 * num_file_FSRs];
 #pragma omp parallel for
-  for (long r=0; r < num_FSRs; r++) {
-    cell_x[r] = x_coord[r] / tolerance;
-    cell_y[r] = y_coord[r] / tolerance;
-    cell_z[r] = z_coord[r] / tolerance;
-  }
-  int* cell_indexes[3] = {cell_x, cell_y, cell_z};
+  for (long r=0; r < 3 * num_file_FSRs; r++)
+    cell_indexes[r] = centroids[r] / tolerance;
 
   /* Find min/max indexes in order to make integer-index mapping */
-  int min_ind[3] = {cell_x[0], cell_y[0], cell_z[0]};
-  int max_ind[3] = {cell_x[0], cell_y[0], cell_z[0]};
-  for (long r=0; r < num_FSRs; r++) {
+  int min_ind[3] = {cell_indexes[0], cell_indexes[1], cell_indexes[2]};
+  int max_ind[3] = {cell_indexes[0], cell_indexes[1], cell_indexes[2]};
+  for (long r=0; r < num_file_FSRs; r++) {
     for (int i=0; i < 3; i++) {
-      if (cell_indexes[i][r] < min_ind[i])
-        min_ind[i] = cell_indexes[i][r];
-      if (cell_indexes[i][r] > max_ind[i])
-        max_ind[i] = cell_indexes[i][r];
+      min_ind[i] = std::min(min_ind[i], cell_indexes[3*r+i]);
+      max_ind[i] = std::max(max_ind[i], cell_indexes[3*r+i]);
     }
   }
 
@@ -1926,99 +2731,787 @@ void Solver::loadFSRFluxes(std::string fname, bool assign_k_eff,
   std::unordered_map<long, std::vector<long> > hashed_lookup;
   long nx = max_ind[0] - min_ind[0] + 1;
   long ny = max_ind[1] - min_ind[1] + 1;
-  long nz = max_ind[2] - min_ind[2] + 1;
-  for (long r=0; r < num_FSRs; r++) {
-    long index = (cell_z[r] - min_ind[2]) * nx * ny + 
-                (cell_y[r] - min_ind[1]) * nx + cell_x[r] - min_ind[0];
-    if (hashed_lookup.find(index) == hashed_lookup.end())
-      hashed_lookup.insert(std::make_pair(index, std::vector<long>()));
+  for (long r=0; r < num_file_FSRs; r++) {
+    long index = (cell_indexes[3*r+2] - min_ind[2]) * nx * ny +
+                 (cell_indexes[3*r+1] - min_ind[1]) * nx +
+                 cell_indexes[3*r] - min_ind[0];
     hashed_lookup[index].push_back(r);
   }
-  
+  delete [] cell_indexes;
+
   /* Generate centroids if they have not been generated yet */
-  double max_centroid_error = 0.0;
-  if (!_geometry->containsFSRCentroids()) 
+  if (!_geometry->containsFSRCentroids())
     _track_generator->generateFSRCentroids(_FSR_volumes);
 
-  /* Assign starting fluxes to the scalar fluxes array */
-#pragma omp parallel for
+  double max_centroid_error = 0.0;
+#pragma omp parallel for reduction(max:max_centroid_error)
   for (long r=0; r < _num_FSRs; r++) {
 
+    if (file_FSRs[r] >= 0)
+      continue;
+    int material_id = 0;
+    if (materials != NULL)
+      material_id = _FSR_materials[r]->getId();
+
     /* Get the cell coordinates */
     Point* centroid = _geometry->getFSRCentroid(r);
     double* centroid_xyz = centroid->getXYZ();
     int cell_xyz[3];
     for (int i=0; i < 3; i++)
       cell_xyz[i] = centroid_xyz[i] / tolerance;
-    
+
     /* Look at all cell combinations */
     double min_dist = std::numeric_limits<double>::max();
     long load_fsr = -1;
     for (int dx=-1; dx <= 1; dx++) {
       for (int dy=-1; dy <= 1; dy++) {
         for (int dz=-1; dz <= 1; dz++) {
-          
+
+          /* Make sure index is within origin min/max bounds */
           int new_cell_xyz[3];
           int d[3] = {dx, dy, dz};
           for (int i=0; i < 3; i++)
-            new_cell_xyz[i] = cell_xyz[i] + d[i];
-          
-          /* Make sure index is within origin min/max bounds */
-          for (int i=0; i < 3; i++) {
-            if (new_cell_xyz[i] > max_ind[i])
-              new_cell_xyz[i] = max_ind[i];
-            if (cell_xyz[i] < min_ind[i])
-              new_cell_xyz[i] = min_ind[i];
-          }
+            new_cell_xyz[i] = std::max(min_ind[i], std::min(max_ind[i],
+                                       cell_xyz[i] + d[i]));
 
           /* Calculate index */
-          long index = (new_cell_xyz[2] - min_ind[2]) * nx * ny + 
-                       (new_cell_xyz[1] - min_ind[1]) * nx + 
+          long index = (new_cell_xyz[2] - min_ind[2]) * nx * ny +
+                       (new_cell_xyz[1] - min_ind[1]) * nx +
                        new_cell_xyz[0] - min_ind[0];
 
           /* Lookup all FSRs in the cell and check for distance to centroid */
-          if (hashed_lookup.find(index) != hashed_lookup.end()) {
-            for (int j =0; j < hashed_lookup[index].size(); j++) {
-              long fsr_id = hashed_lookup[index].at(j);
-              long dist = centroid->distance(x_coord[fsr_id], y_coord[fsr_id], 
-                                             z_coord[fsr_id]);
-              if (dist < min_dist) {
-                min_dist = dist;
-                load_fsr = fsr_id;
-              }
+          std::unordered_map<long, std::vector<long> >::const_iterator it =
+               hashed_lookup.find(index);
+          if (it == hashed_lookup.end())
+            continue;
+          for (size_t j=0; j < it->second.size(); j++) {
+            long fsr_id = it->second[j];
+            if (materials != NULL && materials[fsr_id] != material_id)
+              continue;
+            double dist = centroid->distance(centroids[3*fsr_id],
+                                             centroids[3*fsr_id+1],
+                                             centroids[3*fsr_id+2]);
+            if (dist < min_dist) {
+              min_dist = dist;
+              load_fsr = fsr_id;
             }
           }
         }
       }
     }
-    
-    /* Check against maximum centroid mismatch */
-    if (min_dist > max_centroid_error)
-      max_centroid_error = min_dist;
 
     /* Check to ensure the loaded FSR is positive */
-    if (load_fsr < 0)
-      log_printf(ERROR, "Loaded FSR %d with location (%3.2f, %3.2f, %3.2f) "
-                 "and cell (%d, %d, %d)", load_fsr, centroid_xyz[0], 
+    if (load_fsr < 0 && materials != NULL)
+      continue;
+    else if (load_fsr < 0)
+      log_printf(ERROR, "Loaded FSR %ld with location (%3.2f, %3.2f, %3.2f) "
+                 "and cell (%d, %d, %d)", load_fsr, centroid_xyz[0],
                  centroid_xyz[1], centroid_xyz[2], cell_xyz[0], cell_xyz[1],
                  cell_xyz[2]);
 
-    /* Assign scalar fluxes */
-    for (int e=0; e < _num_groups; e++)
-      _scalar_flux[r*num_groups+e] = fluxes[load_fsr * num_groups + e];
+    /* Check against maximum centroid mismatch */
+    max_centroid_error = std::max(max_centroid_error, min_dist);
+    file_FSRs[r] = load_fsr;
   }
 
-  /* Delete auxilary data structures */
-  delete [] x_coord;
-  delete [] y_coord;
-  delete [] z_coord;
-  delete [] fluxes;
-  delete [] cell_x;
-  delete [] cell_y;
-  delete [] cell_z;
+  return max_centroid_error;
+}
 
-  log_printf(NORMAL, "FSR fluxes successfully loaded with maximum centroid "
-             "error %6.4e", max_centroid_error);
+
+/**
+ * @brief Finds the position of the items of this domain among the items of
+ *        all domains, ordered by domain rank.
+ * @param num_items the number of items of this domain
+ * @param num_total_items the number of items of all domains
+ * @return the index of the first item of this domain
+ */
+long Solver::getFirstDomainItem(long num_items, long& num_total_items) {
+
+  long first_item = 0;
+  num_total_items = num_items;
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed()) {
+    MPI_Comm comm = _geometry->getMPICart();
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Exscan(&num_items, &first_item, 1, MPI_LONG, MPI_SUM, comm);
+    MPI_Allreduce(&num_items, &num_total_items, 1, MPI_LONG, MPI_SUM, comm);
+
+    /* MPI_Exscan leaves the result of the first rank undefined */
+    if (rank == 0)
+      first_item = 0;
+  }
+#endif
+  return first_item;
+}
+
+
+/**
+ * @brief Converts the header of a Solver file to the current layout.
+ * @details Up to version 3, the header ended with a section table of 7, 16
+ *          and 18 sections, placed where the number of sections now is.
+ *          Version 3 also had the FSR volumes and Materials before the CMFD
+ *          sections, which precede them now. Later versions share the
+ *          layout of the current header, and the sections they added are
+ *          ignored.
+ * @param header the header, as read from the file
+ * @param size the number of bytes of the header read from the file
+ * @return whether the header is complete and of a supported version
+ */
+static bool convertSolverFileHeader(SolverFileHeader& header, long size) {
+
+  static_assert(NUM_SOLVER_FILE_SECTIONS <= SOLVER_FILE_MAX_SECTIONS,
+                "The section table of Solver files is full");
+
+  if (header._version > 3)
+    return size == sizeof(SolverFileHeader) &&
+           header._num_sections <= SOLVER_FILE_MAX_SECTIONS;
+
+  /* Find the number of sections of the previous version */
+  const int legacy_num_sections[3] = {7, 16, 18};
+  if (header._version < 1)
+    return false;
+  int num_sections = legacy_num_sections[header._version - 1];
+  size_t table_offset = offsetof(SolverFileHeader, _num_sections);
+  if (size < (long) (table_offset + num_sections * sizeof(SolverFileSection)))
+    return false;
+
+  /* Move the sections to their place in the current table */
+  const int version_3_sections[4] = {SOLVER_SECTION_FSR_VOLUMES,
+                                     SOLVER_SECTION_FSR_MATERIALS,
+                                     SOLVER_SECTION_CMFD_OLD_FLUX,
+                                     SOLVER_SECTION_CMFD_DIF_SURF_CORR};
+  std::vector<SolverFileSection> sections(num_sections);
+  memcpy(&sections[0], (char*) &header + table_offset,
+         num_sections * sizeof(SolverFileSection));
+  memset((char*) &header + table_offset, 0,
+         sizeof(SolverFileHeader) - table_offset);
+  header._num_sections = num_sections;
+  for (int i=0; i < num_sections; i++) {
+    int section = i;
+    if (header._version == 3 && i >= SOLVER_SECTION_CMFD_OLD_FLUX)
+      section = version_3_sections[i - SOLVER_SECTION_CMFD_OLD_FLUX];
+    header._sections[section] = sections[i];
+  }
+  return true;
+}
+
+
+/**
+ * @brief Creates a Solver file and initializes its header.
+ * @details With domain decomposition, all domains create the file together
+ *          unless it is local. The header is written when the file is closed.
+ * @param file the Solver file to create
+ * @param filename the name of the file
+ * @param local whether the file holds the FSRs of this domain only
+ */
+void Solver::createSolverFile(SolverFile& file, std::string filename,
+                              bool local) {
+
+  SolverFileHeader& header = file._header;
+  memset(&header, 0, sizeof(SolverFileHeader));
+  memcpy(header._magic, "OMOCSOLV", sizeof(header._magic));
+  header._version = SOLVER_FILE_VERSION;
+  header._endianness = SOLVER_FILE_ENDIANNESS;
+  header._precision_size = sizeof(FP_PRECISION);
+  header._num_groups = _num_groups;
+  header._num_domains = 1;
+  header._num_FSRs = _num_FSRs;
+  header._k_eff = _k_eff;
+  header._num_sections = NUM_SOLVER_FILE_SECTIONS;
+
+  file._write = true;
+  file._fd = -1;
+  file._collective = false;
+  file._offset = (sizeof(SolverFileHeader) + SOLVER_FILE_ALIGNMENT - 1) /
+                 SOLVER_FILE_ALIGNMENT * SOLVER_FILE_ALIGNMENT;
+
+  /* Only domain decomposed files may be shared */
+#ifndef MPIx
+  (void) local;
+#endif
+#ifdef MPIx
+  file._collective = _geometry->isDomainDecomposed() && !local;
+  if (file._collective) {
+    MPI_Comm comm = _geometry->getMPICart();
+    int num_domains;
+    MPI_Comm_size(comm, &num_domains);
+    header._num_domains = num_domains;
+    header._num_FSRs = _geometry->getNumTotalFSRs();
+
+    /* Delete any previous file, which may be longer than the new one */
+    if (_geometry->isRootDomain())
+      MPI_File_delete(filename.c_str(), MPI_INFO_NULL);
+    MPI_Barrier(comm);
+    if (MPI_File_open(comm, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                      MPI_INFO_NULL, &file._mpi_file) != MPI_SUCCESS)
+      log_printf(ERROR, "Unable to create Solver file %s", filename.c_str());
+    return;
+  }
+#endif
+
+  file._fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file._fd < 0)
+    log_printf(ERROR, "Unable to create Solver file %s", filename.c_str());
+}
+
+
+/**
+ * @brief Opens a Solver file for reading and checks its header.
+ * @details With domain decomposition, all domains open the file together
+ *          unless it is local.
+ * @param file the Solver file to open
+ * @param filename the name of the file
+ * @param local whether the file holds the FSRs of this domain only
+ * @return whether the file could be opened and is a Solver file
+ */
+bool Solver::openSolverFile(SolverFile& file, std::string filename,
+                            bool local) {
+
+  SolverFileHeader& header = file._header;
+  memset(&header, 0, sizeof(SolverFileHeader));
+  long header_size = 0;
+  file._write = false;
+  file._fd = -1;
+  file._collective = false;
+  file._offset = 0;
+
+  /* Only domain decomposed files may be shared */
+#ifndef MPIx
+  (void) local;
+#endif
+#ifdef MPIx
+  file._collective = _geometry->isDomainDecomposed() && !local;
+  if (file._collective) {
+    if (MPI_File_open(_geometry->getMPICart(), filename.c_str(),
+                      MPI_MODE_RDONLY, MPI_INFO_NULL, &file._mpi_file)
+        != MPI_SUCCESS)
+      return false;
+    MPI_Status status;
+    int count = 0;
+    MPI_File_read_at_all(file._mpi_file, 0, &header, sizeof(SolverFileHeader),
+                         MPI_BYTE, &status);
+    MPI_Get_count(&status, MPI_BYTE, &count);
+    header_size = count;
+  }
+  else
+#endif
+  {
+    file._fd = open(filename.c_str(), O_RDONLY);
+    if (file._fd < 0)
+      return false;
+    header_size = pread(file._fd, &header, sizeof(SolverFileHeader), 0);
+  }
+
+  /* Check the header, files of previous versions may have a shorter one */
+  if (header_size < (long) sizeof(header._magic) ||
+      memcmp(header._magic, "OMOCSOLV", sizeof(header._magic)) != 0) {
+    closeSolverFile(file);
+    return false;
+  }
+  if (header._endianness != SOLVER_FILE_ENDIANNESS)
+    log_printf(ERROR, "Solver file %s was written on a machine of different "
+               "endianness", filename.c_str());
+  if (!convertSolverFileHeader(header, header_size))
+    log_printf(ERROR, "Solver file %s has an incomplete header or an "
+               "unsupported version %d", filename.c_str(), header._version);
+  if (header._precision_size != sizeof(float) &&
+      header._precision_size != sizeof(double))
+    log_printf(ERROR, "Solver file %s has values of unsupported size %d",
+               filename.c_str(), header._precision_size);
+
+  return true;
+}
+
+
+/**
+ * @brief Closes a Solver file, writing its header if it was open for writing.
+ * @param file the Solver file to close
+ */
+void Solver::closeSolverFile(SolverFile& file) {
+
+  SolverFileHeader& header = file._header;
+  header._file_size = file._offset;
+
+#ifdef MPIx
+  if (file._collective) {
+    if (file._write) {
+      if (_geometry->isRootDomain())
+        MPI_File_write_at(file._mpi_file, 0, &header,
+                          sizeof(SolverFileHeader), MPI_BYTE,
+                          MPI_STATUS_IGNORE);
+      MPI_File_set_size(file._mpi_file, file._offset);
+    }
+    MPI_File_close(&file._mpi_file);
+    return;
+  }
+#endif
+
+  if (file._write) {
+    if (ftruncate(file._fd, file._offset) != 0 ||
+        pwrite(file._fd, &header, sizeof(SolverFileHeader), 0) !=
+        sizeof(SolverFileHeader))
+      log_printf(ERROR, "Unable to write the header of a Solver file");
+  }
+  close(file._fd);
+  file._fd = -1;
+}
+
+
+/**
+ * @brief Writes a section to a Solver file.
+ * @details A distributed section of a file shared by all domains holds the
+ *          items of all domains, in the order of the domain ranks. Other
+ *          sections are written by the root domain alone. All domains must
+ *          write the same sections of shared files in the same order.
+ * @param file the Solver file to write to
+ * @param section the section to write
+ * @param data the items of this domain
+ * @param item_size the size of each item (bytes)
+ * @param num_items the number of items of this domain
+ * @param distributed whether each domain writes its own items
+ */
+void Solver::writeSolverFileSection(SolverFile& file, solverFileSection section,
+                                    const void* data, size_t item_size,
+                                    long num_items, bool distributed) {
+
+  /* Locate the items of this domain */
+  long num_total_items = num_items;
+  long first_item = 0;
+  if (file._collective) {
+    if (distributed)
+      first_item = getFirstDomainItem(num_items, num_total_items);
+    else if (!_geometry->isRootDomain())
+      num_items = 0;
+  }
+
+  /* Add the section to the header */
+  SolverFileSection& location = file._header._sections[section];
+  location._offset = file._offset;
+  location._size = num_total_items * item_size;
+  location._count = num_total_items;
+  file._offset += (location._size + SOLVER_FILE_ALIGNMENT - 1) /
+                  SOLVER_FILE_ALIGNMENT * SOLVER_FILE_ALIGNMENT;
+
+  uint64_t offset = location._offset + first_item * item_size;
+  uint64_t size = num_items * item_size;
+
+#ifdef MPIx
+  if (file._collective) {
+    MPI_Datatype item_type;
+    MPI_Type_contiguous(item_size, MPI_BYTE, &item_type);
+    MPI_Type_commit(&item_type);
+    int result = MPI_File_write_at_all(file._mpi_file, offset, (void*) data,
+                                       num_items, item_type,
+                                       MPI_STATUS_IGNORE);
+    MPI_Type_free(&item_type);
+    if (result != MPI_SUCCESS)
+      log_printf(ERROR, "Unable to write section %d of a Solver file",
+                 section);
+    return;
+  }
+#endif
+
+  /* Write the section in chunks from several threads */
+  const char* buffer = (const char*) data;
+  long num_chunks = (size + SOLVER_FILE_CHUNK - 1) / SOLVER_FILE_CHUNK;
+  bool failed = false;
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c < num_chunks; c++) {
+    uint64_t start = c * SOLVER_FILE_CHUNK;
+    size_t length = std::min(size - start, (uint64_t) SOLVER_FILE_CHUNK);
+    if (pwrite(file._fd, buffer + start, length, offset + start) !=
+        (ssize_t) length)
+      failed = true;
+  }
+  if (failed)
+    log_printf(ERROR, "Unable to write section %d of a Solver file", section);
+}
+
+
+/**
+ * @brief Reads items from a section of a Solver file.
+ * @details Unless the read is independent, all domains must read the same
+ *          sections in the same order.
+ * @param file the Solver file to read from
+ * @param section the section to read
+ * @param data the array of items to fill
+ * @param item_size the size of each item (bytes)
+ * @param first_item the index of the first item to read
+ * @param num_items the number of items to read
+ * @param independent whether domains read without the others
+ */
+void Solver::readSolverFileSection(SolverFile& file, solverFileSection section,
+                                   void* data, size_t item_size,
+                                   long first_item, long num_items,
+                                   bool independent) {
+
+  /* Check that the items are in the section */
+  SolverFileSection& location = file._header._sections[section];
+  if (location._size != location._count * item_size ||
+      first_item + num_items > (long) location._count)
+    log_printf(ERROR, "Section %d of a Solver file does not hold items %ld "
+               "to %ld of %ld bytes", section, first_item,
+               first_item + num_items, item_size);
+
+  uint64_t offset = location._offset + first_item * item_size;
+  uint64_t size = num_items * item_size;
+
+#ifdef MPIx
+  if (file._collective) {
+    MPI_Datatype item_type;
+    MPI_Type_contiguous(item_size, MPI_BYTE, &item_type);
+    MPI_Type_commit(&item_type);
+    int result;
+    if (independent)
+      result = MPI_File_read_at(file._mpi_file, offset, data, num_items,
+                                item_type, MPI_STATUS_IGNORE);
+    else
+      result = MPI_File_read_at_all(file._mpi_file, offset, data, num_items,
+                                    item_type, MPI_STATUS_IGNORE);
+    MPI_Type_free(&item_type);
+    if (result != MPI_SUCCESS)
+      log_printf(ERROR, "Unable to read section %d of a Solver file", section);
+    return;
+  }
+#endif
+
+  /* Read the section in chunks from several threads */
+  char* buffer = (char*) data;
+  long num_chunks = (size + SOLVER_FILE_CHUNK - 1) / SOLVER_FILE_CHUNK;
+  bool failed = false;
+#pragma omp parallel for schedule(dynamic)
+  for (long c=0; c < num_chunks; c++) {
+    uint64_t start = c * SOLVER_FILE_CHUNK;
+    size_t length = std::min(size - start, (uint64_t) SOLVER_FILE_CHUNK);
+    if (pread(file._fd, buffer + start, length, offset + start) !=
+        (ssize_t) length)
+      failed = true;
+  }
+  if (failed)
+    log_printf(ERROR, "Unable to read section %d of a Solver file", section);
+}
+
+
+/**
+ * @brief Reads the values of each energy group of the FSRs from a section of
+ *        a Solver file.
+ * @details The values are converted to FP_PRECISION if they were written with
+ *          a different precision. If the FSRs of the file are contiguous, all
+ *          domains read their slice of the file together. Otherwise each
+ *          domain reads the chunks of the file holding its FSRs.
+ * @param file the Solver file to read from
+ * @param section the section to read
+ * @param values the array of values of each FSR and energy group to fill
+ * @param file_FSRs the FSR of the file matching each FSR
+ * @param contiguous whether the FSRs of the file follow each other
+ */
+void Solver::readSolverFileFSRValues(SolverFile& file,
+                                     solverFileSection section,
+                                     FP_PRECISION* values, long* file_FSRs,
+                                     bool contiguous) {
+
+  size_t value_size = file._header._precision_size;
+  size_t item_size = _num_groups * value_size;
+
+  /* Read the values of a contiguous range of FSRs of the file */
+  if (contiguous) {
+    if (value_size == sizeof(FP_PRECISION)) {
+      readSolverFileSection(file, section, values, item_size, file_FSRs[0],
+                            _num_FSRs);
+      return;
+    }
+    std::vector<char> buffer(_num_FSRs * item_size);
+    readSolverFileSection(file, section, &buffer[0], item_size, file_FSRs[0],
+                          _num_FSRs);
+#pragma omp parallel for
+    for (long i=0; i < _num_FSRs * _num_groups; i++) {
+      if (value_size == sizeof(double))
+        values[i] = ((double*) &buffer[0])[i];
+      else
+        values[i] = ((float*) &buffer[0])[i];
+    }
+    return;
+  }
+
+  /* Sort the FSRs by their index in the file, to read the file in order */
+  std::vector<std::pair<long, long> > order(_num_FSRs);
+#pragma omp parallel for
+  for (long r=0; r < _num_FSRs; r++)
+    order[r] = std::make_pair(file_FSRs[r], r);
+  std::sort(order.begin(), order.end());
+
+  /* Read the chunks of the file holding FSRs of this domain */
+  long chunk_size = std::max(1L, (long) (SOLVER_FILE_CHUNK / item_size));
+  std::vector<char> buffer(std::min(chunk_size, (long) file._header._num_FSRs)
+                           * item_size);
+  size_t i = 0;
+  while (i < order.size()) {
+    long start = order[i].first;
+    long num_items = std::min(chunk_size, file._header._num_FSRs - start);
+    size_t end = i;
+    while (end < order.size() && order[end].first < start + num_items)
+      end++;
+    num_items = order[end-1].first - start + 1;
+    readSolverFileSection(file, section, &buffer[0], item_size, start,
+                          num_items, true);
+
+#pragma omp parallel for
+    for (size_t j=i; j < end; j++) {
+      char* item = &buffer[(order[j].first - start) * item_size];
+      FP_PRECISION* fsr_values = &values[order[j].second * _num_groups];
+      for (int e=0; e < _num_groups; e++) {
+        if (value_size == sizeof(double))
+          fsr_values[e] = ((double*) item)[e];
+        else
+          fsr_values[e] = ((float*) item)[e];
+      }
+    }
+    i = end;
+  }
+}
+
+
+/**
+ * @brief Lists the arrays of the Solver state saved in checkpoints.
+ * @details Solvers with additional iteration state add their own arrays.
+ * @param arrays the list of arrays to append to
+ */
+void Solver::getCheckpointArrays(std::vector<SolverCheckpointArray>& arrays) {
+
+  size_t fluxes_size = _num_groups * sizeof(FP_PRECISION);
+  size_t track_fluxes_size = 2 * _fluxes_per_track * sizeof(float);
+  SolverCheckpointArray solver_arrays[5] = {
+    {SOLVER_SECTION_SCALAR_FLUXES, _scalar_flux, fluxes_size, _num_FSRs},
+    {SOLVER_SECTION_OLD_SCALAR_FLUXES, _old_scalar_flux, fluxes_size,
+     _num_FSRs},
+    {SOLVER_SECTION_STABILIZING_FLUXES, _stabilizing_flux, fluxes_size,
+     _num_FSRs},
+    {SOLVER_SECTION_BOUNDARY_FLUXES, _boundary_flux, track_fluxes_size,
+     _tot_num_tracks},
+    {SOLVER_SECTION_START_FLUXES, _start_flux, track_fluxes_size,
+     _tot_num_tracks}};
+  for (int i=0; i < 5; i++)
+    if (solver_arrays[i]._data != NULL)
+      arrays.push_back(solver_arrays[i]);
+
+  /* Add the CMFD fluxes and corrected diffusion coefficients */
+  if (_cmfd != NULL) {
+    Vector* old_flux = _cmfd->getOldFlux();
+    Vector* old_dif_surf_corr = _cmfd->getOldDifSurfCorr();
+    SolverCheckpointArray cmfd_arrays[2] = {
+      {SOLVER_SECTION_CMFD_OLD_FLUX, old_flux->getArray(),
+       sizeof(CMFD_PRECISION), old_flux->getNumRows()},
+      {SOLVER_SECTION_CMFD_DIF_SURF_CORR, old_dif_surf_corr->getArray(),
+       sizeof(CMFD_PRECISION), old_dif_surf_corr->getNumRows()}};
+    arrays.insert(arrays.end(), cmfd_arrays, cmfd_arrays + 2);
+  }
+}
+
+
+/**
+ * @brief Returns the name of the checkpoint file of this domain.
+ * @param fname the name of the checkpoint file
+ * @return the name of the file, with the domain indexes appended with domain
+ *         decomposition
+ */
+std::string Solver::getCheckpointFilename(std::string fname) {
+
+  std::string filename = fname;
+  if (_geometry->isDomainDecomposed()) {
+    int indexes[3];
+    _geometry->getDomainIndexes(indexes);
+    for (int i=0; i < 3; i++)
+      filename += "_" + std::to_string((long long int) indexes[i]);
+  }
+  return filename;
+}
+
+
+/**
+ * @brief Copies the state of the source iteration and writes it to a
+ *        checkpoint from a background thread.
+ * @details The previous checkpoint is finished first, so at most one
+ *          checkpoint is written at a time and its copies of the Solver
+ *          state are reused.
+ * @param residual the residual of the last source iteration
+ */
+void Solver::writeCheckpoint(double residual) {
+
+  waitForCheckpoint();
+
+  /* Copy the state of the iteration */
+  std::vector<SolverCheckpointArray> arrays;
+  getCheckpointArrays(arrays);
+  _checkpoint_buffers.resize(arrays.size());
+  for (size_t i=0; i < arrays.size(); i++) {
+    long size = arrays[i]._item_size * arrays[i]._num_items;
+    _checkpoint_buffers[i].resize(size);
+    char* buffer = _checkpoint_buffers[i].data();
+    char* data = (char*) arrays[i]._data;
+    long num_chunks = (size + SOLVER_FILE_CHUNK - 1) / SOLVER_FILE_CHUNK;
+#pragma omp parallel for
+    for (long c=0; c < num_chunks; c++) {
+      long start = c * SOLVER_FILE_CHUNK;
+      memcpy(buffer + start, data + start,
+             std::min(size - start, SOLVER_FILE_CHUNK));
+    }
+    arrays[i]._data = buffer;
+  }
+
+  SolverIterationState state;
+  state._num_iterations = _num_iterations;
+  state._k_eff = _k_eff;
+  state._residual = residual;
+  state._cmfd_k_eff = 1.;
+  state._cmfd_dif_surf_valid = false;
+  if (_cmfd != NULL) {
+    state._cmfd_k_eff = _cmfd->getKeff();
+    state._cmfd_dif_surf_valid = _cmfd->isOldDifSurfValid();
+  }
+
+  _checkpoint_thread = new std::thread(&Solver::writeCheckpointFile, this,
+                                       getCheckpointFilename(_checkpoint_file),
+                                       arrays, state);
+}
+
+
+/**
+ * @brief Writes a checkpoint file, from a background thread.
+ * @details The checkpoint is written to a temporary file which then replaces
+ *          the previous checkpoint, so that a complete checkpoint is always
+ *          available. An exception cannot leave the thread, so it is kept
+ *          and thrown again by waitForCheckpoint().
+ * @param filename the name of the checkpoint file
+ * @param arrays the copies of the arrays of the Solver state
+ * @param state the state of the source iteration
+ */
+void Solver::writeCheckpointFile(std::string filename,
+                                 std::vector<SolverCheckpointArray> arrays,
+                                 SolverIterationState state) {
+
+  /* Leave the cores to the source iteration */
+  omp_set_num_threads(1);
+
+  std::string temporary_filename = filename + ".tmp";
+  SolverFile file;
+  file._fd = -1;
+  try {
+    createSolverFile(file, temporary_filename, true);
+    file._header._k_eff = state._k_eff;
+    writeSolverFileSection(file, SOLVER_SECTION_ITERATION_STATE, &state,
+                           sizeof(SolverIterationState), 1);
+    writeSolverFileSection(file, SOLVER_SECTION_FSR_KEYS,
+                           &_geometry->getFSRsToKeys()[0], sizeof(FSRKey),
+                           _num_FSRs);
+    for (size_t i=0; i < arrays.size(); i++)
+      writeSolverFileSection(file, arrays[i]._section, arrays[i]._data,
+                             arrays[i]._item_size, arrays[i]._num_items);
+    closeSolverFile(file);
+
+    if (rename(temporary_filename.c_str(), filename.c_str()) != 0)
+      log_printf(ERROR, "Unable to write checkpoint %s", filename.c_str());
+    log_printf(INFO, "Wrote checkpoint %s at iteration %ld", filename.c_str(),
+               (long) state._num_iterations);
+  }
+  catch (...) {
+
+    /* Discard the incomplete checkpoint, keeping the previous one */
+    if (file._fd >= 0) {
+      close(file._fd);
+      remove(temporary_filename.c_str());
+    }
+    _checkpoint_error = std::current_exception();
+  }
+}
+
+
+/**
+ * @brief Waits for the checkpoint written in the background, if any.
+ * @details An exception thrown while writing the checkpoint is thrown again.
+ */
+void Solver::waitForCheckpoint() {
+  if (_checkpoint_thread != NULL) {
+    _checkpoint_thread->join();
+    delete _checkpoint_thread;
+    _checkpoint_thread = NULL;
+  }
+
+  if (_checkpoint_error) {
+    std::exception_ptr error = _checkpoint_error;
+    _checkpoint_error = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+
+/**
+ * @brief Restores the state of the source iteration from a checkpoint.
+ * @details Later eigenvalue calculations start afresh unless
+ *          restartFromCheckpoint() is called again.
+ * @param residual the residual of the last source iteration to set
+ * @return the number of source iterations performed before the checkpoint
+ */
+int Solver::loadCheckpoint(double& residual) {
+
+  std::string filename = getCheckpointFilename(_restart_file);
+  SolverFile file;
+  if (!openSolverFile(file, filename, true))
+    log_printf(ERROR, "Unable to read checkpoint %s", filename.c_str());
+
+  /* Check that the checkpoint was written by the same calculation */
+  SolverFileHeader& header = file._header;
+  if (header._num_groups != (uint32_t) _num_groups ||
+      header._num_FSRs != _num_FSRs ||
+      header._precision_size != sizeof(FP_PRECISION))
+    log_printf(ERROR, "The checkpoint %s was written with different energy "
+               "groups, FSRs or floating point precision", filename.c_str());
+  std::vector<FSRKey> keys(_num_FSRs);
+  readSolverFileSection(file, SOLVER_SECTION_FSR_KEYS, &keys[0],
+                        sizeof(FSRKey), 0, _num_FSRs);
+  std::vector<FSRKey>& FSRs_to_keys = _geometry->getFSRsToKeys();
+  if (!std::equal(keys.begin(), keys.end(), FSRs_to_keys.begin()))
+    log_printf(ERROR, "The checkpoint %s was written for different FSRs",
+               filename.c_str());
+
+  /* Read the state of the iteration */
+  SolverIterationState state;
+  readSolverFileSection(file, SOLVER_SECTION_ITERATION_STATE, &state,
+                        sizeof(SolverIterationState), 0, 1);
+  std::vector<SolverCheckpointArray> arrays;
+  getCheckpointArrays(arrays);
+  for (size_t i=0; i < arrays.size(); i++)
+    readSolverFileSection(file, arrays[i]._section, arrays[i]._data,
+                          arrays[i]._item_size, 0, arrays[i]._num_items);
+  closeSolverFile(file);
+
+  /* Check that all domains restart from the same iteration */
+#ifdef MPIx
+  if (_geometry->isDomainDecomposed()) {
+    long iterations[2] = {-state._num_iterations, state._num_iterations};
+    MPI_Allreduce(MPI_IN_PLACE, iterations, 2, MPI_LONG, MPI_MAX,
+                  _geometry->getMPICart());
+    if (-iterations[0] != iterations[1])
+      log_printf(ERROR, "The checkpoints of the domains were written at "
+                 "iterations %ld to %ld", -iterations[0], iterations[1]);
+  }
+#endif
+
+  _k_eff = state._k_eff;
+  residual = state._residual;
+  if (_cmfd != NULL) {
+    _cmfd->setKeff(state._cmfd_k_eff);
+    _cmfd->setOldDifSurfValid(state._cmfd_dif_surf_valid);
+    _cmfd->setSourceConvergenceThreshold(0.01 * residual);
+  }
+
+  log_printf(NORMAL, "Restarting from iteration %ld of checkpoint %s with "
+             "k_eff = %1.6f", (long) state._num_iterations, _restart_file.c_str(),
+             _k_eff);
+
+  /* Only the next eigenvalue calculation restarts from the checkpoint */
+  _restart_from_checkpoint = false;
+  return state._num_iterations;
 }
 
 
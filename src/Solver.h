@@ -22,6 +22,8 @@
 #include "ExpEvaluator.h"
 #include "segmentation_type.h"
 #include <math.h>
+#include <thread>
+#include <exception>
 #endif
 
 /** Indexing macro for the scalar flux in each FSR and energy group */
@@ -113,6 +115,275 @@ enum stabilizationType {
 };
 
 
+/** Version of the Solver file format, incremented with every change to it */
+#define SOLVER_FILE_VERSION 4
+
+/** Capacity of the section table of Solver files */
+#define SOLVER_FILE_MAX_SECTIONS 64
+
+/** Written natively to detect Solver files of a different endianness */
+#define SOLVER_FILE_ENDIANNESS 0x01020304
+
+/** Alignment (bytes) of the sections of a Solver file */
+#define SOLVER_FILE_ALIGNMENT 64
+
+/** Size (bytes) of the chunks of a Solver file accessed by each thread */
+#define SOLVER_FILE_CHUNK (1L << 22)
+
+
+/**
+ * @enum solverFileSection
+ * @brief The sections of a Solver file.
+ * @details Sections indexed by FSR hold the FSRs of all domains, in the
+ *          order of the domain ranks and then of the FSR IDs in each domain.
+ *          The value of each section is its index in the section table of
+ *          the files, so new sections must be appended before
+ *          NUM_SOLVER_FILE_SECTIONS and existing ones never reordered.
+ */
+enum solverFileSection {
+
+  /** The number of FSRs of each domain which wrote the file */
+  SOLVER_SECTION_DOMAIN_FSRS,
+
+  /** The key of each FSR */
+  SOLVER_SECTION_FSR_KEYS,
+
+  /** The centroid of each FSR */
+  SOLVER_SECTION_FSR_CENTROIDS,
+
+  /** The scalar flux of each FSR and energy group */
+  SOLVER_SECTION_SCALAR_FLUXES,
+
+  /** The total source per steradian of each FSR and energy group */
+  SOLVER_SECTION_SOURCES,
+
+  /** The number of cells (3 int64) and the bounds (6 double) of a mesh */
+  SOLVER_SECTION_MESH,
+
+  /** The fission rate in each cell of the mesh */
+  SOLVER_SECTION_FISSION_RATES,
+
+  /** The state of the source iteration at a checkpoint */
+  SOLVER_SECTION_ITERATION_STATE,
+
+  /** The old scalar flux of each FSR and energy group */
+  SOLVER_SECTION_OLD_SCALAR_FLUXES,
+
+  /** The stabilizing flux of each FSR and energy group */
+  SOLVER_SECTION_STABILIZING_FLUXES,
+
+  /** The boundary angular fluxes of each Track */
+  SOLVER_SECTION_BOUNDARY_FLUXES,
+
+  /** The starting angular fluxes of each Track */
+  SOLVER_SECTION_START_FLUXES,
+
+  /** The scalar flux moments of each FSR, for linear sources */
+  SOLVER_SECTION_FLUX_MOMENTS,
+
+  /** The stabilizing flux moments of each FSR, for linear sources */
+  SOLVER_SECTION_STABILIZING_FLUX_MOMENTS,
+
+  /** The CMFD flux at the beginning of the last CMFD solve */
+  SOLVER_SECTION_CMFD_OLD_FLUX,
+
+  /** The corrected CMFD surface diffusion coefficients */
+  SOLVER_SECTION_CMFD_DIF_SURF_CORR,
+
+  /** The volume of each FSR */
+  SOLVER_SECTION_FSR_VOLUMES,
+
+  /** The ID of the Material filling each FSR */
+  SOLVER_SECTION_FSR_MATERIALS,
+
+  /** The eigenvalue of each state of several states solved together */
+  SOLVER_SECTION_STATE_K_EFF,
+
+  /** The eigenvalue of each state at the previous iteration */
+  SOLVER_SECTION_PREVIOUS_STATE_K_EFF,
+
+  /** The number of sections */
+  NUM_SOLVER_FILE_SECTIONS
+};
+
+
+/**
+ * @struct SolverFileSection
+ * @brief The location of a section in a Solver file.
+ */
+struct SolverFileSection {
+
+  /** The offset of the section from the start of the file (bytes) */
+  uint64_t _offset;
+
+  /** The size of the section (bytes) */
+  uint64_t _size;
+
+  /** The number of items in the section */
+  uint64_t _count;
+};
+
+
+/**
+ * @struct SolverFileHeader
+ * @brief The header at the start of a Solver file.
+ * @details Solver files describe their own contents so that they can be
+ *          read by runs with a different number of domains or threads. The
+ *          section table has a fixed capacity, so that files of other
+ *          versions can be read as long as they hold the sections needed.
+ */
+struct SolverFileHeader {
+
+  /** Identifies Solver files */
+  char _magic[8];
+
+  /** The version of the file format */
+  uint32_t _version;
+
+  /** SOLVER_FILE_ENDIANNESS as written by the machine writing the file */
+  uint32_t _endianness;
+
+  /** The size of the floating point fluxes and sources (bytes) */
+  uint32_t _precision_size;
+
+  /** The number of energy groups */
+  uint32_t _num_groups;
+
+  /** The number of domains which wrote the file */
+  uint32_t _num_domains;
+
+  /** The total number of FSRs in all domains */
+  int64_t _num_FSRs;
+
+  /** The eigenvalue */
+  double _k_eff;
+
+  /** The size of the file (bytes) */
+  uint64_t _file_size;
+
+  /** The number of sections known to the version which wrote the file */
+  uint64_t _num_sections;
+
+  /** The location of each section, empty if it was not written */
+  SolverFileSection _sections[SOLVER_FILE_MAX_SECTIONS];
+};
+
+
+/**
+ * @struct SolverFile
+ * @brief A Solver file open for writing or reading by all domains.
+ * @details With domain decomposition, the file is accessed collectively
+ *          through MPI-IO. Otherwise it is accessed by several threads at
+ *          once. Local files are accessed by a single domain.
+ */
+struct SolverFile {
+
+  /** The file descriptor, if not accessed through MPI-IO */
+  int _fd;
+
+#ifdef MPIx
+  /** The MPI file, if accessed through MPI-IO */
+  MPI_File _mpi_file;
+#endif
+
+  /** Whether the file is accessed by all domains through MPI-IO */
+  bool _collective;
+
+  /** Whether the file is open for writing */
+  bool _write;
+
+  /** The header of the file */
+  SolverFileHeader _header;
+
+  /** The offset of the next section to write (bytes) */
+  uint64_t _offset;
+};
+
+
+/**
+ * @struct SolverIterationState
+ * @brief The state of the source iteration saved in a checkpoint.
+ */
+struct SolverIterationState {
+
+  /** The number of source iterations performed */
+  int64_t _num_iterations;
+
+  /** The eigenvalue */
+  double _k_eff;
+
+  /** The residual of the last source iteration */
+  double _residual;
+
+  /** The eigenvalue of the CMFD solver */
+  double _cmfd_k_eff;
+
+  /** Whether the corrected CMFD surface diffusion coefficients were set */
+  int64_t _cmfd_dif_surf_valid;
+};
+
+
+/**
+ * @struct SolverCheckpointArray
+ * @brief An array of the Solver state saved in checkpoints.
+ */
+struct SolverCheckpointArray {
+
+  /** The section of the checkpoint holding the array */
+  solverFileSection _section;
+
+  /** The array */
+  void* _data;
+
+  /** The size of each item of the array (bytes) */
+  size_t _item_size;
+
+  /** The number of items of the array */
+  long _num_items;
+};
+
+
+/**
+ * @struct SolverInitialization
+ * @brief The inputs for which the Solver arrays were last initialized.
+ * @details An eigenvalue calculation following another one with the same
+ *          Tracks and Materials, whose cross sections only may have changed,
+ *          keeps the arrays and only updates what depends on cross sections.
+ */
+struct SolverInitialization {
+
+  /** The TrackGenerator, or NULL if the arrays must be initialized */
+  TrackGenerator* _track_generator;
+
+  /** The version of the Tracks of the TrackGenerator */
+  int _tracks_version;
+
+  /** The number of energy groups */
+  int _num_groups;
+
+  /** The number of OpenMP threads */
+  int _num_threads;
+
+  /** Whether transport stabilization was on */
+  bool _stabilize_transport;
+
+  /** The Cmfd of the Geometry */
+  Cmfd* _cmfd;
+
+  /** The Materials filling the Cells of the Geometry, by Cell ID */
+  std::map<int, Material*> _cell_fills;
+
+  /** The Materials of the Geometry by ID */
+  std::map<int, Material*> _materials;
+
+  /** The maximum total cross section of each Material by ID */
+  std::map<int, double> _max_sigma_t;
+
+  /** Whether the exponential evaluators are still valid */
+  bool _exp_evaluators_valid;
+};
+
+
 /**
  * @class Solver Solver.h "src/Solver.h"
  * @brief This is an abstract base class which different Solver subclasses
@@ -204,6 +475,9 @@ protected:
   
   /** Boolean for whether to load initial FSR flux profile from file */
   bool _load_initial_FSR_fluxes;
+
+  /** Whether to transfer the initial FSR fluxes from different FSRs */
+  bool _transfer_initial_FSR_fluxes;
   
   /** Boolean for whether to calculate residuals from reference flux */
   bool _calculate_residuals_by_reference;
@@ -214,6 +488,33 @@ protected:
   /** File to load reference FSR fluxes from */
   std::string _reference_file;
 
+  /** File to write checkpoints of the source iteration to */
+  std::string _checkpoint_file;
+
+  /** The number of source iterations between checkpoints, 0 if none */
+  int _checkpoint_interval;
+
+  /** Boolean for whether to restart the source iteration from a checkpoint */
+  bool _restart_from_checkpoint;
+
+  /** File to restart the source iteration from */
+  std::string _restart_file;
+
+  /** The thread writing a checkpoint in the background, if any */
+  std::thread* _checkpoint_thread;
+
+  /** The exception thrown by the thread writing a checkpoint, if any */
+  std::exception_ptr _checkpoint_error;
+
+  /** Copies of the Solver state being written to a checkpoint */
+  std::vector< std::vector<char> > _checkpoint_buffers;
+
+  /** The inputs for which the arrays were last initialized */
+  SolverInitialization _initialization;
+
+  /** Whether to start from the fluxes of the previous calculation */
+  bool _warm_start;
+
   /** The log level for outputting cross-section inconsitencies */
   logLevel _xs_log_level;
 
@@ -397,6 +698,44 @@ protected:
   /** To stop and reset all timer splits */
   void clearTimerSplits();
 
+  /* Input/output of Solver files */
+  void computeMeshFissionRates(double* fission_rates, int nx, int ny, int nz);
+  long getFirstDomainItem(long num_items, long& num_total_items);
+  void createSolverFile(SolverFile& file, std::string filename,
+                        bool local=false);
+  bool openSolverFile(SolverFile& file, std::string filename,
+                      bool local=false);
+  void closeSolverFile(SolverFile& file);
+  void writeSolverFileSection(SolverFile& file, solverFileSection section,
+                              const void* data, size_t item_size,
+                              long num_items, bool distributed=true);
+  void readSolverFileSection(SolverFile& file, solverFileSection section,
+                             void* data, size_t item_size, long first_item,
+                             long num_items, bool independent=false);
+  void readSolverFileFSRValues(SolverFile& file, solverFileSection section,
+                               FP_PRECISION* values, long* file_FSRs,
+                               bool contiguous);
+  double matchFSRCentroids(double* centroids, long num_file_FSRs,
+                           long* file_FSRs, double tolerance,
+                           int* materials=NULL);
+  void loadLegacyFSRFluxes(std::string fname, bool assign_k_eff,
+                           double tolerance);
+
+  /* Checkpointing of the source iteration */
+  virtual void getCheckpointArrays(std::vector<SolverCheckpointArray>& arrays);
+  std::string getCheckpointFilename(std::string fname);
+  void writeCheckpoint(double residual);
+  void writeCheckpointFile(std::string filename,
+                           std::vector<SolverCheckpointArray> arrays,
+                           SolverIterationState state);
+  void waitForCheckpoint();
+  int loadCheckpoint(double& residual);
+
+  /* Reinitialization after changes to the cross sections only */
+  bool onlyCrossSectionsChanged();
+  virtual void updateCrossSections();
+  void recordInitialization();
+
   /* Whether to ray-trace and propagate fluxes at the same time */
   bool _OTF_transport;
 
@@ -410,6 +749,7 @@ public:
   TrackGenerator* getTrackGenerator();
   FP_PRECISION getFSRVolume(long fsr_id);
   int getNumPolarAngles();
+  int getNumEnergyGroups();
   int getNumIterations();
   double getTotalTime();
   double getKeff();
@@ -423,11 +763,20 @@ public:
   void printFissionRates(std::string fname, int nx, int ny, int nz);
   virtual void printInputParamsSummary();
 
+  void dumpFissionRates(std::string fname, int nx, int ny, int nz);
+  void loadFissionRates(std::string fname, double* fission_rates,
+                        int num_mesh_cells);
+
   void setKeffFromNeutronBalance();
   void setResidualByReference(std::string fname);
   void dumpFSRFluxes(std::string fname);
-  void loadInitialFSRFluxes(std::string fname);
+  void loadInitialFSRFluxes(std::string fname, bool transfer=false);
+  void setCheckpointing(std::string fname, int interval);
+  void restartFromCheckpoint(std::string fname);
+  void setWarmStart(bool warm_start);
   void loadFSRFluxes(std::string fname, bool assign_k_eff=false, double tolerance=0.01);
+  void transferFSRFluxes(std::string fname, bool assign_k_eff=false,
+                         double tolerance=0.5);
 
   double getFlux(long fsr_id, int group);
   virtual void getFluxes(FP_PRECISION* out_fluxes, int num_fluxes) = 0;
@@ -1,9 +1,11 @@
 #include "Surface.h"
+#include "Cell.h"
 
 int Surface::_n = 0;
 
 static int auto_id = DEFAULT_INIT_ID;
 
+
 /**
  * @brief Returns an auto-generated unique surface ID.
  * @details This method is intended as a utility mehtod for user's writing
@@ -43,6 +45,133 @@ void maximize_surface_id(int surface_id) {
 }
 
 
+/**
+ * @brief Computes the minimum positive distance from a Point along a
+ *        trajectory to a batch of Planes.
+ * @details The Planes are given by their coefficients stored as arrays of
+ *          structures, so that the distances to SURFACE_DISTANCE_BATCH Planes
+ *          are computed together in a vectorized loop before the minimum is
+ *          found. Planes parallel to the trajectory and intersections behind
+ *          the Point are ignored.
+ * @param num_planes the number of Planes
+ * @param a the A coefficients of the Planes
+ * @param b the B coefficients of the Planes
+ * @param c the C coefficients of the Planes
+ * @param d the D coefficients of the Planes
+ * @param origin the x, y and z coordinates of the Point
+ * @param direction the unit direction vector of the trajectory
+ * @param index the index of the nearest Plane, or -1 if none is intersected
+ * @return the distance to the nearest Plane, or INFINITY
+ */
+double minPlaneDistance(int num_planes, const double* a, const double* b,
+                        const double* c, const double* d, const double* origin,
+                        const double* direction, int& index) {
+
+  double x = origin[0];
+  double y = origin[1];
+  double z = origin[2];
+  double u_x = direction[0];
+  double u_y = direction[1];
+  double u_z = direction[2];
+
+  double distances[SURFACE_DISTANCE_BATCH];
+  double min_dist = INFINITY;
+  index = -1;
+
+  for (int start=0; start < num_planes; start += SURFACE_DISTANCE_BATCH) {
+    int size = std::min(SURFACE_DISTANCE_BATCH, num_planes - start);
+    const double* pa = a + start;
+    const double* pb = b + start;
+    const double* pc = c + start;
+    const double* pd = d + start;
+
+#pragma omp simd
+    for (int i=0; i < size; i++) {
+      double projection = pa[i] * u_x + pb[i] * u_y + pc[i] * u_z;
+      double dist = - (pa[i] * x + pb[i] * y + pc[i] * z + pd[i])
+                    / projection;
+      bool hit = fabs(projection) >= 1.e-10 && dist > 0.0;
+      distances[i] = hit ? dist : INFINITY;
+    }
+
+    for (int i=0; i < size; i++) {
+      if (distances[i] < min_dist) {
+        min_dist = distances[i];
+        index = start + i;
+      }
+    }
+  }
+
+  return min_dist;
+}
+
+
+/**
+ * @brief Computes the minimum positive distance from a Point along a
+ *        trajectory to a batch of ZCylinders.
+ * @details The intersections are computed in the x-y plane for batches of
+ *          SURFACE_DISTANCE_BATCH ZCylinders in a vectorized loop, and the
+ *          nearest one is projected back onto the trajectory. Trajectories
+ *          parallel to the z-axis never intersect a ZCylinder.
+ * @param num_zcylinders the number of ZCylinders
+ * @param x0 the x coordinates of the ZCylinders' centers
+ * @param y0 the y coordinates of the ZCylinders' centers
+ * @param r2 the squared radii of the ZCylinders
+ * @param origin the x, y and z coordinates of the Point
+ * @param direction the unit direction vector of the trajectory
+ * @param index the index of the nearest ZCylinder, or -1 if none is
+ *        intersected
+ * @return the distance to the nearest ZCylinder, or INFINITY
+ */
+double minZCylinderDistance(int num_zcylinders, const double* x0,
+                            const double* y0, const double* r2,
+                            const double* origin, const double* direction,
+                            int& index) {
+
+  index = -1;
+  double sin_polar = sqrt(direction[0] * direction[0] +
+                          direction[1] * direction[1]);
+  if (sin_polar < FLT_EPSILON)
+    return INFINITY;
+
+  double x = origin[0];
+  double y = origin[1];
+  double cos_azim = direction[0] / sin_polar;
+  double sin_azim = direction[1] / sin_polar;
+
+  double distances[SURFACE_DISTANCE_BATCH];
+  double min_dist_2D = INFINITY;
+
+  for (int start=0; start < num_zcylinders; start += SURFACE_DISTANCE_BATCH) {
+    int size = std::min(SURFACE_DISTANCE_BATCH, num_zcylinders - start);
+    const double* px = x0 + start;
+    const double* py = y0 + start;
+    const double* pr2 = r2 + start;
+
+#pragma omp simd
+    for (int i=0; i < size; i++) {
+      double dx = x - px[i];
+      double dy = y - py[i];
+      double b = dx * cos_azim + dy * sin_azim;
+      double c = dx * dx + dy * dy - pr2[i];
+      double discr = b * b - c;
+      double root = sqrt(std::max(discr, 0.0));
+      double dist = (-b - root > 0.0) ? -b - root : -b + root;
+      distances[i] = (discr >= 0.0 && dist > 0.0) ? dist : INFINITY;
+    }
+
+    for (int i=0; i < size; i++) {
+      if (distances[i] < min_dist_2D) {
+        min_dist_2D = distances[i];
+        index = start + i;
+      }
+    }
+  }
+
+  return min_dist_2D / sin_polar;
+}
+
+
 /**
  * @brief Constructor assigns unique ID and user-defined ID for a Surface.
  * @details Assigns a default boundary condition for this Surface to
@@ -89,6 +218,11 @@ Surface::~Surface() {
     delete _neighbors[+1];
     _neighbors.clear();
   }
+
+  /* Detach the Cells whose bounds were computed from this Surface */
+  std::set<Cell*>::iterator iter;
+  for (iter = _bounded_cells.begin(); iter != _bounded_cells.end(); ++iter)
+    (*iter)->removeBoundingSurface(this);
 }
 
 
@@ -206,6 +340,7 @@ void Surface::setName(const char* name) {
  */
 void Surface::setBoundaryType(boundaryType boundary_type) {
   _boundary_type = boundary_type;
+  invalidateBoundedCells();
 }
 
 
@@ -246,6 +381,36 @@ void Surface::addNeighborCell(int halfspace, Cell* cell) {
 }
 
 
+/**
+ * @brief Registers a Cell whose cached bounds were computed from this Surface.
+ * @details The bounds of the Cell are invalidated whenever the position or
+ *          the boundary type of the Surface changes.
+ * @param cell a pointer to the Cell
+ */
+void Surface::addBoundedCell(Cell* cell) {
+  _bounded_cells.insert(cell);
+}
+
+
+/**
+ * @brief Removes a Cell from the Cells bounded by this Surface.
+ * @param cell a pointer to the Cell
+ */
+void Surface::removeBoundedCell(Cell* cell) {
+  _bounded_cells.erase(cell);
+}
+
+
+/**
+ * @brief Invalidates the cached bounds of the Cells bounded by this Surface.
+ */
+void Surface::invalidateBoundedCells() {
+  std::set<Cell*>::iterator iter;
+  for (iter = _bounded_cells.begin(); iter != _bounded_cells.end(); ++iter)
+    (*iter)->invalidateBounds();
+}
+
+
 /**
  * @brief Return true or false if a Point is on or off of a Surface.
  * @param point pointer to the Point of interest
@@ -523,6 +688,7 @@ XPlane::XPlane(const double x, const int id, const char* name):
 void XPlane::setX(const double x) {
   _x = x;
   _D = -x;
+  invalidateBoundedCells();
 }
 
 
@@ -605,6 +771,7 @@ YPlane::YPlane(const double y, const int id, const char* name):
 void YPlane::setY(const double y) {
   _y = y;
   _D = -y;
+  invalidateBoundedCells();
 }
 
 
@@ -686,6 +853,7 @@ ZPlane::ZPlane(const double z, const int id, const char* name):
 void ZPlane::setZ(const double z) {
   _z = z;
   _D = -z;
+  invalidateBoundedCells();
 }
 
 
@@ -18,6 +18,7 @@
 #include "boundary_type.h"
 #include <limits>
 #include <map>
+#include <set>
 #include <vector>
 #include <algorithm>
 #endif
@@ -31,6 +32,15 @@ class Cell;
 int surface_id();
 void reset_surface_id();
 void maximize_surface_id(int surface_id);
+#ifndef SWIG
+double minPlaneDistance(int num_planes, const double* a, const double* b,
+                        const double* c, const double* d, const double* origin,
+                        const double* direction, int& index);
+double minZCylinderDistance(int num_zcylinders, const double* x0,
+                            const double* y0, const double* r2,
+                            const double* origin, const double* direction,
+                            int& index);
+#endif
 
 
 /**
@@ -93,6 +103,11 @@ protected:
   /* Vector of neighboring Cells */
   std::map<int, std::vector<Cell*>* > _neighbors;
 
+  /** The Cells whose cached bounds were computed from this Surface */
+  std::set<Cell*> _bounded_cells;
+
+  void invalidateBoundedCells();
+
 public:
   Surface(const int id=0, const char* name="");
   virtual ~Surface();
@@ -168,6 +183,8 @@ public:
   void setName(const char* name);
   void setBoundaryType(const boundaryType boundary_type);
   void addNeighborCell(int halfspace, Cell* cell);
+  void addBoundedCell(Cell* cell);
+  void removeBoundedCell(Cell* cell);
 
   /**
    * @brief Evaluate a Point using the Surface's potential equation.
@@ -22,6 +22,7 @@ Track::Track() {
 
   /* Initialize the cycle ids and periodic track index to -1 (not set) */
   _num_segments = 0;
+  _mapped_segments = NULL;
   _surface_in = -1;
   _surface_out = -1;
   _domain_fwd = -1;
@@ -203,6 +204,8 @@ int Track::getDomainBwd() {
  */
 void Track::addSegment(segment* segment) {
 
+  unmapSegments();
+
   try {
     _segments.push_back(*segment);
   }
@@ -218,6 +221,7 @@ void Track::addSegment(segment* segment) {
  * @param index The index of the segment to remove
  */
 void Track::removeSegment(int index) {
+  unmapSegments();
   try {
     _segments.erase(_segments.begin()+index);
   }
@@ -236,6 +240,7 @@ void Track::removeSegment(int index) {
  * @param segment A pointer to the segment to insert
  */
 void Track::insertSegment(int index, segment* segment) {
+  unmapSegments();
   try {
     _segments.insert(_segments.begin()+index, *segment);
   }
@@ -250,6 +255,40 @@ void Track::insertSegment(int index, segment* segment) {
  */
 void Track::clearSegments() {
   _segments.clear();
+  if (_mapped_segments != NULL) {
+    _mapped_segments = NULL;
+    _num_segments = 0;
+  }
+}
+
+
+/**
+ * @brief Makes the Track use segments stored elsewhere in place.
+ * @details This is used to reference the segments of a memory mapped Track
+ *          file without copying them. The segments must outlive their use
+ *          by the Track. They are copied into the Track if it is modified.
+ * @param segments the segments of the Track
+ * @param num_segments the number of segments
+ */
+void Track::mapSegments(segment* segments, int num_segments) {
+  _segments.clear();
+  _mapped_segments = segments;
+  _num_segments = num_segments;
+  if (num_segments == 0)
+    _mapped_segments = NULL;
+}
+
+
+/**
+ * @brief Copies segments referenced in place into the Track so that they
+ *        can be modified.
+ */
+void Track::unmapSegments() {
+  if (_mapped_segments == NULL)
+    return;
+  _segments.assign(_mapped_segments, _mapped_segments + _num_segments);
+  _mapped_segments = NULL;
+  _num_segments = 0;
 }
 
 
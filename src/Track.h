@@ -86,6 +86,12 @@ protected:
   /** Number of segments recorded during volume calculation */
   int _num_segments;
 
+  /** Segments referenced in place, such as from a memory mapped Track file,
+   *  NULL if the segments are stored in _segments */
+  segment* _mapped_segments;
+
+  void unmapSegments();
+
   /** An enum to indicate whether the outgoing angular flux along this
    *  Track's "forward" direction should be zeroed out for vacuum boundary
    *  conditions or sent to a periodic or reflective track. */
@@ -191,6 +197,7 @@ public:
   void removeSegment(int index);
   void insertSegment(int index, segment* segment);
   void clearSegments();
+  void mapSegments(segment* segments, int num_segments);
   void setNumSegments(int num_segments);
   virtual std::string toString();
 };
@@ -215,11 +222,11 @@ inline int Track::getUid() {
 inline segment* Track::getSegment(int segment) {
 
   /* If Track doesn't contain this segment, exits program */
-  if (segment >= (int)_segments.size())
+  if (segment >= getNumSegments())
     log_printf(ERROR, "Attempted to retrieve segment s = %d but Track only "
-               "has %d segments", segment, _segments.size());
+               "has %d segments", segment, getNumSegments());
 
-  return &_segments[segment];
+  return &getSegments()[segment];
 }
 
 
@@ -229,6 +236,8 @@ inline segment* Track::getSegment(int segment) {
  * @return vector of segment pointers
  */
 inline segment* Track::getSegments() {
+  if (_mapped_segments != NULL)
+    return _mapped_segments;
   return &_segments[0];
 }
 
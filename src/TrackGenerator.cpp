@@ -1,6 +1,10 @@
 #include "TrackGenerator.h"
 #include "TrackTraversingAlgorithms.h"
 #include <iomanip>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <utime.h>
 
 /**
  * @brief Constructor for the TrackGenerator assigns default values.
@@ -22,12 +26,17 @@ TrackGenerator::TrackGenerator(Geometry* geometry, int num_azim,
   _segment_formation = EXPLICIT_2D;
   _max_optical_length = std::numeric_limits<FP_PRECISION>::max();
   _max_num_segments = 0;
+  _tracks_version = 0;
   _FSR_volumes = NULL;
   _dump_segments = true;
+  _cache_OTF_startup = false;
   _segments_centered = false;
   _FSR_locks = NULL;
   _tracks_2D_array = NULL;
   _tracks_per_azim = NULL;
+  _track_file_map = NULL;
+  _track_file_size = 0;
+  _max_track_cache_size = 0.;
   _timer = new Timer();
 }
 
@@ -62,6 +71,8 @@ TrackGenerator::~TrackGenerator() {
 
   delete _quadrature;
   delete _timer;
+
+  unmapTrackFile();
 }
 
 
@@ -271,6 +282,17 @@ int TrackGenerator::getMaxNumSegments() {
 }
 
 
+/**
+ * @brief Returns the version of the Tracks, incremented every time Tracks are
+ *        generated.
+ * @details Solvers use the version to detect new Tracks and segments.
+ * @return the version of the Tracks
+ */
+int TrackGenerator::getTracksVersion() {
+  return _tracks_version;
+}
+
+
 /**
  * @brief Returns the number of shared memory OpenMP threads in use.
  * @return the number of threads
@@ -324,8 +346,16 @@ void TrackGenerator::exportFSRVolumes(double* out_volumes, int num_fsrs) {
  */
 FP_PRECISION* TrackGenerator::getFSRVolumes() {
 
-  /* Reset FSR volumes to zero */
+  /* Use the FSR volumes cached in the Track file if available */
   long num_FSRs = _geometry->getNumFSRs();
+  const char* cached_volumes =
+      getMappedTrackFileSection(SECTION_FSR_VOLUMES, num_FSRs);
+  if (_FSR_volumes != NULL && cached_volumes != NULL) {
+    memcpy(_FSR_volumes, cached_volumes, num_FSRs*sizeof(FP_PRECISION));
+    return _FSR_volumes;
+  }
+
+  /* Reset FSR volumes to zero */
   if (_FSR_volumes != NULL)
     memset(_FSR_volumes, 0., num_FSRs*sizeof(FP_PRECISION));
 
@@ -346,6 +376,10 @@ FP_PRECISION* TrackGenerator::getFSRVolumes() {
     }
   }
 
+  /* Cache the FSR volumes in the Track file */
+  appendTrackFileSection(SECTION_FSR_VOLUMES, _FSR_volumes,
+                         num_FSRs*sizeof(FP_PRECISION), num_FSRs);
+
   return _FSR_volumes;
 }
 
@@ -411,8 +445,6 @@ void TrackGenerator::setNumThreads(int num_threads) {
 
   /* Set the number of threads for OpenMP */
   omp_set_num_threads(_num_threads);
-  if (_geometry != NULL)
-    _geometry->reserveKeyStrings(num_threads);
 
   /* Print CPU assignments, useful for NUMA where by-socket is the preferred
    * CPU grouping */
@@ -770,9 +802,19 @@ void TrackGenerator::generateTracks() {
     /* If track file not present, generate segments */
     if (_use_input_file == false) {
 
-      /* Segmentize the tracks */
+      /* Segmentize the tracks, reusing one set of LocalCoords per thread */
+      long num_allocations = LocalCoords::getNumAllocations();
       segmentize();
-      //FIXME HERE dumpSegmentsToFile();
+      log_printf(INFO, "Allocated %ld LocalCoords arrays during ray tracing",
+                 LocalCoords::getNumAllocations() - num_allocations);
+
+      /* On-the-fly ray tracing only stores 2D segments, so their Track file
+       * is small and may be written as a startup cache of the extruded
+       * FSRs, to which the FSR volumes and centroids are added once
+       * computed */
+      if (_cache_OTF_startup && _segment_formation != EXPLICIT_2D &&
+          _segment_formation != EXPLICIT_3D)
+        dumpSegmentsToFile();
     }
 
     /* Allocate array of mutex locks for each FSR */
@@ -798,7 +840,7 @@ void TrackGenerator::generateTracks() {
 
     /* Precompute the quadrature weights */
     _quadrature->precomputeWeights(_segment_formation != EXPLICIT_2D);
-
+    _tracks_version++;
   }
   catch (std::exception &e) {
     log_printf(ERROR, "Unable to allocate memory needed to generate "
@@ -1164,6 +1206,9 @@ void TrackGenerator::segmentize() {
   int tracks_segmented = 0;
   long num_2D_tracks = getNum2DTracks();
 
+  /* Allocate the LocalCoords reused by each thread for ray tracing */
+  _geometry->initializeThreadCoords();
+
   /* Loop over all Tracks */
   for (int a=0; a < _num_azim/2; a++) {
     log_printf(NORMAL, "segmenting 2D tracks - Percent complete: %5.2f %%",
@@ -1176,11 +1221,80 @@ void TrackGenerator::segmentize() {
     tracks_segmented += _num_x[a] + _num_y[a];
   }
 
+  log_printf(INFO, "Replayed chord templates for %ld of %ld pin crossings",
+             _geometry->getNumTemplateCrossings(),
+             _geometry->getNumPinCrossings());
+
+  /* Free the chord templates, which are only used during segmentation */
+  _geometry->clearChordTemplates();
+
+  renumberFSRs();
   _geometry->initializeFSRVectors();
   _contains_2D_segments = true;
 }
 
 
+/**
+ * @brief Renumbers the FSRs found during explicit ray tracing independently
+ *        of the number of threads
+ * @details FSR IDs are handed out in the order in which threads discover the
+ *          FSRs. The Geometry renumbers them in spatial order, and
+ *          the explicit segments are updated accordingly, so that segment
+ *          files, flux files and tallies can be compared and reused across
+ *          runs with any number of threads.
+ */
+void TrackGenerator::renumberFSRs() {
+
+  std::vector<long> id_mapping;
+  _geometry->renumberFSRs(id_mapping);
+  if (id_mapping.empty())
+    return;
+
+  RenumberFSRs renumber_fsrs(this);
+  renumber_fsrs.setIDMapping(&id_mapping[0]);
+  renumber_fsrs.execute();
+}
+
+
+/**
+ * @brief Updates the Materials of the FSRs and segments after Cells were
+ *        filled again.
+ * @details The Geometry finds the Material of each FSR again, and the
+ *          segments keep their FSRs but take the Materials of the FSRs.
+ *          Segments traced on-the-fly take their Materials from the extruded
+ *          FSRs, which the Geometry updates.
+ */
+void TrackGenerator::updateFSRMaterials() {
+
+  if (!_geometry->updateFSRMaterials())
+    return;
+
+  long num_FSRs = _geometry->getNumFSRs();
+  std::map<int, Material*> all_materials = _geometry->getAllMaterials();
+  std::vector<int>& FSRs_to_material_IDs = _geometry->getFSRsToMaterialIDs();
+  std::vector<Material*> FSR_materials(num_FSRs);
+  for (long r=0; r < num_FSRs; r++)
+    FSR_materials[r] = all_materials[FSRs_to_material_IDs[r]];
+
+  updateSegmentMaterials(&FSR_materials[0]);
+}
+
+
+/**
+ * @brief Sets the Material of each explicit segment to that of its FSR.
+ * @param FSR_materials the Material of each FSR, indexed by FSR ID
+ */
+void TrackGenerator::updateSegmentMaterials(Material** FSR_materials) {
+
+  if (_segment_formation != EXPLICIT_2D && _segment_formation != EXPLICIT_3D)
+    return;
+
+  UpdateSegmentMaterials update_materials(this);
+  update_materials.setFSRMaterials(FSR_materials);
+  update_materials.execute();
+}
+
+
 /**
  * @brief This method creates a directory to store Track files, and reads
  *        in ray tracing data for Tracks and segments from a Track file
@@ -1203,13 +1317,18 @@ void TrackGenerator::initializeTrackFileDirectory() {
   if (!(stat(directory.str().c_str(), &st) == 0))
     mkdir(directory.str().c_str(), S_IRWXU);
 
-  /* Check to see if a Track file exists for this geometry, number of azimuthal
-   * angles, and track spacing, and if so, import the ray tracing data */
+  /* Check to see if a Track file exists for this Geometry and ray tracing
+   * parameters, and if so, import the ray tracing data */
+  _tracking_hash.clear();
+  hashTrackingParameters(_tracking_hash);
   _tracks_filename = getTestFilename(directory.str());
   if (!stat(_tracks_filename.c_str(), &buffer)) {
     if (readSegmentsFromFile()) {
       _use_input_file = true;
       setContainsSegments(true);
+
+      /* Mark the Track file as recently used */
+      utime(_tracks_filename.c_str(), NULL);
     }
   }
 }
@@ -1217,25 +1336,103 @@ void TrackGenerator::initializeTrackFileDirectory() {
 
 /**
  * @brief Returns the filename for writing tracking data
+ * @details The filename is formed from the hash of the Geometry and ray
+ *          tracing parameters.
  */
 std::string TrackGenerator::getTestFilename(std::string directory) {
 
   std::stringstream test_filename;
+  test_filename << directory << "/2D_" << _tracking_hash.toString()
+                << ".data";
 
-  if (_geometry->getCmfd() != NULL)
-    test_filename << directory << "/2D_"
-                  << _num_azim << "_azim_"
-                  << _azim_spacing << "_cm_spacing_cmfd_"
-                  << _geometry->getCmfd()->getNumX()
-                  << "x" << _geometry->getCmfd()->getNumY();
-  else
-    test_filename << directory << "/2D_"
-                  << _num_azim << "_angles_"
-                  << _azim_spacing << "_cm_spacing";
+  return test_filename.str();
+}
 
-  test_filename << ".data";
 
-  return test_filename.str();
+/**
+ * @brief Hashes the Geometry and all parameters determining the Tracks and
+ *        segments.
+ * @details The hash identifies the Track file of this TrackGenerator, both
+ *          in its filename and in its header.
+ * @param hash the hash to update
+ */
+void TrackGenerator::hashTrackingParameters(FSRKey& hash) {
+
+  /* Hash the Geometry */
+  _geometry->hashContents(hash);
+
+  /* Hash the quadrature */
+  hash.append(_quadrature->getQuadratureType());
+  int num_azim = _quadrature->getNumAzimAngles();
+  int num_polar = _quadrature->getNumPolarAngles();
+  hash.append(num_azim);
+  hash.append(num_polar);
+  for (int a=0; a < num_azim/4; a++) {
+    hash.appendDouble(_quadrature->getPhi(a));
+    for (int p=0; p < num_polar/2; p++)
+      hash.appendDouble(_quadrature->getTheta(a, p));
+  }
+
+  /* Hash the ray tracing parameters */
+  hash.append(_num_azim);
+  hash.appendDouble(_azim_spacing);
+  hash.appendDouble(_z_coord);
+  hash.append(_segment_formation);
+  hash.appendDouble(_max_optical_length);
+}
+
+
+/**
+ * @brief Deletes the least recently used Track files of the Track file
+ *        directory until their total size is within the maximum size set
+ *        by setMaxTrackCacheSize(...).
+ * @details Track files are marked as used when they are written or read.
+ *          The Track file of this TrackGenerator is never deleted.
+ */
+void TrackGenerator::evictTrackFiles() {
+
+  if (_max_track_cache_size <= 0.)
+    return;
+
+  /* List the Track files of the directory by time of last use */
+  std::string directory =
+      _tracks_filename.substr(0, _tracks_filename.find_last_of('/'));
+  DIR* dir = opendir(directory.c_str());
+  if (dir == NULL)
+    return;
+
+  std::vector<std::pair<time_t, std::string> > track_files;
+  std::map<std::string, off_t> file_sizes;
+  double total_size = 0.;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name = entry->d_name;
+    if (name.length() < 5 || name.substr(name.length() - 5) != ".data")
+      continue;
+    std::string filename = directory + "/" + name;
+    struct stat file_stat;
+    if (stat(filename.c_str(), &file_stat) != 0)
+      continue;
+    track_files.push_back(std::make_pair(file_stat.st_mtime, filename));
+    file_sizes[filename] = file_stat.st_size;
+    total_size += file_stat.st_size / 1e6;
+  }
+  closedir(dir);
+
+  /* Delete the least recently used Track files first */
+  std::sort(track_files.begin(), track_files.end());
+  for (size_t i=0; i < track_files.size(); i++) {
+    if (total_size <= _max_track_cache_size)
+      break;
+    std::string& filename = track_files[i].second;
+    if (filename == _tracks_filename)
+      continue;
+    if (unlink(filename.c_str()) == 0) {
+      total_size -= file_sizes[filename] / 1e6;
+      log_printf(INFO, "Deleted least recently used Track file %s",
+                 filename.c_str());
+    }
+  }
 }
 
 
@@ -1252,6 +1449,10 @@ void TrackGenerator::setContainsSegments(bool contains_segments) {
  * @brief Writes all Track and segment data to a "*.tracks" binary file.
  * @details Storing Tracks in a binary file saves time by eliminating ray
  *          tracing for Track segmentation in commonly simulated geometries.
+ *          The file starts with a TrackFileHeader locating aligned sections
+ *          of data. Segments are written with the layout of the segment
+ *          struct, so that the file can be memory mapped and its segments
+ *          used in place when it is read.
  */
 void TrackGenerator::dumpSegmentsToFile() {
 
@@ -1266,98 +1467,171 @@ void TrackGenerator::dumpSegmentsToFile() {
                "have been generated for %d azimuthal angles and %f track "
                "spacing", _num_azim, _azim_spacing);
 
+  TrackFileHeader header;
+  std::map<int, int> material_indexes;
+  FILE* out = openTrackFile(header, material_indexes);
+
+  /* Write the offsets of the segments of each Track which stores segments */
+  long num_tracks = getNum2DTracks();
+  if (_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D)
+    num_tracks = getNumTracks();
+  std::vector<long> segment_offsets(num_tracks + 1, 0);
+  DumpSegments dump_segments(this);
+  dump_segments.setSegmentOffsets(&segment_offsets[0], num_tracks);
+  dump_segments.setMaterialIndexes(&material_indexes);
+  dump_segments.countSegments();
+  writeTrackFileSection(out, header, SECTION_SEGMENT_OFFSETS,
+                        &segment_offsets[0], (num_tracks + 1) * sizeof(long),
+                        num_tracks + 1);
+
+  /* Write segment data to Track file */
+  long num_segments = segment_offsets[num_tracks];
+  writeTrackFileSection(out, header, SECTION_SEGMENTS, NULL,
+                        num_segments * sizeof(segment), num_segments);
+  dump_segments.setOutputFile(out, header._sections[SECTION_SEGMENTS]._offset);
+  dump_segments.execute();
+  header._checksum += dump_segments.getChecksum();
+
+  closeTrackFile(out, header);
+}
+
+
+/**
+ * @brief Opens a new Track file and writes the Materials section.
+ * @details The file is written under a temporary name until it is closed by
+ *          closeTrackFile(), so that a memory mapped Track file remains
+ *          valid. The sections holding the segments are written next by the
+ *          caller.
+ * @param header the header of the Track file, initialized
+ * @param material_indexes set to the index in the file of each Material,
+ *        indexed by Material ID
+ * @return the Track file
+ */
+FILE* TrackGenerator::openTrackFile(TrackFileHeader& header,
+                                    std::map<int, int>& material_indexes) {
+
+  /* Write to a temporary file which then replaces the Track file, so that a
+   * memory mapped Track file remains valid */
+  std::string temporary_filename = _tracks_filename + ".tmp";
   FILE* out;
-  out = fopen(_tracks_filename.c_str(), "w");
+  out = fopen(temporary_filename.c_str(), "w+");
+  if (out == NULL)
+    log_printf(ERROR, "Unable to open the Track file %s",
+               temporary_filename.c_str());
+
+  /* Initialize the header, the sections are placed after it. The hash of the
+   * Geometry and ray tracing parameters is used to check whether or not ray
+   * tracing has been performed for them */
+  header = TrackFileHeader();
+  strncpy(header._magic, "OMOCTRK", sizeof(header._magic));
+  header._version = TRACK_FILE_VERSION;
+  header._endianness = TRACK_FILE_ENDIANNESS;
+  header._segment_size = sizeof(segment);
+  header._precision_size = sizeof(FP_PRECISION);
+  header._segment_formation = _segment_formation;
+  header._tracking_hash = _tracking_hash;
+  header._num_sections = NUM_TRACK_FILE_SECTIONS;
+  header._file_size = (sizeof(TrackFileHeader) + TRACK_FILE_ALIGNMENT - 1)
+      / TRACK_FILE_ALIGNMENT * TRACK_FILE_ALIGNMENT;
+
+  /* Write the Material IDs, segments reference Materials by index */
+  std::map<int, Material*> materials = _geometry->getAllMaterials();
+  std::map<int, Material*>::iterator m_iter;
+  std::vector<int> material_ids;
+  for (m_iter = materials.begin(); m_iter != materials.end(); ++m_iter) {
+    material_indexes[m_iter->first] = material_ids.size();
+    material_ids.push_back(m_iter->first);
+  }
+  writeTrackFileSection(out, header, SECTION_MATERIALS, &material_ids[0],
+                        material_ids.size() * sizeof(int),
+                        material_ids.size());
 
-  /* Get a string representation of the Geometry's attributes. This is used to
-   * check whether or not ray tracing has been performed for this Geometry */
-  std::string geometry_to_string = _geometry->toString();
-  int string_length = geometry_to_string.length() + 1;
+  return out;
+}
 
-  /* Write geometry metadata to the Track file */
-  fwrite(&string_length, sizeof(int), 1, out);
-  fwrite(geometry_to_string.c_str(), sizeof(char)*string_length, 1, out);
 
-  /* Write segment data to Track file */
-  DumpSegments dump_segments(this);
-  dump_segments.setOutputFile(out);
-  if (_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D)
-    dump_segments.execute();
-  
+/**
+ * @brief Writes the FSR sections of a Track file and replaces the Track
+ *        file with it.
+ * @details This is called once the sections holding the segments have been
+ *          written, and the FSRs have been numbered.
+ * @param out the Track file opened by openTrackFile()
+ * @param header the header of the Track file
+ */
+void TrackGenerator::closeTrackFile(FILE* out, TrackFileHeader& header) {
+
   /* Get FSR vector maps */
-  ParallelHashMap<std::string, fsr_data*>& FSR_keys_map =
+  ConcurrentHashMap<FSRKey, fsr_data*>& FSR_keys_map =
       _geometry->getFSRKeysMap();
-  std::vector<std::string>& FSRs_to_keys = _geometry->getFSRsToKeys();
+  std::vector<FSRKey>& FSRs_to_keys = _geometry->getFSRsToKeys();
   std::vector<int>& FSRs_to_material_IDs = _geometry->getFSRsToMaterialIDs();
 
-  std::string fsr_key;
-  long fsr_id;
-  double x, y, z;
-
-  /* Write number of FSRs */
+  /* Gather the characteristic point of each FSR */
   long num_FSRs = _geometry->getNumFSRs();
-  fwrite(&num_FSRs, sizeof(long), 1, out);
-
-  /* Write FSR vector maps to file */
-  std::string* fsr_key_list = FSR_keys_map.keys();
-  fsr_data** fsr_data_list = FSR_keys_map.values();
-  Cmfd* cmfd = _geometry->getCmfd();
-  for (long i=0; i < num_FSRs; i++) {
-
-    /* Write data to file from FSR_keys_map */
-    fsr_key = fsr_key_list[i];
-    string_length = fsr_key.length() + 1;
-    fwrite(&string_length, sizeof(int), 1, out);
-    fwrite(fsr_key.c_str(), sizeof(char)*string_length, 1, out);
-
-    fsr_id = fsr_data_list[i]->_fsr_id;
-    x = fsr_data_list[i]->_point->getX();
-    y = fsr_data_list[i]->_point->getY();
-    z = fsr_data_list[i]->_point->getZ();
-    fwrite(&fsr_id, sizeof(long), 1, out);
-    fwrite(&x, sizeof(double), 1, out);
-    fwrite(&y, sizeof(double), 1, out);
-    fwrite(&z, sizeof(double), 1, out);
-
-    /* Write data to file from FSRs_to_material_IDs */
-    fwrite(&(FSRs_to_material_IDs.at(i)), sizeof(int), 1, out);
-
-    /* Write data to file from FSRs_to_keys */
-    fsr_key = FSRs_to_keys.at(i);
-    string_length = fsr_key.length() + 1;
-    fwrite(&string_length, sizeof(int), 1, out);
-    fwrite(fsr_key.c_str(), sizeof(char)*string_length, 1, out);
+  std::vector<double> FSR_points(3 * num_FSRs);
+#pragma omp parallel for
+  for (long r=0; r < num_FSRs; r++) {
+    Point* point = FSR_keys_map.at(FSRs_to_keys.at(r))->_point;
+    FSR_points[3*r] = point->getX();
+    FSR_points[3*r+1] = point->getY();
+    FSR_points[3*r+2] = point->getZ();
   }
 
+  /* Write FSR vector maps to file, indexed by FSR ID */
+  writeTrackFileSection(out, header, SECTION_FSR_KEYS, &FSRs_to_keys[0],
+                        num_FSRs * sizeof(FSRKey), num_FSRs);
+  writeTrackFileSection(out, header, SECTION_FSR_POINTS, &FSR_points[0],
+                        3 * num_FSRs * sizeof(double), num_FSRs);
+  writeTrackFileSection(out, header, SECTION_FSR_MATERIALS,
+                        &FSRs_to_material_IDs[0], num_FSRs * sizeof(int),
+                        num_FSRs);
+
   /* Write cmfd_fsrs vector of vectors to file */
+  Cmfd* cmfd = _geometry->getCmfd();
   if (cmfd != NULL) {
     std::vector< std::vector<long> >* cell_fsrs = cmfd->getCellFSRs();
-    std::vector<long>::iterator iter;
     int num_cells = cmfd->getNumCells();
-    fwrite(&num_cells, sizeof(int), 1, out);
+    std::vector<long> cell_offsets(num_cells + 1, 0);
+    std::vector<long> cell_FSR_ids;
 
     /* Loop over CMFD cells */
     for (int cell=0; cell < num_cells; cell++) {
-      int num_cell_FSRs = cell_fsrs->at(cell).size();
-      fwrite(&num_cell_FSRs, sizeof(int), 1, out);
-
-      /* Loop over FSRs within cell */
-      for (iter = cell_fsrs->at(cell).begin();
-           iter != cell_fsrs->at(cell).end(); ++iter)
-        fwrite(&(*iter), sizeof(long), 1, out);
+      cell_FSR_ids.insert(cell_FSR_ids.end(), cell_fsrs->at(cell).begin(),
+                          cell_fsrs->at(cell).end());
+      cell_offsets[cell+1] = cell_FSR_ids.size();
     }
-  }
 
-  /* Delete key and value lists */
-  delete [] fsr_key_list;
-  delete [] fsr_data_list;
+    writeTrackFileSection(out, header, SECTION_CMFD_OFFSETS, &cell_offsets[0],
+                          (num_cells + 1) * sizeof(long), num_cells + 1);
+    writeTrackFileSection(out, header, SECTION_CMFD_FSRS, &cell_FSR_ids[0],
+                          cell_FSR_ids.size() * sizeof(long),
+                          cell_FSR_ids.size());
+  }
 
   /* Write 2D basis information for 3D solvers */
-  if (_segment_formation != EXPLICIT_2D && _segment_formation != EXPLICIT_3D)
-    writeExtrudedFSRInfo(out);
+  if (_segment_formation != EXPLICIT_2D && _segment_formation != EXPLICIT_3D) {
+    char* buffer;
+    size_t size;
+    FILE* extruded_out = open_memstream(&buffer, &size);
+    writeExtrudedFSRInfo(extruded_out);
+    fclose(extruded_out);
+    writeTrackFileSection(out, header, SECTION_EXTRUDED_FSRS, buffer, size,
+                          _geometry->getExtrudedFSRKeysMap().size());
+    free(buffer);
+  }
 
-  /* Close the Track file */
+  /* Write the header once all sections are located */
+  writeTrackFileHeader(out, header);
+
+  /* Close the Track file and replace any previous one */
   fclose(out);
+  std::string temporary_filename = _tracks_filename + ".tmp";
+  if (rename(temporary_filename.c_str(), _tracks_filename.c_str()) != 0)
+    log_printf(ERROR, "Unable to replace the Track file %s",
+               _tracks_filename.c_str());
+
+  /* Keep the Track file directory within its maximum size */
+  evictTrackFiles();
 
   /* Inform other the TrackGenerator::generateTracks() method that it may
    * import ray tracing data from this file if it is called and the ray
@@ -1366,6 +1640,124 @@ void TrackGenerator::dumpSegmentsToFile() {
 }
 
 
+/**
+ * @brief Writes a section of a Track file after the previous sections.
+ * @details The section is aligned in the file and recorded in the header,
+ *          and its contents are added to the checksum. If no data is
+ *          provided, the section is only located and must be written by
+ *          the caller.
+ * @param out the Track file
+ * @param header the header of the Track file
+ * @param section the section to write
+ * @param data the contents of the section
+ * @param size the size of the section (bytes)
+ * @param count the number of items in the section
+ */
+void TrackGenerator::writeTrackFileSection(FILE* out, TrackFileHeader& header,
+                                           trackFileSection section,
+                                           const void* data, uint64_t size,
+                                           uint64_t count) {
+
+  uint64_t offset = header._file_size;
+  header._sections[section]._offset = offset;
+  header._sections[section]._size = size;
+  header._sections[section]._count = count;
+  header._file_size = (offset + size + TRACK_FILE_ALIGNMENT - 1)
+      / TRACK_FILE_ALIGNMENT * TRACK_FILE_ALIGNMENT;
+
+  if (data == NULL || size == 0)
+    return;
+
+  if (pwrite(fileno(out), data, size, offset) != (ssize_t) size)
+    log_printf(ERROR, "Unable to write section %d of the Track file %s",
+               section, _tracks_filename.c_str());
+  header._checksum += trackFileChecksum((const char*) data, size, offset);
+}
+
+
+/**
+ * @brief Writes the header of a Track file once all sections are located.
+ * @details The file is sized to hold all the sections.
+ * @param out the Track file
+ * @param header the header of the Track file
+ */
+void TrackGenerator::writeTrackFileHeader(FILE* out, TrackFileHeader& header) {
+
+  if (ftruncate(fileno(out), header._file_size) != 0 ||
+      pwrite(fileno(out), &header, sizeof(TrackFileHeader), 0) !=
+      (ssize_t) sizeof(TrackFileHeader))
+    log_printf(ERROR, "Unable to write the header of the Track file %s",
+               _tracks_filename.c_str());
+}
+
+
+/**
+ * @brief Appends a section to the Track file of this TrackGenerator.
+ * @details This is used to cache data computed after ray tracing, such as
+ *          the FSR volumes and centroids, so that later runs with the same
+ *          Geometry and ray tracing parameters do not compute it again. The
+ *          section is only appended if the Track file was written for this
+ *          TrackGenerator and does not contain the section yet. The file
+ *          may be memory mapped, since only its header and its end change.
+ * @param section the section to append
+ * @param data the contents of the section
+ * @param size the size of the section (bytes)
+ * @param count the number of items in the section
+ */
+void TrackGenerator::appendTrackFileSection(trackFileSection section,
+                                            const void* data, uint64_t size,
+                                            uint64_t count) {
+
+  if (!_dump_segments || _tracks_filename.empty())
+    return;
+
+  FILE* out = fopen(_tracks_filename.c_str(), "r+");
+  if (out == NULL)
+    return;
+
+  /* Check that the Track file is the one of this TrackGenerator */
+  TrackFileHeader header;
+  if (pread(fileno(out), &header, sizeof(TrackFileHeader), 0) !=
+      (ssize_t) sizeof(TrackFileHeader) ||
+      strncmp(header._magic, "OMOCTRK", sizeof(header._magic)) != 0 ||
+      header._version != TRACK_FILE_VERSION ||
+      header._num_sections != NUM_TRACK_FILE_SECTIONS ||
+      header._segment_formation != _segment_formation ||
+      header._tracking_hash != _tracking_hash ||
+      header._sections[section]._size != 0) {
+    fclose(out);
+    return;
+  }
+
+  writeTrackFileSection(out, header, section, data, size, count);
+  writeTrackFileHeader(out, header);
+  fclose(out);
+}
+
+
+/**
+ * @brief Returns a section of the memory mapped Track file.
+ * @param section the section
+ * @param count the expected number of items in the section
+ * @return the contents of the section, NULL if no Track file is mapped or
+ *         if it does not contain the section with the expected count
+ */
+const char* TrackGenerator::getMappedTrackFileSection(trackFileSection section,
+                                                      uint64_t count) {
+
+  if (_track_file_map == NULL)
+    return NULL;
+
+  /* Sections appended since the file was mapped are beyond the mapping */
+  TrackFileSection* sections = ((TrackFileHeader*) _track_file_map)->_sections;
+  if (sections[section]._size == 0 || sections[section]._count != count ||
+      sections[section]._offset + sections[section]._size > _track_file_size)
+    return NULL;
+
+  return _track_file_map + sections[section]._offset;
+}
+
+
 /**
  * @brief Write information of all Extruded FSRs to a file 
  //TODO Use implementation in 3D track generator
@@ -1375,113 +1767,225 @@ void TrackGenerator::writeExtrudedFSRInfo(FILE* out) {}
 
 
 /**
- * @brief Reads Tracks in from a "*.tracks" binary file.
- * @details Storing Tracks in a binary file saves time by eliminating ray
- *          tracing for Track segmentation in commonly simulated geometries.
- * @return true if able to read Tracks in from a file; false otherwise
+ * @brief Checks whether a memory mapped Track file can be used.
+ * @details The format, the machine representation of the data, the ray
+ *          tracing parameters and the Geometry must match those of this
+ *          TrackGenerator, and the contents must match the checksum.
+ * @param header the header at the start of the memory mapped Track file
+ * @return whether the Track file can be used
  */
-bool TrackGenerator::readSegmentsFromFile() {
+bool TrackGenerator::checkTrackFile(TrackFileHeader* header) {
 
-  int ret;
-  FILE* in = fopen(_tracks_filename.c_str(), "r");
+  const char* map = (const char*) header;
+  TrackFileSection* sections = header->_sections;
 
-  int string_length;
+  /* Check the format and machine representation of the data */
+  if (strncmp(header->_magic, "OMOCTRK", sizeof(header->_magic)) != 0 ||
+      header->_version != TRACK_FILE_VERSION ||
+      header->_num_sections != NUM_TRACK_FILE_SECTIONS) {
+    log_printf(WARNING, "Ignoring Track file %s written in another format",
+               _tracks_filename.c_str());
+    return false;
+  }
+  if (header->_endianness != TRACK_FILE_ENDIANNESS ||
+      header->_segment_size != sizeof(segment) ||
+      header->_precision_size != sizeof(FP_PRECISION)) {
+    log_printf(WARNING, "Ignoring Track file %s written by a machine or "
+               "build with another data representation",
+               _tracks_filename.c_str());
+    return false;
+  }
+  if (header->_segment_formation != _segment_formation ||
+      header->_tracking_hash != _tracking_hash)
+    return false;
+
+  for (int i=0; i < NUM_TRACK_FILE_SECTIONS; i++) {
+    if (sections[i]._offset % TRACK_FILE_ALIGNMENT != 0 ||
+        sections[i]._offset + sections[i]._size > header->_file_size) {
+      log_printf(WARNING, "Ignoring truncated Track file %s",
+                 _tracks_filename.c_str());
+      return false;
+    }
+  }
 
-  /* Import Geometry metadata from the Track file */
-  ret = _geometry->twiddleRead(&string_length, sizeof(int), 1, in);
-  char* geometry_to_string = new char[string_length];
-  ret = _geometry->twiddleRead(geometry_to_string, sizeof(char)*string_length, 1, in);
+  /* Check the number of Tracks and the presence of CMFD data */
+  long num_tracks = getNum2DTracks();
+  if (_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D)
+    num_tracks = getNumTracks();
+  if (sections[SECTION_SEGMENT_OFFSETS]._count != (uint64_t) num_tracks + 1 ||
+      (_geometry->getCmfd() != NULL) !=
+      (sections[SECTION_CMFD_OFFSETS]._count > 0))
+    return false;
 
-  /* Check if our Geometry is exactly the same as the Geometry in the
-   * Track file for this number of azimuthal angles and track spacing */
-  if (_geometry->toString().compare(std::string(geometry_to_string)) != 0)
+  /* Check that all Materials of the file are in the Geometry */
+  std::map<int, Material*> materials = _geometry->getAllMaterials();
+  int* material_ids = (int*) (map + sections[SECTION_MATERIALS]._offset);
+  for (uint64_t m=0; m < sections[SECTION_MATERIALS]._count; m++)
+    if (materials.find(material_ids[m]) == materials.end())
+      return false;
+
+  /* Check the contents of all sections against the checksum */
+  const uint64_t block_size = 1 << 20;
+  uint64_t checksum = 0;
+  for (int i=0; i < NUM_TRACK_FILE_SECTIONS; i++) {
+    uint64_t offset = sections[i]._offset;
+    uint64_t size = sections[i]._size;
+    long num_blocks = (size + block_size - 1) / block_size;
+#pragma omp parallel for reduction(+:checksum)
+    for (long b=0; b < num_blocks; b++) {
+      uint64_t start = offset + b * block_size;
+      uint64_t block = std::min(block_size, offset + size - start);
+      checksum += trackFileChecksum(map + start, block, start);
+    }
+  }
+  if (checksum != header->_checksum) {
+    log_printf(WARNING, "Ignoring corrupted Track file %s",
+               _tracks_filename.c_str());
     return false;
+  }
+
+  return true;
+}
 
-  delete [] geometry_to_string;
 
-  log_printf(NORMAL, "Importing ray tracing data from file...");
+/**
+ * @brief Memory maps the Track file and uses its segments in place.
+ * @details Only the Material references of the segments are relocated,
+ *          unless the segments are streamed from the file, in which case
+ *          they are relocated as they are streamed. The file remains mapped
+ *          until it is replaced or the TrackGenerator is deleted.
+ * @return true if the Track file could be mapped; false otherwise
+ */
+bool TrackGenerator::mapTrackFile() {
+
+  /* Map the Track file in memory. The mapping is private since the Material
+   * references of the segments are relocated in place. */
+  int fd = open(_tracks_filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      file_stat.st_size < (off_t) sizeof(TrackFileHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t file_size = file_stat.st_size;
+  char* map = (char*) mmap(NULL, file_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  /* Check whether the Track file can be used */
+  TrackFileHeader* header = (TrackFileHeader*) map;
+  if (header->_file_size != file_size || !checkTrackFile(header)) {
+    munmap(map, file_size);
+    return false;
+  }
 
-  /* Load all segment data into Tracks */
+  /* Replace any previously mapped Track file */
+  unmapTrackFile();
+  _track_file_map = map;
+  _track_file_size = file_size;
+  TrackFileSection* sections = header->_sections;
+
+  /* Find the Material of each index in the file */
+  std::map<int, Material*> all_materials = _geometry->getAllMaterials();
+  int* material_ids = (int*) (map + sections[SECTION_MATERIALS]._offset);
+  long num_materials = sections[SECTION_MATERIALS]._count;
+  _track_file_materials.resize(num_materials);
+  for (long m=0; m < num_materials; m++)
+    _track_file_materials[m] = all_materials[material_ids[m]];
+
+  /* Use the segments of all Tracks in place */
+  segment* segments = (segment*) (map + sections[SECTION_SEGMENTS]._offset);
+  long num_segments = sections[SECTION_SEGMENTS]._count;
   ReadSegments read_segments(this);
-  read_segments.setInputFile(in);
-  if (_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D)
-    read_segments.execute();
+  read_segments.setSegments(
+      (long*) (map + sections[SECTION_SEGMENT_OFFSETS]._offset), segments);
+  read_segments.execute();
+
+  /* Relocate the Material references of the segments in place */
+  if (streamsSegments())
+    return true;
+#pragma omp parallel for
+  for (long s=0; s < num_segments; s++) {
+    long material_index = (long) segments[s]._material;
+    if (material_index < 0)
+      segments[s]._material = NULL;
+    else
+      segments[s]._material = _track_file_materials[material_index];
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Reads Tracks in from a "*.tracks" binary file.
+ * @details Storing Tracks in a binary file saves time by eliminating ray
+ *          tracing for Track segmentation in commonly simulated geometries.
+ *          The file is memory mapped and its segments are used in place by
+ *          the Tracks. The FSRs found by ray tracing are then restored in
+ *          the Geometry.
+ * @return true if able to read Tracks in from a file; false otherwise
+ */
+bool TrackGenerator::readSegmentsFromFile() {
+
+  if (!mapTrackFile())
+    return false;
+
+  log_printf(NORMAL, "Importing ray tracing data from file %s...",
+             _tracks_filename.c_str());
+  char* map = _track_file_map;
+  TrackFileSection* sections = ((TrackFileHeader*) map)->_sections;
 
   /* Create FSR vector maps */
-  ParallelHashMap<std::string, fsr_data*>& FSR_keys_map =
+  ConcurrentHashMap<FSRKey, fsr_data*>& FSR_keys_map =
     _geometry->getFSRKeysMap();
   std::vector<int>& FSRs_to_material_IDs = _geometry->getFSRsToMaterialIDs();
-  std::vector<std::string>& FSRs_to_keys = _geometry->getFSRsToKeys();
+  std::vector<FSRKey>& FSRs_to_keys = _geometry->getFSRsToKeys();
   std::vector<Point*>& FSRs_to_centroids = _geometry->getFSRsToCentroids();
   std::vector<int>& FSRs_to_CMFD_cells = _geometry->getFSRsToCMFDCells();
 
-  long num_FSRs;
-  std::string fsr_key;
-  long fsr_key_id;
-  double x, y, z;
+  long num_FSRs = sections[SECTION_FSR_KEYS]._count;
+  FSRKey* FSR_keys = (FSRKey*) (map + sections[SECTION_FSR_KEYS]._offset);
+  double* FSR_points = (double*) (map + sections[SECTION_FSR_POINTS]._offset);
+  int* FSR_material_IDs =
+      (int*) (map + sections[SECTION_FSR_MATERIALS]._offset);
 
-  /* Get number of FSRs */
-  ret = _geometry->twiddleRead(&num_FSRs, sizeof(long), 1, in);
-
-  /* Resize vectors */
+  /* Copy the FSR arrays into the Geometry */
+  FSRs_to_keys.assign(FSR_keys, FSR_keys + num_FSRs);
+  FSRs_to_material_IDs.assign(FSR_material_IDs, FSR_material_IDs + num_FSRs);
   FSRs_to_centroids.resize(num_FSRs);
   FSRs_to_CMFD_cells.resize(num_FSRs);
 
-  /* Read FSR vector maps from file */
-  for (long fsr_id=0; fsr_id < num_FSRs; fsr_id++) {
-
-    /* Read key for FSR_keys_map */
-    ret = _geometry->twiddleRead(&string_length, sizeof(int), 1, in);
-    char* char_buffer1 = new char[string_length];
-    ret = _geometry->twiddleRead(char_buffer1, sizeof(char)*string_length, 1, in);
-    fsr_key = std::string(char_buffer1);
-
-    /* Read data from file for FSR_keys_map */
-    ret = _geometry->twiddleRead(&fsr_key_id, sizeof(long), 1, in);
-    ret = _geometry->twiddleRead(&x, sizeof(double), 1, in);
-    ret = _geometry->twiddleRead(&y, sizeof(double), 1, in);
-    ret = _geometry->twiddleRead(&z, sizeof(double), 1, in);
+  /* Fill the FSR map */
+#pragma omp parallel for
+  for (long r=0; r < num_FSRs; r++) {
     fsr_data* fsr = new fsr_data;
-    fsr->_fsr_id = fsr_key_id;
+    fsr->_fsr_id = r;
+    fsr->_mat_id = FSR_material_IDs[r];
     Point* point = new Point();
-    point->setCoords(x,y,z);
+    point->setCoords(FSR_points[3*r], FSR_points[3*r+1], FSR_points[3*r+2]);
     fsr->_point = point;
-    FSR_keys_map.insert(fsr_key, fsr);
-
-    /* Read data from file for FSR_to_materials_IDs */
-    int material_id;
-    ret = _geometry->twiddleRead(&material_id, sizeof(int), 1, in);
-    FSRs_to_material_IDs.push_back(material_id);
-
-    /* Read data from file for FSR_to_keys */
-    ret = _geometry->twiddleRead(&string_length, sizeof(int), 1, in);
-    char* char_buffer2 = new char[string_length];
-    ret = _geometry->twiddleRead(char_buffer2, sizeof(char)*string_length, 1, in);
-    fsr_key = std::string(char_buffer2);
-    FSRs_to_keys.push_back(fsr_key);
+    FSR_keys_map.insert(FSR_keys[r], fsr);
   }
 
   /* Read cmfd cell_fsrs vector of vectors from file */
   Cmfd* cmfd = _geometry->getCmfd();
   if (cmfd != NULL) {
-    std::vector< std::vector<long> > cell_fsrs;
-    int num_cells;
-    ret = _geometry->twiddleRead(&num_cells, sizeof(int), 1, in);
-    long fsr_id;
+    long num_cells = sections[SECTION_CMFD_OFFSETS]._count - 1;
+    long* cell_offsets = (long*) (map + sections[SECTION_CMFD_OFFSETS]._offset);
+    long* cell_FSR_ids = (long*) (map + sections[SECTION_CMFD_FSRS]._offset);
+    std::vector< std::vector<long> > cell_fsrs(num_cells);
 
     /* Loop over CMFD cells */
-    for (int cell=0; cell < num_cells; cell++) {
-      std::vector<long>* fsrs = new std::vector<long>;
-      cell_fsrs.push_back(*fsrs);
-      int num_cell_FSRs;
-      ret = _geometry->twiddleRead(&num_cell_FSRs, sizeof(int), 1, in);
-
-      /* Loop over FSRs within cell */
-      for (int fsr = 0; fsr < num_cell_FSRs; fsr++) {
-        ret = _geometry->twiddleRead(&fsr_id, sizeof(long), 1, in);
-        cell_fsrs.at(cell).push_back(fsr_id);
-        FSRs_to_CMFD_cells.at(fsr_id) = cell;
-      }
+    for (long cell=0; cell < num_cells; cell++) {
+      cell_fsrs.at(cell).assign(cell_FSR_ids + cell_offsets[cell],
+                                cell_FSR_ids + cell_offsets[cell+1]);
+      for (long i=cell_offsets[cell]; i < cell_offsets[cell+1]; i++)
+        FSRs_to_CMFD_cells.at(cell_FSR_ids[i]) = cell;
     }
 
     /* Set CMFD cell_fsrs vector of vectors */
@@ -1489,16 +1993,41 @@ bool TrackGenerator::readSegmentsFromFile() {
   }
 
   /* Read 2D basis information for OTF 3D solvers */
-  if (_segment_formation != EXPLICIT_2D && _segment_formation != EXPLICIT_3D)
+  if (_segment_formation != EXPLICIT_2D && _segment_formation != EXPLICIT_3D) {
+    FILE* in = fmemopen(map + sections[SECTION_EXTRUDED_FSRS]._offset,
+                        sections[SECTION_EXTRUDED_FSRS]._size, "r");
     readExtrudedFSRInfo(in);
-
-  /* Close the Track file */
-  fclose(in);
+    fclose(in);
+  }
 
   return true;
 }
 
 
+/**
+ * @brief Unmaps the memory mapped Track file, if any.
+ * @details Tracks must no longer use the segments of the file.
+ */
+void TrackGenerator::unmapTrackFile() {
+  if (_track_file_map != NULL)
+    munmap(_track_file_map, _track_file_size);
+  _track_file_map = NULL;
+  _track_file_size = 0;
+  _track_file_materials.clear();
+}
+
+
+/**
+ * @brief Returns whether segments are streamed from the memory mapped Track
+ *        file rather than kept in memory.
+ * @details Segments are only streamed in explicit 3D ray tracing.
+ * @return false
+ */
+bool TrackGenerator::streamsSegments() {
+  return false;
+}
+
+
 /**
  * @brief Read information of all Extruded FSRs from a file.
  * @param in file to read from
@@ -1523,7 +2052,8 @@ void TrackGenerator::splitSegments(FP_PRECISION max_optical_length) {
   if (_segment_formation != EXPLICIT_3D && _segment_formation != EXPLICIT_2D)
     log_printf(ERROR, "Segments cannot be split for on-the-fly ray tracing");
 
-  /* Split all segments along all Tracks */
+  /* Split all segments along all Tracks. Segments streamed from the Track
+   * file are split as they are streamed */
   _max_optical_length = max_optical_length;
   SegmentSplitter segment_splitter(this);
   segment_splitter.execute();
@@ -1550,18 +2080,41 @@ void TrackGenerator::generateFSRCentroids(FP_PRECISION* FSR_volumes) {
     centroids[r]->setCoords(0.0, 0.0, 0.0);
   }
 
-  /* Generate FSR centroids by looping over all Tracks */
-  CentroidGenerator centroid_generator(this);
-  centroid_generator.setCentroids(centroids);
-  centroid_generator.execute();
+  /* Use the FSR centroids cached in the Track file if available */
+  const double* cached_centroids = (const double*)
+      getMappedTrackFileSection(SECTION_FSR_CENTROIDS, num_FSRs);
+  if (cached_centroids != NULL) {
+#pragma omp parallel for
+    for (long r=0; r < num_FSRs; r++)
+      centroids[r]->setCoords(cached_centroids[3*r], cached_centroids[3*r+1],
+                              cached_centroids[3*r+2]);
+  }
+
+  /* Generate FSR centroids by looping over all Tracks and cache them in
+   * the Track file */
+  else {
+    CentroidGenerator centroid_generator(this);
+    centroid_generator.setCentroids(centroids);
+    centroid_generator.execute();
+
+    std::vector<double> FSR_centroids(3 * num_FSRs);
+#pragma omp parallel for
+    for (long r=0; r < num_FSRs; r++) {
+      FSR_centroids[3*r] = centroids[r]->getX();
+      FSR_centroids[3*r+1] = centroids[r]->getY();
+      FSR_centroids[3*r+2] = centroids[r]->getZ();
+    }
+    appendTrackFileSection(SECTION_FSR_CENTROIDS, &FSR_centroids[0],
+                           3 * num_FSRs * sizeof(double), num_FSRs);
+  }
 
   /* Set the centroid for the FSR */
   for (long r=0; r < num_FSRs; r++)
     _geometry->setFSRCentroid(r, centroids[r]);
 
   /* Recenter the segments around FSR centroid */
-  if ((_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D)
-      && _segments_centered == false) {
+  if ((_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D
+       || _segment_formation == HYBRID_STACKS) && _segments_centered == false) {
     log_printf(NORMAL, "Centering segments around FSR centroid...");
     RecenterSegments rs(this);
     rs.execute();
@@ -1676,6 +2229,37 @@ void TrackGenerator::setDumpSegments(bool dump_segments) {
 }
 
 
+/**
+ * @brief Sets whether the startup data of on-the-fly ray tracing is cached
+ *        in a Track file.
+ * @details The 2D segments and extruded FSRs found by on-the-fly ray tracing,
+ *          and later the FSR volumes and centroids, are then written to a
+ *          Track file of the Track file directory. Later runs with the same
+ *          Geometry and ray tracing parameters start from this file instead
+ *          of ray tracing again. The cache is not written by default, and its
+ *          size may be bounded with setMaxTrackCacheSize(...).
+ * @param cache_OTF_startup whether to cache the startup data in a Track file
+ */
+void TrackGenerator::setCacheOTFStartup(bool cache_OTF_startup) {
+  _cache_OTF_startup = cache_OTF_startup;
+}
+
+
+/**
+ * @brief Sets the maximum size of all Track files in the Track file
+ *        directory.
+ * @details When a Track file is written, the least recently used Track
+ *          files are deleted until the directory is within this size.
+ * @param max_size the maximum size (MB), 0 for no maximum
+ */
+void TrackGenerator::setMaxTrackCacheSize(double max_size) {
+  if (max_size < 0.)
+    log_printf(ERROR, "Unable to set a negative maximum Track file "
+               "directory size %f MB", max_size);
+  _max_track_cache_size = max_size;
+}
+
+
 /**
  * @brief Resets the TrackGenerator to not contain tracks or segments
  */
@@ -23,6 +23,159 @@
 #include <sstream>
 #include <unistd.h>
 #include <omp.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+
+/** Version of the Track file format, incremented with every change to it */
+#define TRACK_FILE_VERSION 3
+
+/** Written natively to detect Track files of a different endianness */
+#define TRACK_FILE_ENDIANNESS 0x01020304
+
+/** Alignment (bytes) of the sections of a Track file */
+#define TRACK_FILE_ALIGNMENT 64
+
+
+/**
+ * @enum trackFileSection
+ * @brief The sections of a Track file.
+ */
+enum trackFileSection {
+
+  /** The IDs of the Materials referenced by index in the segments */
+  SECTION_MATERIALS,
+
+  /** The offsets of the segments of each Track, indexed by Track UID */
+  SECTION_SEGMENT_OFFSETS,
+
+  /** The segments of all Tracks, with the layout of the segment struct */
+  SECTION_SEGMENTS,
+
+  /** The key of each FSR, indexed by FSR ID */
+  SECTION_FSR_KEYS,
+
+  /** The characteristic point of each FSR */
+  SECTION_FSR_POINTS,
+
+  /** The Material ID of each FSR */
+  SECTION_FSR_MATERIALS,
+
+  /** The offsets of the FSRs of each CMFD cell */
+  SECTION_CMFD_OFFSETS,
+
+  /** The FSRs of all CMFD cells */
+  SECTION_CMFD_FSRS,
+
+  /** The extruded FSRs of on-the-fly ray tracing */
+  SECTION_EXTRUDED_FSRS,
+
+  /** The volume of each FSR, appended once computed */
+  SECTION_FSR_VOLUMES,
+
+  /** The centroid of each FSR, appended once computed */
+  SECTION_FSR_CENTROIDS,
+
+  /** The number of sections */
+  NUM_TRACK_FILE_SECTIONS
+};
+
+
+/**
+ * @struct TrackFileSection
+ * @brief The location of a section in a Track file.
+ */
+struct TrackFileSection {
+
+  /** The offset of the section from the start of the file (bytes) */
+  uint64_t _offset;
+
+  /** The size of the section (bytes) */
+  uint64_t _size;
+
+  /** The number of items in the section */
+  uint64_t _count;
+};
+
+
+/**
+ * @struct TrackFileHeader
+ * @brief The header at the start of a Track file.
+ * @details Track files are made of sections aligned in the file, so that
+ *          they can be memory mapped and their segments used in place.
+ */
+struct TrackFileHeader {
+
+  /** Identifies Track files */
+  char _magic[8];
+
+  /** The version of the file format */
+  uint32_t _version;
+
+  /** TRACK_FILE_ENDIANNESS as written by the machine writing the file */
+  uint32_t _endianness;
+
+  /** The size of the segment struct (bytes) */
+  uint32_t _segment_size;
+
+  /** The size of FP_PRECISION (bytes) */
+  uint32_t _precision_size;
+
+  /** The segmentation type the file was written for */
+  int32_t _segment_formation;
+
+  /** The hash of the Geometry and ray tracing parameters */
+  FSRKey _tracking_hash;
+
+  /** The number of sections */
+  uint32_t _num_sections;
+
+  /** The checksum of the contents of all sections */
+  uint64_t _checksum;
+
+  /** The size of the file (bytes) */
+  uint64_t _file_size;
+
+  /** The location of each section */
+  TrackFileSection _sections[NUM_TRACK_FILE_SECTIONS];
+};
+
+
+#ifndef SWIG
+/**
+ * @brief Computes the checksum of a block of a Track file.
+ * @details Each 8-byte word is mixed with its position in the file and the
+ *          results are summed, so that the blocks of a file can be
+ *          checksummed in any order and by any number of threads.
+ * @param data the block of data, starting at an 8-byte aligned position
+ * @param size the size of the block (bytes)
+ * @param position the position of the block in the file (bytes)
+ * @return the checksum of the block
+ */
+inline uint64_t trackFileChecksum(const char* data, uint64_t size,
+                                  uint64_t position) {
+
+  uint64_t checksum = 0;
+  uint64_t first_word = position / sizeof(uint64_t);
+  uint64_t num_words = size / sizeof(uint64_t);
+  for (uint64_t i=0; i < num_words; i++) {
+    uint64_t word;
+    memcpy(&word, data + i * sizeof(uint64_t), sizeof(uint64_t));
+    checksum += FSRKey::mix(word ^ ((first_word + i) * 0x9E3779B97F4A7C15ULL));
+  }
+
+  /* Pad the last word with zeros */
+  uint64_t remainder = size - num_words * sizeof(uint64_t);
+  if (remainder > 0) {
+    uint64_t word = 0;
+    memcpy(&word, data + num_words * sizeof(uint64_t), remainder);
+    checksum += FSRKey::mix(word ^ ((first_word + num_words)
+                                    * 0x9E3779B97F4A7C15ULL));
+  }
+
+  return checksum;
+}
 #endif
 
 
@@ -75,6 +228,25 @@ protected:
   /** Filename for the *.tracks input / output file */
   std::string _tracks_filename;
 
+  /** The memory mapped Track file whose segments are used in place, NULL
+   *  if no Track file is mapped */
+  char* _track_file_map;
+
+  /** The size of the memory mapped Track file (bytes) */
+  size_t _track_file_size;
+
+  /** The Material of each index used by the segments of the memory mapped
+   *  Track file */
+  std::vector<Material*> _track_file_materials;
+
+  /** The hash of the Geometry and ray tracing parameters identifying the
+   *  Track file */
+  FSRKey _tracking_hash;
+
+  /** The maximum size (MB) of all Track files in the Track file directory,
+   *  least recently used files being deleted beyond it, 0 if unbounded */
+  double _max_track_cache_size;
+
   /** OpenMP mutual exclusion locks for atomic FSR operations */
   omp_lock_t* _FSR_locks;
 
@@ -104,9 +276,16 @@ protected:
   /** Maximum number of track segmenets in a single Track */
   int _max_num_segments;
 
+  /** The number of times Tracks were generated, identifying the Tracks */
+  int _tracks_version;
+
   /** Boolean to indicate whether the segments should be dumped to file */
   bool _dump_segments;
 
+  /** Boolean to indicate whether the startup data of on-the-fly ray tracing
+   *  is cached in a Track file for later runs */
+  bool _cache_OTF_startup;
+
   /** Boolean to indicate whether the segments have been centered around their
    * centroid or not */
   bool _segments_centered;
@@ -129,13 +308,31 @@ protected:
   virtual void initializeTracks();
   void initializeTrackReflections();
   virtual void segmentize();
+  void renumberFSRs();
+  virtual void updateSegmentMaterials(Material** FSR_materials);
   virtual void setContainsSegments(bool contains_segments);
   virtual void allocateTemporarySegments();
   virtual void resetStatus();
   virtual void initializeDefaultQuadrature();
   virtual void writeExtrudedFSRInfo(FILE* out);
   virtual void readExtrudedFSRInfo(FILE* in);
+  FILE* openTrackFile(TrackFileHeader& header,
+                      std::map<int, int>& material_indexes);
+  void closeTrackFile(FILE* out, TrackFileHeader& header);
+  void writeTrackFileSection(FILE* out, TrackFileHeader& header,
+                             trackFileSection section, const void* data,
+                             uint64_t size, uint64_t count);
+  void writeTrackFileHeader(FILE* out, TrackFileHeader& header);
+  void appendTrackFileSection(trackFileSection section, const void* data,
+                              uint64_t size, uint64_t count);
+  const char* getMappedTrackFileSection(trackFileSection section,
+                                        uint64_t count);
+  bool checkTrackFile(TrackFileHeader* header);
+  bool mapTrackFile();
+  void unmapTrackFile();
   virtual std::string getTestFilename(std::string directory);
+  virtual void hashTrackingParameters(FSRKey& hash);
+  void evictTrackFiles();
 
 public:
 
@@ -150,13 +347,14 @@ public:
   virtual long getNumSegments();
   long getNum2DTracks();
   long getNum2DSegments();
-  void countSegments();
+  virtual void countSegments();
   bool getPeriodic();
   Track** get2DTracksArray();
   Track** getTracksArray();
   Track** get2DTracks();
   FP_PRECISION getMaxOpticalLength();
   int getMaxNumSegments();
+  int getTracksVersion();
   int getNumThreads();
   int getNumX(int azim);
   int getNumY(int azim);
@@ -172,6 +370,7 @@ public:
   segmentationType getSegmentFormation();
   virtual bool containsTracks();
   virtual bool containsSegments();
+  virtual bool streamsSegments();
   int get2DTrackID(int a, int x);
   long* getTracksPerAzim();
 
@@ -185,6 +384,8 @@ public:
   void setMaxOpticalLength(FP_PRECISION tau);
   void setMaxNumSegments(int max_num_segments);
   void setDumpSegments(bool dump_segments);
+  void setCacheOTFStartup(bool cache_OTF_startup);
+  void setMaxTrackCacheSize(double max_size);
 
   /* Worker functions */
   virtual void retrieveTrackCoords(double* coords, long num_tracks);
@@ -192,6 +393,7 @@ public:
   virtual void retrieveSegmentCoords(double* coords, long num_segments);
   void retrieve2DSegmentCoords(double* coords, long num_segments);
   void generateFSRCentroids(FP_PRECISION* FSR_volumes);
+  void updateFSRMaterials();
   void generateTracks();
   void splitSegments(FP_PRECISION max_optical_length);
   double leastCommonMultiple(double a, double b);
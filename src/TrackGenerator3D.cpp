@@ -1,5 +1,6 @@
 #include "TrackGenerator3D.h"
 #include "TrackTraversingAlgorithms.h"
+#include <sys/mman.h>
 
 
 /**
@@ -12,6 +13,21 @@ TrackGenerator3D::TrackGenerator3D(Geometry* geometry, int num_azim,
                                    int num_polar, double azim_spacing,
                                    double z_spacing) :
                     TrackGenerator(geometry, num_azim, azim_spacing) {
+  _max_segment_memory = 0.;
+  _stack_segments = NULL;
+  _num_stack_segments = NULL;
+  _num_stacks = 0;
+  _stored_segment_memory = 0.;
+  _stored_max_optical_length = 0.;
+  _pipeline_depth = 0;
+  _pipeline_slots = NULL;
+  _num_pipeline_slots = 0;
+  _pipeline_slot_size = 0;
+  _pipeline_stall_time = 0.;
+  _implicit_3D_tracks = false;
+  _mapped_implicit_segments = NULL;
+  _segment_window = 0.;
+  _streamed_segments = NULL;
   setNumPolar(num_polar);
   setDesiredZSpacing(z_spacing);
   _contains_3D_tracks = false;
@@ -109,6 +125,11 @@ TrackGenerator3D::~TrackGenerator3D() {
       }
     }
   }
+
+  clearPipelineSlots();
+
+  /* Delete explicit z-stack segments if they exist */
+  clearStackSegments();
 }
 
 
@@ -177,7 +198,9 @@ long TrackGenerator3D::getNum3DSegments() {
 
   /* Loop over all Tracks and count segments */
   long num_3D_segments = 0;
-  if (_segment_formation == EXPLICIT_3D) {
+  if (_segment_formation == EXPLICIT_3D && _implicit_3D_tracks)
+    num_3D_segments = _implicit_segment_offsets.back();
+  else if (_segment_formation == EXPLICIT_3D) {
     for (int a=0; a < _num_azim/2; a++) {
       for (int i=0; i < _num_x[a] + _num_y[a]; i++) {
         for (int p=0; p < _num_polar; p++) {
@@ -380,6 +403,9 @@ void TrackGenerator3D::setDesiredZSpacing(double spacing) {
  *          - EXPLICIT_3D: explicit 2D/3D segment formation
  *          - OTF_TRACKS: axial on-the-fly ray tracing by individual tracks
  *          - OTF_STACKS: axial on-the-fly ray tracing by entire z-stacks
+ *          - HYBRID_STACKS: axial on-the-fly ray tracing by entire z-stacks,
+ *            storing the explicit segments of the z-stacks most costly to
+ *            ray trace within the budget set by setMaxSegmentMemory(...)
  */
 void TrackGenerator3D::setSegmentFormation(segmentationType segmentation_type) {
   _segment_formation = segmentation_type;
@@ -457,11 +483,569 @@ void TrackGenerator3D::setSegmentationZones(std::vector<double> zones) {
  *          determine the axial cell. Alternatively, this function can be
  *          called which creates a global z-mesh from the geometry so that
  *          binary searches must only be conducted at the beginning of the
- *          track.
+ *          track. The global z-mesh is created when the extruded FSRs are
+ *          formed, or read with them from a Track file.
  */
 void TrackGenerator3D::useGlobalZMesh() {
   _contains_global_z_mesh = true;
-  _global_z_mesh = _geometry->getUniqueZHeights(true);
+  _global_z_mesh.clear();
+}
+
+
+/**
+ * @brief Sets the memory budget for explicit segments in hybrid ray tracing
+ * @details With HYBRID_STACKS segmentation, the explicit segments of the
+ *          z-stacks most costly to ray trace on-the-fly are stored, until
+ *          the budget is exhausted. All other z-stacks are ray traced
+ *          on-the-fly in every transport sweep.
+ * @param max_memory the memory budget for explicit segments (MB)
+ */
+void TrackGenerator3D::setMaxSegmentMemory(double max_memory) {
+  if (max_memory < 0)
+    log_printf(ERROR, "Unable to set a negative memory budget %f MB for "
+               "explicit segments", max_memory);
+  _max_segment_memory = max_memory;
+}
+
+
+/**
+ * @brief Sets the depth of pipelined on-the-fly ray tracing
+ * @details With a non-zero depth, threads of on-the-fly z-stack traversals
+ *          which form segments (such as transport sweeps) work in pairs: one
+ *          thread ray traces z-stacks into a ring buffer of depth slots
+ *          while the other applies the MOC equations to the z-stacks already
+ *          traced. Threads 2k and 2k+1 are paired, so consecutive OpenMP
+ *          threads should be bound to the SMT siblings of a core, which the
+ *          pair then shares. The pipeline is disabled by default, with a
+ *          depth of 0, and traversals fall back to the regular on-the-fly
+ *          ray tracing when the threads cannot all be paired.
+ * @param depth the number of z-stacks a tracing thread may run ahead
+ */
+void TrackGenerator3D::setPipelineDepth(int depth) {
+  if (depth < 0)
+    log_printf(ERROR, "Unable to set a negative pipeline depth %d", depth);
+  _pipeline_depth = depth;
+  if (_contains_temporary_segments)
+    allocatePipelineSlots();
+}
+
+
+/**
+ * @brief Returns the depth of pipelined on-the-fly ray tracing
+ * @return the number of z-stacks a tracing thread may run ahead, 0 if on-the-fly
+ *         ray tracing is not pipelined
+ */
+int TrackGenerator3D::getPipelineDepth() {
+  if (_pipeline_slots == NULL)
+    return 0;
+  return _pipeline_depth;
+}
+
+
+/**
+ * @brief Returns the ring buffer of a pair of pipelined threads
+ * @param pair_id the index of the pair of tracing and transport threads
+ * @return the _pipeline_depth slots of the pair
+ */
+PipelineSlot* TrackGenerator3D::getPipelineSlots(int pair_id) {
+  return &_pipeline_slots[pair_id * _pipeline_depth];
+}
+
+
+/**
+ * @brief Returns the time spent waiting on the pipeline
+ * @details Tracing threads wait when their ring buffer is full and transport
+ *          threads when it is empty. The time is summed over all threads and
+ *          all pipelined traversals.
+ * @return the pipeline stall time (s)
+ */
+double TrackGenerator3D::getPipelineStallTime() {
+  return _pipeline_stall_time;
+}
+
+
+/**
+ * @brief Adds the time a thread spent waiting on the pipeline
+ * @param stall_time the time to add (s)
+ */
+void TrackGenerator3D::addPipelineStallTime(double stall_time) {
+#pragma omp atomic update
+  _pipeline_stall_time += stall_time;
+}
+
+
+/**
+ * @brief Sets whether the 3D Tracks of explicit 3D ray tracing are implicit
+ * @details Explicit 3D ray tracing normally stores a Track3D object, with its
+ *          points, angles, indexes and linking Tracks, for every 3D Track.
+ *          With implicit 3D Tracks only the segments are stored, in a single
+ *          array indexed by an offset array over Track UIDs, and each 3D
+ *          Track is formed from its indexes when it is traversed, with
+ *          linking Tracks derived from the cyclic Track structure. This
+ *          must be set before Tracks are generated.
+ * @param implicit_tracks whether to form 3D Tracks from their indexes
+ */
+void TrackGenerator3D::setImplicit3DTracks(bool implicit_tracks) {
+  if (_contains_3D_tracks)
+    log_printf(ERROR, "Unable to change the 3D Track representation after "
+               "Tracks have been generated");
+  _implicit_3D_tracks = implicit_tracks;
+}
+
+
+/**
+ * @brief Streams the segments of explicit 3D ray tracing from the Track file
+ * @details The segments of all 3D Tracks are written to the Track file once
+ *          ray traced and are then no longer kept in memory. Traversals
+ *          stream the segments of each z-stack from the memory mapped file
+ *          into a buffer of the thread, relocating their Materials, centering
+ *          them around FSR centroids and splitting them as they are streamed.
+ *          The segments of the window which follows are prefetched and those
+ *          streamed are released, so that the memory used is bounded by the
+ *          window and the largest z-stack for each thread. This is meant for
+ *          segments exceeding the memory with a fast local disk for the Track
+ *          files, and implies implicit 3D Tracks. This must be set before
+ *          Tracks are generated.
+ * @param window_memory the memory (MB) of the window of the Track file each
+ *        thread prefetches, 0 to keep segments in memory
+ */
+void TrackGenerator3D::setSegmentStreamingWindow(double window_memory) {
+  if (window_memory < 0)
+    log_printf(ERROR, "Unable to set a negative segment streaming window %f "
+               "MB", window_memory);
+  if (window_memory > 0)
+    setImplicit3DTracks(true);
+  _segment_window = window_memory;
+}
+
+
+/**
+ * @brief Returns whether segments are streamed from the memory mapped Track
+ *        file rather than kept in memory.
+ * @return true if explicit 3D segments are streamed, false otherwise
+ */
+bool TrackGenerator3D::streamsSegments() {
+  return _streamed_segments != NULL;
+}
+
+
+/**
+ * @brief Streams the segments of a z-stack into the buffer of the thread
+ * @details The segments of the Tracks of a z-stack are contiguous in the
+ *          Track file, in the order of the Tracks in the z-stack.
+ * @param azim the azimuthal index of the z-stack
+ * @param xy the xy index of the z-stack
+ * @param polar the polar index of the z-stack
+ * @param track_offsets set to the offsets of the segments of each Track of
+ *        the z-stack in the buffer, with a final entry for their number
+ * @return the buffer holding the segments of the z-stack
+ */
+segment* TrackGenerator3D::streamStackSegments(int azim, int xy, int polar,
+                                               long*& track_offsets) {
+
+  int thread_id = omp_get_thread_num();
+  std::vector<segment>& buffer = _stream_buffers.at(thread_id);
+  std::vector<long>& offsets = _stream_offsets.at(thread_id);
+  buffer.clear();
+  offsets.assign(1, 0);
+
+  long first_track = _cum_tracks_per_stack[azim][xy][polar];
+  int num_tracks = _tracks_per_stack[azim][xy][polar];
+  long start = _implicit_segment_offsets[first_track];
+  long end = _implicit_segment_offsets[first_track + num_tracks];
+  segment* source = _streamed_segments;
+
+  /* Get the direction of travel */
+  double phi = _tracks_2D[azim][xy].getPhi();
+  double theta = _quadrature->getTheta(azim, polar);
+  double direction[3];
+  direction[0] = cos(phi) * sin(theta);
+  direction[1] = sin(phi) * sin(theta);
+  direction[2] = cos(theta);
+  bool centered = _segments_centered && _geometry->containsFSRCentroids();
+
+  for (int z=0; z < num_tracks; z++) {
+    for (long s=_implicit_segment_offsets[first_track + z];
+         s < _implicit_segment_offsets[first_track + z + 1]; s++) {
+      segment curr_segment = source[s];
+
+      /* Relocate the Material of the segment */
+      long material_index = (long) curr_segment._material;
+      if (!_streamed_FSR_materials.empty())
+        curr_segment._material =
+            _streamed_FSR_materials[curr_segment._region_id];
+      else if (material_index < 0)
+        curr_segment._material = NULL;
+      else
+        curr_segment._material = _track_file_materials[material_index];
+
+      /* Center the segment around the centroid of its FSR */
+      if (centered) {
+        Point* centroid = _geometry->getFSRCentroid(curr_segment._region_id);
+        curr_segment._starting_position[0] -= centroid->getX();
+        curr_segment._starting_position[1] -= centroid->getY();
+        curr_segment._starting_position[2] -= centroid->getZ();
+      }
+
+      /* Split the segment for the maximum optical length */
+      int num_cuts = SegmentSplitter::getNumCuts(&curr_segment,
+                                                 _max_optical_length);
+      size_t num_segments = buffer.size();
+      buffer.resize(num_segments + num_cuts);
+      SegmentSplitter::splitSegment(&curr_segment, num_cuts, direction,
+                                    &buffer[num_segments]);
+    }
+    offsets.push_back(buffer.size());
+  }
+  track_offsets = &offsets[0];
+
+  /* Prefetch the window of the Track file which follows when it was not
+   * prefetched by this thread yet */
+  long page_size = sysconf(_SC_PAGESIZE);
+  long num_window_segments = _segment_window * 1e6 / sizeof(segment);
+  long& prefetched = _stream_prefetched.at(thread_id);
+  if (end + num_window_segments / 2 > prefetched ||
+      start + num_window_segments < prefetched) {
+    long total = _implicit_segment_offsets.back();
+    prefetched = std::min(end + num_window_segments, total);
+    uintptr_t first = (uintptr_t) (source + end) / page_size * page_size;
+    uintptr_t last = (uintptr_t) (source + prefetched);
+    if (last > first)
+      madvise((void*) first, last - first, MADV_WILLNEED);
+  }
+
+  /* Release the pages holding only segments of the z-stack */
+  uintptr_t first = ((uintptr_t) (source + start) + page_size - 1)
+      / page_size * page_size;
+  uintptr_t last = (uintptr_t) (source + end) / page_size * page_size;
+  if (last > first)
+    madvise((void*) first, last - first, MADV_DONTNEED);
+
+  return &buffer[0];
+}
+
+
+/**
+ * @brief Allocates the buffers of each thread streaming segments
+ */
+void TrackGenerator3D::allocateStreamBuffers() {
+  int num_threads = std::max(_num_threads, omp_get_max_threads());
+  _stream_buffers.resize(num_threads);
+  _stream_offsets.resize(num_threads);
+  _stream_prefetched.assign(num_threads, 0);
+}
+
+
+/**
+ * @brief Returns whether the 3D Tracks of explicit 3D ray tracing are
+ *        formed from their indexes rather than stored
+ * @return true if 3D Tracks are implicit, false otherwise
+ */
+bool TrackGenerator3D::hasImplicit3DTracks() {
+  return _segment_formation == EXPLICIT_3D && _implicit_3D_tracks;
+}
+
+
+/**
+ * @brief Returns the segments of an implicit 3D Track
+ * @param track_id the UID of the 3D Track
+ * @param num_segments the number of segments of the 3D Track
+ * @return a pointer to the segments of the 3D Track, NULL if its segments
+ *         have not been generated
+ */
+segment* TrackGenerator3D::getImplicitSegments(long track_id,
+                                               int& num_segments) {
+  if (_streamed_segments != NULL)
+    log_printf(ERROR, "Unable to get the segments of 3D Track %ld since "
+               "segments are streamed by z-stack from the Track file",
+               track_id);
+  if (track_id + 1 >= (long) _implicit_segment_offsets.size()) {
+    num_segments = 0;
+    return NULL;
+  }
+  long offset = _implicit_segment_offsets[track_id];
+  num_segments = _implicit_segment_offsets[track_id + 1] - offset;
+  if (_mapped_implicit_segments != NULL)
+    return _mapped_implicit_segments + offset;
+  return &_implicit_segments[0] + offset;
+}
+
+
+/**
+ * @brief Uses the segments of all implicit 3D Tracks in place
+ * @details This is used for the segments of a memory mapped Track file,
+ *          which must remain mapped while the segments are used. If
+ *          segments are streamed, they are left in the file with Materials
+ *          referenced by index.
+ * @param offsets the offsets of the segments of each 3D Track, indexed by
+ *        Track UID, with a final entry for the total number of segments
+ * @param segments the segments of all 3D Tracks ordered by Track UID
+ */
+void TrackGenerator3D::mapImplicitSegments(long* offsets, segment* segments) {
+  clearImplicitSegments();
+  _implicit_segment_offsets.assign(offsets, offsets + getNum3DTracks() + 1);
+  if (_segment_window == 0) {
+    _mapped_implicit_segments = segments;
+    return;
+  }
+
+  _streamed_segments = segments;
+  allocateStreamBuffers();
+  log_printf(NORMAL, "Streaming %ld 3D segments (%.2f MB) from the Track file "
+             "with a %.2f MB window per thread",
+             _implicit_segment_offsets.back(),
+             _implicit_segment_offsets.back() * sizeof(segment) / 1e6,
+             _segment_window);
+}
+
+
+/**
+ * @brief Replaces the segments of all implicit 3D Tracks
+ * @details The contents of the provided vectors are swapped in, leaving the
+ *          vectors with the previous segments.
+ * @param offsets the offsets of the segments of each 3D Track, indexed by
+ *        Track UID, with a final entry for the total number of segments
+ * @param segments the segments of all 3D Tracks ordered by Track UID
+ */
+void TrackGenerator3D::setImplicitSegments(std::vector<long>& offsets,
+                                           std::vector<segment>& segments) {
+  _implicit_segment_offsets.swap(offsets);
+  _implicit_segments.swap(segments);
+  _mapped_implicit_segments = NULL;
+  _streamed_segments = NULL;
+}
+
+
+/**
+ * @brief Deletes the segments of implicit 3D Tracks
+ */
+void TrackGenerator3D::clearImplicitSegments() {
+  std::vector<long>().swap(_implicit_segment_offsets);
+  std::vector<segment>().swap(_implicit_segments);
+  _mapped_implicit_segments = NULL;
+  _streamed_segments = NULL;
+  _streamed_FSR_materials.clear();
+}
+
+
+/**
+ * @brief Returns the index of a z-stack in the hybrid ray tracing arrays
+ * @param azim the azimuthal index of the z-stack
+ * @param xy the 2D Track index of the z-stack
+ * @param polar the polar index of the z-stack
+ * @return the z-stack index
+ */
+long TrackGenerator3D::getStackID(int azim, int xy, int polar) {
+  return (long) _tracks_2D[azim][xy].getUid() * _num_polar + polar;
+}
+
+
+/**
+ * @brief Returns the explicit segments stored for a z-stack, if any
+ * @param stack_id the z-stack index, from TrackGenerator3D::getStackID(...)
+ * @param num_segments the number of segments stored for the z-stack
+ * @return the segments of all Tracks in the z-stack, NULL if the z-stack is
+ *         ray traced on-the-fly
+ */
+segment* TrackGenerator3D::getStackSegments(long stack_id, int& num_segments) {
+  if (_stack_segments == NULL) {
+    num_segments = 0;
+    return NULL;
+  }
+  num_segments = _num_stack_segments[stack_id];
+  return _stack_segments[stack_id];
+}
+
+
+/**
+ * @brief Stores a copy of the segments of a z-stack if the z-stack was
+ *        selected for explicit storage in hybrid ray tracing
+ * @param stack_id the z-stack index, from TrackGenerator3D::getStackID(...)
+ * @param segments the segments of all Tracks in the z-stack
+ * @param num_segments the number of segments in the z-stack
+ */
+void TrackGenerator3D::setStackSegments(long stack_id, segment* segments,
+                                        int num_segments) {
+  if (_num_stack_segments[stack_id] == 0 || _stack_segments[stack_id] != NULL)
+    return;
+  _stack_segments[stack_id] = new segment[num_segments];
+  std::copy(segments, segments + num_segments, _stack_segments[stack_id]);
+  _num_stack_segments[stack_id] = num_segments;
+}
+
+
+/**
+ * @brief Deletes the explicit z-stack segments of hybrid ray tracing
+ */
+void TrackGenerator3D::clearStackSegments() {
+
+  if (_stack_segments != NULL) {
+    for (long i=0; i < _num_stacks; i++)
+      delete [] _stack_segments[i];
+    delete [] _stack_segments;
+    delete [] _num_stack_segments;
+  }
+  _stack_segments = NULL;
+  _num_stack_segments = NULL;
+  _num_stacks = 0;
+}
+
+
+/**
+ * @brief Sets the Material of each explicit segment to that of its FSR,
+ *        including the segments of the z-stacks stored in hybrid ray tracing
+ *        and the segments streamed from the Track file.
+ * @param FSR_materials the Material of each FSR, indexed by FSR ID
+ */
+void TrackGenerator3D::updateSegmentMaterials(Material** FSR_materials) {
+
+  /* Streamed segments take the Materials of their FSRs when streamed */
+  if (streamsSegments()) {
+    _streamed_FSR_materials.assign(FSR_materials,
+                                   FSR_materials + _geometry->getNumFSRs());
+    return;
+  }
+
+  TrackGenerator::updateSegmentMaterials(FSR_materials);
+  if (_stack_segments == NULL)
+    return;
+
+#pragma omp parallel for schedule(guided)
+  for (long i=0; i < _num_stacks; i++) {
+    if (_stack_segments[i] == NULL)
+      continue;
+    for (int s=0; s < _num_stack_segments[i]; s++)
+      _stack_segments[i][s]._material =
+          FSR_materials[_stack_segments[i][s]._region_id];
+  }
+}
+
+
+/**
+ * @brief Checks whether the stored z-stack segments are those that would be
+ *        stored for the current maximum optical length
+ * @details Segments split for a larger maximum optical length remain the same
+ *          if none of them needs to be split for the current one.
+ * @return whether the stored segments can be kept
+ */
+bool TrackGenerator3D::storedSegmentsFit() {
+
+  if (_max_optical_length == _stored_max_optical_length)
+    return true;
+  if (_max_optical_length > _stored_max_optical_length)
+    return false;
+
+  int max_num_cuts = 1;
+#pragma omp parallel for schedule(guided) reduction(max:max_num_cuts)
+  for (long i=0; i < _num_stacks; i++) {
+    if (_stack_segments[i] == NULL)
+      continue;
+    for (int s=0; s < _num_stack_segments[i]; s++)
+      max_num_cuts = std::max(max_num_cuts, SegmentSplitter::getNumCuts(
+                              &_stack_segments[i][s], _max_optical_length));
+  }
+
+  return max_num_cuts == 1;
+}
+
+
+/**
+ * @brief Selects and stores the explicit segments of the z-stacks most costly
+ *        to ray trace on-the-fly within the memory budget
+ * @details The cost of ray tracing a z-stack on-the-fly is estimated as the
+ *          number of axial cells visited over the 2D segments of its
+ *          flattened Track, plus its number of 3D segments. z-stacks are
+ *          ranked by this cost per stored segment and stored in order until
+ *          the budget set by TrackGenerator3D::setMaxSegmentMemory(...) is
+ *          exhausted. The segments are kept as long as the Tracks and the
+ *          budget are unchanged and the maximum optical length does not split
+ *          them differently.
+ */
+void TrackGenerator3D::storeStackSegments() {
+
+  /* Keep the stored segments, counting the segments of the other z-stacks
+   * for the current maximum optical length */
+  if (_stack_segments != NULL &&
+      _stored_segment_memory == _max_segment_memory &&
+      storedSegmentsFit()) {
+    _stored_max_optical_length = _max_optical_length;
+    TrackGenerator::countSegments();
+    return;
+  }
+
+  clearStackSegments();
+  _num_stacks = getNum2DTracks() * _num_polar;
+  _stack_segments = new segment*[_num_stacks];
+  _num_stack_segments = new int[_num_stacks];
+  for (long i=0; i < _num_stacks; i++) {
+    _stack_segments[i] = NULL;
+    _num_stack_segments[i] = 0;
+  }
+
+  /* Count the segments of every z-stack */
+  SegmentCounter counter(this);
+  counter.countStackNumSegments(_num_stack_segments);
+  counter.execute();
+  allocateTemporarySegments();
+
+  /* Estimate the cost of ray tracing each z-stack on-the-fly */
+  std::vector<std::pair<double, long> > ranks(_num_stacks);
+  long num_segments = 0;
+  for (long t=0; t < getNum2DTracks(); t++) {
+
+    Track* flattened_track = _tracks_2D_array[t];
+    long num_axial_cells = 0;
+    for (int s=0; s < flattened_track->getNumSegments(); s++) {
+      if (_contains_global_z_mesh)
+        num_axial_cells += _global_z_mesh.size() - 1;
+      else {
+        int extruded_fsr_id = flattened_track->getSegment(s)->_region_id;
+        num_axial_cells += _geometry->getExtrudedFSR(extruded_fsr_id)
+                           ->_num_fsrs;
+      }
+    }
+
+    for (int p=0; p < _num_polar; p++) {
+      long stack_id = getStackID(flattened_track->getAzimIndex(),
+                                 flattened_track->getXYIndex(), p);
+      int num_stack_segments = _num_stack_segments[stack_id];
+      double cost = num_axial_cells + num_stack_segments;
+      ranks[stack_id].first = -cost / std::max(num_stack_segments, 1);
+      ranks[stack_id].second = stack_id;
+      num_segments += num_stack_segments;
+    }
+  }
+  std::sort(ranks.begin(), ranks.end());
+
+  /* Select the z-stacks to store within the memory budget */
+  long max_num_stored = _max_segment_memory * 1e6 / sizeof(segment);
+  long num_stored = 0;
+  long num_stored_stacks = 0;
+  for (long i=0; i < _num_stacks; i++) {
+    long stack_id = ranks[i].second;
+    if (num_stored + _num_stack_segments[stack_id] <= max_num_stored) {
+      num_stored += _num_stack_segments[stack_id];
+      num_stored_stacks++;
+    }
+    else
+      _num_stack_segments[stack_id] = 0;
+  }
+
+  /* Store the segments of the selected z-stacks, timing the sweep of fully
+   * on-the-fly ray tracing which stores them */
+  StoreSegments store_segments(this);
+  double start_time = omp_get_wtime();
+  store_segments.execute();
+  double otf_time = omp_get_wtime() - start_time;
+  _segments_centered = _geometry->containsFSRCentroids();
+  _stored_segment_memory = _max_segment_memory;
+  _stored_max_optical_length = _max_optical_length;
+
+  log_printf(NORMAL, "Stored explicit segments for %ld of %ld z-stacks, "
+             "%.1f%% of segments (%.2f MB) in a %.3f s on-the-fly sweep",
+             num_stored_stacks, _num_stacks,
+             100. * num_stored / std::max(num_segments, 1L),
+             num_stored * sizeof(segment) / 1e6, otf_time);
 }
 
 
@@ -477,7 +1061,7 @@ void TrackGenerator3D::useGlobalZMesh() {
  */
 void TrackGenerator3D::retrieveGlobalZMesh(double*& z_mesh,
                                            int& num_fsrs) {
-  if (_contains_global_z_mesh) {
+  if (_contains_global_z_mesh && !_global_z_mesh.empty()) {
     z_mesh = &_global_z_mesh[0];
     num_fsrs = _global_z_mesh.size() - 1;
   }
@@ -853,9 +1437,34 @@ void TrackGenerator3D::initializeTracks() {
   create3DTracksArrays();
 
   /* Save explicit Track data if necessary */
-  if (_segment_formation == EXPLICIT_3D)
+  if (_segment_formation == EXPLICIT_3D && !_implicit_3D_tracks) {
     getCycleTrackData(tcis, num_chains, true);
 
+    /* Set the UIDs of the 3D Tracks, also needed when their segments are
+     * read from a Track file, and their boundary conditions and linking
+     * Tracks as for on-the-fly ray tracing */
+    for (int a=0; a < _num_azim/2; a++) {
+#pragma omp parallel for
+      for (int i=0; i < _num_x[a] + _num_y[a]; i++) {
+        TrackStackIndexes tsi;
+        TrackChainIndexes tci;
+        tsi._azim = a;
+        tsi._xy = i;
+        for (int p=0; p < _num_polar; p++) {
+          tsi._polar = p;
+          for (int z=0; z < _tracks_per_stack[a][i][p]; z++) {
+            tsi._z = z;
+            Track3D* track_3D = &_tracks_3D[a][i][p][z];
+            track_3D->setUid(get3DTrackID(&tsi));
+            convertTSItoTCI(&tsi, &tci);
+            setLinkingTracks(&tsi, &tci, true, track_3D);
+            setLinkingTracks(&tsi, &tci, false, track_3D);
+          }
+        }
+      }
+    }
+  }
+
   /* Delete the array of chain track indexes */
   delete [] tcis;
 
@@ -867,7 +1476,8 @@ void TrackGenerator3D::initializeTracks() {
           _max_num_tracks_per_stack = _tracks_per_stack[a][i][p];
 
   /* Allocate temporary Tracks if necessary */
-  if (_segment_formation == OTF_STACKS)
+  if (_segment_formation == OTF_STACKS ||
+      _segment_formation == HYBRID_STACKS)
     allocateTemporaryTracks();
 
   log_printf(NORMAL, "3D Tracks in domain: %ld", getNum3DTracks());
@@ -1232,6 +1842,18 @@ void TrackGenerator3D::segmentizeExtruded() {
     _geometry->segmentizeExtruded(_tracks_2D_array[index], z_coords);
   }
 
+  /* Renumber extruded FSRs independently of the number of threads, the 3D
+   * FSRs are then numbered in the order of the extruded FSRs */
+  std::vector<long> id_mapping;
+  _geometry->renumberExtrudedFSRs(id_mapping);
+#pragma omp parallel for
+  for (int index=0; index < _num_2D_tracks; index++) {
+    Track* flattened_track = _tracks_2D_array[index];
+    segment* segments = flattened_track->getSegments();
+    for (int s=0; s < flattened_track->getNumSegments(); s++)
+      segments[s]._region_id = id_mapping[segments[s]._region_id];
+  }
+
   /* Initialize 3D FSRs and their associated vectors */
 #ifdef MPIx
   if (_geometry->isDomainDecomposed())
@@ -1242,6 +1864,8 @@ void TrackGenerator3D::segmentizeExtruded() {
   if (_geometry->isDomainDecomposed())
     MPI_Barrier(_geometry->getMPICart());
 #endif
+  if (_contains_global_z_mesh)
+    _global_z_mesh = _geometry->getUniqueZHeights(true);
   _geometry->initializeAxialFSRs(_global_z_mesh);
   _geometry->initializeFSRVectors();
   _contains_2D_segments = true;
@@ -1256,12 +1880,21 @@ void TrackGenerator3D::segmentizeExtruded() {
  */
 void TrackGenerator3D::segmentize() {
 
+  /* Allocate the LocalCoords reused by each thread for ray tracing */
+  _geometry->initializeThreadCoords();
+
   /* Check for on-the-fly methods */
   if (_segment_formation != EXPLICIT_3D) {
     segmentizeExtruded();
     return;
   }
 
+  /* Check for 3D Tracks formed from their indexes */
+  if (_implicit_3D_tracks) {
+    segmentizeImplicit();
+    return;
+  }
+
   log_printf(NORMAL, "Ray tracing for 3D track segmentation...");
 
   int tracks_segmented = 0;
@@ -1276,25 +1909,231 @@ void TrackGenerator3D::segmentize() {
 #pragma omp parallel for
     for (int i=0; i < _num_x[a] + _num_y[a]; i++) {
       for (int p=0; p < _num_polar; p++) {
-        for (int z=0; z < _tracks_per_stack[a][i][p]; z++){
+        for (int z=0; z < _tracks_per_stack[a][i][p]; z++)
           _geometry->segmentize3D(&_tracks_3D[a][i][p][z]);
+      }
+    }
+
+    for (int i=0; i < _num_x[a] + _num_y[a]; i++) {
+      for (int p=0; p < _num_polar; p++)
+        tracks_segmented += _tracks_per_stack[a][i][p];
+    }
+  }
+  renumberFSRs();
+  _geometry->initializeFSRVectors();
+  _contains_3D_segments = true;
+}
+
+
+/**
+ * @brief Generate segments for each implicit 3D Track across the Geometry.
+ * @details Each 3D Track is formed from its indexes and ray traced, its
+ *          segments are then copied into a single array ordered by Track UID.
+ *          Segments are gathered by azimuthal angle so that the peak memory
+ *          only exceeds the final array by the segments of one azimuthal
+ *          angle. If segments are streamed, the segments of each azimuthal
+ *          angle are instead written to the Track file as they are formed,
+ *          and their FSR IDs are renumbered in the file once all FSRs are
+ *          found, so that the segments never all reside in memory.
+ */
+void TrackGenerator3D::segmentizeImplicit() {
+
+  log_printf(NORMAL, "Ray tracing for implicit 3D track segmentation...");
+
+  long num_3D_tracks = getNum3DTracks();
+  long tracks_segmented = 0;
+  clearImplicitSegments();
+  _implicit_segment_offsets.resize(num_3D_tracks + 1, 0);
+  std::vector<std::vector<segment> > azim_segments(_num_azim/2);
+
+  /* Open the Track file to which segments are streamed, the segments
+   * section is located after the offsets of the segments of each Track */
+  bool stream = _segment_window > 0;
+  TrackFileHeader header;
+  std::map<int, int> material_indexes;
+  FILE* out = NULL;
+  uint64_t segments_offset = 0;
+  long num_streamed_segments = 0;
+  if (stream) {
+    if (!_dump_segments)
+      log_printf(ERROR, "Unable to stream segments from the Track file "
+                 "since Track files are not written");
+    out = openTrackFile(header, material_indexes);
+    writeTrackFileSection(out, header, SECTION_SEGMENT_OFFSETS, NULL,
+                          (num_3D_tracks + 1) * sizeof(long),
+                          num_3D_tracks + 1);
+    segments_offset = header._file_size;
+  }
+
+  /* Loop over all Tracks */
+  for (int a=0; a < _num_azim/2; a++) {
+
+    log_printf(NORMAL, "segmenting 3D tracks - Percent complete: %5.2f %%",
+               double(tracks_segmented) / num_3D_tracks * 100.0);
+
+    int num_xy = _num_x[a] + _num_y[a];
+    std::vector<std::vector<segment> > xy_segments(num_xy);
+
+#pragma omp parallel for
+    for (int i=0; i < num_xy; i++) {
+      Track3D track;
+      for (int p=0; p < _num_polar; p++) {
+        for (int z=0; z < _tracks_per_stack[a][i][p]; z++) {
           TrackStackIndexes tsi;
           tsi._azim = a;
           tsi._xy = i;
           tsi._polar = p;
           tsi._z = z;
-          _tracks_3D[a][i][p][z].setUid(get3DTrackID(&tsi));    
+          track.clearSegments();
+          getTrackOTF(&track, &tsi);
+          _geometry->segmentize3D(&track);
+
+          /* Record the number of segments, offsets are summed later */
+          int num_segments = track.getNumSegments();
+          _implicit_segment_offsets.at(track.getUid() + 1) = num_segments;
+          xy_segments.at(i).insert(xy_segments.at(i).end(),
+                                   track.getSegments(),
+                                   track.getSegments() + num_segments);
         }
       }
     }
 
-    for (int i=0; i < _num_x[a] + _num_y[a]; i++) {
-      for (int p=0; p < _num_polar; p++)
-        tracks_segmented += _tracks_per_stack[a][i][p];
+    /* Gather the segments of the azimuthal angle in Track UID order */
+    long num_azim_segments = 0;
+    for (int i=0; i < num_xy; i++)
+      num_azim_segments += xy_segments.at(i).size();
+    azim_segments.at(a).reserve(num_azim_segments);
+    for (int i=0; i < num_xy; i++) {
+      azim_segments.at(a).insert(azim_segments.at(a).end(),
+                                 xy_segments.at(i).begin(),
+                                 xy_segments.at(i).end());
+      std::vector<segment>().swap(xy_segments.at(i));
+    }
+
+    /* Write the segments of the azimuthal angle to the Track file, with
+     * Materials referenced by index */
+    if (stream) {
+      std::vector<segment>& segments = azim_segments.at(a);
+#pragma omp parallel for
+      for (long s=0; s < num_azim_segments; s++) {
+        long material_index = -1;
+        Material* material = segments[s]._material;
+        if (material != NULL)
+          material_index = material_indexes.find(material->getId())->second;
+        segments[s]._material = (Material*) material_index;
+      }
+      uint64_t size = num_azim_segments * sizeof(segment);
+      uint64_t position = segments_offset
+          + num_streamed_segments * sizeof(segment);
+      if (size > 0 && pwrite(fileno(out), &segments[0], size, position) !=
+          (ssize_t) size)
+        log_printf(ERROR, "Unable to write the segments of azimuthal angle "
+                   "%d to the Track file %s", a, _tracks_filename.c_str());
+      num_streamed_segments += num_azim_segments;
+      std::vector<segment>().swap(segments);
     }
+
+    tracks_segmented += _tracks_per_azim[a];
+  }
+
+  /* Convert the numbers of segments to offsets */
+  for (long t=0; t < num_3D_tracks; t++)
+    _implicit_segment_offsets.at(t + 1) += _implicit_segment_offsets.at(t);
+
+  if (stream) {
+    finishStreamedSegments(out, header, num_streamed_segments);
+    return;
+  }
+
+  /* Copy the segments into a single array */
+  _implicit_segments.reserve(_implicit_segment_offsets.back());
+  for (int a=0; a < _num_azim/2; a++) {
+    _implicit_segments.insert(_implicit_segments.end(),
+                              azim_segments.at(a).begin(),
+                              azim_segments.at(a).end());
+    std::vector<segment>().swap(azim_segments.at(a));
   }
+
+  double size_mb = (double) (_implicit_segments.size() * sizeof(segment)
+      + _implicit_segment_offsets.size() * sizeof(long)) / (double) 1e6;
+  log_printf(NORMAL, "Implicit 3D track segment storage = %6.2f MB",
+             size_mb);
+
+  renumberFSRs();
+  _geometry->initializeFSRVectors();
+  _contains_3D_segments = true;
+}
+
+
+/**
+ * @brief Completes the Track file to which implicit 3D segments were
+ *        streamed during ray tracing, and streams the segments from it.
+ * @details The FSRs are renumbered, and the FSR IDs of the segments in the
+ *          file are renumbered accordingly by windows of the size of the
+ *          streaming window. The offsets of the segments of each Track and
+ *          the FSR sections are then written, and the file is memory mapped.
+ * @param out the Track file, with the segments of all Tracks written
+ * @param header the header of the Track file
+ * @param num_segments the number of segments written to the file
+ */
+void TrackGenerator3D::finishStreamedSegments(FILE* out,
+                                              TrackFileHeader& header,
+                                              long num_segments) {
+
+  /* Write the offsets of the segments of each Track */
+  TrackFileSection& offsets_section =
+      header._sections[SECTION_SEGMENT_OFFSETS];
+  const char* offsets = (const char*) &_implicit_segment_offsets[0];
+  if (pwrite(fileno(out), offsets, offsets_section._size,
+             offsets_section._offset) != (ssize_t) offsets_section._size)
+    log_printf(ERROR, "Unable to write the segment offsets to the Track file "
+               "%s", _tracks_filename.c_str());
+  header._checksum += trackFileChecksum(offsets, offsets_section._size,
+                                        offsets_section._offset);
+  writeTrackFileSection(out, header, SECTION_SEGMENTS, NULL,
+                        num_segments * sizeof(segment), num_segments);
+
+  log_printf(NORMAL, "Implicit 3D track segment storage = %6.2f MB in the "
+             "Track file", num_segments * sizeof(segment) / 1e6);
+
+  /* Renumber the FSRs independently of the number of threads */
+  std::vector<long> id_mapping;
+  _geometry->renumberFSRs(id_mapping);
   _geometry->initializeFSRVectors();
   _contains_3D_segments = true;
+
+  /* Renumber the FSRs of the segments in the file, window by window */
+  uint64_t segments_offset = header._sections[SECTION_SEGMENTS]._offset;
+  long window_size = std::max(1L, (long) (_segment_window * 1e6
+                                          / sizeof(segment)));
+  std::vector<segment> window;
+  for (long first=0; first < num_segments; first += window_size) {
+    long count = std::min(window_size, num_segments - first);
+    uint64_t size = count * sizeof(segment);
+    uint64_t position = segments_offset + first * sizeof(segment);
+    window.resize(count);
+    char* data = (char*) &window[0];
+    if (pread(fileno(out), data, size, position) != (ssize_t) size)
+      log_printf(ERROR, "Unable to read back the segments of the Track file "
+                 "%s", _tracks_filename.c_str());
+    if (!id_mapping.empty()) {
+#pragma omp parallel for
+      for (long s=0; s < count; s++)
+        window[s]._region_id = id_mapping[window[s]._region_id];
+      if (pwrite(fileno(out), data, size, position) != (ssize_t) size)
+        log_printf(ERROR, "Unable to write the segments of the Track file "
+                   "%s", _tracks_filename.c_str());
+    }
+    header._checksum += trackFileChecksum(data, size, position);
+  }
+  std::vector<segment>().swap(window);
+
+  /* Write the FSR sections and stream the segments from the Track file */
+  closeTrackFile(out, header);
+  clearImplicitSegments();
+  if (!mapTrackFile())
+    log_printf(ERROR, "Unable to map the Track file %s to stream segments",
+               _tracks_filename.c_str());
 }
 
 
@@ -1374,7 +2213,7 @@ void TrackGenerator3D::create3DTracksArrays() {
 
   log_printf(NORMAL, "Total number of Tracks = %ld", num_tracks);
 
-  if (_segment_formation == EXPLICIT_3D) {
+  if (_segment_formation == EXPLICIT_3D && !_implicit_3D_tracks) {
     _tracks_3D = new Track3D***[_num_azim/2];
     for (int a=0; a < _num_azim/2; a++) {
       _tracks_3D[a] = new Track3D**[_num_x[a] + _num_y[a]];
@@ -1425,62 +2264,40 @@ void TrackGenerator3D::initializeDefaultQuadrature() {
 
 /**
  * @brief Returns the filename for writing tracking data
+ * @details The filename is formed from the hash of the Geometry and ray
+ *          tracing parameters.
  */
 std::string TrackGenerator3D::getTestFilename(std::string directory) {
 
   std::stringstream test_filename;
-
-  /* Get the quadrature and track method types */
-  std::string quad_type;
-  std::string track_method;
-
-  if (_quadrature->getQuadratureType() == EQUAL_WEIGHT)
-    quad_type = "EQ_WGT";
-  else if (_quadrature->getQuadratureType() == EQUAL_ANGLE)
-    quad_type = "EQ_ANG";
-  if (_quadrature->getQuadratureType() == TABUCHI_YAMAMOTO)
-    quad_type = "TABUCHI_YAMAMOTO";
-  else if (_quadrature->getQuadratureType() == LEONARD)
-    quad_type = "LEONARD";
-  else if (_quadrature->getQuadratureType() == GAUSS_LEGENDRE)
-    quad_type = "GAUSS_LEGENDRE";
-
-  if (_geometry->getCmfd() != NULL)
-    test_filename << directory << "/3D_"
-                  << _num_azim << "_azim_"
-                  << _num_polar << "_polar_"
-                  << _azim_spacing << "x" << _z_spacing
-                  << "_cm_spacing_cmfd_"
-                  << _geometry->getCmfd()->getNumX()
-                  << "x" << _geometry->getCmfd()->getNumY()
-                  << "x" << _geometry->getCmfd()->getNumZ()
-                  << "_quad_" << quad_type << "_track_" << track_method;
-  else
-    test_filename << directory << "/3D_"
-                  << _num_azim << "_azim_"
-                  << _num_polar << "_polar_"
-                  << _azim_spacing << "x" << _z_spacing
-                  << "_cm_spacing_quad_"
-                  << quad_type << "_track_" << track_method;
-
-  if (_geometry->isDomainDecomposed()) {
-    test_filename << "_dd";
-    struct stat st;
-    if (!(stat(test_filename.str().c_str(), &st) == 0))
-      mkdir(test_filename.str().c_str(), S_IRWXU);
-    int indexes[3];
-    _geometry->getDomainIndexes(indexes);
-    test_filename << "/domain";
-    for (int i=0; i<3; i++)
-      test_filename << "_" << indexes[i];
-  }
-
-  test_filename << ".data";
+  test_filename << directory << "/3D_" << _tracking_hash.toString()
+                << ".data";
 
   return test_filename.str();
 }
 
 
+/**
+ * @brief Hashes the Geometry and all parameters determining the Tracks and
+ *        segments, including the 3D ray tracing parameters.
+ * @details Explicit and implicit 3D Tracks share their Track files.
+ * @param hash the hash to update
+ */
+void TrackGenerator3D::hashTrackingParameters(FSRKey& hash) {
+
+  TrackGenerator::hashTrackingParameters(hash);
+
+  hash.append(_num_polar);
+  hash.appendDouble(_z_spacing);
+
+  /* Hash the axial meshes of on-the-fly ray tracing */
+  hash.append(_segmentation_heights.size());
+  for (size_t i=0; i < _segmentation_heights.size(); i++)
+    hash.appendDouble(_segmentation_heights[i]);
+  hash.append(_contains_global_z_mesh);
+}
+
+
 /**
  * @brief Updates whether the TrackGenerator contains segments
  * @param contains_segments whether the TrackGenerator contains segments
@@ -1565,6 +2382,60 @@ void TrackGenerator3D::allocateTemporarySegments() {
   /* Allocate new temporary segments */
   for (int t = 0; t < _num_threads; t++)
     _temporary_segments.at(t) = new segment[_num_seg_matrix_columns];
+
+  /* Widen the segment buffers of pipelined ray tracing */
+  allocatePipelineSlots();
+}
+
+
+/**
+ * @brief Allocates the ring buffers of pipelined on-the-fly ray tracing
+ * @details Each pair of threads shares _pipeline_depth slots, each holding
+ *          the segments of a full z-stack. Buffers are only reallocated if
+ *          the number of slots or the maximum number of segments changed.
+ */
+void TrackGenerator3D::allocatePipelineSlots() {
+
+  int num_slots = (_num_threads / 2) * _pipeline_depth;
+  if (num_slots == _num_pipeline_slots &&
+      _num_seg_matrix_columns == _pipeline_slot_size)
+    return;
+
+  clearPipelineSlots();
+  if (num_slots == 0 || _num_seg_matrix_columns == 0)
+    return;
+
+  if (_num_threads % 2 != 0)
+    log_printf(WARNING, "Unable to pair all %d threads for pipelined ray "
+               "tracing, which falls back to regular on-the-fly ray tracing",
+               _num_threads);
+
+  double size_mb = (double) (num_slots * _num_seg_matrix_columns
+        * sizeof(segment)) / (double) 1e6;
+  log_printf(NORMAL, "Pipeline segment storage per domain = %6.2f MB",
+             size_mb);
+
+  _pipeline_slots = new PipelineSlot[num_slots];
+  for (int i=0; i < num_slots; i++)
+    _pipeline_slots[i]._buffer = new segment[_num_seg_matrix_columns];
+  _num_pipeline_slots = num_slots;
+  _pipeline_slot_size = _num_seg_matrix_columns;
+}
+
+
+/**
+ * @brief Deletes the ring buffers of pipelined on-the-fly ray tracing
+ */
+void TrackGenerator3D::clearPipelineSlots() {
+
+  if (_pipeline_slots != NULL) {
+    for (int i=0; i < _num_pipeline_slots; i++)
+      delete [] _pipeline_slots[i]._buffer;
+    delete [] _pipeline_slots;
+  }
+  _pipeline_slots = NULL;
+  _num_pipeline_slots = 0;
+  _pipeline_slot_size = 0;
 }
 
 
@@ -1609,6 +2480,22 @@ void TrackGenerator3D::resetStatus() {
   TrackGenerator::resetStatus();
   _contains_3D_tracks = false;
   _contains_3D_segments = false;
+  clearStackSegments();
+  clearImplicitSegments();
+}
+
+
+/**
+ * @brief Counts the number of segments for each Track in the Geometry
+ * @details With hybrid ray tracing, the explicit segments of the selected
+ *          z-stacks are also stored, so that they are split according to the
+ *          current maximum optical path length.
+ */
+void TrackGenerator3D::countSegments() {
+  if (_segment_formation == HYBRID_STACKS)
+    storeStackSegments();
+  else
+    TrackGenerator::countSegments();
 }
 
 
@@ -1652,7 +2539,7 @@ void TrackGenerator3D::getTrackOTF(Track3D* track, TrackStackIndexes* tsi) {
     convertTSItoTCI(tsi, &tci);
 
     /* Set the start and end points */
-    if (_segment_formation == EXPLICIT_3D) {
+    if (_segment_formation == EXPLICIT_3D && !_implicit_3D_tracks) {
       Track3D* track_3D =
         &_tracks_3D[tsi->_azim][tsi->_xy][tsi->_polar][tsi->_z];
       Point* start_3d_1 = track_3D->getStart();
@@ -2370,14 +3257,10 @@ void TrackGenerator3D::getTSIByIndex(long id, TrackStackIndexes* tsi) {
  */
 void TrackGenerator3D::writeExtrudedFSRInfo(FILE* out) {
 
-  /* Module to write track info */
-  DumpSegments dump_segments(this);
-  dump_segments.setOutputFile(out);
-
   /* Write extruded FSR data */
-    ParallelHashMap<std::string, ExtrudedFSR*>& extruded_FSR_keys_map =
+    ConcurrentHashMap<FSRKey, ExtrudedFSR*>& extruded_FSR_keys_map =
         _geometry->getExtrudedFSRKeysMap();
-    std::string* extruded_fsr_key_list = extruded_FSR_keys_map.keys();
+    FSRKey* extruded_fsr_key_list = extruded_FSR_keys_map.keys();
     ExtrudedFSR** extruded_fsr_list = extruded_FSR_keys_map.values();
     
     /* Write number of extruded FSRs */
@@ -2387,10 +3270,9 @@ void TrackGenerator3D::writeExtrudedFSRInfo(FILE* out) {
     /* Write extruded FSR data */
     for (int i=0; i < num_extruded_FSRs; i++) {
       
-      std::string key = extruded_fsr_key_list[i];
-      int string_length = key.length() + 1;
-      fwrite(&string_length, sizeof(int), 1, out);
-      fwrite(key.c_str(), sizeof(char)*string_length, 1, out);
+      FSRKey key = extruded_fsr_key_list[i];
+      fwrite(&key._hi, sizeof(long), 1, out);
+      fwrite(&key._lo, sizeof(long), 1, out);
 
       ExtrudedFSR* extruded_fsr = extruded_fsr_list[i];
       
@@ -2406,14 +3288,19 @@ void TrackGenerator3D::writeExtrudedFSRInfo(FILE* out) {
       
       int num_fsrs = extruded_fsr->_num_fsrs;
       fwrite(&num_fsrs, sizeof(int), 1, out);
+
+      /* Extruded FSRs have no mesh of their own with a global z-mesh */
+      double* mesh = extruded_fsr->_mesh;
+      if (mesh == NULL)
+        mesh = &_global_z_mesh[0];
      
-      double init_mesh_val = extruded_fsr->_mesh[0];
+      double init_mesh_val = mesh[0];
       fwrite(&init_mesh_val, sizeof(double), 1, out);
       
       for (int j=0; j < num_fsrs; j++) {
         long fsr_id = extruded_fsr->_fsr_ids[j];
         fwrite(&fsr_id, sizeof(long), 1, out);
-        double mesh_val = extruded_fsr->_mesh[j+1];
+        double mesh_val = mesh[j+1];
         fwrite(&mesh_val, sizeof(double), 1, out);
       }
     }
@@ -2422,17 +3309,14 @@ void TrackGenerator3D::writeExtrudedFSRInfo(FILE* out) {
     delete [] extruded_fsr_key_list;
     delete [] extruded_fsr_list;
 
-    /* Record 2D track info */
-    int num_2D_tracks = getNum2DTracks();
-    fwrite(&num_2D_tracks, sizeof(int), 1, out);
-    for (int i=0; i < num_2D_tracks; i++) {
-      Track* track = _tracks_2D_array[i];
-      segment* segments = track->getSegments();
-      dump_segments.onTrack(track, segments);
-    }
-
     /* Record maximum number of segments */
     fwrite(&_max_num_segments, sizeof(int), 1, out);
+
+    /* Write the global z-mesh */
+    int num_z_mesh = _global_z_mesh.size();
+    fwrite(&num_z_mesh, sizeof(int), 1, out);
+    if (num_z_mesh > 0)
+      fwrite(&_global_z_mesh[0], sizeof(double), num_z_mesh, out);
 }
 
 
@@ -2441,13 +3325,9 @@ void TrackGenerator3D::writeExtrudedFSRInfo(FILE* out) {
  * @param in file to read from
  */
 void TrackGenerator3D::readExtrudedFSRInfo(FILE* in) {
-  
-  /* Module to read track info */
-  ReadSegments read_segments(this);
-  read_segments.setInputFile(in);
 
     /* Read number of extruded FSRs */
-    ParallelHashMap<std::string, ExtrudedFSR*>& extruded_FSR_keys_map =
+    ConcurrentHashMap<FSRKey, ExtrudedFSR*>& extruded_FSR_keys_map =
         _geometry->getExtrudedFSRKeysMap();
     int num_extruded_FSRs;
     int ret = _geometry->twiddleRead(&num_extruded_FSRs, sizeof(int), 1, in);
@@ -2462,12 +3342,9 @@ void TrackGenerator3D::readExtrudedFSRInfo(FILE* in) {
     for (int i=0; i < num_extruded_FSRs; i++) {
       
       /* Read the extruded FSR key */
-      int string_length;
-      ret = _geometry->twiddleRead(&string_length, sizeof(int), 1, in);
-      char* char_buffer2 = new char[string_length];
-      ret = _geometry->twiddleRead(char_buffer2, sizeof(char)*string_length, 1,
-                                   in);
-      std::string key = std::string(char_buffer2);    
+      FSRKey key;
+      ret = _geometry->twiddleRead((long*) &key._hi, sizeof(long), 1, in);
+      ret = _geometry->twiddleRead((long*) &key._lo, sizeof(long), 1, in);
 
       /* Create new extruded FSR and add to map */
       ExtrudedFSR* extruded_fsr = new ExtrudedFSR;
@@ -2493,12 +3370,12 @@ void TrackGenerator3D::readExtrudedFSRInfo(FILE* in) {
       extruded_fsr->_num_fsrs = num_fsrs;
       extruded_fsr->_materials = new Material*[num_fsrs];
       extruded_fsr->_fsr_ids = new long[num_fsrs];
-      extruded_fsr->_mesh = new double[num_fsrs+1];
+      std::vector<double> mesh(num_fsrs+1);
 
       /* Read the mesh values and FSR IDs */
       double init_mesh_val;
       ret = _geometry->twiddleRead(&init_mesh_val, sizeof(double), 1, in);
-      extruded_fsr->_mesh[0] = init_mesh_val;
+      mesh[0] = init_mesh_val;
 
       for (int j=0; j < num_fsrs; j++) {
         long fsr_id;
@@ -2507,25 +3384,34 @@ void TrackGenerator3D::readExtrudedFSRInfo(FILE* in) {
         ret = _geometry->twiddleRead(&mesh_val, sizeof(double), 1, in);
         extruded_fsr->_fsr_ids[j] = fsr_id;
         extruded_fsr->_materials[j] = _geometry->findFSRMaterial(fsr_id);
-        extruded_fsr->_mesh[j+1] = mesh_val;
+        mesh[j+1] = mesh_val;
+      }
+
+      /* Extruded FSRs have no mesh of their own with a global z-mesh */
+      if (!_contains_global_z_mesh) {
+        extruded_fsr->_mesh = new double[num_fsrs+1];
+        std::copy(mesh.begin(), mesh.end(), extruded_fsr->_mesh);
+        extruded_fsr->_mesh_lookup.initialize(extruded_fsr->_mesh, num_fsrs);
       }
 
       /* Setup reverse lookup */
       extruded_FSR_lookup[extruded_fsr_id] = extruded_fsr;
     }
 
-    /* Record 2D track info */
-    int num_2D_tracks;
-    ret = _geometry->twiddleRead(&num_2D_tracks, sizeof(int), 1, in);
-    for (int i=0; i < num_2D_tracks; i++) {
-      Track* track = _tracks_2D_array[i];
-      read_segments.onTrack(track, NULL);
-    }
+    /* The segments of the 2D Tracks are read with the other segments */
     _contains_2D_segments = true;
 
     /* Record maximum number of segments */
     ret = _geometry->twiddleRead(&_max_num_segments, sizeof(int), 1, in);
 
+    /* Read the global z-mesh */
+    int num_z_mesh;
+    ret = _geometry->twiddleRead(&num_z_mesh, sizeof(int), 1, in);
+    _global_z_mesh.resize(num_z_mesh);
+    if (num_z_mesh > 0)
+      ret = _geometry->twiddleRead(&_global_z_mesh[0], sizeof(double),
+                                   num_z_mesh, in);
+
     /* Allocate temporary segments */
     allocateTemporarySegments();
 }
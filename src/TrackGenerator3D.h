@@ -75,6 +75,45 @@ struct TrackStackIndexes {
 };
 
 
+/**
+ * @struct PipelineSlot
+ * @brief A slot of the ring buffer through which a tracing thread hands the
+ *        segments of a z-stack to a transport thread in pipelined on-the-fly
+ *        ray tracing.
+ */
+struct PipelineSlot {
+
+  /** The segment buffer owned by the slot */
+  segment* _buffer;
+
+  /** The segments of the z-stack, either the buffer or stored segments */
+  segment* _segments;
+
+  /** The index of the flattened 2D Track of the z-stack, -1 to signal that
+   *  the tracing thread is done */
+  long _ext_id;
+
+  /** The polar index of the z-stack */
+  int _polar;
+
+  /** The number of segments in the z-stack */
+  int _num_segments;
+
+  /** Whether the slot holds a z-stack to transport (1) or is free (0) */
+  volatile int _full;
+
+  /** Constructor initializes an empty slot */
+  PipelineSlot() {
+    _buffer = NULL;
+    _segments = NULL;
+    _ext_id = -1;
+    _polar = -1;
+    _num_segments = 0;
+    _full = 0;
+  }
+};
+
+
 /**
  * @class TrackGenerator3D TrackGenerator3D.h "src/TrackGenerator3D.h"
  * @brief The TrackGenerator3D is dedicated to generating and storing Tracks
@@ -150,6 +189,82 @@ private:
    *  computation */
   int _max_num_tracks_per_stack;
 
+  /** Memory budget (MB) for the explicit segments of z-stacks stored in
+   *  hybrid explicit/on-the-fly ray tracing */
+  double _max_segment_memory;
+
+  /** Explicit segments of each z-stack in hybrid ray tracing, NULL for the
+   *  z-stacks ray traced on-the-fly */
+  segment** _stack_segments;
+
+  /** Number of segments of each z-stack in hybrid ray tracing, zero for the
+   *  z-stacks not selected for explicit storage */
+  int* _num_stack_segments;
+
+  /** Number of z-stacks in the hybrid ray tracing arrays */
+  long _num_stacks;
+
+  /** Memory budget (MB) and maximum optical length the explicit segments of
+   *  the z-stacks were stored for */
+  double _stored_segment_memory;
+  FP_PRECISION _stored_max_optical_length;
+
+  /** Number of z-stacks each tracing thread may run ahead of its transport
+   *  thread in pipelined on-the-fly ray tracing, 0 if not pipelined */
+  int _pipeline_depth;
+
+  /** Ring buffers of z-stack segments, _pipeline_depth slots for each pair
+   *  of tracing and transport threads */
+  PipelineSlot* _pipeline_slots;
+
+  /** Number of slots in the pipeline ring buffers */
+  int _num_pipeline_slots;
+
+  /** Number of segments each pipeline slot can hold */
+  int _pipeline_slot_size;
+
+  /** Time (s) summed over threads spent waiting on the pipeline */
+  double _pipeline_stall_time;
+
+  /** Whether the 3D Tracks of explicit 3D ray tracing are formed from their
+   *  indexes when needed rather than stored */
+  bool _implicit_3D_tracks;
+
+  /** Offsets of the segments of each 3D Track in _implicit_segments, indexed
+   *  by Track UID, with a final entry for the total number of segments */
+  std::vector<long> _implicit_segment_offsets;
+
+  /** The segments of all 3D Tracks ordered by Track UID when 3D Tracks are
+   *  implicit */
+  std::vector<segment> _implicit_segments;
+
+  /** The segments of all 3D Tracks used in place from a memory mapped Track
+   *  file, NULL if the segments are stored in _implicit_segments */
+  segment* _mapped_implicit_segments;
+
+  /** Memory (MB) of the window of the Track file each thread prefetches when
+   *  streaming explicit 3D segments, 0 if segments are kept in memory */
+  double _segment_window;
+
+  /** The segments of all 3D Tracks in a memory mapped Track file, which
+   *  reference Materials by index, NULL if segments are not streamed from
+   *  the file */
+  segment* _streamed_segments;
+
+  /** The Material of each FSR, which the streamed segments take instead of
+   *  the Materials in the Track file once Cells were filled again */
+  std::vector<Material*> _streamed_FSR_materials;
+
+  /** The segments of the z-stack each thread last streamed */
+  std::vector<std::vector<segment> > _stream_buffers;
+
+  /** The offsets of the segments of each Track in the streamed z-stack of
+   *  each thread */
+  std::vector<std::vector<long> > _stream_offsets;
+
+  /** The end of the range of segments each thread last prefetched */
+  std::vector<long> _stream_prefetched;
+
   /** Booleans to indicate whether the Tracks and segments have been generated
    *  (true) or not (false) */
   bool _contains_3D_tracks;
@@ -168,6 +283,7 @@ private:
   void resetStatus();
   void initializeDefaultQuadrature();
   std::string getTestFilename(std::string directory);
+  void hashTrackingParameters(FSRKey& hash);
   void getCycleTrackData(TrackChainIndexes* tcis, int num_cycles,
                          bool save_tracks);
 
@@ -180,6 +296,18 @@ private:
   void writeExtrudedFSRInfo(FILE* out);
   void readExtrudedFSRInfo(FILE* in);
 
+  bool storedSegmentsFit();
+  void storeStackSegments();
+  void clearStackSegments();
+  void updateSegmentMaterials(Material** FSR_materials);
+  void allocatePipelineSlots();
+  void clearPipelineSlots();
+  void segmentizeImplicit();
+  void finishStreamedSegments(FILE* out, TrackFileHeader& header,
+                              long num_segments);
+  void clearImplicitSegments();
+  void allocateStreamBuffers();
+
 public:
 
   TrackGenerator3D(Geometry* geometry, int num_azim, int num_polar,
@@ -215,6 +343,17 @@ public:
   void getTSIByIndex(long id, TrackStackIndexes* tsi);
 
   void getTrackOTF(Track3D* track, TrackStackIndexes* tsi);
+  long getStackID(int azim, int xy, int polar);
+  segment* getStackSegments(long stack_id, int& num_segments);
+  int getPipelineDepth();
+  PipelineSlot* getPipelineSlots(int pair_id);
+  double getPipelineStallTime();
+  void addPipelineStallTime(double stall_time);
+  bool hasImplicit3DTracks();
+  segment* getImplicitSegments(long track_id, int& num_segments);
+  bool streamsSegments();
+  segment* streamStackSegments(int azim, int xy, int polar,
+                               long*& track_offsets);
 
   /* Set parameters */
   void setNumPolar(int num_polar);
@@ -225,6 +364,14 @@ public:
                         bool outgoing, Track3D* track);
   void setLinkIndex(TrackChainIndexes* tci, TrackStackIndexes* tsi);
   void useGlobalZMesh();
+  void setMaxSegmentMemory(double max_memory);
+  void setPipelineDepth(int depth);
+  void setImplicit3DTracks(bool implicit_tracks);
+  void setSegmentStreamingWindow(double window_memory);
+  void mapImplicitSegments(long* offsets, segment* segments);
+  void setImplicitSegments(std::vector<long>& offsets,
+                           std::vector<segment>& segments);
+  void setStackSegments(long stack_id, segment* segments, int num_segments);
 
   /* Worker functions */
   void retrieveTrackCoords(double* coords, long num_tracks);
@@ -235,6 +382,7 @@ public:
   void retrieve3DSegmentCoords(double* coords, long num_segments);
   void create3DTracksArrays();
   void checkBoundaryConditions();
+  void countSegments();
 };
 
 #endif /* TRACKGENERATOR3D_H_ */
@@ -75,6 +75,7 @@ SegmentCounter::SegmentCounter(TrackGenerator* track_generator)
   _total_num_segments = 0;
   _count_total_segments = false;
   _total_segments_counted = false;
+  _stack_num_segments = NULL;
 }
 
 
@@ -105,6 +106,16 @@ void SegmentCounter::countTotalNumSegments() {
 }
 
 
+/**
+ * @brief Turn on counting the segments of each z-stack.
+ * @param stack_num_segments array filled with the number of segments of each
+ *        z-stack, indexed by TrackGenerator3D::getStackID(...)
+*/
+void SegmentCounter::countStackNumSegments(int* stack_num_segments) {
+  _stack_num_segments = stack_num_segments;
+}
+
+
 /**
  * @brief Get the total number of segments.
  * @return The total number of segments
@@ -133,6 +144,12 @@ void SegmentCounter::onTrack(Track* track, segment* segments) {
 #pragma omp atomic update
     _total_num_segments += track->getNumSegments();
   }
+  if (_stack_num_segments != NULL) {
+    Track3D* track_3D = dynamic_cast<Track3D*>(track);
+    long stack_id = _track_generator_3D->getStackID(track->getAzimIndex(),
+        track->getXYIndex(), track_3D->getPolarIndex());
+    _stack_num_segments[stack_id] = track->getNumSegments();
+  }
 }
 
 
@@ -143,18 +160,53 @@ void SegmentCounter::onTrack(Track* track, segment* segments) {
  */
 SegmentSplitter::SegmentSplitter(TrackGenerator* track_generator)
                                : TraverseSegments(track_generator) {
+  _counting = false;
 }
 
 
 /**
  * @brief Splits segments stored explicity along each Track
- * @details No MOCKernels are initialized for this function.
+ * @details No MOCKernels are initialized for this function. The segments of
+ *          implicit 3D Tracks are stored in a single array, so they are split
+ *          in two traversals: the first counts the split segments of each
+ *          Track and the second writes them to a new array.
  */
 void SegmentSplitter::execute() {
+
+  /* Segments streamed from the Track file are split as they are streamed */
+  if (_track_generator_3D != NULL && _track_generator_3D->streamsSegments())
+    return;
+
+  /* Split the segments stored in each Track */
+  if (_track_generator_3D == NULL ||
+      !_track_generator_3D->hasImplicit3DTracks()) {
+#pragma omp parallel
+    {
+      loopOverTracks(NULL);
+    }
+    return;
+  }
+
+  /* Count the split segments of each implicit 3D Track */
+  long num_3D_tracks = _track_generator_3D->getNum3DTracks();
+  _split_offsets.assign(num_3D_tracks + 1, 0);
+  _counting = true;
 #pragma omp parallel
   {
     loopOverTracks(NULL);
   }
+
+  /* Split the segments into a new array */
+  for (long t=0; t < num_3D_tracks; t++)
+    _split_offsets.at(t + 1) += _split_offsets.at(t);
+  _split_segments.resize(_split_offsets.back());
+  _counting = false;
+#pragma omp parallel
+  {
+    loopOverTracks(NULL);
+  }
+
+  _track_generator_3D->setImplicitSegments(_split_offsets, _split_segments);
 }
 
 
@@ -176,70 +228,51 @@ void SegmentSplitter::onTrack(Track* track, segment* segments) {
   Track3D* track_3D = dynamic_cast<Track3D*>(track);
   if (track_3D != 0)
     theta = track_3D->getTheta();
-  double xdir = cos(phi) * sin(theta);
-  double ydir = sin(phi) * sin(theta);
-  double zdir = cos(theta);
+  double direction[3];
+  direction[0] = cos(phi) * sin(theta);
+  direction[1] = sin(phi) * sin(theta);
+  direction[2] = cos(theta);
+
+  /* Split the segments of implicit 3D Tracks into the new array */
+  if (!_split_offsets.empty()) {
+    long track_id = track->getUid();
+    if (_counting) {
+      long num_split_segments = 0;
+      for (int s = 0; s < track->getNumSegments(); s++)
+        num_split_segments += getNumCuts(&segments[s], max_optical_length);
+      _split_offsets.at(track_id + 1) = num_split_segments;
+    }
+    else {
+      segment* split_segments = &_split_segments[_split_offsets[track_id]];
+      for (int s = 0; s < track->getNumSegments(); s++) {
+        int num_cuts = getNumCuts(&segments[s], max_optical_length);
+        splitSegment(&segments[s], num_cuts, direction, split_segments);
+        split_segments += num_cuts;
+      }
+    }
+    return;
+  }
 
   /* Extract data from this segment to compute its optical
    * length */
   for (int s = 0; s < track->getNumSegments(); s++) {
     segment* curr_segment = track->getSegment(s);
-    Material* material = curr_segment->_material;
-    double length = curr_segment->_length;
-    long fsr_id = curr_segment->_region_id;
 
     /* Compute number of segments to split this segment into */
-    int min_num_cuts = 1;
-    int num_groups = material->getNumEnergyGroups();
-    FP_PRECISION* sigma_t = material->getSigmaT();
-
-    for (int g=0; g < num_groups; g++) {
-      FP_PRECISION tau = length * sigma_t[g];
-      int num_cuts = ceil(tau / max_optical_length);
-      min_num_cuts = std::max(num_cuts, min_num_cuts);
-    }
+    int min_num_cuts = getNumCuts(curr_segment, max_optical_length);
 
     /* If the segment does not need subdivisions, go to next
      * segment */
     if (min_num_cuts == 1)
       continue;
 
-    /* Record the CMFD surfaces */
-    int cmfd_surface_fwd = curr_segment->_cmfd_surface_fwd;
-    int cmfd_surface_bwd = curr_segment->_cmfd_surface_bwd;
-
-    /* Extract the current starting points */
-    double x_curr = curr_segment->_starting_position[0];
-    double y_curr = curr_segment->_starting_position[1];
-    double z_curr = curr_segment->_starting_position[2];
-
     /* Split the segment into sub-segments */
-    for (int k=0; k < min_num_cuts; k++) {
-
-      /* Create a new Track segment */
-      segment* new_segment = new segment;
-      new_segment->_material = material;
-      new_segment->_length = length / min_num_cuts;
-      new_segment->_region_id = fsr_id;
-
-      /* Assign CMFD surface boundaries */
-      if (k == 0)
-        new_segment->_cmfd_surface_bwd = cmfd_surface_bwd;
-
-      if (k == min_num_cuts-1)
-        new_segment->_cmfd_surface_fwd = cmfd_surface_fwd;
-
-      /* Set the starting position */
-      new_segment->_starting_position[0] = x_curr;
-      new_segment->_starting_position[1] = y_curr;
-      new_segment->_starting_position[2] = z_curr;
-      x_curr += new_segment->_length * xdir;
-      y_curr += new_segment->_length * ydir;
-      z_curr += new_segment->_length * zdir;
-
-      /* Insert the new segment to the Track */
-      track->insertSegment(s+k+1, new_segment);
-    }
+    std::vector<segment> sub_segments(min_num_cuts);
+    splitSegment(curr_segment, min_num_cuts, direction, &sub_segments[0]);
+
+    /* Insert the new segments to the Track */
+    for (int k=0; k < min_num_cuts; k++)
+      track->insertSegment(s+k+1, &sub_segments[k]);
 
     /* Remove the original segment from the Track */
     track->removeSegment(s);
@@ -247,6 +280,82 @@ void SegmentSplitter::onTrack(Track* track, segment* segments) {
 }
 
 
+/**
+ * @brief Computes the number of segments a segment must be split into
+ * @param curr_segment the segment to split
+ * @param max_optical_length the maximum optical path length of a segment
+ * @return the number of sub-segments
+ */
+int SegmentSplitter::getNumCuts(segment* curr_segment,
+                                FP_PRECISION max_optical_length) {
+
+  Material* material = curr_segment->_material;
+  double length = curr_segment->_length;
+  int min_num_cuts = 1;
+  int num_groups = material->getNumEnergyGroups();
+  FP_PRECISION* sigma_t = material->getSigmaT();
+
+  for (int g=0; g < num_groups; g++) {
+    FP_PRECISION tau = length * sigma_t[g];
+    int num_cuts = ceil(tau / max_optical_length);
+    min_num_cuts = std::max(num_cuts, min_num_cuts);
+  }
+
+  return min_num_cuts;
+}
+
+
+/**
+ * @brief Splits a segment into sub-segments of equal length
+ * @details The first sub-segment keeps the backward CMFD surface and the last
+ *          sub-segment the forward CMFD surface of the segment. A segment
+ *          split into a single sub-segment is copied.
+ * @param curr_segment the segment to split
+ * @param num_cuts the number of sub-segments
+ * @param direction the unit vector of the direction of travel
+ * @param sub_segments the array of num_cuts sub-segments to fill
+ */
+void SegmentSplitter::splitSegment(segment* curr_segment, int num_cuts,
+                                   double* direction,
+                                   segment* sub_segments) {
+
+  if (num_cuts == 1) {
+    sub_segments[0] = *curr_segment;
+    return;
+  }
+
+  /* Extract the current starting points */
+  double x_curr = curr_segment->_starting_position[0];
+  double y_curr = curr_segment->_starting_position[1];
+  double z_curr = curr_segment->_starting_position[2];
+
+  for (int k=0; k < num_cuts; k++) {
+
+    /* Create a new Track segment */
+    segment* new_segment = &sub_segments[k];
+    *new_segment = segment();
+    new_segment->_material = curr_segment->_material;
+    new_segment->_length = curr_segment->_length / num_cuts;
+    new_segment->_region_id = curr_segment->_region_id;
+
+    /* Assign CMFD surface boundaries */
+    if (k == 0)
+      new_segment->_cmfd_surface_bwd = curr_segment->_cmfd_surface_bwd;
+
+    if (k == num_cuts-1)
+      new_segment->_cmfd_surface_fwd = curr_segment->_cmfd_surface_fwd;
+
+    /* Set the starting position */
+    new_segment->_starting_position[0] = x_curr;
+    new_segment->_starting_position[1] = y_curr;
+    new_segment->_starting_position[2] = z_curr;
+    x_curr += new_segment->_length * direction[0];
+    y_curr += new_segment->_length * direction[1];
+    z_curr += new_segment->_length * direction[2];
+  }
+}
+
+
 /**
  * @brief Constructor for SegmentSplitter calls the TraverseSegments
  *        constructor
@@ -374,7 +483,8 @@ void CentroidGenerator::onTrack(Track* track, segment* segments) {
     wgt *= _quadrature->getPolarSpacing(azim_index, polar_index)
         *_quadrature->getPolarWeight(azim_index, polar_index);
 
-    if (_segment_formation == OTF_STACKS) {
+    if (_segment_formation == OTF_STACKS ||
+        _segment_formation == HYBRID_STACKS) {
       int xy_index = track->getXYIndex();
       int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
       Track3D* current_stack = _track_generator_3D->getTemporary3DTracks(tid);
@@ -774,7 +884,8 @@ void LinearExpansionGenerator::onTrack(Track* track, segment* segments) {
 
   /* Determine progress */
   int max_track_index = 0;
-  if (_segment_formation == OTF_STACKS) {
+  if (_segment_formation == OTF_STACKS ||
+      _segment_formation == HYBRID_STACKS) {
     int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
     max_track_index = tracks_per_stack[azim_index][xy_index][polar_index] - 1;
   }
@@ -868,7 +979,8 @@ void TransportSweep::onTrack(Track* track, segment* segments) {
   /* Extract the maximum track index */
   Track** tracks_array = &track;
   int max_track_index = 0;
-  if (_segment_formation == OTF_STACKS) {
+  if (_segment_formation == OTF_STACKS ||
+      _segment_formation == HYBRID_STACKS) {
     int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
     max_track_index = tracks_per_stack[azim_index][xy_index][polar_index] - 1;
     tracks_array = _track_generator_3D->getTemporaryTracksArray(tid);
@@ -876,7 +988,7 @@ void TransportSweep::onTrack(Track* track, segment* segments) {
 
   /* Allocate a temporary flux buffer on the stack (free) and initialize it */
 #ifndef NGROUPS
-  int _num_groups = _track_generator->getGeometry()->getNumEnergyGroups();
+  int _num_groups = _cpu_solver->getNumEnergyGroups();
 #endif
   int num_polar = 1;
   if (track_3D == NULL)
@@ -996,175 +1108,196 @@ void TransportSweep::onTrack(Track* track, segment* segments) {
 DumpSegments::DumpSegments(TrackGenerator* track_generator)
                            : TraverseSegments(track_generator) {
   _out = NULL;
+  _section_offset = 0;
+  _segment_offsets = NULL;
+  _num_tracks = 0;
+  _material_indexes = NULL;
+  _counting = false;
+  _checksum = 0;
 }
 
 
 /**
- * @brief Writes all tracking information to file
- * @details SegmentationKernels are created to temporarily store segments for
- *          on-the-fly method. For each Track, onTrack(...) writes the tracking
- *          information to file.
+ * @brief Writes the segments of all Tracks which store segments to file
+ * @details The segments of each Track are written at the position given by
+ *          the segment offsets computed by countSegments(), so that Tracks
+ *          can be written by all threads in any order.
  */
 void DumpSegments::execute() {
-  MOCKernel* kernel = getKernel<SegmentationKernel>();
-  loopOverTracks(kernel);
+  _checksum = 0;
+#pragma omp parallel
+  {
+    loopOverStoredTracks();
+  }
+}
+
+
+/**
+ * @brief Computes the offsets of the segments of each Track in the segments
+ *        section of the Track file
+ * @details The number of segments of each Track is first recorded by Track
+ *          UID, then the offsets are formed by a prefix sum.
+ */
+void DumpSegments::countSegments() {
+
+  _counting = true;
+  _segment_offsets[0] = 0;
+#pragma omp parallel
+  {
+    loopOverStoredTracks();
+  }
+  _counting = false;
+
+  for (long t=0; t < _num_tracks; t++)
+    _segment_offsets[t+1] += _segment_offsets[t];
 }
 
 
 /**
  * @brief Sets the file which to write tracking information
  * @param out the file which to write tracking infmormation
+ * @param section_offset the offset of the segments section in the file
+ *        (bytes)
  */
-void DumpSegments::setOutputFile(FILE* out) {
+void DumpSegments::setOutputFile(FILE* out, uint64_t section_offset) {
   _out = out;
+  _section_offset = section_offset;
+}
+
+
+/**
+ * @brief Sets the array of segment offsets of each Track
+ * @param segment_offsets an array of the offsets of the segments of each
+ *        Track, indexed by Track UID, of length num_tracks + 1
+ * @param num_tracks the number of Tracks which store segments
+ */
+void DumpSegments::setSegmentOffsets(long* segment_offsets, long num_tracks) {
+  _segment_offsets = segment_offsets;
+  _num_tracks = num_tracks;
+}
+
+
+/**
+ * @brief Sets the index in the Track file of each Material
+ * @details Segments reference their Material by this index in the file.
+ * @param material_indexes a map of Material IDs to indexes
+ */
+void DumpSegments::setMaterialIndexes(std::map<int, int>* material_indexes) {
+  _material_indexes = material_indexes;
+}
+
+
+/**
+ * @brief Returns the checksum of the segments written to file
+ * @return the checksum of the segments section
+ */
+uint64_t DumpSegments::getChecksum() {
+  return _checksum;
 }
 
 
 /**
  * @brief Writes tracking information to file for a Track and associated
  *        segments
+ * @details The segments are written with the layout of the segment struct,
+ *          with the Material pointer replaced by the index of the Material
+ *          in the file.
  * @param track The Track whose information is written to file
  * @param segments The segments associated with the Track whose information is
  *        written to file
  */
 void DumpSegments::onTrack(Track* track, segment* segments) {
 
-  /* Write data for this Track to the Track file */
   int num_segments = track->getNumSegments();
-  fwrite(&num_segments, sizeof(int), 1, _out);
+  long uid = track->getUid();
 
-  /* Get CMFD mesh object */
-  Cmfd* cmfd = _track_generator->getGeometry()->getCmfd();
-
-  /* Loop over all segments for this Track */
-  for (int s=0; s < num_segments; s++) {
-
-    /* Get data for this segment */
-    segment* curr_segment = &segments[s];
-    FP_PRECISION length = curr_segment->_length;
-    int material_id;
-    if (curr_segment->_material != NULL)
-      material_id = curr_segment->_material->getId();
-    else
-      material_id = -1;
-    long region_id = curr_segment->_region_id;
-    int track_idx = curr_segment->_track_idx;
-    double start_x = curr_segment->_starting_position[0];
-    double start_y = curr_segment->_starting_position[1];
-    double start_z = curr_segment->_starting_position[2];
+  /* Record the number of segments of the Track */
+  if (_counting) {
+    _segment_offsets[uid+1] = num_segments;
+    return;
+  }
 
-    /* Write data for this segment to the Track file */
-    fwrite(&length, sizeof(double), 1, _out);
-    fwrite(&material_id, sizeof(int), 1, _out);
-    fwrite(&region_id, sizeof(long), 1, _out);
-    fwrite(&track_idx, sizeof(int), 1, _out);
-    fwrite(&start_x, sizeof(double), 1, _out);
-    fwrite(&start_y, sizeof(double), 1, _out);
-    fwrite(&start_z, sizeof(double), 1, _out);
+  if (num_segments == 0)
+    return;
 
-    /* Write CMFD-related data for the Track if needed */
-    if (cmfd != NULL) {
-      int cmfd_surface_fwd = curr_segment->_cmfd_surface_fwd;
-      int cmfd_surface_bwd = curr_segment->_cmfd_surface_bwd;
-      fwrite(&cmfd_surface_fwd, sizeof(int), 1, _out);
-      fwrite(&cmfd_surface_bwd, sizeof(int), 1, _out);
-    }
+  /* Replace Material pointers by Material indexes */
+  std::vector<segment> file_segments(segments, segments + num_segments);
+  for (int s=0; s < num_segments; s++) {
+    long material_index = -1;
+    Material* material = file_segments[s]._material;
+    if (material != NULL)
+      material_index = _material_indexes->find(material->getId())->second;
+    file_segments[s]._material = (Material*) material_index;
   }
+
+  /* Write the segments at their position in the segments section */
+  uint64_t size = num_segments * sizeof(segment);
+  uint64_t position = _section_offset + _segment_offsets[uid] * sizeof(segment);
+  char* data = (char*) &file_segments[0];
+  if (pwrite(fileno(_out), data, size, position) != (ssize_t) size)
+    log_printf(ERROR, "Unable to write the segments of Track %ld to the "
+               "Track file", uid);
+
+  uint64_t checksum = trackFileChecksum(data, size, position);
+#pragma omp atomic
+  _checksum += checksum;
 }
 
 
 /**
  * @brief Constructor for ReadSegments calls the TraverseSegments
- *        constructor and initializes the input FILE to NULL
+ *        constructor and initializes the segments to NULL
  * @param track_generator The TrackGenerator to pull tracking information from
  */
 ReadSegments::ReadSegments(TrackGenerator* track_generator)
                            : TraverseSegments(track_generator) {
-  _in = NULL;
+  _segment_offsets = NULL;
+  _segments = NULL;
 }
 
 
 /**
- * @brief Reads a tracking file and saves the information explicitly for every
- *        Track in the TrackGenerator.
- * @details The tracking file is set by setInputFile(...)
+ * @brief Makes all Tracks which store segments use their segments from a
+ *        memory mapped Track file in place.
+ * @details The segments are set by setSegments(...). Implicit 3D Tracks
+ *          directly use the offsets and segments of the file.
  */
 void ReadSegments::execute() {
-  loopOverTracks(NULL);
+
+  if (_track_generator_3D != NULL &&
+      _track_generator_3D->hasImplicit3DTracks()) {
+    _track_generator_3D->mapImplicitSegments(_segment_offsets, _segments);
+    return;
+  }
+
+#pragma omp parallel
+  {
+    loopOverStoredTracks();
+  }
 }
 
 
 /**
- * @brief Sets the input file to read in tracking information
- * @param in The input tracking file
+ * @brief Sets the segments of all Tracks read from a Track file
+ * @param segment_offsets the offsets of the segments of each Track, indexed
+ *        by Track UID
+ * @param segments the segments of all Tracks
  */
-void ReadSegments::setInputFile(FILE* input) {
-  _in = input;
+void ReadSegments::setSegments(long* segment_offsets, segment* segments) {
+  _segment_offsets = segment_offsets;
+  _segments = segments;
 }
 
 
 /**
- * @brief Saves tracking information to the corresponding Track explicity
- * @param track The track for which all tracking information is explicitly
- *        saved (including segments)
+ * @brief Makes a Track use its segments from the Track file in place
+ * @param track The Track whose segments are set
  * @param segments The segments associated with the Track
  */
 void ReadSegments::onTrack(Track* track, segment* segments) {
-
-  /* Get CMFD mesh object */
-  Geometry* geometry = _track_generator->getGeometry();
-  Cmfd* cmfd = geometry->getCmfd();
-  int ret;
-
-  /* Get materials map */
-  std::map<int, Material*> materials = geometry->getAllMaterials();
-
-  /* Import data for this Track from Track file */
-  int num_segments;
-  ret = geometry->twiddleRead(&num_segments, sizeof(int), 1, _in);
-
-  /* Loop over all segments in this Track */
-  for (int s=0; s < num_segments; s++) {
-
-    /* Import data for this segment from Track file */
-    double length;
-    ret = geometry->twiddleRead(&length, sizeof(double), 1, _in);
-    int material_id;
-    ret = geometry->twiddleRead(&material_id, sizeof(int), 1, _in);
-    long region_id;
-    ret = geometry->twiddleRead(&region_id, sizeof(long), 1, _in);
-    int  track_idx;
-    ret = geometry->twiddleRead(&track_idx, sizeof(int), 1, _in);
-    double start_x;
-    ret = geometry->twiddleRead(&start_x, sizeof(double), 1, _in);
-    double start_y;
-    ret = geometry->twiddleRead(&start_y, sizeof(double), 1, _in);
-    double start_z;
-    ret = geometry->twiddleRead(&start_z, sizeof(double), 1, _in);
-
-    /* Initialize segment with the data */
-    segment* curr_segment = new segment;
-    curr_segment->_length = length;
-    curr_segment->_material = materials[material_id];
-    curr_segment->_region_id = region_id;
-    curr_segment->_track_idx = track_idx;
-    curr_segment->_starting_position[0] = start_x;
-    curr_segment->_starting_position[1] = start_y;
-    curr_segment->_starting_position[2] = start_z;
-
-    /* Import CMFD-related data if needed */
-    if (cmfd != NULL) {
-      int cmfd_surface_fwd;
-      ret = geometry->twiddleRead(&cmfd_surface_fwd, sizeof(int), 1, _in);
-      curr_segment->_cmfd_surface_fwd = cmfd_surface_fwd;
-      int cmfd_surface_bwd;
-      ret = geometry->twiddleRead(&cmfd_surface_bwd, sizeof(int), 1, _in);
-      curr_segment->_cmfd_surface_bwd = cmfd_surface_bwd;
-    }
-
-    /* Add this segment to the Track */
-    track->addSegment(curr_segment);
-  }
+  long uid = track->getUid();
+  long offset = _segment_offsets[uid];
+  track->mapSegments(&_segments[offset], _segment_offsets[uid+1] - offset);
 }
 
 
@@ -1226,6 +1359,12 @@ RecenterSegments::RecenterSegments(TrackGenerator* track_generator)
  *        segments.
  */
 void RecenterSegments::execute() {
+
+  /* Segments streamed from the Track file are centered as they are
+   * streamed */
+  if (_track_generator_3D != NULL && _track_generator_3D->streamsSegments())
+    return;
+
 #pragma omp parallel
   {
     MOCKernel* kernel = getKernel<SegmentationKernel>();
@@ -1253,6 +1392,130 @@ void RecenterSegments::onTrack(Track* track, segment* segments) {
 }
 
 
+/**
+ * @brief Constructor for StoreSegments calls the TraverseSegments
+ *        constructor
+ * @param track_generator The TrackGenerator to pull tracking information from
+ */
+StoreSegments::StoreSegments(TrackGenerator* track_generator)
+                             : TraverseSegments(track_generator) {
+}
+
+
+/**
+ * @brief When executed, the Kernel loops over all z-stacks, ray tracing their
+ *        segments so that those of selected z-stacks can be stored.
+ */
+void StoreSegments::execute() {
+#pragma omp parallel
+  {
+    MOCKernel* kernel = getKernel<SegmentationKernel>();
+    loopOverTracks(kernel);
+  }
+}
+
+
+/**
+ * @brief Passes the segments of a z-stack to the TrackGenerator3D, which
+ *        stores them if the z-stack was selected for explicit storage.
+ * @param track The first Track of the z-stack
+ * @param segments The segments of all the Tracks in the z-stack
+ */
+void StoreSegments::onTrack(Track* track, segment* segments) {
+  Track3D* track_3D = dynamic_cast<Track3D*>(track);
+  long stack_id = _track_generator_3D->getStackID(track->getAzimIndex(),
+      track->getXYIndex(), track_3D->getPolarIndex());
+  _track_generator_3D->setStackSegments(stack_id, segments,
+                                        track->getNumSegments());
+}
+
+
+/**
+ * @brief Constructor for RenumberFSRs calls the TraverseSegments
+ *        constructor
+ * @param track_generator The TrackGenerator to pull tracking information from
+ */
+RenumberFSRs::RenumberFSRs(TrackGenerator* track_generator)
+                           : TraverseSegments(track_generator) {
+  _id_mapping = NULL;
+}
+
+
+/**
+ * @brief Sets the mapping from previous to new FSR IDs
+ * @param id_mapping the new ID of each FSR, indexed by its previous ID
+ */
+void RenumberFSRs::setIDMapping(long* id_mapping) {
+  _id_mapping = id_mapping;
+}
+
+
+/**
+ * @brief Updates the FSR IDs of the explicit segments of all Tracks
+ * @details No MOCKernels are initialized for this function.
+ */
+void RenumberFSRs::execute() {
+#pragma omp parallel
+  {
+    loopOverTracks(NULL);
+  }
+}
+
+
+/**
+ * @brief Replaces the FSR ID of each segment of the Track
+ * @param track The Track whose segments are updated
+ * @param segments The segments associated with the Track
+ */
+void RenumberFSRs::onTrack(Track* track, segment* segments) {
+  for (int s=0; s < track->getNumSegments(); s++)
+    segments[s]._region_id = _id_mapping[segments[s]._region_id];
+}
+
+
+/**
+ * @brief Constructor for UpdateSegmentMaterials calls the TraverseSegments
+ *        constructor
+ * @param track_generator The TrackGenerator to pull tracking information from
+ */
+UpdateSegmentMaterials::UpdateSegmentMaterials(
+    TrackGenerator* track_generator) : TraverseSegments(track_generator) {
+  _FSR_materials = NULL;
+}
+
+
+/**
+ * @brief Sets the Material of each FSR
+ * @param FSR_materials the Material of each FSR, indexed by FSR ID
+ */
+void UpdateSegmentMaterials::setFSRMaterials(Material** FSR_materials) {
+  _FSR_materials = FSR_materials;
+}
+
+
+/**
+ * @brief Updates the Materials of the explicit segments of all Tracks
+ * @details No MOCKernels are initialized for this function.
+ */
+void UpdateSegmentMaterials::execute() {
+#pragma omp parallel
+  {
+    loopOverTracks(NULL);
+  }
+}
+
+
+/**
+ * @brief Sets the Material of each segment of the Track to that of its FSR
+ * @param track The Track whose segments are updated
+ * @param segments The segments associated with the Track
+ */
+void UpdateSegmentMaterials::onTrack(Track* track, segment* segments) {
+  for (int s=0; s < track->getNumSegments(); s++)
+    segments[s]._material = _FSR_materials[segments[s]._region_id];
+}
+
+
 /**
  * @brief Constructor for PrintSegments calls the TraverseSegments
  *        constructor and initializes the output FILE to NULL
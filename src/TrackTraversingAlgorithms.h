@@ -66,6 +66,7 @@ private:
   long _total_num_segments;
   bool _count_total_segments;
   bool _total_segments_counted;
+  int* _stack_num_segments;
 
 public:
 
@@ -73,6 +74,7 @@ public:
   void execute();
   void onTrack(Track* track, segment* segments);
   void countTotalNumSegments();
+  void countStackNumSegments(int* stack_num_segments);
   long getTotalNumSegments();
 };
 
@@ -88,11 +90,28 @@ public:
  */
 class SegmentSplitter: public TraverseSegments {
 
+private:
+
+  /** Whether the split segments of implicit 3D Tracks are counted (true) or
+   *  written (false) */
+  bool _counting;
+
+  /** Offsets of the split segments of each implicit 3D Track */
+  std::vector<long> _split_offsets;
+
+  /** The split segments of all implicit 3D Tracks */
+  std::vector<segment> _split_segments;
+
 public:
 
   SegmentSplitter(TrackGenerator* track_generator);
   void execute();
   void onTrack(Track* track, segment* segments);
+
+  static int getNumCuts(segment* curr_segment,
+                        FP_PRECISION max_optical_length);
+  static void splitSegment(segment* curr_segment, int num_cuts,
+                           double* direction, segment* sub_segments);
 };
 
 
@@ -221,12 +240,35 @@ class DumpSegments: public TraverseSegments {
 
 private:
 
+  /** The Track file to write to */
   FILE* _out;
 
+  /** The offset of the segments section in the Track file (bytes) */
+  uint64_t _section_offset;
+
+  /** The offsets of the segments of each Track, indexed by Track UID */
+  long* _segment_offsets;
+
+  /** The number of Tracks which store segments */
+  long _num_tracks;
+
+  /** The index in the Track file of each Material, by Material ID */
+  std::map<int, int>* _material_indexes;
+
+  /** Whether the segments are counted rather than written */
+  bool _counting;
+
+  /** The checksum of the segments written */
+  uint64_t _checksum;
+
 public:
 
   DumpSegments(TrackGenerator* track_generator);
-  void setOutputFile(FILE* out);
+  void setOutputFile(FILE* out, uint64_t section_offset);
+  void setSegmentOffsets(long* segment_offsets, long num_tracks);
+  void setMaterialIndexes(std::map<int, int>* material_indexes);
+  void countSegments();
+  uint64_t getChecksum();
   void execute();
   void onTrack(Track* track, segment* segments);
 };
@@ -236,19 +278,23 @@ public:
  * @class ReadSegments TrackTraversingAlgorithms.h
  *        "src/TrackTraversingAlgorithms.h"
  * @brief A class used to read tracking data from a file.
- * @details ReadSegments imports Track data from the provided file and writes
- *          the tracking data to the Tracks in the provided TrackGenerator.
+ * @details ReadSegments makes the Tracks in the provided TrackGenerator use
+ *          the segments of a memory mapped Track file in place.
  */
 class ReadSegments: public TraverseSegments {
 
 private:
 
-  FILE* _in;
+  /** The offsets of the segments of each Track, indexed by Track UID */
+  long* _segment_offsets;
+
+  /** The segments of all Tracks */
+  segment* _segments;
 
 public:
 
   ReadSegments(TrackGenerator* track_generator);
-  void setInputFile(FILE* input);
+  void setSegments(long* segment_offsets, segment* segments);
   void execute();
   void onTrack(Track* track, segment* segments);
 };
@@ -302,6 +348,73 @@ public:
 };
 
 
+/**
+ * @class StoreSegments TrackTraversingAlgorithms.h
+ *        "src/TrackTraversingAlgorithms.h"
+ * @brief A class used to store the explicit segments of selected z-stacks
+ * @details StoreSegments allocates SegmentationKernels to temporarily store
+ *          the segments of each z-stack, which are then copied by the
+ *          TrackGenerator3D for the z-stacks selected for explicit storage in
+ *          hybrid explicit/on-the-fly ray tracing.
+ */
+class StoreSegments: public TraverseSegments {
+
+public:
+
+  StoreSegments(TrackGenerator* track_generator);
+  void onTrack(Track* track, segment* segments);
+  void execute();
+};
+
+
+/**
+ * @class RenumberFSRs TrackTraversingAlgorithms.h
+ *        "src/TrackTraversingAlgorithms.h"
+ * @brief A class used to update the FSR IDs of explicit segments
+ * @details RenumberFSRs loops over the explicit segments of all Tracks and
+ *          replaces their FSR IDs using the provided mapping, once the
+ *          Geometry has renumbered the FSRs deterministically.
+ */
+class RenumberFSRs: public TraverseSegments {
+
+private:
+
+  /** The new ID of each FSR, indexed by its previous ID */
+  long* _id_mapping;
+
+public:
+
+  RenumberFSRs(TrackGenerator* track_generator);
+  void setIDMapping(long* id_mapping);
+  void onTrack(Track* track, segment* segments);
+  void execute();
+};
+
+
+/**
+ * @class UpdateSegmentMaterials TrackTraversingAlgorithms.h
+ *        "src/TrackTraversingAlgorithms.h"
+ * @brief A class used to update the Materials of explicit segments
+ * @details UpdateSegmentMaterials loops over the explicit segments of all
+ *          Tracks and sets the Material of each segment to the one of its
+ *          FSR, once the Cells of the Geometry were filled again.
+ */
+class UpdateSegmentMaterials: public TraverseSegments {
+
+private:
+
+  /** The Material of each FSR, indexed by FSR ID */
+  Material** _FSR_materials;
+
+public:
+
+  UpdateSegmentMaterials(TrackGenerator* track_generator);
+  void setFSRMaterials(Material** FSR_materials);
+  void onTrack(Track* track, segment* segments);
+  void execute();
+};
+
+
 /**
  * @class PrintSegments TrackTraversingAlgorithms.h
  *        "src/TrackTraversingAlgorithms.h"
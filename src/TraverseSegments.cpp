@@ -1,4 +1,5 @@
 #include "TraverseSegments.h"
+#include <sched.h>
 
 /**
  * @brief Constructor for the TravseSegments class assigns the TrackGenerator
@@ -8,6 +9,7 @@ TraverseSegments::TraverseSegments(TrackGenerator* track_generator) {
 
   /* Save the track generator */
   _track_generator = track_generator;
+  _next_track = 0;
 
   /* Determine the type of segment formation used */
   _segment_formation = track_generator->getSegmentFormation();
@@ -16,6 +18,8 @@ TraverseSegments::TraverseSegments(TrackGenerator* track_generator) {
   _track_generator_3D = dynamic_cast<TrackGenerator3D*>(track_generator);
   if (_track_generator_3D != NULL) {
     _track_generator_3D->retrieveGlobalZMesh(_global_z_mesh, _mesh_size);
+    if (_global_z_mesh != NULL)
+      _global_z_lookup.initialize(_global_z_mesh, _mesh_size);
   }
 }
 
@@ -49,6 +53,7 @@ void TraverseSegments::loopOverTracks(MOCKernel* kernel) {
       loopOverTracksByTrackOTF(kernel);
       break;
     case OTF_STACKS:
+    case HYBRID_STACKS:
       loopOverTracksByStackOTF(kernel);
       break;
   }
@@ -58,6 +63,28 @@ void TraverseSegments::loopOverTracks(MOCKernel* kernel) {
 }
 
 
+/**
+ * @brief Loops over all Tracks which store segments.
+ * @details These are the 2D or 3D Tracks of explicit ray tracing and the
+ *          flattened 2D Tracks of on-the-fly ray tracing. Only the
+ *          onTrack(...) functionality is applied.
+ */
+void TraverseSegments::loopOverStoredTracks() {
+
+  if (_segment_formation == EXPLICIT_2D || _segment_formation == EXPLICIT_3D) {
+    loopOverTracks(NULL);
+    return;
+  }
+
+  /* Loop over the flattened 2D Tracks */
+  long num_2D_tracks = _track_generator->getNum2DTracks();
+  Track** tracks_2D = _track_generator->get2DTracksArray();
+#pragma omp for schedule(guided)
+  for (long t=0; t < num_2D_tracks; t++)
+    onTrack(tracks_2D[t], tracks_2D[t]->getSegments());
+}
+
+
 /**
  * @brief Loops over all explicit 2D Tracks
  * @details The onTrack(...) function is applied to all 2D Tracks and the
@@ -82,7 +109,7 @@ void TraverseSegments::loopOverTracks2D(MOCKernel* kernel) {
       /* Operate on segments if necessary */
       if (kernel != NULL) {
         kernel->newTrack(track_2D);
-        traceSegmentsExplicit(track_2D, kernel);
+        traceSegmentsExplicit(track_2D, track_2D->getSegments(), kernel);
       }
 
       /* Operate on the Track */
@@ -107,6 +134,16 @@ void TraverseSegments::loopOverTracksExplicit(MOCKernel* kernel) {
   int num_polar = _track_generator_3D->getNumPolar();
   int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
 
+  /* Implicit 3D Tracks are formed from their indexes */
+  Track3D implicit_track;
+  TrackStackIndexes tsi;
+
+  /* The segments of z-stacks streamed from the Track file. Each thread
+   * streams the contiguous ranges of the file of its chunks of z-stacks */
+  bool streamed = _track_generator_3D->streamsSegments();
+  segment* stack_segments = NULL;
+  long* stack_offsets = NULL;
+
   /* Loop over all tracks, parallelizing over parallel 2D tracks */
   for (int a=0; a < num_azim/2; a++) {
     int num_xy = _track_generator->getNumX(a) + _track_generator->getNumY(a);
@@ -116,11 +153,38 @@ void TraverseSegments::loopOverTracksExplicit(MOCKernel* kernel) {
       /* Loop over polar angles */
       for (int p=0; p < num_polar; p++) {
 
+        if (streamed)
+          stack_segments = _track_generator_3D->streamStackSegments(
+              a, i, p, stack_offsets);
+
         /* Loop over tracks in the z-stack */
         for (int z=0; z < tracks_per_stack[a][i][p]; z++) {
 
           /* Extract 3D track and initialize segments pointer */
-          Track* track_3D = &tracks_3D[a][i][p][z];
+          Track* track_3D;
+          segment* segments;
+          if (tracks_3D != NULL) {
+            track_3D = &tracks_3D[a][i][p][z];
+            segments = track_3D->getSegments();
+          }
+          else {
+            tsi._azim = a;
+            tsi._xy = i;
+            tsi._polar = p;
+            tsi._z = z;
+            implicit_track.clearSegments();
+            _track_generator_3D->getTrackOTF(&implicit_track, &tsi);
+            int num_segments;
+            if (streamed) {
+              segments = stack_segments + stack_offsets[z];
+              num_segments = stack_offsets[z+1] - stack_offsets[z];
+            }
+            else
+              segments = _track_generator_3D->getImplicitSegments(
+                  implicit_track.getUid(), num_segments);
+            implicit_track.setNumSegments(num_segments);
+            track_3D = &implicit_track;
+          }
 
           /* Operate on segments if necessary */
           if (kernel != NULL) {
@@ -129,11 +193,10 @@ void TraverseSegments::loopOverTracksExplicit(MOCKernel* kernel) {
             kernel->newTrack(track_3D);
 
             /* Trace the segments on the track */
-            traceSegmentsExplicit(track_3D, kernel);
+            traceSegmentsExplicit(track_3D, segments, kernel);
           }
 
           /* Operate on the Track */
-          segment* segments = track_3D->getSegments();
           onTrack(track_3D, segments);
         }
       }
@@ -223,6 +286,19 @@ void TraverseSegments::loopOverTracksByStackOTF(MOCKernel* kernel) {
   /* Allocate array of current Tracks */
   Track3D* current_stack = _track_generator_3D->getTemporary3DTracks(tid);
 
+  /* Stored segments are used directly in place of segmentation kernels */
+  bool segmentation = dynamic_cast<SegmentationKernel*>(kernel) != NULL;
+
+  /* Overlap ray tracing with the operation on Tracks if requested and if
+   * all threads can be paired, otherwise use the regular traversal */
+  int num_threads = omp_get_num_threads();
+  if (segmentation && _track_generator_3D->getPipelineDepth() > 0 &&
+      num_threads > 1 && num_threads % 2 == 0 &&
+      num_threads <= _track_generator_3D->getNumThreads()) {
+    loopOverTracksByStackPipelined(dynamic_cast<SegmentationKernel*>(kernel));
+    return;
+  }
+
   /* Loop over flattened 2D tracks */
 #pragma omp for schedule(dynamic)
   for (int ext_id=0; ext_id < num_2D_tracks; ext_id++) {
@@ -244,34 +320,225 @@ void TraverseSegments::loopOverTracksByStackOTF(MOCKernel* kernel) {
         _track_generator_3D->getTrackOTF(&current_stack[z], &tsi);
       }
 
-      if (kernel != NULL) {
+      /* Retrieve the explicit segments of the z-stack if they are stored */
+      segment* segments = _track_generator_3D->getTemporarySegments(tid);
+      segment* stored_segments = NULL;
+      int num_stored_segments = 0;
+      if (_segment_formation == HYBRID_STACKS)
+        stored_segments = _track_generator_3D->getStackSegments(
+            _track_generator_3D->getStackID(tsi._azim, tsi._xy, p),
+            num_stored_segments);
+
+      if (stored_segments != NULL && segmentation) {
+        current_stack[0].setNumSegments(num_stored_segments);
+        segments = stored_segments;
+      }
+      else if (kernel != NULL) {
 
         /* Reset kernel to for the new base Track */
         kernel->newTrack(&current_stack[0]);
 
         /* Trace all segments in the z-stack */
-        traceStackOTF(flattened_track, p, kernel);
+        if (stored_segments != NULL)
+          traceStackExplicit(&current_stack[0], stored_segments,
+                             num_stored_segments, kernel);
+        else
+          traceStackOTF(flattened_track, p, kernel);
         current_stack[0].setNumSegments(kernel->getCount());
       }
 
       /* Operate on the Track */
-      segment* segments = _track_generator_3D->getTemporarySegments(tid);
       onTrack(&current_stack[0], segments);
     }
   }
 }
 
 
+/**
+ * @brief Loops over all 3D Tracks by z-stack, overlapping on-the-fly ray
+ *        tracing of upcoming z-stacks with the operation on traced z-stacks
+ * @details Threads are paired into producers and consumers. A producer ray
+ *          traces z-stacks into the ring buffer of its pair, claiming
+ *          flattened Tracks dynamically, while the consumer applies the
+ *          onTrack(...) functionality to the z-stacks in the order they were
+ *          traced. Producers wait when their ring buffer is full and
+ *          consumers when it is empty; this stall time is added to the
+ *          TrackGenerator3D. Threads 2k and 2k+1 form a pair, which assumes
+ *          consecutive OpenMP threads are bound to the SMT siblings of a
+ *          core (e.g. OMP_PLACES=threads and OMP_PROC_BIND=close), so that
+ *          the pair shares the core rather than idling half of it. This is
+ *          only called by loopOverTracksByStackOTF with an even number of
+ *          threads, at most the number of threads of the TrackGenerator3D.
+ * @param kernel The SegmentationKernel of the calling thread
+ */
+void TraverseSegments::loopOverTracksByStackPipelined(
+    SegmentationKernel* kernel) {
+
+  int num_2D_tracks = _track_generator_3D->getNum2DTracks();
+  Track** flattened_tracks = _track_generator_3D->get2DTracksArray();
+  int num_polar = _track_generator_3D->getNumPolar();
+  int depth = _track_generator_3D->getPipelineDepth();
+  int tid = omp_get_thread_num();
+  double stall_time = 0.;
+
+  /* Reset the dynamic distribution of flattened Tracks */
+#pragma omp single
+  _next_track = 0;
+
+  /* Producer: ray trace z-stacks into the ring buffer */
+  if (tid % 2 == 0) {
+
+    PipelineSlot* slots = _track_generator_3D->getPipelineSlots(tid / 2);
+    int slot_index = 0;
+    long ext_id = __sync_fetch_and_add(&_next_track, 1);
+
+    while (true) {
+      for (int p=0; p < num_polar; p++) {
+
+        /* Wait for the transport of the z-stack in the next slot */
+        PipelineSlot* slot = &slots[slot_index];
+        if (slot->_full) {
+          double start = omp_get_wtime();
+          while (slot->_full)
+            sched_yield();
+          stall_time += omp_get_wtime() - start;
+        }
+        __sync_synchronize();
+
+        /* Signal the end of the pipeline after the last z-stack */
+        if (ext_id >= num_2D_tracks) {
+          slot->_ext_id = -1;
+          __sync_synchronize();
+          slot->_full = 1;
+          break;
+        }
+
+        /* Fill the slot and hand it over */
+        traceStackPipelined(flattened_tracks[ext_id], p, kernel, slot);
+        slot->_ext_id = ext_id;
+        slot->_polar = p;
+        __sync_synchronize();
+        slot->_full = 1;
+        slot_index = (slot_index + 1) % depth;
+      }
+      if (ext_id >= num_2D_tracks)
+        break;
+      ext_id = __sync_fetch_and_add(&_next_track, 1);
+    }
+  }
+
+  /* Consumer: operate on the z-stacks traced by the paired producer */
+  else {
+
+    PipelineSlot* slots = _track_generator_3D->getPipelineSlots(tid / 2);
+    Track3D* current_stack = _track_generator_3D->getTemporary3DTracks(tid);
+    int slot_index = 0;
+
+    while (true) {
+
+      /* Wait for the next z-stack to be traced */
+      PipelineSlot* slot = &slots[slot_index];
+      if (!slot->_full) {
+        double start = omp_get_wtime();
+        while (!slot->_full)
+          sched_yield();
+        stall_time += omp_get_wtime() - start;
+      }
+      __sync_synchronize();
+
+      if (slot->_ext_id < 0) {
+        slot->_full = 0;
+        break;
+      }
+
+      /* Operate on the z-stack, then release the slot */
+      getStackOTF(current_stack, slot->_ext_id, slot->_polar);
+      current_stack[0].setNumSegments(slot->_num_segments);
+      onTrack(&current_stack[0], slot->_segments);
+      __sync_synchronize();
+      slot->_full = 0;
+      slot_index = (slot_index + 1) % depth;
+    }
+  }
+
+  if (stall_time > 0.)
+    _track_generator_3D->addPipelineStallTime(stall_time);
+
+#pragma omp barrier
+}
+
+
+/**
+ * @brief Forms the 3D Tracks of a z-stack on-the-fly
+ * @param stack The array of 3D Tracks to fill
+ * @param ext_id The index of the flattened 2D Track of the z-stack
+ * @param polar_index The polar index of the z-stack
+ */
+void TraverseSegments::getStackOTF(Track3D* stack, long ext_id,
+                                   int polar_index) {
+
+  Track* flattened_track = _track_generator_3D->get2DTracksArray()[ext_id];
+  int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
+
+  TrackStackIndexes tsi;
+  tsi._azim = flattened_track->getAzimIndex();
+  tsi._xy = flattened_track->getXYIndex();
+  tsi._polar = polar_index;
+  int stack_size = tracks_per_stack[tsi._azim][tsi._xy][polar_index];
+  for (int z=0; z < stack_size; z++) {
+    tsi._z = z;
+    _track_generator_3D->getTrackOTF(&stack[z], &tsi);
+  }
+}
+
+
+/**
+ * @brief Forms the segments of a z-stack into a pipeline slot
+ * @details Segments stored explicitly in hybrid ray tracing are referenced
+ *          by the slot rather than copied, all other z-stacks are ray traced
+ *          on-the-fly into the buffer of the slot.
+ * @param flattened_track The flattened 2D Track of the z-stack
+ * @param polar_index The polar index of the z-stack
+ * @param kernel The SegmentationKernel used to ray trace the z-stack
+ * @param slot The pipeline slot receiving the segments
+ */
+void TraverseSegments::traceStackPipelined(Track* flattened_track,
+                                           int polar_index,
+                                           SegmentationKernel* kernel,
+                                           PipelineSlot* slot) {
+
+  /* Reference the explicit segments of the z-stack if they are stored */
+  if (_segment_formation == HYBRID_STACKS) {
+    long stack_id = _track_generator_3D->getStackID(
+        flattened_track->getAzimIndex(), flattened_track->getXYIndex(),
+        polar_index);
+    slot->_segments = _track_generator_3D->getStackSegments(
+        stack_id, slot->_num_segments);
+    if (slot->_segments != NULL)
+      return;
+  }
+
+  /* Ray trace the z-stack into the buffer of the slot */
+  kernel->setSegments(slot->_buffer);
+  kernel->newTrack(flattened_track);
+  traceStackOTF(flattened_track, polar_index, kernel);
+  slot->_segments = slot->_buffer;
+  slot->_num_segments = kernel->getCount();
+}
+
+
 /**
  * @brief Loops over segments in a Track when segments are explicitly generated
  * @details All segments in the provided Track are looped over and the provided
  *          MOCKernel is applied to them.
  * @param track The Track whose segments will be traversed
+ * @param segments The segments of the Track
  * @param kernel The kernel to apply to all segments
  */
-void TraverseSegments::traceSegmentsExplicit(Track* track, MOCKernel* kernel) {
+void TraverseSegments::traceSegmentsExplicit(Track* track, segment* segments,
+                                             MOCKernel* kernel) {
   for (int s=0; s < track->getNumSegments(); s++) {
-    segment* seg = track->getSegment(s);
+    segment* seg = &segments[s];
     kernel->execute(seg->_length, seg->_material, seg->_region_id, 0,
                     seg->_cmfd_surface_fwd, seg->_cmfd_surface_bwd,
                     seg->_starting_position[0], seg->_starting_position[1],
@@ -280,6 +547,31 @@ void TraverseSegments::traceSegmentsExplicit(Track* track, MOCKernel* kernel) {
 }
 
 
+/**
+ * @brief Loops over the explicit segments stored for a z-stack
+ * @details All segments stored for the z-stack are passed to the provided
+ *          MOCKernel with the direction of the z-stack.
+ * @param track The first 3D Track of the z-stack
+ * @param segments The segments stored for the z-stack
+ * @param num_segments The number of segments stored for the z-stack
+ * @param kernel The kernel to apply to all segments
+ */
+void TraverseSegments::traceStackExplicit(Track3D* track, segment* segments,
+                                          int num_segments,
+                                          MOCKernel* kernel) {
+  double phi = track->getPhi();
+  double theta = track->getTheta();
+  for (int s=0; s < num_segments; s++) {
+    segment* seg = &segments[s];
+    kernel->execute(seg->_length, seg->_material, seg->_region_id,
+                    seg->_track_idx, seg->_cmfd_surface_fwd,
+                    seg->_cmfd_surface_bwd, seg->_starting_position[0],
+                    seg->_starting_position[1], seg->_starting_position[2],
+                    phi, theta);
+  }
+}
+
+
 /**
  * @brief Computes 3D segment lengths on-the-fly for a single 3D track given an
  *        associated 2D Track with a starting point and a polar angle. The
@@ -353,11 +645,13 @@ void TraverseSegments::traceSegmentsOTF(Track* flattened_track, Point* start,
   /* Extract the appropriate starting mesh */
   int num_fsrs;
   double* axial_mesh;
+  AxialMeshLookup* mesh_lookup;
   bool contains_global_z_mesh;
   if (_global_z_mesh != NULL) {
     contains_global_z_mesh = true;
     num_fsrs = _mesh_size;
     axial_mesh = _global_z_mesh;
+    mesh_lookup = &_global_z_lookup;
   }
   else {
     contains_global_z_mesh = false;
@@ -365,10 +659,12 @@ void TraverseSegments::traceSegmentsOTF(Track* flattened_track, Point* start,
     ExtrudedFSR* extruded_FSR = geometry->getExtrudedFSR(extruded_fsr_id);
     num_fsrs = extruded_FSR->_num_fsrs;
     axial_mesh = extruded_FSR->_mesh;
+    mesh_lookup = &extruded_FSR->_mesh_lookup;
   }
 
   /* Get the starting z index */
-  int z_ind = findMeshIndex(axial_mesh, num_fsrs+1, z_coord, sign);
+  int z_ind = findMeshIndex(axial_mesh, mesh_lookup, num_fsrs+1, z_coord,
+                            sign);
 
   /* Loop over 2D segments */
   bool first_segment = true;
@@ -387,7 +683,8 @@ void TraverseSegments::traceSegmentsOTF(Track* flattened_track, Point* start,
       /* Determine the axial region */
       num_fsrs = extruded_FSR->_num_fsrs;
       axial_mesh = extruded_FSR->_mesh;
-      z_ind = findMeshIndex(axial_mesh, num_fsrs+1, z_coord, sign);
+      z_ind = findMeshIndex(axial_mesh, &extruded_FSR->_mesh_lookup,
+                            num_fsrs+1, z_coord, sign);
     }
 
     /* Extract 2D segment length */
@@ -521,22 +818,43 @@ void TraverseSegments::traceSegmentsOTF(Track* flattened_track, Point* start,
 void TraverseSegments::traceStackOTF(Track* flattened_track, int polar_index,
                                      MOCKernel* kernel) {
 
-  /* Extract information about the z-stack */
-  int azim_index = flattened_track->getAzimIndex();
-  int track_index = flattened_track->getXYIndex();
-  int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
-  int num_z_stack = tracks_per_stack[azim_index][track_index][polar_index];
-  double z_spacing = _track_generator_3D->getZSpacing(azim_index, polar_index);
-
   /* Get infromation for the first Track in the z-stack */
   TrackStackIndexes tsi;
   Track3D first;
-  tsi._azim = azim_index;
-  tsi._xy = track_index;
+  tsi._azim = flattened_track->getAzimIndex();
+  tsi._xy = flattened_track->getXYIndex();
   tsi._polar = polar_index;
   tsi._z = 0;
   _track_generator_3D->getTrackOTF(&first, &tsi);
-  double theta = first.getTheta();
+
+  traceStackOTF(flattened_track, &first, polar_index, kernel);
+}
+
+
+/**
+ * @brief Computes 3D segment lengths on-the-fly for all tracks in a z-stack
+ *        starting from its first 3D Track and passes the computed segments
+ *        to the provided kernel.
+ * @details The 2D Track and the first 3D Track may be reversed copies of
+ *          those of the TrackGenerator, so that the z-stack is traced
+ *          backwards.
+ * @param flattened_track the 2D track associated with the z-stack for which
+ *        3D segments are computed
+ * @param first the first 3D Track of the z-stack
+ * @param polar_index the index into the polar angles which is associated with
+ *        the polar angle of the z-stack
+ * @param kernel The MOCKernel to apply to the calculated 3D segments
+ */
+void TraverseSegments::traceStackOTF(Track* flattened_track, Track3D* first,
+                                     int polar_index, MOCKernel* kernel) {
+
+  /* Extract information about the z-stack */
+  int azim_index = flattened_track->getAzimIndex();
+  int track_index = flattened_track->getXYIndex();
+  int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
+  int num_z_stack = tracks_per_stack[azim_index][track_index][polar_index];
+  double z_spacing = _track_generator_3D->getZSpacing(azim_index, polar_index);
+  double theta = first->getTheta();
 
   /* Create unit vector */
   double phi = flattened_track->getPhi();
@@ -549,13 +867,13 @@ void TraverseSegments::traceStackOTF(Track* flattened_track, int polar_index,
   double track_spacing_3D = z_spacing / std::abs(cos_theta);
 
   /* Find 2D distance from 2D edge to start of track */
-  double x_start_3D = first.getStart()->getX();
+  double x_start_3D = first->getStart()->getX();
   double x_start_2D = flattened_track->getStart()->getX();
   double y_start_2D = flattened_track->getStart()->getY();
   double start_dist_2D = (x_start_3D - x_start_2D) / cos_phi;
 
   /* Calculate starting intersection of lowest track with z-axis */
-  double z0 = first.getStart()->getZ();
+  double z0 = first->getStart()->getZ();
   double start_z = z0 - start_dist_2D / tan_theta;
 
   /* Get the Geometry and CMFD mesh */
@@ -886,47 +1204,28 @@ void TraverseSegments::traceStackOTF(Track* flattened_track, int polar_index,
 
 
 /**
- * @brief A function that searches for the index into a values mesh using a
- *        binary search.
- * @details A binary search is used to calculate the index into a mesh of where
- *          the value val resides. If a mesh boundary is hit, the upper region
- *          is selected for positive-z traversing rays and the lower region is
- *          selected for negative-z traversing rays.
+ * @brief A function that finds the index into a values mesh using its
+ *        bucket lookup.
+ * @details The bucket containing val gives the index into the mesh in a few
+ *          steps, without searching the mesh. If a mesh boundary is hit, the
+ *          upper region is selected for positive-z traversing rays and the
+ *          lower region is selected for negative-z traversing rays.
  * @param values an array of monotonically increasing values
+ * @param lookup the bucket lookup built for the values array
  * @param size the size of the values array
  * @param val the level to be searched for in the mesh
  * @param sign the direction of the ray in the z-direction
  */
-int TraverseSegments::findMeshIndex(double* values, int size,
-                                    double val, int sign) {
-
-  /* Initialize indexes into the values array */
-  int imin = 0;
-  int imax = size-1;
+int TraverseSegments::findMeshIndex(double* values, AxialMeshLookup* lookup,
+                                    int size, double val, int sign) {
 
   /* Check if val is outside the range */
-  if (val < values[imin] or val > values[imax]) {
-    log_printf(ERROR, "Value out of the mesh range in binary search");
+  if (val < values[0] or val > values[size-1]) {
+    log_printf(ERROR, "Value out of the mesh range in mesh lookup");
     return -1;
   }
 
-  /* Search for interval containing val */
-  while (imax - imin > 1) {
-
-    int imid = (imin + imax) / 2;
-
-    if (val > values[imid])
-      imin = imid;
-    else if (val < values[imid])
-      imax = imid;
-    else {
-      if (sign > 0)
-        return imid;
-      else
-        return imid-1;
-    }
-  }
-  return imin;
+  return lookup->find(values, val, sign);
 }
 
 
@@ -992,102 +1291,62 @@ void TraverseSegments::loopOverTracksByStackTwoWay(TransportKernel* kernel) {
  * @brief Traces the 3D segments of 3D Tracks in a z-stack both forward and
  *        backward across the geometry, applying the kernel provided by the
  *        user when the segment information is calculated.
- * @details This function copies information of the 3D z-stack, ray traces the
- *          z-stack forward using TrackGenerator::traceStackOTF, then reverses
- *          the tracks so that they point backwards, and ray traces in the
- *          reverse direction. This allows segments to be applied to
- *          TransportKernels during the on-the-fly ray tracing process.
+ * @details This function ray traces the z-stack forward using
+ *          TraverseSegments::traceStackOTF, then ray traces reversed copies
+ *          of the 2D Track and of the first 3D Track of the z-stack, so that
+ *          the z-stack is traced in the reverse direction. This allows
+ *          segments to be applied to TransportKernels during the on-the-fly
+ *          ray tracing process. The Tracks of the TrackGenerator are left
+ *          unchanged, as other threads form 3D Tracks from them.
  * @param flattened_track the 2D track associated with the z-stack for which
  *        3D segments are computed
  * @param polar_index the polar index of the 3D Track z-stack
  * @param kernel The TransportKernel applied to the calculated 3D segments
  */
-//FIXME debug
 void TraverseSegments::traceStackTwoWay(Track* flattened_track, int polar_index,
                                         TransportKernel* kernel) {
 
-  /* Copy segments from flattened track */
-  segment* segments = flattened_track->getSegments();
-  int*** tracks_per_stack = _track_generator_3D->getTracksPerStack();
   MOCKernel* moc_kernel = dynamic_cast<MOCKernel*>(kernel);
 
   /* Get the first track in the 3D track stack */
-  int azim_index = flattened_track->getAzimIndex();
-  int track_index = flattened_track->getXYIndex();
   TrackStackIndexes tsi;
-  tsi._azim = azim_index;
-  tsi._xy = track_index;
+  tsi._azim = flattened_track->getAzimIndex();
+  tsi._xy = flattened_track->getXYIndex();
   tsi._polar = polar_index;
   tsi._z = 0;
   Track3D first;
   _track_generator_3D->getTrackOTF(&first, &tsi);
-  int num_z_stack = tracks_per_stack[azim_index][track_index][polar_index];
-
-  /* Copy spatial data from track stack */
-  double start_2D[3], end_2D[3], start_3D[3], end_3D[3];
-  for (int i = 0; i < 3; i++) {
-    start_2D[i] = flattened_track->getStart()->getXYZ()[i];
-    end_2D[i] = flattened_track->getEnd()->getXYZ()[i];
-    start_3D[i] = first.getStart()->getXYZ()[i];
-    end_3D[i] = first.getEnd()->getXYZ()[i];
-  }
-
-  /* Copy directional data from track stack */
-  double phi = flattened_track->getPhi();
-  double theta = first.getTheta();
 
   /* Trace stack forwards */
   kernel->setDirection(true);
-  traceStackOTF(flattened_track, polar_index, moc_kernel);
+  traceStackOTF(flattened_track, &first, polar_index, moc_kernel);
   kernel->post();
 
-  /* Reflect track stack */
-  first.getStart()->setXYZ(end_3D);
-  first.getEnd()->setXYZ(start_3D);
-  first.setTheta(M_PI - theta);
-  flattened_track->getStart()->setXYZ(end_2D);
-  flattened_track->getEnd()->setXYZ(start_2D);
-  flattened_track->setPhi(M_PI + phi);
-
-  /* Reverse segments in flattened track */
-  int num_segments = flattened_track->getNumSegments();
-  for (int s = 0; s < num_segments/2; s++) {
-    segment tmp_segment = segments[num_segments-s-1];
-    segments[num_segments-s-1] = segments[s];
-    segments[s] = tmp_segment;
-  }
-
-  /* Flip CMFD surfaces on segments in flattened track */
-  for (int s = 0; s < num_segments; s++) {
-    int tmp_surface = segments[s]._cmfd_surface_fwd;
-    segments[s]._cmfd_surface_fwd = segments[s]._cmfd_surface_bwd;
-    segments[s]._cmfd_surface_bwd = tmp_surface;
+  /* Reflect the first track of the stack */
+  Point start_3D = *first.getStart();
+  first.getStart()->setXYZ(first.getEnd()->getXYZ());
+  first.getEnd()->setXYZ(start_3D.getXYZ());
+  first.setTheta(M_PI - first.getTheta());
+
+  /* Reflect the flattened track */
+  Track reversed_track;
+  reversed_track.setAzimIndex(flattened_track->getAzimIndex());
+  reversed_track.setXYIndex(flattened_track->getXYIndex());
+  reversed_track.setPhi(M_PI + flattened_track->getPhi());
+  reversed_track.getStart()->setXYZ(flattened_track->getEnd()->getXYZ());
+  reversed_track.getEnd()->setXYZ(flattened_track->getStart()->getXYZ());
+
+  /* Reverse the segments and flip their CMFD surfaces */
+  segment* segments = flattened_track->getSegments();
+  for (int s = flattened_track->getNumSegments() - 1; s >= 0; s--) {
+    segment reversed_segment = segments[s];
+    reversed_segment._cmfd_surface_fwd = segments[s]._cmfd_surface_bwd;
+    reversed_segment._cmfd_surface_bwd = segments[s]._cmfd_surface_fwd;
+    reversed_track.addSegment(&reversed_segment);
   }
 
   /* Trace stack backwards */
   kernel->setDirection(false);
-  traceStackOTF(flattened_track, polar_index, moc_kernel);
+  traceStackOTF(&reversed_track, &first, polar_index, moc_kernel);
   kernel->post();
-
-  /* Reflect track stack back to forwards */
-  first.getStart()->setXYZ(start_3D);
-  first.getEnd()->setXYZ(end_3D);
-  first.setTheta(theta);
-  flattened_track->getStart()->setXYZ(start_2D);
-  flattened_track->getEnd()->setXYZ(end_2D);
-  flattened_track->setPhi(phi);
-
-  /* Reverse segments in flattened track */
-  for (int s = 0; s < num_segments/2; s++) {
-    segment tmp_segment = segments[num_segments-s-1];
-    segments[num_segments-s-1] = segments[s];
-    segments[s] = tmp_segment;
-  }
-
-  /* Flip CMFD surfaces on segments in flattened track */
-  for (int s = 0; s < num_segments; s++) {
-    int tmp_surface = segments[s]._cmfd_surface_fwd;
-    segments[s]._cmfd_surface_fwd = segments[s]._cmfd_surface_bwd;
-    segments[s]._cmfd_surface_bwd = tmp_surface;
-  }
 }
@@ -41,19 +41,30 @@ private:
   void loopOverTracksExplicit(MOCKernel* kernel);
   void loopOverTracksByTrackOTF(MOCKernel* kernel);
   void loopOverTracksByStackOTF(MOCKernel* kernel);
+  void loopOverTracksByStackPipelined(SegmentationKernel* kernel);
 
   /* Functions defining how to traverse segments */
-  void traceSegmentsExplicit(Track* track, MOCKernel* kernel);
+  void traceSegmentsExplicit(Track* track, segment* segments,
+                             MOCKernel* kernel);
   void traceSegmentsOTF(Track* flattened_track, Point* start,
                         double theta, MOCKernel* kernel);
   void traceStackOTF(Track* flattened_track, int polar_index,
                      MOCKernel* kernel);
+  void traceStackOTF(Track* flattened_track, Track3D* first, int polar_index,
+                     MOCKernel* kernel);
+  void traceStackExplicit(Track3D* track, segment* segments,
+                          int num_segments, MOCKernel* kernel);
+
+  void getStackOTF(Track3D* stack, long ext_id, int polar_index);
+  void traceStackPipelined(Track* flattened_track, int polar_index,
+                           SegmentationKernel* kernel, PipelineSlot* slot);
 
   void traceStackTwoWay(Track* flattened_track, int polar_index,
                         TransportKernel* kernel);
 
 
-  int findMeshIndex(double* values, int size, double val, int sign);
+  int findMeshIndex(double* values, AxialMeshLookup* lookup, int size,
+                    double val, int sign);
 
 protected:
 
@@ -67,14 +78,21 @@ protected:
   /** The size of the global z-mesh */
   int _mesh_size;
 
+  /** Bucket index to find the global z-mesh cell containing a height */
+  AxialMeshLookup _global_z_lookup;
+
   /** The type of segmentation used for segment formation */
   segmentationType _segment_formation;
 
+  /** Index of the next flattened Track to ray trace in pipelined loops */
+  long _next_track;
+
   TraverseSegments(TrackGenerator* track_generator);
   virtual ~TraverseSegments();
 
   /* Functions defining how to loop over and operate on Tracks */
   void loopOverTracks(MOCKernel* kernel);
+  void loopOverStoredTracks();
   virtual void onTrack(Track* track, segment* segments) = 0;
 
   //FIXME Rework function calls to make this private
@@ -1,5 +1,7 @@
 #include "Universe.h"
 #include <set>
+#include <algorithm>
+#include <cmath>
 
 
 int Universe::_n = 0;
@@ -77,6 +79,7 @@ Universe::Universe(const int id, const char* name) {
   _type = SIMPLE;
 
   _boundaries_inspected = false;
+  _cell_search_initialized = false;
 
   /* By default, the Universe's fissionability is unknown */
   _fissionable = false;
@@ -93,6 +96,9 @@ Universe::~Universe() {
 
   /* Clear the map of Cells, cells are deallocated either with the Geometry
      or automatically at the end of your input file */
+  std::map<int, Cell*>::iterator iter;
+  for (iter = _cells.begin(); iter != _cells.end(); ++iter)
+    iter->second->removeUniverse(this);
   _cells.clear();
 }
 
@@ -474,7 +480,8 @@ void Universe::addCell(Cell* cell) {
                " ID = %d. Backtrace:\n%s", cell, _id, e.what());
   }
 
-  _boundaries_inspected = false;
+  cell->addUniverse(this);
+  resetBoundaries();
 }
 
 
@@ -486,15 +493,21 @@ void Universe::removeCell(Cell* cell) {
   if (_cells.find(cell->getId()) != _cells.end())
     _cells.erase(cell->getId());
 
-  _boundaries_inspected = false;
+  cell->removeUniverse(this);
+  resetBoundaries();
 }
 
 
 /**
  * @brief Finds the Cell for which a LocalCoords object resides.
  * @details Finds the Cell that a LocalCoords object is located inside by
- *          checking each of this Universe's Cells. Returns NULL if the
- *          LocalCoords is not in any of the Cells.
+ *          first checking the Cell previously occupied at this level and its
+ *          neighbors, then the Cells whose bounding boxes overlap the bin of
+ *          the Universe's Cell search grid containing the LocalCoords. As
+ *          when checking all Cells in the order of increasing ID, the Cell
+ *          with the lowest ID containing the LocalCoords is returned, so that
+ *          the result does not depend on the Cells previously occupied.
+ *          Returns NULL if the LocalCoords is not in any of the Cells.
  * @param coords a pointer to the LocalCoords of interest
  * @return a pointer the Cell where the LocalCoords is located
  */
@@ -503,66 +516,563 @@ Cell* Universe::findCell(LocalCoords* coords) {
   /* Sets the LocalCoord type to UNIV at this level */
   coords->setType(UNIV);
 
-  /* Loop over all Cells */
-  std::map<int,Cell*>::iterator iter;
-  for (iter = _cells.begin(); iter != _cells.end(); ++iter) {
-    Cell* cell = iter->second;
-
-    if (cell->containsCoords(coords)) {
-
-      /* Set the Cell on this level */
-      coords->setCell(cell);
-
-      /* MATERIAL type Cell - lowest level, terminate search for Cell */
-      if (cell->getType() == MATERIAL)
-        return cell;
-
-      /* FILL type Cell - Cell contains a Universe at a lower level
-       * Update coords to next level and continue search */
-      else if (cell->getType() == FILL) {
-
-        LocalCoords* next_coords = coords->getNextCreate(coords->getX(),
-                                                         coords->getY(),
-                                                         coords->getZ());
-
-        /* Apply translation to position in the next coords */
-        if (cell->isTranslated()){
-          double* translation = cell->getTranslation();
-          double new_x = coords->getX() - translation[0];
-          double new_y = coords->getY() - translation[1];
-          double new_z = coords->getZ() - translation[2];
-          next_coords->setX(new_x);
-          next_coords->setY(new_y);
-          next_coords->setZ(new_z);
-        }
+  /* Build the Cell search structures if the Cells have changed */
+  if (!_cell_search_initialized) {
+#pragma omp critical (cell_search)
+    {
+      if (!_cell_search_initialized)
+        initializeCellSearch();
+    }
+  }
 
-        /* Apply rotation to position and direction in the next coords */
-        if (cell->isRotated()){
-          double x = coords->getX();
-          double y = coords->getY();
-          double z = coords->getZ();
-          double* matrix = cell->getRotationMatrix();
-          double new_x = matrix[0] * x + matrix[1] * y + matrix[2] * z;
-          double new_y = matrix[3] * x + matrix[4] * y + matrix[5] * z;
-          double new_z = matrix[6] * x + matrix[7] * y + matrix[8] * z;
-          next_coords->setX(new_x);
-          next_coords->setY(new_y);
-          next_coords->setZ(new_z);
+  Cell* cell = NULL;
+
+  /* Check the previously occupied Cell and its neighbors first */
+  Cell* hint = coords->getCell();
+  if (hint == NULL)
+    hint = coords->getPreviousCell();
+  int hint_index = getCellIndex(hint);
+  if (hint_index != -1) {
+    if (isFirstCell(coords, hint_index))
+      cell = _flat_cells[hint_index];
+    else {
+      for (int n=_neighbor_offsets[hint_index];
+           n < _neighbor_offsets[hint_index+1]; n++) {
+        if (isFirstCell(coords, _neighbor_cells[n])) {
+          cell = _flat_cells[_neighbor_cells[n]];
+          break;
         }
+      }
+    }
+  }
+
+  /* Check the Cells overlapping the grid bin of the coords */
+  if (cell == NULL) {
+    int bin_x = getGridBin(coords->getX(), _grid_min_x, _grid_inv_width_x,
+                           _grid_num_x);
+    int bin_y = getGridBin(coords->getY(), _grid_min_y, _grid_inv_width_y,
+                           _grid_num_y);
+    int bin = bin_y * _grid_num_x + bin_x;
+    int start = _grid_offsets[bin];
+    int num_cells = _grid_offsets[bin+1] - start;
+    if (num_cells > 0)
+      cell = searchCells(coords, &_grid_cells[start], num_cells, hint_index);
+  }
+
+  if (cell == NULL)
+    return NULL;
+
+  /* Set the Cell on this level */
+  coords->setCell(cell);
+
+  /* MATERIAL type Cell - lowest level, terminate search for Cell */
+  if (cell->getType() == MATERIAL)
+    return cell;
+
+  /* FILL type Cell - Cell contains a Universe at a lower level
+   * Update coords to next level and continue search */
+  LocalCoords* next_coords = coords->getNextCreate(coords->getX(),
+                                                   coords->getY(),
+                                                   coords->getZ());
+
+  /* Apply translation to position in the next coords */
+  if (cell->isTranslated()){
+    double* translation = cell->getTranslation();
+    double new_x = coords->getX() - translation[0];
+    double new_y = coords->getY() - translation[1];
+    double new_z = coords->getZ() - translation[2];
+    next_coords->setX(new_x);
+    next_coords->setY(new_y);
+    next_coords->setZ(new_z);
+  }
+
+  /* Apply rotation to position and direction in the next coords */
+  if (cell->isRotated()){
+    double x = coords->getX();
+    double y = coords->getY();
+    double z = coords->getZ();
+    double* matrix = cell->getRotationMatrix();
+    double new_x = matrix[0] * x + matrix[1] * y + matrix[2] * z;
+    double new_y = matrix[3] * x + matrix[4] * y + matrix[5] * z;
+    double new_z = matrix[6] * x + matrix[7] * y + matrix[8] * z;
+    next_coords->setX(new_x);
+    next_coords->setY(new_y);
+    next_coords->setZ(new_z);
+  }
+
+  Universe* univ = cell->getFillUniverse();
+  next_coords->setUniverse(univ);
+
+  if (univ->getType() == SIMPLE)
+    return univ->findCell(next_coords);
+  else
+    return static_cast<Lattice*>(univ)->findCell(next_coords);
+}
+
+
+/**
+ * @brief Returns the first of a list of Cells which contains a LocalCoords.
+ * @details The padded bounding box of each Cell is checked before its Region.
+ * @param coords a pointer to the LocalCoords of interest
+ * @param cells the indexes of the Cells in the flat array of Cells
+ * @param num_cells the number of Cells in the list
+ * @param skip the index of a Cell that was already checked, or -1
+ * @return a pointer to the Cell containing the LocalCoords or NULL
+ */
+Cell* Universe::searchCells(LocalCoords* coords, int* cells, int num_cells,
+                            int skip) {
+
+  double x = coords->getX();
+  double y = coords->getY();
+
+  for (int i=0; i < num_cells; i++) {
+    int c = cells[i];
+    if (c == skip)
+      continue;
+    double* bounds = &_cell_bounds[4*c];
+    if (x < bounds[0] || x > bounds[1] || y < bounds[2] || y > bounds[3])
+      continue;
+    if (_flat_cells[c]->containsCoords(coords))
+      return _flat_cells[c];
+  }
+
+  return NULL;
+}
+
+
+/**
+ * @brief Determines whether a Cell is the Cell with the lowest ID containing
+ *        a LocalCoords.
+ * @details Only the Cells with a lower ID whose bounding box overlaps the
+ *          bounding box of the Cell may also contain the LocalCoords, when
+ *          it lies on a Surface or when Cells overlap. Of these, only the
+ *          Cells which are not separated from the Cell by one of its
+ *          Surfaces are checked, unless the LocalCoords lie on the Surface.
+ * @param coords a pointer to the LocalCoords of interest
+ * @param cell the index of the Cell in the flat array of Cells
+ * @return whether the Cell is the first Cell containing the LocalCoords
+ */
+bool Universe::isFirstCell(LocalCoords* coords, int cell) {
+
+  if (searchCells(coords, &cell, 1) == NULL)
+    return false;
+
+  /* Cells separated from the Cell by one of its Surfaces only contain the
+   * LocalCoords if they lie on this Surface */
+  Point* point = coords->getPoint();
+  for (int s=_separator_offsets[cell]; s < _separator_offsets[cell+1]; s++) {
+    if (_separators[s]->evaluate(point) == 0.) {
+      int start = _lower_offsets[cell];
+      int num_lower = _lower_offsets[cell+1] - start;
+      return searchCells(coords, &_lower_cells[start], num_lower) == NULL;
+    }
+  }
 
-        Universe* univ = cell->getFillUniverse();
-        next_coords->setUniverse(univ);
-        coords->setCell(cell);
+  int start = _conflict_offsets[cell];
+  int num_conflicts = _conflict_offsets[cell+1] - start;
+  if (num_conflicts == 0)
+    return true;
+
+  return searchCells(coords, &_conflict_cells[start], num_conflicts) == NULL;
+}
+
+
+/**
+ * @brief Returns the index of a Cell in the flat array of Cells.
+ * @param cell a pointer to the Cell, which may belong to another Universe
+ * @return the index of the Cell or -1 if it is not in this Universe
+ */
+int Universe::getCellIndex(Cell* cell) {
+
+  if (cell == NULL)
+    return -1;
+
+  std::vector<int>::iterator iter = std::lower_bound(_flat_cell_ids.begin(),
+                                                     _flat_cell_ids.end(),
+                                                     cell->getId());
+  if (iter == _flat_cell_ids.end())
+    return -1;
+
+  int index = iter - _flat_cell_ids.begin();
+  if (_flat_cells[index] != cell)
+    return -1;
+
+  return index;
+}
+
+
+/**
+ * @brief Returns the Cell search grid bin containing a coordinate.
+ * @details Coordinates beyond the grid are placed in the outer bins.
+ * @param coord the x or y coordinate
+ * @param min the minimum coordinate of the grid
+ * @param inv_width the inverse of the grid bin width
+ * @param num_bins the number of bins along this axis
+ * @return the bin index
+ */
+int Universe::getGridBin(double coord, double min, double inv_width,
+                         int num_bins) {
+
+  if (num_bins == 1)
+    return 0;
+
+  double bin = (coord - min) * inv_width;
+  if (bin < 1.)
+    return 0;
+  else if (bin >= num_bins - 1)
+    return num_bins - 1;
+  else
+    return int(bin);
+}
+
+
+/**
+ * @brief Determines whether a Region contains a Complement, whose bounds are
+ *        not reliable.
+ * @param region a pointer to the Region
+ * @return whether the Region contains a Complement
+ */
+static bool containsComplement(Region* region) {
+
+  if (region->getRegionType() == COMPLEMENT)
+    return true;
+
+  std::vector<Region*> nodes = region->getNodes();
+  std::vector<Region*>::iterator iter;
+  for (iter = nodes.begin(); iter != nodes.end(); ++iter)
+    if (containsComplement(*iter))
+      return true;
+
+  return false;
+}
+
+
+/**
+ * @brief Collects the Halfspaces which a Region is the intersection of.
+ * @param region a pointer to the Region
+ * @param halfspaces the vector the Halfspaces bounding the Region are
+ *        appended to
+ */
+static void getBoundingHalfspaces(Region* region,
+                                  std::vector<Halfspace*>& halfspaces) {
+
+  if (region->getRegionType() == HALFSPACE)
+    halfspaces.push_back(static_cast<Halfspace*>(region));
+  else if (region->getRegionType() == INTERSECTION) {
+    std::vector<Region*> nodes = region->getNodes();
+    std::vector<Region*>::iterator iter;
+    for (iter = nodes.begin(); iter != nodes.end(); ++iter)
+      getBoundingHalfspaces(*iter, halfspaces);
+  }
+}
+
+
+/**
+ * @brief Determines whether the negative Halfspace of a Surface lies
+ *        strictly inside the negative Halfspace of another Surface.
+ * @details This is the case of a ZCylinder nested in a larger ZCylinder, or
+ *          of a plane behind a parallel XPlane, YPlane or ZPlane. The
+ *          negative Halfspace of the first Surface is then disjoint from the
+ *          positive Halfspace of the second Surface.
+ * @param inner a pointer to the first Surface
+ * @param outer a pointer to the second Surface
+ * @return whether the first Surface is nested in the second Surface
+ */
+static bool isNested(Surface* inner, Surface* outer) {
 
-        if (univ->getType() == SIMPLE)
-          return univ->findCell(next_coords);
-        else
-          return static_cast<Lattice*>(univ)->findCell(next_coords);
+  surfaceType type = inner->getSurfaceType();
+  if (type != outer->getSurfaceType())
+    return false;
+
+  if (type == ZCYLINDER) {
+    ZCylinder* inner_cyl = static_cast<ZCylinder*>(inner);
+    ZCylinder* outer_cyl = static_cast<ZCylinder*>(outer);
+    double dist = sqrt(pow(inner_cyl->getX0() - outer_cyl->getX0(), 2) +
+                       pow(inner_cyl->getY0() - outer_cyl->getY0(), 2));
+    return dist + inner_cyl->getRadius() + TINY_MOVE <
+        outer_cyl->getRadius();
+  }
+  else if (type == XPLANE)
+    return static_cast<XPlane*>(inner)->getX() + TINY_MOVE <
+        static_cast<XPlane*>(outer)->getX();
+  else if (type == YPLANE)
+    return static_cast<YPlane*>(inner)->getY() + TINY_MOVE <
+        static_cast<YPlane*>(outer)->getY();
+  else if (type == ZPLANE)
+    return static_cast<ZPlane*>(inner)->getZ() + TINY_MOVE <
+        static_cast<ZPlane*>(outer)->getZ();
+
+  return false;
+}
+
+
+/**
+ * @brief Determines whether two Regions, given by the Halfspaces they are
+ *        the intersection of, are separated by their Surfaces.
+ * @details Regions on opposite Halfspaces of a Surface only share the
+ *          points on the Surface, which is returned as the separator.
+ *          Regions on disjoint Halfspaces of nested Surfaces share no point.
+ * @param first the Halfspaces bounding the first Region
+ * @param second the Halfspaces bounding the second Region
+ * @param separator set to the Surface on which both Regions may contain
+ *        points, or to NULL if the Regions are disjoint
+ * @return whether the Regions are separated
+ */
+static bool areSeparated(std::vector<Halfspace*>& first,
+                         std::vector<Halfspace*>& second,
+                         Surface** separator) {
+
+  *separator = NULL;
+  for (size_t i=0; i < first.size(); i++) {
+    for (size_t j=0; j < second.size(); j++) {
+      Surface* first_surface = first[i]->getSurface();
+      Surface* second_surface = second[j]->getSurface();
+      int first_halfspace = first[i]->getHalfspace();
+      int second_halfspace = second[j]->getHalfspace();
+      if (first_halfspace == second_halfspace)
+        continue;
+      if (first_surface == second_surface)
+        *separator = first_surface;
+      else if ((first_halfspace < 0 &&
+                isNested(first_surface, second_surface)) ||
+               (second_halfspace < 0 &&
+                isNested(second_surface, first_surface))) {
+        *separator = NULL;
+        return true;
       }
     }
   }
 
-  return NULL;
+  return *separator != NULL;
+}
+
+
+/**
+ * @brief Builds the structures used to accelerate Cell searches.
+ * @details The filled Cells are stored in a flat array along with their
+ *          padded x-y bounding boxes. Cells sharing a Surface on opposite
+ *          halfspaces are registered as neighbors of each other. Finally, a
+ *          uniform grid is laid over the bounding boxes of the Cells, with
+ *          about one bin per Cell, and each bin stores the Cells whose
+ *          bounding box overlaps it in the order of increasing Cell ID.
+ *          The Cells with a lower ID that may overlap each Cell are also
+ *          stored to validate the Cells found from the neighbor hints,
+ *          leaving aside those separated from the Cell by one of its
+ *          Surfaces.
+ *          This method is called automatically by findCell() whenever the
+ *          Cells of the Universe have changed.
+ */
+void Universe::initializeCellSearch() {
+
+  double inf = std::numeric_limits<double>::infinity();
+
+  /* Gather the filled Cells in a flat array */
+  _flat_cells.clear();
+  _flat_cell_ids.clear();
+  std::map<int, Cell*>::iterator iter;
+  for (iter = _cells.begin(); iter != _cells.end(); ++iter) {
+    if (iter->second->getType() != UNFILLED) {
+      _flat_cells.push_back(iter->second);
+      _flat_cell_ids.push_back(iter->first);
+    }
+  }
+  int num_cells = _flat_cells.size();
+
+  /* Compute the padded bounding boxes of the Cells */
+  _cell_bounds.resize(4*num_cells);
+  for (int c=0; c < num_cells; c++) {
+
+    Cell* cell = _flat_cells[c];
+    double* bounds = &_cell_bounds[4*c];
+
+    /* Bounds of regions with complements are not reliable */
+    bool bounded = true;
+    for (Cell* curr = cell; curr != NULL; curr = curr->getParent())
+      if (curr->getRegion() != NULL && containsComplement(curr->getRegion()))
+        bounded = false;
+
+    if (bounded) {
+      bounds[0] = cell->getMinX() - CELL_BOUNDS_PADDING;
+      bounds[1] = cell->getMaxX() + CELL_BOUNDS_PADDING;
+      bounds[2] = cell->getMinY() - CELL_BOUNDS_PADDING;
+      bounds[3] = cell->getMaxY() + CELL_BOUNDS_PADDING;
+    }
+    else {
+      bounds[0] = -inf;
+      bounds[1] = inf;
+      bounds[2] = -inf;
+      bounds[3] = inf;
+    }
+  }
+
+  /* Register Cells sharing a Surface on opposite halfspaces as neighbors */
+  std::map<int, std::vector<int> > surface_cells[2];
+  for (int c=0; c < num_cells; c++) {
+    std::map<int, Halfspace*> surfaces = _flat_cells[c]->getSurfaces();
+    std::map<int, Halfspace*>::iterator s_iter;
+    for (s_iter = surfaces.begin(); s_iter != surfaces.end(); ++s_iter)
+      surface_cells[s_iter->second->getHalfspace() > 0][s_iter->first]
+          .push_back(c);
+  }
+
+  std::map<int, std::vector<int> >::iterator s_iter;
+  for (s_iter = surface_cells[0].begin(); s_iter != surface_cells[0].end();
+       ++s_iter) {
+    std::vector<int>& negative = s_iter->second;
+    std::vector<int>& positive = surface_cells[1][s_iter->first];
+    for (size_t i=0; i < negative.size(); i++) {
+      for (size_t j=0; j < positive.size(); j++) {
+        _flat_cells[negative[i]]->addNeighborCell(_flat_cells[positive[j]]);
+        _flat_cells[positive[j]]->addNeighborCell(_flat_cells[negative[i]]);
+      }
+    }
+  }
+
+  /* Store the neighbors within this Universe in a flat array */
+  _neighbor_offsets.resize(num_cells+1);
+  _neighbor_cells.clear();
+  for (int c=0; c < num_cells; c++) {
+    _neighbor_offsets[c] = _neighbor_cells.size();
+    std::vector<Cell*> neighbors = _flat_cells[c]->getNeighbors();
+    for (size_t n=0; n < neighbors.size(); n++) {
+      int index = getCellIndex(neighbors[n]);
+      if (index != -1 && index != c)
+        _neighbor_cells.push_back(index);
+    }
+  }
+  _neighbor_offsets[num_cells] = _neighbor_cells.size();
+
+  /* Find the extent of the finite bounds of the Cells */
+  double min_x = inf;
+  double max_x = -inf;
+  double min_y = inf;
+  double max_y = -inf;
+  for (int i=0; i < 4*num_cells; i++) {
+    double bound = _cell_bounds[i];
+    if (std::abs(bound) >= FLT_INFINITY)
+      continue;
+    if (i % 4 < 2) {
+      min_x = std::min(min_x, bound);
+      max_x = std::max(max_x, bound);
+    }
+    else {
+      min_y = std::min(min_y, bound);
+      max_y = std::max(max_y, bound);
+    }
+  }
+
+  /* Size the grid with about one bin per Cell */
+  int num_bins = std::ceil(std::sqrt(double(num_cells)));
+  num_bins = std::max(1, std::min(num_bins, MAX_CELL_SEARCH_BINS));
+  _grid_num_x = (max_x > min_x) ? num_bins : 1;
+  _grid_num_y = (max_y > min_y) ? num_bins : 1;
+  _grid_min_x = (max_x > min_x) ? min_x : 0.;
+  _grid_min_y = (max_y > min_y) ? min_y : 0.;
+  _grid_inv_width_x = (max_x > min_x) ? _grid_num_x / (max_x - min_x) : 0.;
+  _grid_inv_width_y = (max_y > min_y) ? _grid_num_y / (max_y - min_y) : 0.;
+
+  /* Count, then store the Cells overlapping each bin */
+  int num_grid_bins = _grid_num_x * _grid_num_y;
+  _grid_offsets.assign(num_grid_bins+1, 0);
+  for (int pass=0; pass < 2; pass++) {
+
+    if (pass == 1) {
+      for (int b=0; b < num_grid_bins; b++)
+        _grid_offsets[b+1] += _grid_offsets[b];
+      _grid_cells.resize(_grid_offsets[num_grid_bins]);
+    }
+    std::vector<int> fill(_grid_offsets.begin(), _grid_offsets.end() - 1);
+
+    for (int c=0; c < num_cells; c++) {
+      double* bounds = &_cell_bounds[4*c];
+      int min_bin_x = getGridBin(bounds[0], _grid_min_x, _grid_inv_width_x,
+                                 _grid_num_x);
+      int max_bin_x = getGridBin(bounds[1], _grid_min_x, _grid_inv_width_x,
+                                 _grid_num_x);
+      int min_bin_y = getGridBin(bounds[2], _grid_min_y, _grid_inv_width_y,
+                                 _grid_num_y);
+      int max_bin_y = getGridBin(bounds[3], _grid_min_y, _grid_inv_width_y,
+                                 _grid_num_y);
+      for (int j=min_bin_y; j <= max_bin_y; j++) {
+        for (int i=min_bin_x; i <= max_bin_x; i++) {
+          int bin = j * _grid_num_x + i;
+          if (pass == 0)
+            _grid_offsets[bin+1]++;
+          else
+            _grid_cells[fill[bin]++] = c;
+        }
+      }
+    }
+  }
+
+  /* Store the Cells with a lower ID overlapping the bounding box of each
+   * Cell, which are found in the grid bins covered by the Cell */
+  std::vector<int> last_cell(num_cells, -1);
+  _lower_offsets.resize(num_cells+1);
+  _lower_cells.clear();
+  for (int c=0; c < num_cells; c++) {
+    _lower_offsets[c] = _lower_cells.size();
+    double* bounds = &_cell_bounds[4*c];
+    int min_bin_x = getGridBin(bounds[0], _grid_min_x, _grid_inv_width_x,
+                               _grid_num_x);
+    int max_bin_x = getGridBin(bounds[1], _grid_min_x, _grid_inv_width_x,
+                               _grid_num_x);
+    int min_bin_y = getGridBin(bounds[2], _grid_min_y, _grid_inv_width_y,
+                               _grid_num_y);
+    int max_bin_y = getGridBin(bounds[3], _grid_min_y, _grid_inv_width_y,
+                               _grid_num_y);
+    for (int j=min_bin_y; j <= max_bin_y; j++) {
+      for (int i=min_bin_x; i <= max_bin_x; i++) {
+        int bin = j * _grid_num_x + i;
+        for (int b=_grid_offsets[bin]; b < _grid_offsets[bin+1]; b++) {
+          int other = _grid_cells[b];
+          if (other >= c)
+            break;
+          double* other_bounds = &_cell_bounds[4*other];
+          if (last_cell[other] == c || other_bounds[0] > bounds[1] ||
+              other_bounds[1] < bounds[0] || other_bounds[2] > bounds[3] ||
+              other_bounds[3] < bounds[2])
+            continue;
+          last_cell[other] = c;
+          _lower_cells.push_back(other);
+        }
+      }
+    }
+    std::sort(_lower_cells.begin() + _lower_offsets[c], _lower_cells.end());
+  }
+  _lower_offsets[num_cells] = _lower_cells.size();
+
+  /* Find the Halfspaces bounding the Region of each Cell */
+  std::vector<std::vector<Halfspace*> > halfspaces(num_cells);
+  for (int c=0; c < num_cells; c++)
+    if (_flat_cells[c]->getRegion() != NULL)
+      getBoundingHalfspaces(_flat_cells[c]->getRegion(), halfspaces[c]);
+
+  /* Split the Cells with a lower ID overlapping each Cell into the Cells
+   * conflicting with it and those separated from it by its Surfaces */
+  _conflict_offsets.resize(num_cells+1);
+  _conflict_cells.clear();
+  _separator_offsets.resize(num_cells+1);
+  _separators.clear();
+  for (int c=0; c < num_cells; c++) {
+    _conflict_offsets[c] = _conflict_cells.size();
+    _separator_offsets[c] = _separators.size();
+    for (int l=_lower_offsets[c]; l < _lower_offsets[c+1]; l++) {
+      int other = _lower_cells[l];
+      Surface* separator;
+      if (!areSeparated(halfspaces[c], halfspaces[other], &separator))
+        _conflict_cells.push_back(other);
+      else if (separator != NULL &&
+               std::find(_separators.begin() + _separator_offsets[c],
+                         _separators.end(), separator) == _separators.end())
+        _separators.push_back(separator);
+    }
+  }
+  _conflict_offsets[num_cells] = _conflict_cells.size();
+  _separator_offsets[num_cells] = _separators.size();
+
+#pragma omp flush
+  _cell_search_initialized = true;
 }
 
 
@@ -692,10 +1202,15 @@ Universe* Universe::clone() {
   */
 void Universe::calculateBoundaries() {
 
+  /* Compute the bounds of the Cells, which registers them with the Surfaces
+   * read below so that changes of these Surfaces reset the boundaries */
+  std::map<int, Cell*>::iterator c_iter;
+  for (c_iter = _cells.begin(); c_iter != _cells.end(); ++c_iter)
+    c_iter->second->getMinX();
+
   /* Calculate the minimum reachable x-coordinate in the geometry and store it
    * in _min_x */
   double min_x = std::numeric_limits<double>::infinity();
-  std::map<int, Cell*>::iterator c_iter;
   std::map<int, Halfspace*>::iterator s_iter;
   Surface* surf;
   int halfspace;
@@ -948,16 +1463,21 @@ void Universe::calculateBoundaries() {
 
   _max_z = max_z;
 
+  /* Publish the boundaries only once they are all computed */
+  __sync_synchronize();
   _boundaries_inspected = true;
 }
 
 
 /**
-  * @brief  sets _boundaries_not_updated to true so boundaries will be
-  *         recalculated if needed
+  * @brief  invalidates the cached boundaries so they will be recalculated
+  *         if needed
+  * @details The Cell search structures, built from the bounds of the Cells,
+  *          are rebuilt as well.
   */
 void Universe::resetBoundaries() {
   _boundaries_inspected = false;
+  _cell_search_initialized = false;
 }
 
 
@@ -978,6 +1498,9 @@ Lattice::Lattice(const int id, const char* name): Universe(id, name) {
   _width_x = 0;
   _width_y = 0;
   _width_z = 0;
+  _inv_bucket_width_x = 0.;
+  _inv_bucket_width_y = 0.;
+  _inv_bucket_width_z = 0.;
 
   _non_uniform = false;
 }
@@ -1426,6 +1949,7 @@ void Lattice::setWidthsZ(std::vector<double> widthsz) {
  */
 void Lattice::setAccumulateX(std::vector<double> accumulatex) {
   _accumulate_x = accumulatex;
+  computeBuckets(_accumulate_x, _buckets_x, _inv_bucket_width_x);
 }
 
 
@@ -1436,6 +1960,7 @@ void Lattice::setAccumulateX(std::vector<double> accumulatex) {
  */
 void Lattice::setAccumulateY(std::vector<double> accumulatey) {
   _accumulate_y = accumulatey;
+  computeBuckets(_accumulate_y, _buckets_y, _inv_bucket_width_y);
 }
 
 
@@ -1446,6 +1971,7 @@ void Lattice::setAccumulateY(std::vector<double> accumulatey) {
  */
 void Lattice::setAccumulateZ(std::vector<double> accumulatez) {
   _accumulate_z = accumulatez;
+  computeBuckets(_accumulate_z, _buckets_z, _inv_bucket_width_z);
 }
 
 
@@ -1812,12 +2338,8 @@ int Lattice::getLatX(Point* point) {
   double dist_to_left = point->getX() - getMinX();
   
   /* Compute the x indice for the Lattice cell this point is in */
-  for(int i=0; i<_num_x; i++) {
-    if(dist_to_left >= _accumulate_x[i] && dist_to_left < _accumulate_x[i+1]){
-      lat_x = i;
-      break;
-    }
-  }
+  lat_x = findLatticeIndex(dist_to_left, _accumulate_x, _buckets_x,
+                           _inv_bucket_width_x);
 
   /* Check if the Point is on the Lattice boundaries and if so adjust
    * x Lattice cell indice */
@@ -1847,13 +2369,8 @@ int Lattice::getLatY(Point* point) {
   double dist_to_bottom = point->getY() - getMinY();
   
   /* Compute the y indice for the Lattice cell this point is in */
-  for(int i=0; i<_num_y; i++) {
-    if(dist_to_bottom >= _accumulate_y[i] && 
-      dist_to_bottom < _accumulate_y[i+1]){
-      lat_y = i;
-      break;
-    }
-  }
+  lat_y = findLatticeIndex(dist_to_bottom, _accumulate_y, _buckets_y,
+                           _inv_bucket_width_y);
 
   /* Check if the Point is on the Lattice boundaries and if so adjust
    * y Lattice cell indice */
@@ -1886,14 +2403,9 @@ int Lattice::getLatZ(Point* point) {
   /* get the distance to the bottom surface */
   double dist_to_bottom = point->getZ() - getMinZ();
   
-  /* Compute the y indice for the Lattice cell this point is in */
-  for(int i=0; i<_num_z; i++) {
-    if(dist_to_bottom >= _accumulate_z[i] && 
-        dist_to_bottom < _accumulate_z[i+1]){
-      lat_z = i;
-      break;
-    }
-  }
+  /* Compute the z indice for the Lattice cell this point is in */
+  lat_z = findLatticeIndex(dist_to_bottom, _accumulate_z, _buckets_z,
+                           _inv_bucket_width_z);
 
   /* Check if the Point is on the Lattice boundaries and if so adjust
    * z Lattice cell indice */
@@ -2004,40 +2516,28 @@ int Lattice::getLatticeSurface(int cell, Point* point) {
   int lat_y = (cell % (_num_x*_num_y)) / _num_x;
   int lat_z = cell / (_num_x*_num_y);
 
-  /* Create planes representing the boundaries of the lattice cell */
-  XPlane xplane(0.0);
-  YPlane yplane(0.0);
-  ZPlane zplane(0.0);
-  
-  /* Bools indicating if point is on each surface */
-  bool on_min_x, on_max_x, on_min_y, on_max_y, on_min_z, on_max_z;
-
-  /* Check if point is on X_MIN boundary */
-  xplane.setX(_accumulate_x[lat_x] + getMinX());
-  on_min_x = xplane.isPointOnSurface(point);
-
-  /* Check if point is on X_MAX boundary */
-  xplane.setX(_accumulate_x[lat_x+1] + getMinX());
-  on_max_x = xplane.isPointOnSurface(point);
-
-  /* Check if point is on Y_MIN boundary */
-  yplane.setY(_accumulate_y[lat_y] + getMinY());
-  on_min_y = yplane.isPointOnSurface(point);
+  /* Bools indicating if point is on each boundary of the lattice cell,
+   * using the same threshold as Surface::isPointOnSurface */
+  bool on_min_x, on_max_x, on_min_y, on_max_y;
+  bool on_min_z = false;
+  bool on_max_z = false;
 
-  /* Check if point is on Y_MAX boundary */
-  yplane.setY(_accumulate_y[lat_y+1] + getMinY());
-  on_max_y = yplane.isPointOnSurface(point);
+  /* Check if point is on the X_MIN and X_MAX boundaries */
+  on_min_x = fabs(x - (_accumulate_x[lat_x] + getMinX())) < ON_SURFACE_THRESH;
+  on_max_x = fabs(x - (_accumulate_x[lat_x+1] + getMinX()))
+             < ON_SURFACE_THRESH;
 
-  /* Check if point is on Z_MIN boundary */
-  if (_width_z != std::numeric_limits<double>::infinity()) {
-    zplane.setZ(_accumulate_z[lat_z] + getMinZ());
-    on_min_z = zplane.isPointOnSurface(point);
-  }
+  /* Check if point is on the Y_MIN and Y_MAX boundaries */
+  on_min_y = fabs(y - (_accumulate_y[lat_y] + getMinY())) < ON_SURFACE_THRESH;
+  on_max_y = fabs(y - (_accumulate_y[lat_y+1] + getMinY()))
+             < ON_SURFACE_THRESH;
 
-  /* Check if point is on Z_MAX boundary */
+  /* Check if point is on the Z_MIN and Z_MAX boundaries */
   if (_width_z != std::numeric_limits<double>::infinity()) {
-    zplane.setZ(_accumulate_z[lat_z+1] + getMinZ());
-    on_max_z = zplane.isPointOnSurface(point);
+    on_min_z = fabs(z - (_accumulate_z[lat_z] + getMinZ()))
+               < ON_SURFACE_THRESH;
+    on_max_z = fabs(z - (_accumulate_z[lat_z+1] + getMinZ()))
+               < ON_SURFACE_THRESH;
   }
 
   if (on_min_x) {
@@ -2269,6 +2769,86 @@ void Lattice::computeSizes(){
 
   for(int i=0; i<_num_z; i++)
     _accumulate_z[i+1] = _accumulate_z[i] + _widths_z[i];  
+
+  /* Compute the buckets used to find Lattice cell indexes */
+  computeBuckets(_accumulate_x, _buckets_x, _inv_bucket_width_x);
+  computeBuckets(_accumulate_y, _buckets_y, _inv_bucket_width_y);
+  computeBuckets(_accumulate_z, _buckets_z, _inv_bucket_width_z);
+}
+
+
+/**
+ * @brief Computes uniform buckets along an axis of the Lattice, which map a
+ *        distance from the Lattice's minimum to the Lattice cell index.
+ * @details Two buckets are used per Lattice cell, and each bucket stores the
+ *          index of the first Lattice cell overlapping it. For uniform and
+ *          moderately non-uniform Lattices the cell index is thus found in
+ *          constant time instead of with a search over the accumulated
+ *          widths.
+ * @param accumulate the accumulated widths along the axis
+ * @param buckets the buckets to compute
+ * @param inv_bucket_width the inverse of the bucket width to compute
+ */
+void Lattice::computeBuckets(std::vector<double>& accumulate,
+                             std::vector<int>& buckets,
+                             double& inv_bucket_width) {
+
+  int num_cells = accumulate.size() - 1;
+  if (num_cells < 1) {
+    buckets.clear();
+    inv_bucket_width = 0.;
+    return;
+  }
+
+  /* Use a single bucket along infinite axes */
+  double length = accumulate[num_cells];
+  int num_buckets = 2 * num_cells;
+  if (length <= 0. || length >= FLT_INFINITY)
+    num_buckets = 1;
+  inv_bucket_width = (num_buckets > 1) ? num_buckets / length : 0.;
+
+  buckets.resize(num_buckets);
+  int cell = 0;
+  for (int b=0; b < num_buckets; b++) {
+    double bucket_start = (num_buckets > 1) ? b / inv_bucket_width : 0.;
+    while (cell < num_cells - 1 && accumulate[cell+1] <= bucket_start)
+      cell++;
+    buckets[b] = cell;
+  }
+}
+
+
+/**
+ * @brief Finds the Lattice cell index along an axis from the distance to the
+ *        Lattice's minimum along that axis.
+ * @param dist the distance from the Lattice's minimum
+ * @param accumulate the accumulated widths along the axis
+ * @param buckets the buckets along the axis
+ * @param inv_bucket_width the inverse of the bucket width
+ * @return the Lattice cell index, or -1 if outside of the Lattice
+ */
+int Lattice::findLatticeIndex(double dist, std::vector<double>& accumulate,
+                              std::vector<int>& buckets,
+                              double inv_bucket_width) {
+
+  int num_buckets = buckets.size();
+  if (num_buckets == 0 || !(dist >= 0.) || dist >= accumulate.back())
+    return -1;
+
+  /* Find the bucket, then move to the Lattice cell containing the distance */
+  double bucket = dist * inv_bucket_width;
+  int index;
+  if (bucket >= num_buckets - 1)
+    index = buckets[num_buckets - 1];
+  else
+    index = buckets[int(bucket)];
+
+  while (index > 0 && dist < accumulate[index])
+    index--;
+  while (dist >= accumulate[index+1])
+    index++;
+
+  return index;
 }
 
 
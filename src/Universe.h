@@ -89,8 +89,8 @@ protected:
   double _min_z;
   double _max_z;
 
-  /** A flag for determining if boundaries are up to date */
-  bool _boundaries_inspected;
+  /** A flag for determining if boundaries were set */
+  volatile bool _boundaries_inspected;
 
   /** The boundaryTypes of the universe */
   boundaryType _min_x_bound;
@@ -100,6 +100,57 @@ protected:
   boundaryType _min_z_bound;
   boundaryType _max_z_bound;
 
+  /** A flag for determining if the Cell search structures are up to date */
+  bool _cell_search_initialized;
+
+  /** A flat array of the filled Cells, in the order of increasing Cell ID */
+  std::vector<Cell*> _flat_cells;
+
+  /** The IDs of the Cells in the flat array, used to locate a Cell */
+  std::vector<int> _flat_cell_ids;
+
+  /** The padded x-y bounding boxes of the Cells (min x, max x, min y, max y)
+   *  in the order of the flat array */
+  std::vector<double> _cell_bounds;
+
+  /** Offsets and indexes of the neighbors of each Cell in the flat array */
+  std::vector<int> _neighbor_offsets;
+  std::vector<int> _neighbor_cells;
+
+  /** Offsets and indexes of the Cells with a lower ID whose bounding box
+   *  overlaps the bounding box of each Cell in the flat array */
+  std::vector<int> _lower_offsets;
+  std::vector<int> _lower_cells;
+
+  /** Offsets and indexes of the Cells with a lower ID which may overlap
+   *  each Cell, as they are not separated from it by one of its Surfaces */
+  std::vector<int> _conflict_offsets;
+  std::vector<int> _conflict_cells;
+
+  /** Offsets and Surfaces of each Cell separating it from Cells with a
+   *  lower ID, on which both Cells contain the points */
+  std::vector<int> _separator_offsets;
+  std::vector<Surface*> _separators;
+
+  /** A uniform x-y grid over the Cell bounding boxes. The outer bins extend
+   *  to infinity, so that unbounded Cells fall in the outer bins. */
+  int _grid_num_x;
+  int _grid_num_y;
+  double _grid_min_x;
+  double _grid_min_y;
+  double _grid_inv_width_x;
+  double _grid_inv_width_y;
+
+  /** Offsets and indexes of the Cells overlapping each grid bin */
+  std::vector<int> _grid_offsets;
+  std::vector<int> _grid_cells;
+
+  int getCellIndex(Cell* cell);
+  int getGridBin(double coord, double min, double inv_width, int num_bins);
+  Cell* searchCells(LocalCoords* coords, int* cells, int num_cells,
+                    int skip=-1);
+  bool isFirstCell(LocalCoords* coords, int cell);
+
 public:
 
   Universe(const int id=-1, const char* name="");
@@ -141,6 +192,7 @@ public:
   void setFissionability(bool fissionable);
   void subdivideCells(double max_radius=INFINITY);
   void buildNeighbors();
+  void initializeCellSearch();
 
   virtual std::string toString();
   void printString();
@@ -193,6 +245,17 @@ private:
   std::vector<double> _widths_z;
   std::vector<double> _accumulate_z;
 
+  /** Uniform buckets along each axis, each storing the index of the first
+   *  Lattice cell that overlaps it, used to find Lattice cell indexes */
+  std::vector<int> _buckets_x;
+  std::vector<int> _buckets_y;
+  std::vector<int> _buckets_z;
+
+  /** The inverse widths of the buckets along each axis */
+  double _inv_bucket_width_x;
+  double _inv_bucket_width_y;
+  double _inv_bucket_width_z;
+
   /** The coordinates of the offset for the Universe */
   Point _offset;
 
@@ -200,6 +263,11 @@ private:
   std::vector< std::vector< std::vector< std::pair<int, Universe*> > > >
       _universes;
 
+  void computeBuckets(std::vector<double>& accumulate,
+                      std::vector<int>& buckets, double& inv_bucket_width);
+  int findLatticeIndex(double dist, std::vector<double>& accumulate,
+                       std::vector<int>& buckets, double inv_bucket_width);
+
 public:
 
   Lattice(const int id=-1, const char* name="");
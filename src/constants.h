@@ -43,6 +43,18 @@
 /** Error threshold to determine if a point is to be considered on a Surface */
 #define ON_SURFACE_THRESH 1E-12
 
+/** Padding of the Cell bounding boxes used to accelerate Cell searches */
+#define CELL_BOUNDS_PADDING 1E-8
+
+/** Maximum number of bins along each axis of a Universe's Cell search grid */
+#define MAX_CELL_SEARCH_BINS 64
+
+/** Maximum stack size required to evaluate a compiled Region */
+#define MAX_CSG_STACK 64
+
+/** Number of Surfaces whose distances are computed together in one batch */
+#define SURFACE_DISTANCE_BATCH 64
+
 /** Tolerance for difference of the sum of polar weights with respect to 1.0 */
 #define POLAR_WEIGHT_SUM_TOL 1E-5
 
@@ -83,6 +95,25 @@
 #endif
 
 #define LOCAL_COORDS_LEN 16
+
+/** Number of LocalCoords linked lists reused by each thread for ray tracing */
+#define NUM_THREAD_COORDS 4
+
+/** Width (cm) of the bins of distances from the pin center to the line of a
+ *  Track, used to look up chord templates */
+#define CHORD_TEMPLATE_BUCKET 1E-10
+
+/** Largest difference (cm) between the distance from the pin center to the
+ *  line of a Track and that of the line a chord template was recorded for,
+ *  for the template to be replayed */
+#define CHORD_TEMPLATE_TOLERANCE 1E-12
+
+/** Shortest chord of a replayed chord template, shorter chords being close
+ *  to tangent crossings whose lengths are sensitive to the line offset */
+#define CHORD_TEMPLATE_MIN_LENGTH 1E-4
+
+/** Number of buckets per axial mesh cell to look up axial mesh cells */
+#define AXIAL_MESH_BUCKETS_PER_CELL 2
 #define MAX_VERSION_NUM 20
 
 /** The faces, edges, and vertices that collectively make up the surfaces of a
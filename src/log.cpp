@@ -543,9 +543,11 @@ void log_printf(logLevel level, const char* format, ...) {
           MPI_Finalize();
         }
 #endif
-        throw std::logic_error(msg_string.c_str());
       }
       omp_unset_lock(&log_error_lock);
+
+      /* Release the lock first, as the exception may be caught */
+      throw std::logic_error(msg_string.c_str());
     }
     else {
       printf("%s", &msg_string[0]);
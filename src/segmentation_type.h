@@ -24,7 +24,11 @@ enum segmentationType {
   OTF_TRACKS,
 
   /** Axial on-the-fly 3D segment formation by z-stack */
-  OTF_STACKS
+  OTF_STACKS,
+
+  /** Axial on-the-fly 3D segment formation by z-stack, with explicit 3D
+   *  segments stored for the z-stacks most costly to ray trace */
+  HYBRID_STACKS
 };
 
 #endif /* SEGMENTATION_TYPE_H_ */
@@ -0,0 +1,61 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+
+
+class CheckpointRestartTestHarness(TestHarness):
+    """An eigenvalue calculation in a 2D lattice interrupted after writing
+    checkpoints and restarted from the last one."""
+
+    def __init__(self):
+        super(CheckpointRestartTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.filename = 'checkpoint.bin'
+        self.checkpoint_interval = 5
+        self.interrupted_iters = 12
+        self.reference = None
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue and fluxes of the last
+        calculation."""
+        return super(CheckpointRestartTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True)
+
+    def _run_openmoc(self):
+        """Solve without interruption, then with an interruption after a few
+        iterations and a restart from the last checkpoint."""
+
+        super(CheckpointRestartTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+
+        self._create_solver()
+        self.solver.setCheckpointing(self.filename, self.checkpoint_interval)
+        self.solver.computeEigenvalue(self.interrupted_iters,
+                                      res_type=self.res_type)
+
+        self._create_solver()
+        self.solver.restartFromCheckpoint(self.filename)
+        super(CheckpointRestartTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the uninterrupted and restarted solutions."""
+        return self.reference + self._get_solution()
+
+    def _cleanup(self):
+        """Delete the checkpoint along with the other test files."""
+        for filename in [self.filename, self.filename + '.tmp']:
+            if os.path.isfile(filename):
+                os.remove(filename)
+        super(CheckpointRestartTestHarness, self)._cleanup()
+
+
+if __name__ == '__main__':
+    harness = CheckpointRestartTestHarness()
+    harness.main()
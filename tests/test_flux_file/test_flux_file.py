@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+
+
+class FluxFileTestHarness(TestHarness):
+    """An eigenvalue calculation in a 2D lattice started from the fluxes
+    dumped to a Solver file by a previous calculation."""
+
+    def __init__(self):
+        super(FluxFileTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.filename = 'fsr-fluxes.bin'
+        self.reference = None
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue and fluxes of the last
+        calculation."""
+        return super(FluxFileTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True)
+
+    def _run_openmoc(self):
+        """Solve and dump the fluxes, then solve again from those fluxes."""
+
+        super(FluxFileTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+        self.solver.dumpFSRFluxes(self.filename)
+
+        self._create_solver()
+        self.solver.loadInitialFSRFluxes(self.filename)
+        super(FluxFileTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions started from flat and loaded fluxes."""
+        return self.reference + self._get_solution()
+
+    def _cleanup(self):
+        """Delete the Solver file along with the other test files."""
+        if os.path.isfile(self.filename):
+            os.remove(self.filename)
+        super(FluxFileTestHarness, self)._cleanup()
+
+
+if __name__ == '__main__':
+    harness = FluxFileTestHarness()
+    harness.main()
@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import PinCellInput
+
+
+class FluxTransferTestHarness(TestHarness):
+    """An eigenvalue calculation in a pin cell with fuel rings started from
+    the fluxes of the pin cell without rings."""
+
+    def __init__(self):
+        super(FluxTransferTestHarness, self).__init__()
+        self.input_set = PinCellInput()
+        self.filename = 'coarse-fluxes.bin'
+        self.num_rings = 0
+        self.reference = None
+
+    def _create_geometry(self):
+        """Build the pin cell, with rings in the fuel if any."""
+        super(FluxTransferTestHarness, self)._create_geometry()
+        if self.num_rings > 0:
+            cells = self.input_set.geometry.getAllMaterialCells()
+            for cell_id in cells:
+                if cells[cell_id].getName() == 'fuel':
+                    cells[cell_id].setNumRings(self.num_rings)
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue and fluxes of the last
+        calculation."""
+        return super(FluxTransferTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True)
+
+    def _run_openmoc(self):
+        """Solve the pin cell without rings and dump its fluxes, then solve
+        the pin cell with rings from flat and from transferred fluxes."""
+
+        super(FluxTransferTestHarness, self)._run_openmoc()
+        self.solver.dumpFSRFluxes(self.filename)
+
+        self.num_rings = 3
+        self.input_set = PinCellInput()
+        self._setup()
+        super(FluxTransferTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+
+        self._create_solver()
+        self.solver.loadInitialFSRFluxes(self.filename, True)
+        super(FluxTransferTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions started from flat and transferred fluxes."""
+        return self.reference + self._get_solution()
+
+    def _cleanup(self):
+        """Delete the Solver file along with the other test files."""
+        if os.path.isfile(self.filename):
+            os.remove(self.filename)
+        super(FluxTransferTestHarness, self)._cleanup()
+
+
+if __name__ == '__main__':
+    harness = FluxTransferTestHarness()
+    harness.main()
@@ -0,0 +1,56 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import numpy as np
+
+
+class FSRDiscoveryTestHarness(TestHarness):
+    """Discovery of the FSRs of a 2D lattice by all ray tracing threads,
+    which insert and look up FSRs in the FSR hash map while it grows."""
+
+    def __init__(self):
+        super(FSRDiscoveryTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.spacing = 0.05
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments with all threads."""
+        self.track_generator.setNumThreads(self.num_threads)
+        self.track_generator.generateTracks()
+
+    def _create_solver(self):
+        """No Solver is needed."""
+        pass
+
+    def _run_openmoc(self):
+        """No calculation is needed."""
+        pass
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=True, num_tracks=False, num_segments=True,
+                     hash_output=False):
+        """Digest the number of FSRs and segments, and the FSR IDs found on
+        a grid of points."""
+
+        outstr = super(FSRDiscoveryTestHarness, self)._get_results(
+            num_iters=num_iters, keff=keff, fluxes=fluxes, num_fsrs=num_fsrs,
+            num_tracks=num_tracks, num_segments=num_segments)
+
+        # Grids with different spacings avoid points on the sector planes
+        grid_x = np.linspace(-2. + 2. / 32, 2. - 2. / 32, 32)
+        grid_y = np.linspace(-2. + 2. / 30, 2. - 2. / 30, 30)
+        fsr_ids = self.input_set.geometry.getSpatialDataOnGrid(
+            grid_x, grid_y, 0., 'xy', 'fsr')
+        outstr += 'FSR IDs:\n'
+        outstr += '\n'.join(str(fsr_id) for fsr_id in fsr_ids) + '\n'
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = FSRDiscoveryTestHarness()
+    harness.main()
@@ -0,0 +1,59 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+import numpy as np
+
+
+class FSRNumberingTestHarness(TestHarness):
+    """Numbering of the FSRs of a 3D lattice ray traced on-the-fly by all
+    threads, which should not depend on the number of threads."""
+
+    def __init__(self):
+        super(FSRNumberingTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput(num_dimensions=3)
+        self.num_polar = 4
+        self.azim_spacing = 0.12
+        self.z_spacing = 0.5
+
+    def _create_trackgenerator(self):
+        """Instantiate a TrackGenerator3D tracing z-stacks on-the-fly."""
+        geometry = self.input_set.geometry
+        geometry.initializeFlatSourceRegions()
+        self.track_generator = \
+            openmoc.TrackGenerator3D(geometry, self.num_azim, self.num_polar,
+                                     self.azim_spacing, self.z_spacing)
+        self.track_generator.setSegmentFormation(openmoc.OTF_STACKS)
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments with all threads."""
+        self.track_generator.setNumThreads(self.num_threads)
+        self.track_generator.generateTracks()
+
+    def _get_results(self, num_iters=True, keff=True, fluxes=True,
+                     num_fsrs=True, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solution, the number of FSRs and the FSR IDs found on
+        a grid of points of an axial plane."""
+
+        outstr = super(FSRNumberingTestHarness, self)._get_results(
+            num_iters=num_iters, keff=keff, fluxes=fluxes, num_fsrs=num_fsrs,
+            num_tracks=num_tracks, num_segments=num_segments)
+
+        grid_x = np.linspace(-2. + 2. / 32, 2. - 2. / 32, 32)
+        grid_z = np.linspace(-5. + 5. / 20, 5. - 5. / 20, 20)
+        fsr_ids = self.input_set.geometry.getSpatialDataOnGrid(
+            grid_x, grid_z, 0.3, 'xz', 'fsr')
+        outstr += 'FSR IDs:\n'
+        outstr += '\n'.join(str(fsr_id) for fsr_id in fsr_ids) + '\n'
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = FSRNumberingTestHarness()
+    harness.main()
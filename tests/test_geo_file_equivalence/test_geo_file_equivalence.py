@@ -0,0 +1,61 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class GeoFileEquivalenceTestHarness(TestHarness):
+    """An eigenvalue calculation in a 2D lattice loaded from the .geo file
+    dumped from the lattice, compared to that in the lattice itself."""
+
+    def __init__(self):
+        super(GeoFileEquivalenceTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.filename = 'simple-lattice.geo'
+        self.reference = None
+
+    def _create_geometry(self):
+        """Build the lattice and dump it to a .geo file."""
+        super(GeoFileEquivalenceTestHarness, self)._create_geometry()
+        self.input_set.geometry.dumpToFile(self.filename)
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue, fluxes and number of FSRs of the
+        last calculation."""
+        return super(GeoFileEquivalenceTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True, num_fsrs=True)
+
+    def _run_openmoc(self):
+        """Solve the lattice, then the Geometry loaded from its .geo file."""
+
+        super(GeoFileEquivalenceTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+
+        self.input_set.geometry = openmoc.Geometry()
+        self.input_set.geometry.loadFromFile(self.filename)
+        self._create_trackgenerator()
+        self._generate_tracks()
+        self._create_solver()
+        super(GeoFileEquivalenceTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions in the lattice and the loaded Geometry."""
+        return self.reference + self._get_solution()
+
+    def _cleanup(self):
+        """Delete the .geo file along with the other test files."""
+        if os.path.isfile(self.filename):
+            os.remove(self.filename)
+        super(GeoFileEquivalenceTestHarness, self)._cleanup()
+
+
+if __name__ == '__main__':
+    harness = GeoFileEquivalenceTestHarness()
+    harness.main()
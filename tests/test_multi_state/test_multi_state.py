@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class MultiStateTestHarness(TestHarness):
+    """An eigenvalue calculation of several states of the UO2 in a 2D
+    lattice, compared to the eigenvalue calculation of each state alone."""
+
+    def __init__(self):
+        super(MultiStateTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.tolerance = 1E-7
+        self.num_states = 3
+        self.state_materials = []
+        self.references = []
+
+    def _perturb(self, material, state):
+        """Change the fission production of a Material in the first state
+        and its total cross sections in the second."""
+        for group in range(1, material.getNumEnergyGroups() + 1):
+            if state == 1:
+                material.setNuSigmaFByGroup(
+                    1.05 * material.getNuSigmaFByGroup(group), group)
+            elif state == 2:
+                material.setSigmaTByGroup(
+                    1.05 * material.getSigmaTByGroup(group), group)
+
+    def _create_solver(self):
+        """Instantiate a CPUMultiStateSolver with perturbed UO2 states."""
+        self.solver = openmoc.CPUMultiStateSolver(self.track_generator)
+        self.solver.setNumThreads(self.num_threads)
+        self.solver.setConvergenceThreshold(self.tolerance)
+        self.solver.setNumStates(self.num_states)
+
+        # State Materials have the IDs of the C5G7 Materials they replace,
+        # and are kept referenced for as long as the Solver uses them
+        for state in range(1, self.num_states):
+            materials = SimpleLatticeInput()
+            materials.create_materials()
+            self._perturb(materials.materials['UO2'], state)
+            self.state_materials.append(materials)
+            self.solver.setStateMaterial(state, materials.materials['UO2'])
+
+    def _run_openmoc(self):
+        """Solve all states at once, then each state alone."""
+
+        super(MultiStateTestHarness, self)._run_openmoc()
+        multi_state = (self.input_set, self.track_generator, self.solver)
+
+        for state in range(self.num_states):
+            self.input_set = SimpleLatticeInput()
+            self.input_set.create_materials()
+            self._perturb(self.input_set.materials['UO2'], state)
+            self.input_set.create_geometry()
+            self._create_trackgenerator()
+            self._generate_tracks()
+            super(MultiStateTestHarness, self)._create_solver()
+            super(MultiStateTestHarness, self)._run_openmoc()
+            self.references.append(
+                super(MultiStateTestHarness, self)._get_results(
+                    num_iters=True, keff=True, fluxes=True))
+
+        (self.input_set, self.track_generator, self.solver) = multi_state
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solution of each state and that of the state solved
+        alone."""
+
+        geometry = self.input_set.geometry
+        outstr = '# Iterations: {0}\n'.format(self.solver.getNumIterations())
+        for state in range(self.num_states):
+            outstr += 'state {0} keff: {1:12.5E}\n'.format(
+                state, self.solver.getStateKeff(state))
+            fluxes = ['{0:12.6E}'.format(
+                self.solver.getStateFlux(fsr, state, group))
+                for fsr in range(geometry.getNumFSRs())
+                for group in range(1, geometry.getNumEnergyGroups() + 1)]
+            outstr += 'state {0} fluxes:\n'.format(state)
+            outstr += '\n'.join(fluxes) + '\n'
+            outstr += self.references[state]
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = MultiStateTestHarness()
+    harness.main()
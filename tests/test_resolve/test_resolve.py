@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+
+import os
+import sys
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import PinCellInput
+
+
+class ResolveTestHarness(TestHarness):
+    """Eigenvalue calculations in a pin cell solved again by the same Solver
+    after changing the cross sections of the fuel and after swapping the
+    Materials filling the fuel and moderator Cells."""
+
+    def __init__(self):
+        super(ResolveTestHarness, self).__init__()
+        self.input_set = PinCellInput()
+        self.nu_sigma_f_factor = 1.1
+        self.solutions = []
+
+    def _scale_fission(self, material):
+        """Scale the fission production cross sections of a Material."""
+        for group in range(1, material.getNumEnergyGroups() + 1):
+            material.setNuSigmaFByGroup(self.nu_sigma_f_factor *
+                                        material.getNuSigmaFByGroup(group),
+                                        group)
+
+    def _swap_fills(self):
+        """Fill the fuel Cell with water and the moderator Cell with UO2."""
+        materials = self.input_set.materials
+        cells = self.input_set.geometry.getAllMaterialCells()
+        for cell_id in cells:
+            if cells[cell_id].getName() == 'fuel':
+                cells[cell_id].setFill(materials['Water'])
+            elif cells[cell_id].getName() == 'moderator':
+                cells[cell_id].setFill(materials['UO2'])
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue and fluxes of the last
+        calculation."""
+        return super(ResolveTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True)
+
+    def _solve_independently(self, swap_fills):
+        """Return the solution of a new pin cell, with the changed cross
+        sections and possibly swapped fills, by a new Solver."""
+
+        resolved = (self.input_set, self.track_generator, self.solver)
+
+        self.input_set = PinCellInput()
+        self.input_set.create_materials()
+        self._scale_fission(self.input_set.materials['UO2'])
+        self.input_set.create_geometry()
+        if swap_fills:
+            self._swap_fills()
+        self._create_trackgenerator()
+        self._generate_tracks()
+        self._create_solver()
+        super(ResolveTestHarness, self)._run_openmoc()
+        solution = self._get_solution()
+
+        (self.input_set, self.track_generator, self.solver) = resolved
+        return solution
+
+    def _run_openmoc(self):
+        """Solve, then solve again after each change of the pin cell."""
+
+        super(ResolveTestHarness, self)._run_openmoc()
+
+        self._scale_fission(self.input_set.materials['UO2'])
+        super(ResolveTestHarness, self)._run_openmoc()
+        self.solutions.append((self._get_solution(),
+                               self._solve_independently(False)))
+
+        self._swap_fills()
+        super(ResolveTestHarness, self)._run_openmoc()
+        self.solutions.append((self._get_solution(),
+                               self._solve_independently(True)))
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions solved again and those of new Solvers."""
+
+        outstr = ''
+        for solution, reference in self.solutions:
+            outstr += solution + reference
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = ResolveTestHarness()
+    harness.main()
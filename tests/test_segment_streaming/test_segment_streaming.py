@@ -0,0 +1,83 @@
+#!/usr/bin/env python
+
+import os
+import sys
+import glob
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class SegmentStreamingTestHarness(TestHarness):
+    """An eigenvalue calculation in a 3D lattice with explicit segments kept
+    in memory, then streamed from the Track file as it is written and as it
+    is read."""
+
+    def __init__(self):
+        super(SegmentStreamingTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput(num_dimensions=3)
+        self.num_polar = 4
+        self.azim_spacing = 0.12
+        self.z_spacing = 0.5
+        self.segment_window = 0.
+        self.solutions = []
+
+    def _create_trackgenerator(self):
+        """Instantiate a TrackGenerator3D with explicit 3D segments."""
+        geometry = self.input_set.geometry
+        geometry.initializeFlatSourceRegions()
+        self._create_explicit_trackgenerator()
+
+    def _create_explicit_trackgenerator(self):
+        """Instantiate a TrackGenerator3D, which streams segments from the
+        Track file if a window is set."""
+        self.track_generator = \
+            openmoc.TrackGenerator3D(self.input_set.geometry, self.num_azim,
+                                     self.num_polar, self.azim_spacing,
+                                     self.z_spacing)
+        self.track_generator.setSegmentFormation(openmoc.EXPLICIT_3D)
+        self.track_generator.setSegmentStreamingWindow(self.segment_window)
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments."""
+        self.track_generator.setNumThreads(self.num_threads)
+        self.track_generator.generateTracks()
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue, fluxes and number of segments
+        of the last calculation."""
+        return super(SegmentStreamingTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True, num_segments=True)
+
+    def _run_openmoc(self):
+        """Solve with segments in memory, then streamed from the Track file
+        written by ray tracing, then from the Track file read again."""
+
+        super(SegmentStreamingTestHarness, self)._run_openmoc()
+        self.solutions.append(self._get_solution())
+
+        # A window much smaller than the segments of the lattice
+        self.segment_window = 0.05
+        for i in range(2):
+            self._create_explicit_trackgenerator()
+            self._generate_tracks()
+            self._create_solver()
+            super(SegmentStreamingTestHarness, self)._run_openmoc()
+            self.solutions.append(self._get_solution())
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions with segments in memory and streamed."""
+
+        outstr = '# Track files: {0}\n'.format(
+            len(glob.glob(os.path.join('tracks', '*.data'))))
+        outstr += ''.join(self.solutions)
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = SegmentStreamingTestHarness()
+    harness.main()
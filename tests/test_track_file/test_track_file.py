@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+
+import os
+import sys
+import glob
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class TrackFileTestHarness(TestHarness):
+    """An eigenvalue calculation in a 2D lattice with explicit segments
+    imported from the Track file written by a previous ray tracing."""
+
+    def __init__(self):
+        super(TrackFileTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.reference = None
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments, and write them to a Track file."""
+        super(TrackFileTestHarness, self)._generate_tracks()
+        self.track_generator.dumpSegmentsToFile()
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue, fluxes and number of segments
+        of the last calculation."""
+        return super(TrackFileTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True, num_segments=True)
+
+    def _run_openmoc(self):
+        """Solve with ray traced segments, then with the Track file's."""
+
+        super(TrackFileTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+
+        # Track the same Geometry again, which imports the Track file
+        self.track_generator = \
+            openmoc.TrackGenerator(self.input_set.geometry, self.num_azim,
+                                   self.spacing)
+        self.track_generator.setNumThreads(1)
+        self.track_generator.generateTracks()
+        self._create_solver()
+        super(TrackFileTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions with and without the Track file."""
+
+        outstr = '# Track files: {0}\n'.format(
+            len(glob.glob(os.path.join('tracks', '*.data'))))
+        outstr += self.reference
+        outstr += self._get_solution()
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = TrackFileTestHarness()
+    harness.main()
@@ -0,0 +1,74 @@
+#!/usr/bin/env python
+
+import os
+import sys
+import glob
+import shutil
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class TrackFileHashTestHarness(TestHarness):
+    """Eigenvalue calculations in 2D lattices differing only by the rings of
+    a fuel cell, which must not share a Track file."""
+
+    def __init__(self):
+        super(TrackFileHashTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput()
+        self.num_rings = 3
+        self.num_track_files = 0
+        self.reference = None
+
+    def _create_geometry(self):
+        """Build the lattice, with the rings of the large pin's fuel."""
+        super(TrackFileHashTestHarness, self)._create_geometry()
+        cells = self.input_set.geometry.getAllMaterialCells()
+        for cell_id in cells:
+            if cells[cell_id].getName() == 'large pin fuel':
+                cells[cell_id].setNumRings(self.num_rings)
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments, and write them to a Track file."""
+        super(TrackFileHashTestHarness, self)._generate_tracks()
+        self.track_generator.dumpSegmentsToFile()
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue, fluxes and number of FSRs of the
+        last calculation."""
+        return super(TrackFileHashTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=True, num_fsrs=True)
+
+    def _run_openmoc(self):
+        """Solve the lattice with fewer rings after writing the Track file of
+        the original lattice, then without any Track file."""
+
+        self.num_rings = 2
+        self.input_set = SimpleLatticeInput()
+        self._setup()
+        super(TrackFileHashTestHarness, self)._run_openmoc()
+        self.num_track_files = \
+            len(glob.glob(os.path.join('tracks', '*.data')))
+        self.reference = self._get_solution()
+
+        shutil.rmtree('tracks')
+        self.input_set = SimpleLatticeInput()
+        self._setup()
+        super(TrackFileHashTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions with and without the other Track file."""
+
+        outstr = '# Track files: {0}\n'.format(self.num_track_files)
+        outstr += self.reference
+        outstr += self._get_solution()
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = TrackFileHashTestHarness()
+    harness.main()
@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+
+import os
+import sys
+import glob
+sys.path.insert(0, os.pardir)
+sys.path.insert(0, os.path.join(os.pardir, 'openmoc'))
+from testing_harness import TestHarness
+from input_set import SimpleLatticeInput
+import openmoc
+
+
+class TrackFileOTFTestHarness(TestHarness):
+    """An eigenvalue calculation in a 3D lattice with on-the-fly ray tracing
+    started from the Track file written by a previous ray tracing."""
+
+    def __init__(self):
+        super(TrackFileOTFTestHarness, self).__init__()
+        self.input_set = SimpleLatticeInput(num_dimensions=3)
+        self.num_polar = 4
+        self.azim_spacing = 0.12
+        self.z_spacing = 0.5
+        self.reference = None
+
+    def _create_trackgenerator(self):
+        """Instantiate a TrackGenerator."""
+        geometry = self.input_set.geometry
+        geometry.initializeFlatSourceRegions()
+        self._create_otf_trackgenerator()
+
+    def _create_otf_trackgenerator(self):
+        """Instantiate a TrackGenerator3D tracing z-stacks on-the-fly."""
+        self.track_generator = \
+            openmoc.TrackGenerator3D(self.input_set.geometry, self.num_azim,
+                                     self.num_polar, self.azim_spacing,
+                                     self.z_spacing)
+        self.track_generator.setSegmentFormation(openmoc.OTF_STACKS)
+        self.track_generator.setCacheOTFStartup(True)
+
+    def _generate_tracks(self):
+        """Generate Tracks and segments."""
+        self.track_generator.setNumThreads(self.num_threads)
+        self.track_generator.generateTracks()
+
+    def _get_solution(self):
+        """Digest the iterations, eigenvalue and number of segments of the
+        last calculation. The FSR numbering, and thus the order of the
+        fluxes, depends on the number of threads ray tracing."""
+        return super(TrackFileOTFTestHarness, self)._get_results(
+            num_iters=True, keff=True, fluxes=False, num_segments=True)
+
+    def _run_openmoc(self):
+        """Solve after ray tracing, then after reading the Track file."""
+
+        super(TrackFileOTFTestHarness, self)._run_openmoc()
+        self.reference = self._get_solution()
+
+        # Track the same Geometry again, which imports the Track file
+        self._create_otf_trackgenerator()
+        self._generate_tracks()
+        self._create_solver()
+        super(TrackFileOTFTestHarness, self)._run_openmoc()
+
+    def _get_results(self, num_iters=False, keff=False, fluxes=False,
+                     num_fsrs=False, num_tracks=False, num_segments=False,
+                     hash_output=False):
+        """Digest the solutions with and without the Track file."""
+
+        outstr = '# Track files: {0}\n'.format(
+            len(glob.glob(os.path.join('tracks', '*.data'))))
+        outstr += self.reference
+        outstr += self._get_solution()
+        return outstr
+
+
+if __name__ == '__main__':
+    harness = TrackFileOTFTestHarness()
+    harness.main()